@@ -3,22 +3,12 @@
 #include <ituGL/shader/Shader.h>
 #include <ituGL/geometry/VertexAttribute.h>
 #include <cassert>
+#include <cstring>
 #include <array>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
-// Structure defining that Particle data
-struct Particle
-{
-    glm::vec2 position;
-    float size;
-    float birth;
-    float duration;
-    Color color;
-    glm::vec2 velocity;
-};
-
 // List of attributes of the particle. Must match the structure above
 const std::array<VertexAttribute, 6> s_vertexAttributes =
 {
@@ -105,11 +95,26 @@ void ParticlesApplication::Render()
     // Set Gravity uniform
     m_shaderProgram.SetUniform(m_gravityUniform, -9.8f);
 
+    // Copy the particles to the region of this frame. It only waits if the GPU is still drawing from it
+    // The amount of points can't exceed the capacity
+    unsigned int count = std::min(m_particleCount, m_particleCapacity);
+    m_streamingBuffer->BeginFrame();
+    size_t offset = 0;
+    if (count > 0)
+    {
+        // Align to the particle size, so the offset can be used as the first vertex
+        std::span<std::byte> data = m_streamingBuffer->Allocate(count * sizeof(Particle), sizeof(Particle), offset);
+        std::memcpy(data.data(), m_particles.data(), data.size());
+    }
+    m_streamingBuffer->Flush();
+
     // Bind the particle system VAO
     m_vao.Bind();
 
-    // Draw points. The amount of points can't exceed the capacity
-    glDrawArrays(GL_POINTS, 0, std::min(m_particleCount, m_particleCapacity));
+    // Draw points, starting at the region of this frame
+    glDrawArrays(GL_POINTS, static_cast<GLint>(offset / sizeof(Particle)), count);
+
+    m_streamingBuffer->EndFrame();
 
     Application::Render();
 }
@@ -118,13 +123,15 @@ void ParticlesApplication::Render()
 // Change s_vertexAttributes and the Particle struct to add new vertex attributes
 void ParticlesApplication::InitializeGeometry()
 {
-    m_vbo.Bind();
+    m_particles.resize(m_particleCapacity);
 
-    // Allocate enough data for all the particles
-    // Notice the DynamicDraw usage, because we will update the buffer every time we emit a particle
-    m_vbo.AllocateData(m_particleCapacity * sizeof(Particle), BufferObject::Usage::DynamicDraw);
+    // Allocate enough data for all the particles in each region of the streaming buffer
+    // The particles are written every frame, so the buffer never waits for the previous draws
+    m_vbo = std::make_shared<VertexBufferObject>();
+    m_streamingBuffer = std::make_unique<StreamingBuffer>(m_vbo, m_particleCapacity * sizeof(Particle));
 
     m_vao.Bind();
+    m_vbo->Bind();
 
     // Automatically iterate through the vertex attributes, and set the pointer
     // We use interleaved attributes, so the offset is local to the particle, and the stride is the size of the particle
@@ -174,15 +181,8 @@ void ParticlesApplication::EmitParticle(const glm::vec2& position, float size, f
     // Get the index in the circular buffer
     unsigned int particleIndex = m_particleCount % m_particleCapacity;
 
-    // Bind the VBO before updating data
-    m_vbo.Bind();
-
-    // Update the particle data in the VBO
-    int offset = particleIndex * sizeof(Particle);
-    m_vbo.UpdateData(std::span(&particle, 1), offset);
-
-    // Unbind the VBO
-    VertexBufferObject::Unbind();
+    // Store the particle, it will be copied to the VBO when rendering
+    m_particles[particleIndex] = particle;
 
     // Increment the particle count
     m_particleCount++;
@@ -3,7 +3,9 @@
 #include <ituGL/application/Application.h>
 #include <ituGL/geometry/VertexBufferObject.h>
 #include <ituGL/geometry/VertexArrayObject.h>
+#include <ituGL/core/StreamingBuffer.h>
 #include <ituGL/shader/ShaderProgram.h>
+#include <vector>
 
 class ParticlesApplication : public Application
 {
@@ -16,6 +18,17 @@ protected:
     void Render() override;
 
 private:
+    // Structure defining that Particle data
+    struct Particle
+    {
+        glm::vec2 position;
+        float size;
+        float birth;
+        float duration;
+        Color color;
+        glm::vec2 velocity;
+    };
+
     // Initialize the VBO and VAO
     void InitializeGeometry();
 
@@ -35,8 +48,12 @@ private:
     static Color RandomColor();
 
 private:
-    // All particles stored in a single VBO with interleaved attributes
-    VertexBufferObject m_vbo;
+    // All particles stored in memory, copied to the streaming buffer every frame
+    std::vector<Particle> m_particles;
+
+    // VBO with interleaved attributes, with a region for each frame in flight
+    std::shared_ptr<VertexBufferObject> m_vbo;
+    std::unique_ptr<StreamingBuffer> m_streamingBuffer;
 
     // VAO that represents the particle system
     VertexArrayObject m_vao;
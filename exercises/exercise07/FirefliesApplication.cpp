@@ -7,12 +7,13 @@
 #include <ituGL/renderer/ForwardRenderPass.h>
 #include <ituGL/renderer/GBufferRenderPass.h>
 #include <ituGL/renderer/DeferredRenderPass.h>
+#include <ituGL/renderer/ClusteredDeferredRenderPass.h>
 #include <glm/gtx/transform.hpp>
 #include <imgui.h>
 
 FirefliesApplication::FirefliesApplication()
     : Application(1024, 1024, "Fireflies demo")
-    , m_renderMode(RenderMode::Deferred)
+    , m_renderMode(RenderMode::ClusteredDeferred)
     , m_renderer(GetDevice())
     , m_mouseClicked(false)
     , m_ambientColor(0.0f)
@@ -122,11 +123,13 @@ void FirefliesApplication::InitializeForwardMaterials()
     // Load and build shader
     std::vector<const char*> vertexShaderPaths;
     vertexShaderPaths.push_back("shaders/version330.glsl");
+    vertexShaderPaths.push_back("shaders/renderer/uniforms.glsl");
     vertexShaderPaths.push_back("shaders/lit.vert");
     Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
 
     std::vector<const char*> fragmentShaderPaths;
     fragmentShaderPaths.push_back("shaders/version330.glsl");
+    fragmentShaderPaths.push_back("shaders/renderer/uniforms.glsl");
     fragmentShaderPaths.push_back("shaders/utils.glsl");
     fragmentShaderPaths.push_back("shaders/blinn-phong.glsl");
     fragmentShaderPaths.push_back("shaders/lighting.glsl");
@@ -136,29 +139,16 @@ void FirefliesApplication::InitializeForwardMaterials()
     std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
     shaderProgramPtr->Build(vertexShader, fragmentShader);
 
-    // Get transform related uniform locations
-    ShaderProgram::Location cameraPositionLocation = shaderProgramPtr->GetUniformLocation("CameraPosition");
-    ShaderProgram::Location worldMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldMatrix");
-    ShaderProgram::Location viewProjMatrixLocation = shaderProgramPtr->GetUniformLocation("ViewProjMatrix");
-
-    // Register shader with renderer
+    // Register shader with renderer. The world matrix comes in an instance attribute, so fireflies are drawn instanced
+    // Camera uniforms are read from the FrameData block, so there are no transforms to update
     m_renderer.RegisterShaderProgram(shaderProgramPtr,
-        [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
-        {
-            if (cameraChanged)
-            {
-                shaderProgram.SetUniform(cameraPositionLocation, camera.ExtractTranslation());
-                shaderProgram.SetUniform(viewProjMatrixLocation, camera.GetViewProjectionMatrix());
-            }
-            shaderProgram.SetUniform(worldMatrixLocation, worldMatrix);
-        },
-        GetUpdateLightsFunction(shaderProgramPtr)
+        nullptr,
+        GetUpdateLightsFunction(shaderProgramPtr),
+        shaderProgramPtr->GetAttributeLocation("InstanceWorldMatrix")
         );
 
     // Filter out uniforms that are not material properties
     ShaderUniformCollection::NameSet filteredUniforms;
-    filteredUniforms.insert("WorldMatrix");
-    filteredUniforms.insert("ViewProjMatrix");
     filteredUniforms.insert("AmbientColor");
     filteredUniforms.insert("LightColor");
     filteredUniforms.insert("LightPosition");
@@ -176,6 +166,7 @@ void FirefliesApplication::InitializeDeferredMaterials()
         // Load and build shader
         std::vector<const char*> vertexShaderPaths;
         vertexShaderPaths.push_back("shaders/version330.glsl");
+        vertexShaderPaths.push_back("shaders/renderer/uniforms.glsl");
         vertexShaderPaths.push_back("shaders/gbuffer.vert");
         Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
 
@@ -187,27 +178,16 @@ void FirefliesApplication::InitializeDeferredMaterials()
         std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
         shaderProgramPtr->Build(vertexShader, fragmentShader);
 
-        // Get transform related uniform locations
-        ShaderProgram::Location worldViewMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldViewMatrix");
-        ShaderProgram::Location worldViewProjMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldViewProjMatrix");
-
-        // Register shader with renderer
+        // Register shader with renderer. The world matrix comes in an instance attribute, so fireflies are drawn instanced
+        // Camera uniforms are read from the FrameData block, so there are no transforms to update
         m_renderer.RegisterShaderProgram(shaderProgramPtr,
-            [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
-            {
-                shaderProgram.SetUniform(worldViewMatrixLocation, camera.GetViewMatrix() * worldMatrix);
-                shaderProgram.SetUniform(worldViewProjMatrixLocation, camera.GetViewProjectionMatrix() * worldMatrix);
-            },
-            nullptr
+            nullptr,
+            nullptr,
+            shaderProgramPtr->GetAttributeLocation("InstanceWorldMatrix")
         );
 
-        // Filter out uniforms that are not material properties
-        ShaderUniformCollection::NameSet filteredUniforms;
-        filteredUniforms.insert("WorldViewMatrix");
-        filteredUniforms.insert("WorldViewProjMatrix");
-
         // Create material
-        m_gbufferMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
+        m_gbufferMaterial = std::make_shared<Material>(shaderProgramPtr);
     }
 
     // Deferred material
@@ -219,6 +199,7 @@ void FirefliesApplication::InitializeDeferredMaterials()
 
         std::vector<const char*> fragmentShaderPaths;
         fragmentShaderPaths.push_back("shaders/version330.glsl");
+        fragmentShaderPaths.push_back("shaders/renderer/uniforms.glsl");
         fragmentShaderPaths.push_back("shaders/utils.glsl");
         fragmentShaderPaths.push_back("shaders/blinn-phong.glsl");
         fragmentShaderPaths.push_back("shaders/lighting.glsl");
@@ -230,31 +211,52 @@ void FirefliesApplication::InitializeDeferredMaterials()
 
         // Filter out uniforms that are not material properties
         ShaderUniformCollection::NameSet filteredUniforms;
-        filteredUniforms.insert("InvProjMatrix");
         filteredUniforms.insert("WorldViewProjMatrix");
 
-        // Get transform related uniform locations
-        ShaderProgram::Location invViewMatrixLocation = shaderProgramPtr->GetUniformLocation("InvViewMatrix");
-        ShaderProgram::Location invProjMatrixLocation = shaderProgramPtr->GetUniformLocation("InvProjMatrix");
-        ShaderProgram::Location worldViewProjMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldViewProjMatrix");
-
-        // Register shader with renderer
+        // Register shader with renderer. The renderer sets WorldViewProjMatrix
         m_renderer.RegisterShaderProgram(shaderProgramPtr,
-            [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
-            {
-                if (cameraChanged)
-                {
-                    shaderProgram.SetUniform(invViewMatrixLocation, glm::inverse(camera.GetViewMatrix()));
-                    shaderProgram.SetUniform(invProjMatrixLocation, glm::inverse(camera.GetProjectionMatrix()));
-                }
-                shaderProgram.SetUniform(worldViewProjMatrixLocation, camera.GetViewProjectionMatrix() * worldMatrix);
-            },
+            nullptr,
             GetUpdateLightsFunction(shaderProgramPtr)
         );
 
         // Create material
         m_deferredMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
     }
+
+    // Clustered deferred material
+    {
+        std::vector<const char*> vertexShaderPaths;
+        vertexShaderPaths.push_back("shaders/version330.glsl");
+        vertexShaderPaths.push_back("shaders/deferred.vert");
+        Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
+
+        std::vector<const char*> fragmentShaderPaths;
+        fragmentShaderPaths.push_back("shaders/version330.glsl");
+        fragmentShaderPaths.push_back("shaders/renderer/uniforms.glsl");
+        fragmentShaderPaths.push_back("shaders/utils.glsl");
+        fragmentShaderPaths.push_back("shaders/blinn-phong.glsl");
+        fragmentShaderPaths.push_back("shaders/clustered_lighting.glsl");
+        fragmentShaderPaths.push_back("shaders/deferred_clustered.frag");
+        Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load(fragmentShaderPaths);
+
+        std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
+        shaderProgramPtr->Build(vertexShader, fragmentShader);
+
+        // Filter out uniforms that are not material properties
+        ShaderUniformCollection::NameSet filteredUniforms;
+        filteredUniforms.insert("WorldViewProjMatrix");
+        filteredUniforms.insert("AmbientColor");
+
+        // Register shader with renderer. The renderer sets WorldViewProjMatrix
+        // The lights function only sets the ambient color, lights come from the cluster grid
+        m_renderer.RegisterShaderProgram(shaderProgramPtr,
+            nullptr,
+            GetUpdateLightsFunction(shaderProgramPtr)
+        );
+
+        // Create material
+        m_clusteredDeferredMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
+    }
 }
 
 void FirefliesApplication::InitializeModels()
@@ -308,21 +310,32 @@ void FirefliesApplication::InitializeRenderer()
         m_renderer.AddRenderPass(std::make_unique<ForwardRenderPass>());
         break;
     case RenderMode::Deferred:
+    case RenderMode::ClusteredDeferred:
         {
             // Set up deferred passes
             int width, height;
             GetMainWindow().GetDimensions(width, height);
             std::unique_ptr<GBufferRenderPass> gbufferRenderPass(std::make_unique<GBufferRenderPass>(width, height));
 
+            bool clustered = m_renderMode == RenderMode::ClusteredDeferred;
+            std::shared_ptr<Material> deferredMaterial = clustered ? m_clusteredDeferredMaterial : m_deferredMaterial;
+
             // Set the g-buffer textures as properties of the deferred material
-            m_deferredMaterial->SetUniformValue("DepthTexture", gbufferRenderPass->GetDepthTexture());
-            m_deferredMaterial->SetUniformValue("AlbedoTexture", gbufferRenderPass->GetAlbedoTexture());
-            m_deferredMaterial->SetUniformValue("NormalTexture", gbufferRenderPass->GetNormalTexture());
-            m_deferredMaterial->SetUniformValue("OthersTexture", gbufferRenderPass->GetOthersTexture());
+            deferredMaterial->SetUniformValue("DepthTexture", gbufferRenderPass->GetDepthTexture());
+            deferredMaterial->SetUniformValue("AlbedoTexture", gbufferRenderPass->GetAlbedoTexture());
+            deferredMaterial->SetUniformValue("NormalTexture", gbufferRenderPass->GetNormalTexture());
+            deferredMaterial->SetUniformValue("OthersTexture", gbufferRenderPass->GetOthersTexture());
 
             // Add the render passes
             m_renderer.AddRenderPass(std::move(gbufferRenderPass));
-            m_renderer.AddRenderPass(std::make_unique<DeferredRenderPass>(m_deferredMaterial));
+            if (clustered)
+            {
+                m_renderer.AddRenderPass(std::make_unique<ClusteredDeferredRenderPass>(deferredMaterial));
+            }
+            else
+            {
+                m_renderer.AddRenderPass(std::make_unique<DeferredRenderPass>(deferredMaterial));
+            }
             break;
         }
     }
@@ -338,6 +351,13 @@ void FirefliesApplication::RenderGUI()
     ImGui::ColorEdit3("Light color", &m_lightColor[0]);
     ImGui::DragFloat("Light intensity", &m_lightIntensity, 0.05f, 0.0f, 100.0f);
     ImGui::Checkbox("Use random color", &m_useRandomColor);
+    ImGui::Separator();
+    // Show how many state changes the renderer issued and skipped last frame
+    const Renderer::StateChangeCounters& counters = m_renderer.GetStateChangeCounters();
+    ImGui::Text("Shader programs: %u issued, %u skipped", counters.shaderProgramsIssued, counters.shaderProgramsSkipped);
+    ImGui::Text("Materials: %u issued, %u skipped", counters.materialsIssued, counters.materialsSkipped);
+    ImGui::Text("VAOs: %u issued, %u skipped", counters.vaosIssued, counters.vaosSkipped);
+    ImGui::Text("Transforms: %u issued, %u skipped", counters.transformsIssued, counters.transformsSkipped);
 
     m_imGui.EndFrame();
 }
@@ -47,7 +47,9 @@ private:
     enum class RenderMode
     {
         Forward,
-        Deferred
+        Deferred,
+        // Deferred, with all the lights in a single pass using a clustered light grid
+        ClusteredDeferred
     };
     RenderMode m_renderMode;
 
@@ -61,6 +63,7 @@ private:
     std::shared_ptr<Material> m_forwardMaterial;
     std::shared_ptr<Material> m_gbufferMaterial;
     std::shared_ptr<Material> m_deferredMaterial;
+    std::shared_ptr<Material> m_clusteredDeferredMaterial;
 
     // Loaded models
     Model m_floorModel;
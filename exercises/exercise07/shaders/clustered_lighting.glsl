@@ -0,0 +1,117 @@
+
+// Lights and light clusters, filled by ClusteredDeferredRenderPass
+uniform samplerBuffer LightDataBuffer;
+uniform usamplerBuffer LightIndexBuffer;
+uniform usamplerBuffer ClusterBuffer;
+uniform ivec3 ClusterGridSize;
+uniform vec2 ClusterDepthParams;
+uniform int GlobalLightCount;
+
+struct LightData
+{
+	vec3 color;
+	vec3 position;
+	vec3 direction;
+	vec4 attenuation;
+};
+
+LightData GetLightData(int lightIndex)
+{
+	// 4 texels per light
+	int texel = lightIndex * 4;
+
+	LightData light;
+	light.color = texelFetch(LightDataBuffer, texel).rgb;
+	light.position = texelFetch(LightDataBuffer, texel + 1).xyz;
+	light.direction = texelFetch(LightDataBuffer, texel + 2).xyz;
+	light.attenuation = texelFetch(LightDataBuffer, texel + 3);
+	return light;
+}
+
+// Index of the cluster that contains a pixel, using its view depth (positive)
+int GetClusterIndex(vec2 fragCoord, float viewDepth)
+{
+	ivec2 tile = ivec2(fragCoord * InvTargetSize * vec2(ClusterGridSize.xy));
+	tile = clamp(tile, ivec2(0), ClusterGridSize.xy - 1);
+
+	int slice = int(floor(log(viewDepth) * ClusterDepthParams.x + ClusterDepthParams.y));
+	slice = clamp(slice, 0, ClusterGridSize.z - 1);
+
+	return (slice * ClusterGridSize.y + tile.y) * ClusterGridSize.x + tile.x;
+}
+
+float ComputeDistanceAttenuation(LightData light, vec3 position)
+{
+	// Compute distance attenuation, reading the range from attenuation.x (fade start) and attenuation.y (fade end)
+	return smoothstep(light.attenuation.y, light.attenuation.x, distance(position, light.position));
+}
+
+float ComputeAngularAttenuation(LightData light, vec3 lightDir)
+{
+	float angle = acos(dot(light.direction, lightDir));
+	vec2 attAngle = light.attenuation.zw;
+	return smoothstep(attAngle.y, attAngle.x, angle);
+}
+
+float ComputeAttenuation(LightData light, vec3 position, vec3 lightDir)
+{
+	float attenuation = 1.0f;
+	if (light.attenuation.y > 0)
+	{
+		attenuation *= ComputeDistanceAttenuation(light, position);
+	}
+	if (light.attenuation.w > 0)
+	{
+		attenuation *= ComputeAngularAttenuation(light, lightDir);
+	}
+	return attenuation;
+}
+
+vec3 ComputeLightDirection(LightData light, vec3 position)
+{
+	return light.attenuation.y >= 0 ? GetDirection(position, light.position) : light.direction;
+}
+
+vec3 ComputeLight(LightData light, SurfaceData data, vec3 viewDir, vec3 position)
+{
+	vec3 lightDir = ComputeLightDirection(light, position);
+
+	vec3 lighting = vec3(0);
+	lighting += ComputeDiffuseLighting(data, lightDir);
+	lighting += ComputeSpecularLighting(data, lightDir, viewDir);
+
+	float attenuation = ComputeAttenuation(light, position, lightDir);
+	return lighting * light.color * attenuation;
+}
+
+vec3 ComputeLight(int lightListIndex, SurfaceData data, vec3 viewDir, vec3 position)
+{
+	int lightIndex = int(texelFetch(LightIndexBuffer, lightListIndex).r);
+	return ComputeLight(GetLightData(lightIndex), data, viewDir, position);
+}
+
+// Add the global lights and the lights in the cluster
+vec3 ComputeLighting(vec3 position, SurfaceData data, vec3 viewDir, bool indirect, int clusterIndex)
+{
+	vec3 light = vec3(0);
+
+	if (indirect)
+	{
+		light += ComputeDiffuseIndirectLighting(data);
+		light += ComputeSpecularIndirectLighting(data, viewDir);
+	}
+
+	for (int i = 0; i < GlobalLightCount; ++i)
+	{
+		light += ComputeLight(i, data, viewDir, position);
+	}
+
+	// Offset and count of the cluster lights
+	uvec2 cluster = texelFetch(ClusterBuffer, clusterIndex).rg;
+	for (int i = 0; i < int(cluster.y); ++i)
+	{
+		light += ComputeLight(int(cluster.x) + i, data, viewDir, position);
+	}
+
+	return light;
+}
@@ -0,0 +1,44 @@
+//Outputs
+out vec4 FragColor;
+
+//Uniforms
+uniform sampler2D DepthTexture;
+uniform sampler2D AlbedoTexture;
+uniform sampler2D NormalTexture;
+uniform sampler2D OthersTexture;
+
+void main()
+{
+	// Texture coordinates from the pixel position
+	vec2 TexCoord = gl_FragCoord.xy * InvTargetSize;
+
+	// Extract information from g-buffers
+	vec3 position = ReconstructViewPosition(DepthTexture, TexCoord, InvProjMatrix);
+	vec3 albedo = texture(AlbedoTexture, TexCoord).rgb;
+	vec3 normal = GetImplicitNormal(texture(NormalTexture, TexCoord).xy);
+	vec4 others = texture(OthersTexture, TexCoord);
+
+	// Find the light cluster, with the depth in view space
+	int clusterIndex = GetClusterIndex(gl_FragCoord.xy, -position.z);
+
+	// Compute view vector en view space
+	vec3 viewDir = GetDirection(position, vec3(0));
+
+	// Convert position, normal and view vector to world space
+	position = (InvViewMatrix * vec4(position, 1)).xyz;
+	normal = (InvViewMatrix * vec4(normal, 0)).xyz;
+	viewDir = (InvViewMatrix * vec4(viewDir, 0)).xyz;
+
+	// Set surface material data
+	SurfaceData data;
+	data.normal = normal;
+	data.reflectionColor = albedo;
+	data.ambientReflectance = others.x;
+	data.diffuseReflectance = others.y;
+	data.specularReflectance = others.z;
+	data.specularExponent = (1.0f / others.w) - 1.0f;
+
+	// Compute lighting from all the lights in the cluster
+	vec3 lighting = ComputeLighting(position, data, viewDir, true, clusterIndex);
+	FragColor = vec4(lighting, 1.0f);
+}
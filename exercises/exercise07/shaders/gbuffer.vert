@@ -2,23 +2,22 @@
 layout (location = 0) in vec3 VertexPosition;
 layout (location = 1) in vec3 VertexNormal;
 layout (location = 2) in vec2 VertexTexCoord;
+layout (location = 8) in mat4 InstanceWorldMatrix;
 
 //Outputs
 out vec3 ViewNormal;
 out vec2 TexCoord;
 
-//Uniforms
-uniform mat4 WorldViewMatrix;
-uniform mat4 WorldViewProjMatrix;
-
 void main()
 {
+	mat4 worldViewMatrix = ViewMatrix * InstanceWorldMatrix;
+
 	// normal in view space (for lighting computation)
-	ViewNormal = normalize((WorldViewMatrix * vec4(VertexNormal, 0.0)).xyz);
+	ViewNormal = normalize((worldViewMatrix * vec4(VertexNormal, 0.0)).xyz);
 
 	// texture coordinates
 	TexCoord = VertexTexCoord;
 
 	// final vertex position (for opengl rendering, not for lighting)
-	gl_Position = WorldViewProjMatrix * vec4(VertexPosition, 1.0);
+	gl_Position = ViewProjMatrix * InstanceWorldMatrix * vec4(VertexPosition, 1.0);
 }
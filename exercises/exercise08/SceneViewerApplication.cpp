@@ -26,6 +26,14 @@
 SceneViewerApplication::SceneViewerApplication()
     : Application(1024, 1024, "Scene Viewer demo")
     , m_renderer(GetDevice())
+    , m_forwardRenderPass(nullptr)
+    , m_depthPrepass(false)
+    , m_retainedSceneRegistry(m_renderer)
+    , m_retainedModels(false)
+    , m_frustumCulling(true)
+    , m_visibleModelCount(0)
+    , m_culledModelCount(0)
+    , m_levelsOfDetail(true)
 {
 }
 
@@ -50,9 +58,37 @@ void SceneViewerApplication::Update()
     // Update camera controller
     m_cameraController.Update(GetMainWindow(), GetDeltaTime());
 
-    // Add the scene nodes to the renderer
+    // Register the models once, or send the ones that moved
+    if (m_retainedModels)
+    {
+        if (m_retainedSceneRegistry.GetModelCount() == 0)
+        {
+            m_scene.AcceptVisitor(m_retainedSceneRegistry);
+        }
+        m_retainedSceneRegistry.Update();
+    }
+    else
+    {
+        m_retainedSceneRegistry.Clear();
+    }
+
+    // Add the scene nodes to the renderer. Retained models are already there
     RendererSceneVisitor rendererSceneVisitor(m_renderer);
-    m_scene.AcceptVisitor(rendererSceneVisitor);
+    rendererSceneVisitor.SetModelsEnabled(!m_retainedModels);
+    if (m_frustumCulling)
+    {
+        rendererSceneVisitor.EnableFrustumCulling(*m_cameraController.GetCamera()->GetCamera());
+    }
+    if (m_levelsOfDetail)
+    {
+        rendererSceneVisitor.EnableLodSelection(*m_cameraController.GetCamera()->GetCamera());
+    }
+    rendererSceneVisitor.VisitParallel(m_scene);
+    m_visibleModelCount = m_retainedModels ? m_retainedSceneRegistry.GetModelCount() : rendererSceneVisitor.GetVisibleModelCount();
+    m_culledModelCount = rendererSceneVisitor.GetCulledModelCount();
+
+    // Sort the drawcalls by render state and depth. Retained drawcalls are only sorted when they change or the camera moves
+    m_renderer.SortDrawcallCollection(0);
 }
 
 void SceneViewerApplication::Render()
@@ -113,11 +149,13 @@ void SceneViewerApplication::InitializeMaterial()
     // Load and build shader
     std::vector<const char*> vertexShaderPaths;
     vertexShaderPaths.push_back("shaders/version330.glsl");
+    vertexShaderPaths.push_back("shaders/renderer/uniforms.glsl");
     vertexShaderPaths.push_back("shaders/default.vert");
     Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
 
     std::vector<const char*> fragmentShaderPaths;
     fragmentShaderPaths.push_back("shaders/version330.glsl");
+    fragmentShaderPaths.push_back("shaders/renderer/uniforms.glsl");
     fragmentShaderPaths.push_back("shaders/utils.glsl");
     fragmentShaderPaths.push_back("shaders/lambert-ggx.glsl");
     fragmentShaderPaths.push_back("shaders/lighting.glsl");
@@ -127,30 +165,15 @@ void SceneViewerApplication::InitializeMaterial()
     std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
     shaderProgramPtr->Build(vertexShader, fragmentShader);
 
-    // Get transform related uniform locations
-    ShaderProgram::Location cameraPositionLocation = shaderProgramPtr->GetUniformLocation("CameraPosition");
-    ShaderProgram::Location worldMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldMatrix");
-    ShaderProgram::Location viewProjMatrixLocation = shaderProgramPtr->GetUniformLocation("ViewProjMatrix");
-
-    // Register shader with renderer
+    // Register shader with renderer. The renderer sets WorldMatrix, camera uniforms are read from the FrameData block
     m_renderer.RegisterShaderProgram(shaderProgramPtr,
-        [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
-        {
-            if (cameraChanged)
-            {
-                shaderProgram.SetUniform(cameraPositionLocation, camera.ExtractTranslation());
-                shaderProgram.SetUniform(viewProjMatrixLocation, camera.GetViewProjectionMatrix());
-            }
-            shaderProgram.SetUniform(worldMatrixLocation, worldMatrix);
-        },
+        nullptr,
         m_renderer.GetDefaultUpdateLightsFunction(*shaderProgramPtr)
     );
 
     // Filter out uniforms that are not material properties
     ShaderUniformCollection::NameSet filteredUniforms;
-    filteredUniforms.insert("CameraPosition");
     filteredUniforms.insert("WorldMatrix");
-    filteredUniforms.insert("ViewProjMatrix");
     filteredUniforms.insert("LightIndirect");
     filteredUniforms.insert("LightColor");
     filteredUniforms.insert("LightPosition");
@@ -160,6 +183,28 @@ void SceneViewerApplication::InitializeMaterial()
     // Create reference material
     assert(shaderProgramPtr);
     m_defaultMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
+
+    // Depth only shader, with the same position as the default vertex shader
+    std::vector<const char*> depthVertexShaderPaths;
+    depthVertexShaderPaths.push_back("shaders/version330.glsl");
+    depthVertexShaderPaths.push_back("shaders/renderer/uniforms.glsl");
+    depthVertexShaderPaths.push_back("shaders/renderer/depth.vert");
+    Shader depthVertexShader = ShaderLoader(Shader::VertexShader).Load(depthVertexShaderPaths);
+
+    std::vector<const char*> depthFragmentShaderPaths;
+    depthFragmentShaderPaths.push_back("shaders/version330.glsl");
+    depthFragmentShaderPaths.push_back("shaders/renderer/depth.frag");
+    Shader depthFragmentShader = ShaderLoader(Shader::FragmentShader).Load(depthFragmentShaderPaths);
+
+    std::shared_ptr<ShaderProgram> depthShaderProgramPtr = std::make_shared<ShaderProgram>();
+    depthShaderProgramPtr->Build(depthVertexShader, depthFragmentShader);
+
+    // The renderer sets WorldMatrix, and there are no lights
+    m_renderer.RegisterShaderProgram(depthShaderProgramPtr, nullptr, nullptr);
+
+    ShaderUniformCollection::NameSet depthFilteredUniforms;
+    depthFilteredUniforms.insert("WorldMatrix");
+    m_depthMaterial = std::make_shared<Material>(depthShaderProgramPtr, depthFilteredUniforms);
 }
 
 void SceneViewerApplication::InitializeModels()
@@ -199,6 +244,13 @@ void SceneViewerApplication::InitializeModels()
     loader.SetMaterialProperty(ModelLoader::MaterialProperty::NormalTexture, "NormalTexture");
     loader.SetMaterialProperty(ModelLoader::MaterialProperty::SpecularTexture, "SpecularTexture");
 
+    // Generate 3 simplified levels of detail in the renderer threads, and keep them in the build folder for the next run
+    loader.SetLodGeneration(3);
+    loader.SetThreadPool(&m_renderer.GetThreadPool());
+#ifdef LOD_CACHE_DIR
+    loader.SetLodCacheDirectory(LOD_CACHE_DIR);
+#endif
+
     // Load models
     std::shared_ptr<Model> chestModel = loader.LoadShared("models/treasure_chest/treasure_chest.obj");
     m_scene.AddSceneNode(std::make_shared<SceneModel>("treasure chest", chestModel));
@@ -215,7 +267,9 @@ void SceneViewerApplication::InitializeModels()
 
 void SceneViewerApplication::InitializeRenderer()
 {
-    m_renderer.AddRenderPass(std::make_unique<ForwardRenderPass>());
+    std::unique_ptr<ForwardRenderPass> forwardRenderPass = std::make_unique<ForwardRenderPass>();
+    m_forwardRenderPass = forwardRenderPass.get();
+    m_renderer.AddRenderPass(std::move(forwardRenderPass));
     m_renderer.AddRenderPass(std::make_unique<SkyboxRenderPass>(m_skyboxTexture));
 }
 
@@ -230,5 +284,30 @@ void SceneViewerApplication::RenderGUI()
     // Draw GUI for camera controller
     m_cameraController.DrawGUI(m_imGui);
 
+    // Draw GUI for the frame and render pass timings
+    GetProfiler().DrawGUI(m_imGui);
+
+    // Show how many state changes the renderer issued and skipped last frame
+    if (auto window = m_imGui.UseWindow("Renderer"))
+    {
+        const Renderer::StateChangeCounters& counters = m_renderer.GetStateChangeCounters();
+        ImGui::Text("Shader programs: %u issued, %u skipped", counters.shaderProgramsIssued, counters.shaderProgramsSkipped);
+        ImGui::Text("Materials: %u issued, %u skipped", counters.materialsIssued, counters.materialsSkipped);
+        ImGui::Text("VAOs: %u issued, %u skipped", counters.vaosIssued, counters.vaosSkipped);
+        ImGui::Text("Transforms: %u issued, %u skipped", counters.transformsIssued, counters.transformsSkipped);
+        ImGui::Checkbox("Frustum culling", &m_frustumCulling);
+        ImGui::Text("Models: %u visible, %u culled", m_visibleModelCount, m_culledModelCount);
+        ImGui::Checkbox("Levels of detail", &m_levelsOfDetail);
+        if (ImGui::Checkbox("Depth pre-pass", &m_depthPrepass))
+        {
+            m_forwardRenderPass->SetDepthPrepassMaterial(m_depthPrepass ? m_depthMaterial : nullptr);
+        }
+        ImGui::Checkbox("Retained models", &m_retainedModels);
+        if (m_retainedModels)
+        {
+            ImGui::Text("Retained models updated: %u", m_retainedSceneRegistry.GetUpdatedModelCount());
+        }
+    }
+
     m_imGui.EndFrame();
 }
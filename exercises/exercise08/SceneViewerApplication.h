@@ -4,11 +4,13 @@
 
 #include <ituGL/scene/Scene.h>
 #include <ituGL/renderer/Renderer.h>
+#include <ituGL/scene/RetainedSceneRegistry.h>
 #include <ituGL/camera/CameraController.h>
 #include <ituGL/utils/DearImGui.h>
 
 class TextureCubemapObject;
 class Material;
+class ForwardRenderPass;
 
 class SceneViewerApplication : public Application
 {
@@ -48,4 +50,21 @@ private:
 
     // Default material
     std::shared_ptr<Material> m_defaultMaterial;
+
+    // Depth only material for the depth pre-pass of the forward pass, owned by the renderer
+    std::shared_ptr<Material> m_depthMaterial;
+    ForwardRenderPass* m_forwardRenderPass;
+    bool m_depthPrepass;
+
+    // Keep the models in the renderer between frames, only updating the ones that moved. There is no culling then
+    RetainedSceneRegistry m_retainedSceneRegistry;
+    bool m_retainedModels;
+
+    // Skip the models outside the camera frustum, and how many were skipped last frame
+    bool m_frustumCulling;
+    unsigned int m_visibleModelCount;
+    unsigned int m_culledModelCount;
+
+    // Draw the models with their simplified levels of detail when they are small on screen
+    bool m_levelsOfDetail;
 };
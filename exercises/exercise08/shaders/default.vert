@@ -14,7 +14,9 @@ out vec2 TexCoord;
 
 //Uniforms
 uniform mat4 WorldMatrix;
-uniform mat4 ViewProjMatrix;
+
+// Same position as the depth pre-pass, so the lighting can test depth with GL_EQUAL
+invariant gl_Position;
 
 void main()
 {
@@ -0,0 +1,4 @@
+// Only depth is written, color writes are disabled during the pre-pass
+void main()
+{
+}
@@ -0,0 +1,15 @@
+//Inputs
+layout (location = 0) in vec3 VertexPosition;
+
+//Uniforms
+uniform mat4 WorldMatrix;
+
+// Must match the position of the materials drawn after the pre-pass
+invariant gl_Position;
+
+void main()
+{
+	// Same operations as default.vert
+	vec3 WorldPosition = (WorldMatrix * vec4(VertexPosition, 1.0)).xyz;
+	gl_Position = ViewProjMatrix * vec4(WorldPosition, 1.0);
+}
@@ -0,0 +1,23 @@
+// Uniform blocks shared by all the shader programs registered in the renderer
+// The members must match the layouts built in Renderer::InitializeUniformBlocks
+
+// Camera data, updated once per frame
+layout (std140) uniform FrameData
+{
+	mat4 ViewMatrix;
+	mat4 ProjMatrix;
+	mat4 ViewProjMatrix;
+	mat4 InvViewMatrix;
+	mat4 InvProjMatrix;
+	vec3 CameraPosition;
+};
+
+// Render target data, updated when it changes between passes
+layout (std140) uniform PassData
+{
+	vec2 TargetSize;
+	vec2 InvTargetSize;
+	// Part of the render targets rendered this frame, to scale the texture coordinates (dynamic resolution)
+	vec2 ResolutionScale;
+};
+
@@ -15,20 +15,29 @@
 #include <ituGL/shader/Material.h>
 #include <ituGL/geometry/Model.h>
 #include <ituGL/scene/SceneModel.h>
+#include <ituGL/scene/Transform.h>
 
 #include <ituGL/renderer/SkyboxRenderPass.h>
 #include <ituGL/renderer/GBufferRenderPass.h>
 #include <ituGL/renderer/DeferredRenderPass.h>
 #include <ituGL/renderer/PostFXRenderPass.h>
+#include <ituGL/renderer/WeightedBlendedOITRenderPass.h>
 #include <ituGL/scene/RendererSceneVisitor.h>
 
 #include <ituGL/scene/ImGuiSceneVisitor.h>
+#include <ituGL/texture/FramebufferObject.h>
+#include <ituGL/utils/ImageWriter.h>
 #include <imgui.h>
+#include <iostream>
+#include <string>
 
 PostFXSceneViewerApplication::PostFXSceneViewerApplication()
     : Application(1024, 1024, "Post FX Scene Viewer demo")
     , m_renderer(GetDevice())
-    , m_sceneFramebuffer(std::make_shared<FramebufferObject>())
+    , m_renderGraph(nullptr)
+    , m_dynamicResolutionEnabled(true)
+    , m_screenshotRequested(false)
+    , m_screenshotCount(0)
     , m_exposure(1.0f)
     , m_contrast(1.0f)
     , m_hueShift(0.0f)
@@ -61,9 +70,22 @@ void PostFXSceneViewerApplication::Update()
     // Update camera controller
     m_cameraController.Update(GetMainWindow(), GetDeltaTime());
 
+    // The render graph allocates its textures again if the window size changed
+    int width, height;
+    GetMainWindow().GetDimensions(width, height);
+    m_renderGraph->SetSize(width, height);
+
+    // Render a smaller part of the textures when the GPU is slower than the budget. The compose pass scales it up
+    float resolutionScale = m_dynamicResolutionEnabled ? m_dynamicResolution.Update(GetProfiler()) : 1.0f;
+    m_renderGraph->SetResolutionScale(resolutionScale);
+
     // Add the scene nodes to the renderer
     RendererSceneVisitor rendererSceneVisitor(m_renderer);
+    rendererSceneVisitor.EnableFrustumCulling(*m_cameraController.GetCamera()->GetCamera());
     m_scene.AcceptVisitor(rendererSceneVisitor);
+
+    // Sort the opaque drawcalls by render state and depth. The translucent ones don't need any order
+    m_renderer.SortDrawcallCollection(0);
 }
 
 void PostFXSceneViewerApplication::Render()
@@ -75,12 +97,23 @@ void PostFXSceneViewerApplication::Render()
     // Render the scene
     m_renderer.Render();
 
+    // Capture before the GUI is drawn on top
+    if (m_screenshotRequested)
+    {
+        SaveScreenshot();
+        m_screenshotRequested = false;
+    }
+    m_readbackQueue.Poll();
+
     // Render the debug user interface
     RenderGUI();
 }
 
 void PostFXSceneViewerApplication::Cleanup()
 {
+    // Save the screenshots that are still pending
+    m_readbackQueue.Finish();
+
     // Cleanup DearImGUI
     m_imGui.Cleanup();
 
@@ -138,17 +171,9 @@ void PostFXSceneViewerApplication::InitializeMaterials()
         std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
         shaderProgramPtr->Build(vertexShader, fragmentShader);
 
-        // Get transform related uniform locations
-        ShaderProgram::Location worldViewMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldViewMatrix");
-        ShaderProgram::Location worldViewProjMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldViewProjMatrix");
-
-        // Register shader with renderer
+        // Register shader with renderer. The renderer sets the transform matrices, computed for all the models at once
         m_renderer.RegisterShaderProgram(shaderProgramPtr,
-            [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
-            {
-                shaderProgram.SetUniform(worldViewMatrixLocation, camera.GetViewMatrix() * worldMatrix);
-                shaderProgram.SetUniform(worldViewProjMatrixLocation, camera.GetViewProjectionMatrix() * worldMatrix);
-            },
+            nullptr,
             nullptr
         );
 
@@ -156,12 +181,49 @@ void PostFXSceneViewerApplication::InitializeMaterials()
         ShaderUniformCollection::NameSet filteredUniforms;
         filteredUniforms.insert("WorldViewMatrix");
         filteredUniforms.insert("WorldViewProjMatrix");
+        filteredUniforms.insert("NormalMatrix");
 
         // Create material
         m_defaultMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
         m_defaultMaterial->SetUniformValue("Color", glm::vec3(1.0f));
     }
 
+    // Glass material, for the order-independent transparency pass
+    {
+        std::vector<const char*> vertexShaderPaths;
+        vertexShaderPaths.push_back("shaders/version330.glsl");
+        vertexShaderPaths.push_back("shaders/default.vert");
+        Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
+
+        std::vector<const char*> fragmentShaderPaths;
+        fragmentShaderPaths.push_back("shaders/version330.glsl");
+        fragmentShaderPaths.push_back("shaders/utils.glsl");
+        fragmentShaderPaths.push_back("shaders/oit.glsl");
+        fragmentShaderPaths.push_back("shaders/glass.frag");
+        Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load(fragmentShaderPaths);
+
+        std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
+        shaderProgramPtr->Build(vertexShader, fragmentShader);
+
+        m_renderer.RegisterShaderProgram(shaderProgramPtr,
+            nullptr,
+            nullptr
+        );
+
+        ShaderUniformCollection::NameSet filteredUniforms;
+        filteredUniforms.insert("WorldViewMatrix");
+        filteredUniforms.insert("WorldViewProjMatrix");
+        filteredUniforms.insert("NormalMatrix");
+
+        m_glassMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
+        m_glassMaterial->SetUniformValue("Color", glm::vec3(1.0f));
+        m_glassMaterial->SetUniformValue("Opacity", 0.3f);
+
+        // Blending marks the material as translucent. The OIT pass replaces it with its own blending
+        m_glassMaterial->SetBlendEquation(Material::BlendEquation::Add);
+        m_glassMaterial->SetBlendParams(Material::BlendParam::SourceAlpha, Material::BlendParam::OneMinusSourceAlpha);
+    }
+
     // Deferred material
     {
         std::vector<const char*> vertexShaderPaths;
@@ -171,6 +233,7 @@ void PostFXSceneViewerApplication::InitializeMaterials()
 
         std::vector<const char*> fragmentShaderPaths;
         fragmentShaderPaths.push_back("shaders/version330.glsl");
+        fragmentShaderPaths.push_back("shaders/renderer/uniforms.glsl");
         fragmentShaderPaths.push_back("shaders/utils.glsl");
         fragmentShaderPaths.push_back("shaders/lambert-ggx.glsl");
         fragmentShaderPaths.push_back("shaders/lighting.glsl");
@@ -182,8 +245,6 @@ void PostFXSceneViewerApplication::InitializeMaterials()
 
         // Filter out uniforms that are not material properties
         ShaderUniformCollection::NameSet filteredUniforms;
-        filteredUniforms.insert("InvViewMatrix");
-        filteredUniforms.insert("InvProjMatrix");
         filteredUniforms.insert("WorldViewProjMatrix");
         filteredUniforms.insert("LightIndirect");
         filteredUniforms.insert("LightColor");
@@ -191,22 +252,9 @@ void PostFXSceneViewerApplication::InitializeMaterials()
         filteredUniforms.insert("LightDirection");
         filteredUniforms.insert("LightAttenuation");
 
-        // Get transform related uniform locations
-        ShaderProgram::Location invViewMatrixLocation = shaderProgramPtr->GetUniformLocation("InvViewMatrix");
-        ShaderProgram::Location invProjMatrixLocation = shaderProgramPtr->GetUniformLocation("InvProjMatrix");
-        ShaderProgram::Location worldViewProjMatrixLocation = shaderProgramPtr->GetUniformLocation("WorldViewProjMatrix");
-
-        // Register shader with renderer
+        // Register shader with renderer. The renderer sets WorldViewProjMatrix
         m_renderer.RegisterShaderProgram(shaderProgramPtr,
-            [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
-            {
-                if (cameraChanged)
-                {
-                    shaderProgram.SetUniform(invViewMatrixLocation, glm::inverse(camera.GetViewMatrix()));
-                    shaderProgram.SetUniform(invProjMatrixLocation, glm::inverse(camera.GetProjectionMatrix()));
-                }
-                shaderProgram.SetUniform(worldViewProjMatrixLocation, camera.GetViewProjectionMatrix() * worldMatrix);
-            },
+            nullptr,
             m_renderer.GetDefaultUpdateLightsFunction(*shaderProgramPtr)
         );
 
@@ -253,46 +301,23 @@ void PostFXSceneViewerApplication::InitializeModels()
     // Load models
     std::shared_ptr<Model> cannonModel = loader.LoadShared("models/cannon/cannon.obj");
     m_scene.AddSceneNode(std::make_shared<SceneModel>("cannon", cannonModel));
-}
-
-void PostFXSceneViewerApplication::InitializeFramebuffers()
-{
-    int width, height;
-    GetMainWindow().GetDimensions(width, height);
 
-    // Scene Texture
-    m_sceneTexture = std::make_shared<Texture2DObject>();
-    m_sceneTexture->Bind();
-    m_sceneTexture->SetImage(0, width, height, TextureObject::FormatRGBA, TextureObject::InternalFormat::InternalFormatRGBA16F);
-    m_sceneTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_LINEAR);
-    m_sceneTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_LINEAR);
-    Texture2DObject::Unbind();
-
-    // Scene framebuffer
-    m_sceneFramebuffer->Bind();
-    m_sceneFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Depth, *m_depthTexture);
-    m_sceneFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color0, *m_sceneTexture);
-    m_sceneFramebuffer->SetDrawBuffers(std::array<FramebufferObject::Attachment, 1>({ FramebufferObject::Attachment::Color0 }));
-    FramebufferObject::Unbind();
-
-    // Add temp textures and frame buffers
-    for (int i = 0; i < m_tempFramebuffers.size(); ++i)
-    {
-        m_tempTextures[i] = std::make_shared<Texture2DObject>();
-        m_tempTextures[i]->Bind();
-        m_tempTextures[i]->SetImage(0, width, height, TextureObject::FormatRGBA, TextureObject::InternalFormat::InternalFormatRGBA16F);
-        m_tempTextures[i]->SetParameter(TextureObject::ParameterEnum::WrapS, GL_CLAMP_TO_EDGE);
-        m_tempTextures[i]->SetParameter(TextureObject::ParameterEnum::WrapT, GL_CLAMP_TO_EDGE);
-        m_tempTextures[i]->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_LINEAR);
-        m_tempTextures[i]->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_LINEAR);
-
-        m_tempFramebuffers[i] = std::make_shared<FramebufferObject>();
-        m_tempFramebuffers[i]->Bind();
-        m_tempFramebuffers[i]->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color0, *m_tempTextures[i]);
-        m_tempFramebuffers[i]->SetDrawBuffers(std::array<FramebufferObject::Attachment, 1>({ FramebufferObject::Attachment::Color0 }));
-    }
-    Texture2DObject::Unbind();
-    FramebufferObject::Unbind();
+    // Same model with copies of the glass material, keeping only the color
+    ModelLoader glassLoader(m_glassMaterial);
+    glassLoader.SetCreateMaterials(true);
+    glassLoader.GetTexture2DLoader().SetFlipVertical(true);
+    glassLoader.SetMaterialAttribute(VertexAttribute::Semantic::Position, "VertexPosition");
+    glassLoader.SetMaterialAttribute(VertexAttribute::Semantic::Normal, "VertexNormal");
+    glassLoader.SetMaterialAttribute(VertexAttribute::Semantic::Tangent, "VertexTangent");
+    glassLoader.SetMaterialAttribute(VertexAttribute::Semantic::Bitangent, "VertexBitangent");
+    glassLoader.SetMaterialAttribute(VertexAttribute::Semantic::TexCoord0, "VertexTexCoord");
+    glassLoader.SetMaterialProperty(ModelLoader::MaterialProperty::DiffuseColor, "Color");
+    glassLoader.SetMaterialProperty(ModelLoader::MaterialProperty::DiffuseTexture, "ColorTexture");
+
+    std::shared_ptr<Model> glassCannonModel = glassLoader.LoadShared("models/cannon/cannon.obj");
+    std::shared_ptr<SceneModel> glassCannon = std::make_shared<SceneModel>("glass cannon", glassCannonModel);
+    glassCannon->GetTransform()->SetTranslation(glm::vec3(1.5f, 0.0f, 1.5f));
+    m_scene.AddSceneNode(glassCannon);
 }
 
 void PostFXSceneViewerApplication::InitializeRenderer()
@@ -300,53 +325,126 @@ void PostFXSceneViewerApplication::InitializeRenderer()
     int width, height;
     GetMainWindow().GetDimensions(width, height);
 
+    // Opaque drawcalls go to the g-buffer, translucent ones to the order-independent transparency pass, unsorted
+    m_renderer.SetDrawcallCollectionSupportedFunction(0, [](const Renderer::DrawcallInfo& drawcallInfo)
+        {
+            return !drawcallInfo.GetMaterial().HasBlend();
+        });
+    unsigned int translucentCollection = m_renderer.AddDrawcallCollection([](const Renderer::DrawcallInfo& drawcallInfo)
+        {
+            return drawcallInfo.GetMaterial().HasBlend();
+        });
+    m_renderer.SetDrawcallCollectionOrderIndependent(translucentCollection, true);
+
+    std::unique_ptr<RenderGraph> renderGraph = std::make_unique<RenderGraph>(width, height);
+
+    // Textures of the graph. Only the final image goes to the backbuffer, the rest are transient
+    RenderGraph::TextureDesc depthDesc;
+    depthDesc.format = TextureObject::FormatDepth;
+    depthDesc.internalFormat = TextureObject::InternalFormatDepth;
+    RenderGraph::TextureDesc albedoDesc;
+    albedoDesc.internalFormat = TextureObject::InternalFormatSRGBA8;
+    RenderGraph::TextureDesc normalDesc;
+    normalDesc.format = TextureObject::FormatRG;
+    normalDesc.internalFormat = TextureObject::InternalFormatRG16F;
+    RenderGraph::TextureDesc sceneDesc;
+    // Bloom is computed at half resolution
+    RenderGraph::TextureDesc bloomDesc;
+    bloomDesc.scale = glm::vec2(0.5f);
+
+    RenderGraph::ResourceId depthTexture = renderGraph->CreateTexture("Depth", depthDesc);
+    RenderGraph::ResourceId albedoTexture = renderGraph->CreateTexture("Albedo", albedoDesc);
+    RenderGraph::ResourceId normalTexture = renderGraph->CreateTexture("Normal", normalDesc);
+    RenderGraph::ResourceId othersTexture = renderGraph->CreateTexture("Others", albedoDesc);
+    RenderGraph::ResourceId sceneTexture = renderGraph->CreateTexture("Scene", sceneDesc);
+
     // Set up deferred passes
     {
-        std::unique_ptr<GBufferRenderPass> gbufferRenderPass(std::make_unique<GBufferRenderPass>(width, height));
-
-        // Set the g-buffer textures as properties of the deferred material
-        m_deferredMaterial->SetUniformValue("DepthTexture", gbufferRenderPass->GetDepthTexture());
-        m_deferredMaterial->SetUniformValue("AlbedoTexture", gbufferRenderPass->GetAlbedoTexture());
-        m_deferredMaterial->SetUniformValue("NormalTexture", gbufferRenderPass->GetNormalTexture());
-        m_deferredMaterial->SetUniformValue("OthersTexture", gbufferRenderPass->GetOthersTexture());
-
-        // Get the depth texture from the gbuffer pass - This could be reworked
-        m_depthTexture = gbufferRenderPass->GetDepthTexture();
-
-        // Add the render passes
-        m_renderer.AddRenderPass(std::move(gbufferRenderPass));
-        m_renderer.AddRenderPass(std::make_unique<DeferredRenderPass>(m_deferredMaterial, m_sceneFramebuffer));
+        unsigned int gbufferPass = renderGraph->AddPass(std::make_unique<GBufferRenderPass>());
+        renderGraph->WriteTexture(gbufferPass, albedoTexture);
+        renderGraph->WriteTexture(gbufferPass, normalTexture);
+        renderGraph->WriteTexture(gbufferPass, othersTexture);
+        renderGraph->WriteTexture(gbufferPass, depthTexture);
+
+        // The g-buffer textures are set as properties of the deferred material when the graph is compiled
+        // Depth is also attached, so the skybox can be depth tested after the lighting
+        unsigned int deferredPass = renderGraph->AddPass(std::make_unique<DeferredRenderPass>(m_deferredMaterial));
+        renderGraph->ReadTexture(deferredPass, depthTexture, m_deferredMaterial, "DepthTexture");
+        renderGraph->ReadTexture(deferredPass, albedoTexture, m_deferredMaterial, "AlbedoTexture");
+        renderGraph->ReadTexture(deferredPass, normalTexture, m_deferredMaterial, "NormalTexture");
+        renderGraph->ReadTexture(deferredPass, othersTexture, m_deferredMaterial, "OthersTexture");
+        renderGraph->WriteTexture(deferredPass, sceneTexture);
+        renderGraph->WriteTexture(deferredPass, depthTexture);
     }
 
-    // Initialize the framebuffers and the textures they use
-    InitializeFramebuffers();
+    // Skybox pass, drawn over the lit scene
+    unsigned int skyboxPass = renderGraph->AddPass(std::make_unique<SkyboxRenderPass>(m_skyboxTexture));
+    renderGraph->ReadTexture(skyboxPass, sceneTexture);
+    renderGraph->ReadTexture(skyboxPass, depthTexture);
+    renderGraph->WriteTexture(skyboxPass, sceneTexture);
+    renderGraph->WriteTexture(skyboxPass, depthTexture);
 
-    // Skybox pass
-    m_renderer.AddRenderPass(std::make_unique<SkyboxRenderPass>(m_skyboxTexture));
+    // Translucent surfaces, accumulated in any order and then blended over the scene
+    {
+        RenderGraph::TextureDesc revealageDesc;
+        revealageDesc.format = TextureObject::FormatR;
+        revealageDesc.internalFormat = TextureObject::InternalFormatR8;
+        RenderGraph::ResourceId accumulationTexture = renderGraph->CreateTexture("OIT accumulation", sceneDesc);
+        RenderGraph::ResourceId revealageTexture = renderGraph->CreateTexture("OIT revealage", revealageDesc);
+
+        // Depth is only tested, but it has to be written to be attached
+        unsigned int oitPass = renderGraph->AddPass(std::make_unique<WeightedBlendedOITRenderPass>(translucentCollection));
+        renderGraph->ReadTexture(oitPass, depthTexture);
+        renderGraph->WriteTexture(oitPass, accumulationTexture);
+        renderGraph->WriteTexture(oitPass, revealageTexture);
+        renderGraph->WriteTexture(oitPass, depthTexture);
+
+        std::shared_ptr<Material> oitCompositeMaterial = CreatePostFXMaterial("shaders/postfx/oit_composite.frag");
+        oitCompositeMaterial->SetBlendEquation(Material::BlendEquation::Add);
+        oitCompositeMaterial->SetBlendParams(Material::BlendParam::SourceAlpha, Material::BlendParam::OneMinusSourceAlpha);
+        unsigned int oitCompositePass = renderGraph->AddPass(std::make_unique<PostFXRenderPass>(oitCompositeMaterial));
+        renderGraph->ReadTexture(oitCompositePass, accumulationTexture, oitCompositeMaterial, "AccumulationTexture");
+        renderGraph->ReadTexture(oitCompositePass, revealageTexture, oitCompositeMaterial, "RevealageTexture");
+        renderGraph->ReadTexture(oitCompositePass, sceneTexture);
+        renderGraph->WriteTexture(oitCompositePass, sceneTexture);
+    }
 
-    // Create a copy pass from m_sceneTexture to the first temporary texture
-    std::shared_ptr<Material> copyMaterial = CreatePostFXMaterial("shaders/postfx/copy.frag", m_sceneTexture);
-    m_renderer.AddRenderPass(std::make_unique<PostFXRenderPass>(copyMaterial, m_tempFramebuffers[0]));
+    // Create a copy pass from the scene texture to the bloom texture
+    // Nothing reads its output before the bloom pass replaces it, so the graph culls it
+    RenderGraph::ResourceId bloomTexture = renderGraph->CreateTexture("Bloom", bloomDesc);
+    std::shared_ptr<Material> copyMaterial = CreatePostFXMaterial("shaders/postfx/copy.frag");
+    unsigned int copyPass = renderGraph->AddPass(std::make_unique<PostFXRenderPass>(copyMaterial));
+    renderGraph->ReadTexture(copyPass, sceneTexture, copyMaterial, "SourceTexture");
+    renderGraph->WriteTexture(copyPass, bloomTexture);
 
     // Replace the copy pass with a new bloom pass
-    m_bloomMaterial = CreatePostFXMaterial("shaders/postfx/bloom.frag", m_sceneTexture);
+    m_bloomMaterial = CreatePostFXMaterial("shaders/postfx/bloom.frag");
     m_bloomMaterial->SetUniformValue("Range", glm::vec2(2.0f, 3.0f));
     m_bloomMaterial->SetUniformValue("Intensity", 1.0f);
-    m_renderer.AddRenderPass(std::make_unique<PostFXRenderPass>(m_bloomMaterial, m_tempFramebuffers[0]));
+    unsigned int bloomPass = renderGraph->AddPass(std::make_unique<PostFXRenderPass>(m_bloomMaterial));
+    renderGraph->ReadTexture(bloomPass, sceneTexture, m_bloomMaterial, "SourceTexture");
+    renderGraph->WriteTexture(bloomPass, bloomTexture);
 
-    // Add blur passes
-    std::shared_ptr<Material> blurHorizontalMaterial = CreatePostFXMaterial("shaders/postfx/blur.frag", m_tempTextures[0]);
-    blurHorizontalMaterial->SetUniformValue("Scale", glm::vec2(1.0f / width, 0.0f));
-    std::shared_ptr<Material> blurVerticalMaterial = CreatePostFXMaterial("shaders/postfx/blur.frag", m_tempTextures[1]);
-    blurVerticalMaterial->SetUniformValue("Scale", glm::vec2(0.0f, 1.0f / height));
+    // Add blur passes. Each one writes a new texture, and the graph makes them share the same two textures
+    std::shared_ptr<Material> blurMaterial = CreatePostFXMaterial("shaders/postfx/blur.frag");
     for (int i = 0; i < m_blurIterations; ++i)
     {
-        m_renderer.AddRenderPass(std::make_unique<PostFXRenderPass>(blurHorizontalMaterial, m_tempFramebuffers[1]));
-        m_renderer.AddRenderPass(std::make_unique<PostFXRenderPass>(blurVerticalMaterial, m_tempFramebuffers[0]));
+        for (int direction = 0; direction < 2; ++direction)
+        {
+            // Each pass reads a different texture, so it needs its own copy of the material
+            std::shared_ptr<Material> blurPassMaterial = std::make_shared<Material>(*blurMaterial);
+            blurPassMaterial->SetUniformValue("Direction", direction == 0 ? glm::vec2(1.0f, 0.0f) : glm::vec2(0.0f, 1.0f));
+
+            RenderGraph::ResourceId blurTexture = renderGraph->CreateTexture("Blur", bloomDesc);
+            unsigned int blurPass = renderGraph->AddPass(std::make_unique<PostFXRenderPass>(blurPassMaterial));
+            renderGraph->ReadTexture(blurPass, bloomTexture, blurPassMaterial, "SourceTexture");
+            renderGraph->WriteTexture(blurPass, blurTexture);
+            bloomTexture = blurTexture;
+        }
     }
 
     // Final pass
-    m_composeMaterial = CreatePostFXMaterial("shaders/postfx/compose.frag", m_sceneTexture);
+    m_composeMaterial = CreatePostFXMaterial("shaders/postfx/compose.frag");
 
     // Set exposure uniform default value
     m_composeMaterial->SetUniformValue("Exposure", m_exposure);
@@ -357,10 +455,14 @@ void PostFXSceneViewerApplication::InitializeRenderer()
     m_composeMaterial->SetUniformValue("Saturation", m_saturation);
     m_composeMaterial->SetUniformValue("ColorFilter", m_colorFilter);
 
-    // Set the bloom texture uniform
-    m_composeMaterial->SetUniformValue("BloomTexture", m_tempTextures[0]);
+    // The scene and bloom textures are set when the graph is compiled
+    unsigned int composePass = renderGraph->AddPass(std::make_unique<PostFXRenderPass>(m_composeMaterial));
+    renderGraph->ReadTexture(composePass, sceneTexture, m_composeMaterial, "SourceTexture");
+    renderGraph->ReadTexture(composePass, bloomTexture, m_composeMaterial, "BloomTexture");
+    renderGraph->WriteTexture(composePass, RenderGraph::Backbuffer);
 
-    m_renderer.AddRenderPass(std::make_unique<PostFXRenderPass>(m_composeMaterial, m_renderer.GetDefaultFramebuffer()));
+    m_renderGraph = renderGraph.get();
+    m_renderer.AddRenderPass(std::move(renderGraph));
 }
 
 std::shared_ptr<Material> PostFXSceneViewerApplication::CreatePostFXMaterial(const char* fragmentShaderPath, std::shared_ptr<Texture2DObject> sourceTexture)
@@ -368,11 +470,13 @@ std::shared_ptr<Material> PostFXSceneViewerApplication::CreatePostFXMaterial(con
     // We could keep this vertex shader and reuse it, but it looks simpler this way
     std::vector<const char*> vertexShaderPaths;
     vertexShaderPaths.push_back("shaders/version330.glsl");
+    vertexShaderPaths.push_back("shaders/renderer/uniforms.glsl");
     vertexShaderPaths.push_back("shaders/renderer/fullscreen.vert");
     Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
 
     std::vector<const char*> fragmentShaderPaths;
     fragmentShaderPaths.push_back("shaders/version330.glsl");
+    fragmentShaderPaths.push_back("shaders/renderer/uniforms.glsl");
     fragmentShaderPaths.push_back("shaders/utils.glsl");
     fragmentShaderPaths.push_back(fragmentShaderPath);
     Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load(fragmentShaderPaths);
@@ -380,6 +484,12 @@ std::shared_ptr<Material> PostFXSceneViewerApplication::CreatePostFXMaterial(con
     std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
     shaderProgramPtr->Build(vertexShader, fragmentShader);
 
+    // Register shader with renderer, only to bind the uniform blocks. It reads ResolutionScale from PassData
+    m_renderer.RegisterShaderProgram(shaderProgramPtr,
+        nullptr,
+        nullptr
+    );
+
     // Create material
     std::shared_ptr<Material> material = std::make_shared<Material>(shaderProgramPtr);
     material->SetUniformValue("SourceTexture", sourceTexture);
@@ -406,6 +516,22 @@ Renderer::UpdateTransformsFunction PostFXSceneViewerApplication::GetFullscreenTr
         };
 }
 
+void PostFXSceneViewerApplication::SaveScreenshot()
+{
+    int width, height;
+    GetMainWindow().GetDimensions(width, height);
+
+    std::string path = "screenshot_" + std::to_string(m_screenshotCount++) + ".ppm";
+    m_readbackQueue.Read(*FramebufferObject::GetDefault(), 0, 0, width, height, TextureObject::FormatRGB, Data::Type::UByte,
+        [path](const ReadbackQueue::Image& image)
+        {
+            if (!ImageWriter::Save(path.c_str(), image.width, image.height, 3, image.data))
+            {
+                std::cout << "Failed to save screenshot: " << path << std::endl;
+            }
+        });
+}
+
 void PostFXSceneViewerApplication::RenderGUI()
 {
     m_imGui.BeginFrame();
@@ -417,6 +543,9 @@ void PostFXSceneViewerApplication::RenderGUI()
     // Draw GUI for camera controller
     m_cameraController.DrawGUI(m_imGui);
 
+    // Draw GUI for the frame and render pass timings
+    GetProfiler().DrawGUI(m_imGui);
+
     if (auto window = m_imGui.UseWindow("Post FX"))
     {
         if (m_composeMaterial)
@@ -456,6 +585,36 @@ void PostFXSceneViewerApplication::RenderGUI()
                 m_bloomMaterial->SetUniformValue("Intensity", m_bloomIntensity);
             }
         }
+
+        if (m_renderGraph)
+        {
+            ImGui::Separator();
+
+            // Transient textures shared by the passes of the render graph
+            ImGui::Text("Pool textures: %u (%.1f MB)", m_renderGraph->GetPoolTextureCount(), m_renderGraph->GetPoolMemorySize() / (1024.0f * 1024.0f));
+
+            ImGui::Separator();
+
+            ImGui::Checkbox("Dynamic resolution", &m_dynamicResolutionEnabled);
+            float targetFrameTime = static_cast<float>(m_dynamicResolution.GetTargetFrameTime());
+            if (ImGui::DragFloat("GPU budget (ms)", &targetFrameTime, 0.1f, 1.0f, 100.0f))
+            {
+                m_dynamicResolution.SetTargetFrameTime(targetFrameTime);
+            }
+            float minScale = m_dynamicResolution.GetMinScale();
+            if (ImGui::SliderFloat("Min scale", &minScale, 0.25f, m_dynamicResolution.GetMaxScale()))
+            {
+                m_dynamicResolution.SetScaleBounds(minScale, m_dynamicResolution.GetMaxScale());
+            }
+            ImGui::Text("Scale: %.2f (GPU %.2f ms)", m_renderGraph->GetResolutionScale(), m_dynamicResolution.GetGpuFrameTime());
+        }
+
+        ImGui::Separator();
+
+        if (ImGui::Button("Save screenshot"))
+        {
+            m_screenshotRequested = true;
+        }
     }
 
     m_imGui.EndFrame();
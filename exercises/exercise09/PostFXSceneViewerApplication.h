@@ -3,11 +3,12 @@
 #include <ituGL/application/Application.h>
 
 #include <ituGL/scene/Scene.h>
-#include <ituGL/texture/FramebufferObject.h>
 #include <ituGL/renderer/Renderer.h>
+#include <ituGL/renderer/RenderGraph.h>
+#include <ituGL/renderer/DynamicResolutionController.h>
+#include <ituGL/texture/ReadbackQueue.h>
 #include <ituGL/camera/CameraController.h>
 #include <ituGL/utils/DearImGui.h>
-#include <array>
 
 class Texture2DObject;
 class TextureCubemapObject;
@@ -29,7 +30,6 @@ private:
     void InitializeLights();
     void InitializeMaterials();
     void InitializeModels();
-    void InitializeFramebuffers();
     void InitializeRenderer();
 
     std::shared_ptr<Material> CreatePostFXMaterial(const char* fragmentShaderPath, std::shared_ptr<Texture2DObject> sourceTexture = nullptr);
@@ -38,6 +38,9 @@ private:
 
     void RenderGUI();
 
+    // Read the back buffer without waiting for the GPU. The image is saved a few frames later, in a worker thread
+    void SaveScreenshot();
+
 private:
     // Helper object for debug GUI
     DearImGui m_imGui;
@@ -56,16 +59,22 @@ private:
 
     // Materials
     std::shared_ptr<Material> m_defaultMaterial;
+    std::shared_ptr<Material> m_glassMaterial;
     std::shared_ptr<Material> m_deferredMaterial;
     std::shared_ptr<Material> m_composeMaterial;
     std::shared_ptr<Material> m_bloomMaterial;
 
-    // Framebuffers
-    std::shared_ptr<FramebufferObject> m_sceneFramebuffer;
-    std::shared_ptr<Texture2DObject> m_depthTexture;
-    std::shared_ptr<Texture2DObject> m_sceneTexture;
-    std::array<std::shared_ptr<FramebufferObject>, 2> m_tempFramebuffers;
-    std::array<std::shared_ptr<Texture2DObject>, 2> m_tempTextures;
+    // Render graph with all the passes, owned by the renderer. It allocates the framebuffers and textures
+    RenderGraph* m_renderGraph;
+
+    // Resolution of the graph, lowered when the GPU time goes over the budget
+    DynamicResolutionController m_dynamicResolution;
+    bool m_dynamicResolutionEnabled;
+
+    // Screenshots requested from the GUI
+    ReadbackQueue m_readbackQueue;
+    bool m_screenshotRequested;
+    unsigned int m_screenshotCount;
 
     // Configuration values
     float m_exposure;
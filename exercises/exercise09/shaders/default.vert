@@ -14,11 +14,12 @@ out vec2 TexCoord;
 //Uniforms
 uniform mat4 WorldViewMatrix;
 uniform mat4 WorldViewProjMatrix;
+uniform mat3 NormalMatrix;
 
 void main()
 {
 	// normal in view space (for lighting computation)
-	ViewNormal = (WorldViewMatrix * vec4(VertexNormal, 0.0)).xyz;
+	ViewNormal = NormalMatrix * VertexNormal;
 
 	// tangent in view space (for lighting computation)
 	ViewTangent = (WorldViewMatrix * vec4(VertexTangent, 0.0)).xyz;
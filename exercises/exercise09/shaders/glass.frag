@@ -0,0 +1,21 @@
+//Inputs
+in vec3 ViewNormal;
+in vec3 ViewTangent;
+in vec3 ViewBitangent;
+in vec2 TexCoord;
+
+//Uniforms
+uniform vec3 Color;
+uniform sampler2D ColorTexture;
+uniform float Opacity;
+
+void main()
+{
+	vec3 color = Color.rgb * texture(ColorTexture, TexCoord).rgb;
+
+	// Surfaces seen at grazing angles look more opaque
+	float facing = abs(normalize(ViewNormal).z);
+	float alpha = mix(1.0f, Opacity, facing);
+
+	WriteOIT(color, alpha);
+}
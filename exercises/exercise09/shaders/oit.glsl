@@ -0,0 +1,22 @@
+
+// Weighted blended order-independent transparency (McGuire and Bavoil, 2013)
+// Attachment 0 accumulates the weighted premultiplied color, attachment 1 the product of (1 - alpha)
+
+//Outputs
+layout (location = 0) out vec4 FragAccumulation;
+layout (location = 1) out float FragRevealage;
+
+// Closer and more opaque fragments get a higher weight. Clamped to stay in the range of half floats
+float GetOITWeight(float alpha, float depth)
+{
+	float weight = alpha * max(1e-2, 3e3 * pow(1.0f - depth, 3.0f));
+	return clamp(weight, 1e-2, 3e3);
+}
+
+// Write the color of the fragment, not premultiplied
+void WriteOIT(vec3 color, float alpha)
+{
+	float weight = GetOITWeight(alpha, gl_FragCoord.z);
+	FragAccumulation = vec4(color * alpha, alpha) * weight;
+	FragRevealage = alpha;
+}
@@ -6,7 +6,7 @@ out vec4 FragColor;
 
 //Uniforms
 uniform sampler2D SourceTexture;
-uniform vec2 Scale; // Scale to adjust to the resolution, and to select direction
+uniform vec2 Direction; // (1, 0) for horizontal, (0, 1) for vertical
 
 // Offset (in pixels) where to sample the neighbors. We sample between texels to take advantage of the linear filtering
 const float offsets[3] = float[](0.0, 1.3846153846f, 3.2307692308f);
@@ -17,6 +17,12 @@ const float weights[3] = float[](0.2270270270f, 0.3162162162f, 0.0702702703f);
 
 void main()
 {
+   // Scale to adjust to the resolution of the source texture
+   vec2 Scale = Direction / vec2(textureSize(SourceTexture, 0));
+
+   // Don't sample past the part of the texture rendered this frame, with dynamic resolution
+   vec2 maxTexCoord = ResolutionScale - 0.5f / vec2(textureSize(SourceTexture, 0));
+
    // Sample the pixel at the center
    vec4 color = texture(SourceTexture, TexCoord) * weights[0];
 
@@ -24,7 +30,7 @@ void main()
    for (int i = 1; i < 3; i++)
    {
       vec2 scaledOffset = Scale * offsets[i];
-      color += texture(SourceTexture, TexCoord + scaledOffset) * weights[i];
+      color += texture(SourceTexture, min(TexCoord + scaledOffset, maxTexCoord)) * weights[i];
       color += texture(SourceTexture, TexCoord - scaledOffset) * weights[i];
    }
 
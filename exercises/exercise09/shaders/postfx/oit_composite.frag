@@ -0,0 +1,25 @@
+//Inputs
+in vec2 TexCoord;
+
+//Outputs
+out vec4 FragColor;
+
+//Uniforms
+uniform sampler2D AccumulationTexture;
+uniform sampler2D RevealageTexture;
+
+void main()
+{
+	float revealage = texture(RevealageTexture, TexCoord).r;
+
+	// No translucent surfaces in this pixel
+	if (revealage >= 1.0f)
+	{
+		discard;
+	}
+
+	// Weighted average of the colors, blended over the scene with the total coverage
+	vec4 accumulation = texture(AccumulationTexture, TexCoord);
+	vec3 color = accumulation.rgb / max(accumulation.a, 1e-5);
+	FragColor = vec4(color, 1.0f - revealage);
+}
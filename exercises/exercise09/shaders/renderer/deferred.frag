@@ -1,6 +1,3 @@
-//Inputs
-in vec2 TexCoord;
-
 //Outputs
 out vec4 FragColor;
 
@@ -9,13 +6,16 @@ uniform sampler2D DepthTexture;
 uniform sampler2D AlbedoTexture;
 uniform sampler2D NormalTexture;
 uniform sampler2D OthersTexture;
-uniform mat4 InvViewMatrix;
-uniform mat4 InvProjMatrix;
 
 void main()
 {
+	// Texture coordinates from the pixel position, light volumes don't cover the screen
+	// The g-buffers can be larger than the target, with dynamic resolution
+	vec2 screenCoord = gl_FragCoord.xy * InvTargetSize;
+	vec2 TexCoord = screenCoord * ResolutionScale;
+
 	// Extract information from g-buffers
-	vec3 position = ReconstructViewPosition(DepthTexture, TexCoord, InvProjMatrix);
+	vec3 position = ReconstructViewPosition(texture(DepthTexture, TexCoord).r, screenCoord, InvProjMatrix);
 	vec3 albedo = texture(AlbedoTexture, TexCoord).rgb;
 	vec3 normal = GetImplicitNormal(texture(NormalTexture, TexCoord).xy);
 	vec4 others = texture(OthersTexture, TexCoord);
@@ -6,8 +6,8 @@ out vec2 TexCoord;
 
 void main()
 {
-	// texture coordinates
-	TexCoord = VertexPosition.xy * 0.5f + 0.5f;
+	// texture coordinates, in the part of the textures rendered this frame
+	TexCoord = (VertexPosition.xy * 0.5f + 0.5f) * ResolutionScale;
 
 	// final vertex position (for rendering, not for lighting)
 	gl_Position = vec4(VertexPosition.xy, -1.0, 1.0);
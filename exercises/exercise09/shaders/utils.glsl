@@ -60,15 +60,19 @@ vec3 SampleNormalMap(sampler2D normalTexture, vec2 texCoord, vec3 normal, vec3 t
 }
 
 //
-vec3 ReconstructViewPosition(sampler2D depthTexture, vec2 texCoord, mat4 invProjMatrix)
+vec3 ReconstructViewPosition(float depth, vec2 screenCoord, mat4 invProjMatrix)
 {
-	// Reconstruct the position, using the screen texture coordinates and the depth
-	float depth = texture(depthTexture, texCoord).r;
-	vec3 clipPosition = vec3(texCoord, depth) * 2.0f - vec3(1.0f);
+	// Reconstruct the position, using the screen coordinates in [0, 1] and the depth
+	vec3 clipPosition = vec3(screenCoord, depth) * 2.0f - vec3(1.0f);
 	vec4 viewPosition = invProjMatrix * vec4(clipPosition, 1.0f);
 	return viewPosition.xyz / viewPosition.w;
 }
 
+vec3 ReconstructViewPosition(sampler2D depthTexture, vec2 texCoord, mat4 invProjMatrix)
+{
+	return ReconstructViewPosition(texture(depthTexture, texCoord).r, texCoord, invProjMatrix);
+}
+
 float GetLuminance(vec3 color)
 {
    return dot(color, vec3(0.2126f, 0.7152f, 0.0722f));
@@ -0,0 +1,106 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <cassert>
+
+Benchmark::Benchmark(const char* name) : m_name(name)
+{
+}
+
+void Benchmark::Run(unsigned int iterations, const Function& function, const Function& setup, unsigned int warmupIterations)
+{
+    assert(function);
+
+    m_samples.clear();
+    m_samples.reserve(iterations);
+
+    for (unsigned int i = 0; i < warmupIterations + iterations; ++i)
+    {
+        if (setup)
+        {
+            setup();
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - startTime;
+
+        if (i >= warmupIterations)
+        {
+            m_samples.push_back(duration.count());
+        }
+    }
+
+    std::sort(m_samples.begin(), m_samples.end());
+}
+
+void Benchmark::SetSamples(std::vector<double> samples)
+{
+    m_samples = std::move(samples);
+    std::sort(m_samples.begin(), m_samples.end());
+}
+
+void Benchmark::SetCounter(const char* name, double value)
+{
+    for (auto& counter : m_counters)
+    {
+        if (counter.first == name)
+        {
+            counter.second = value;
+            return;
+        }
+    }
+    m_counters.emplace_back(name, value);
+}
+
+double Benchmark::GetPercentile(double percentile) const
+{
+    if (m_samples.empty())
+        return 0.0;
+
+    // Nearest rank
+    size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * m_samples.size()));
+    return m_samples[std::clamp<size_t>(rank, 1, m_samples.size()) - 1];
+}
+
+double Benchmark::GetMean() const
+{
+    if (m_samples.empty())
+        return 0.0;
+
+    return std::accumulate(m_samples.begin(), m_samples.end(), 0.0) / m_samples.size();
+}
+
+void Benchmark::Print() const
+{
+    std::printf("%-40s mean %9.4f ms   p50 %9.4f ms   p95 %9.4f ms   p99 %9.4f ms\n",
+        m_name.c_str(), GetMean(), GetPercentile(50), GetPercentile(95), GetPercentile(99));
+}
+
+void Benchmark::WriteJson(std::ostream& stream) const
+{
+    // Names are written as they are, they don't have characters that need escaping
+    stream << "{ \"name\": \"" << m_name << "\", \"samples\": " << m_samples.size()
+        << ", \"mean\": " << GetMean()
+        << ", \"p50\": " << GetPercentile(50)
+        << ", \"p90\": " << GetPercentile(90)
+        << ", \"p95\": " << GetPercentile(95)
+        << ", \"p99\": " << GetPercentile(99)
+        << ", \"max\": " << GetPercentile(100);
+
+    if (!m_counters.empty())
+    {
+        stream << ", \"counters\": { ";
+        for (size_t i = 0; i < m_counters.size(); ++i)
+        {
+            stream << (i > 0 ? ", " : "") << "\"" << m_counters[i].first << "\": " << m_counters[i].second;
+        }
+        stream << " }";
+    }
+
+    stream << " }";
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Measures the time of a function over several iterations and reports statistics of the samples
+class Benchmark
+{
+public:
+    using Function = std::function<void()>;
+
+public:
+    Benchmark(const char* name);
+
+    const std::string& GetName() const { return m_name; }
+
+    // Run the function the number of iterations, after a few warm up iterations that are not measured
+    // The setup function, if provided, runs before each iteration and it is not measured either
+    void Run(unsigned int iterations, const Function& function, const Function& setup = nullptr, unsigned int warmupIterations = 3);
+
+    // Use samples in milliseconds measured somewhere else, for example one per rendered frame
+    void SetSamples(std::vector<double> samples);
+
+    // Extra value reported with the statistics, like the number of drawcalls
+    void SetCounter(const char* name, double value);
+
+    // Time in milliseconds that the given percentage (0-100) of the samples don't exceed
+    double GetPercentile(double percentile) const;
+
+    // Average time in milliseconds
+    double GetMean() const;
+
+    // Print the name and statistics in a single line
+    void Print() const;
+
+    // Write the statistics and the counters as a JSON object
+    void WriteJson(std::ostream& stream) const;
+
+private:
+    std::string m_name;
+
+    // Time of each iteration in milliseconds, sorted
+    std::vector<double> m_samples;
+
+    std::vector<std::pair<std::string, double>> m_counters;
+};
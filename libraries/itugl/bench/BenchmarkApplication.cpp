@@ -0,0 +1,146 @@
+#include "BenchmarkApplication.h"
+
+#include "SceneBenchmark.h"
+
+#include <ituGL/renderer/Renderer.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+BenchmarkApplication::BenchmarkApplication(const char* outputPath) : Application(256, 256, "itugl benchmarks"), m_outputPath(outputPath)
+{
+}
+
+void BenchmarkApplication::Initialize()
+{
+    Application::Initialize();
+
+    RunSortBenchmarks();
+    RunLightClusterBenchmarks();
+    RunFrustumCullingBenchmarks();
+    RunOcclusionCullingBenchmarks();
+    RunTransformBenchmarks();
+    RunMeshSimplificationBenchmarks();
+    RunRangeAllocatorBenchmarks();
+    RunShaderProgramDispatchBenchmarks();
+    RunSceneTraversalBenchmarks();
+    RunStreamingBufferBenchmarks();
+    RunReadbackBenchmarks();
+    RunSceneBenchmarks();
+
+    if (!WriteResults())
+    {
+        std::printf("Failed to write the results: %s\n", m_outputPath.c_str());
+    }
+
+    for (const std::string& name : m_failedValidations)
+    {
+        std::printf("Validation failed: %s\n", name.c_str());
+    }
+
+    // Everything runs during initialization, there is nothing to show
+    Close();
+}
+
+void BenchmarkApplication::RunSceneBenchmarks()
+{
+    int width, height;
+    GetMainWindow().GetDimensions(width, height);
+
+    SceneBenchmark sceneBenchmark(GetDevice(), GetProfiler(), width, height);
+    if (!sceneBenchmark.Initialize())
+    {
+        return;
+    }
+
+    // Few and many models, with and without post-processing, and with more lights than a forward pass handles cheaply
+    SceneBenchmark::Settings forwardSmall{ "forward_small", 10, 4, false };
+    SceneBenchmark::Settings forwardLarge{ "forward_large", 100, 4, false };
+    SceneBenchmark::Settings postFXLarge{ "postfx_large", 100, 4, true };
+    SceneBenchmark::Settings manyLights{ "many_lights", 20, 32, false };
+    // Same as forward_large, with the models retained in the renderer
+    SceneBenchmark::Settings retainedLarge{ "retained_large", 100, 4, false, 120, true };
+    // Same as forward_large and many_lights, shading only the visible surfaces after a depth pre-pass
+    SceneBenchmark::Settings prepassLarge{ "prepass_large", 100, 4, false, 120, false, true };
+    SceneBenchmark::Settings prepassManyLights{ "prepass_many_lights", 20, 32, false, 120, false, true };
+    // Same as forward_large, drawing the distant models with their simplified levels of detail
+    SceneBenchmark::Settings lodLarge{ "lod_large", 100, 4, false, 120, false, false, true };
+    // Same as postfx_large, rendering the scene at the lowest scale of the dynamic resolution of exercise 09
+    SceneBenchmark::Settings postFXHalfResolution{ "postfx_half_resolution", 100, 4, true, 120, false, false, false, 0.5f };
+    // Same as forward_large, with one material for all the models, drawn instanced from their own buffers or with multi-draw from a mesh pool
+    SceneBenchmark::Settings sharedMaterialLarge{ "shared_material_large", 100, 4, false, 120, false, false, false, 1.0f, true };
+    SceneBenchmark::Settings multiDrawLarge{ "multidraw_large", 100, 4, false, 120, false, false, false, 1.0f, true, true };
+    std::vector<unsigned char> sharedMaterialFrame, multiDrawFrame;
+    if (!Renderer::IsMultiDrawIndirectSupported())
+    {
+        std::printf("Multi-draw indirect is not supported, multidraw_large uses one draw per batch\n");
+    }
+
+    for (const SceneBenchmark::Settings& settings : { forwardSmall, forwardLarge, postFXLarge, manyLights, retainedLarge, prepassLarge, prepassManyLights, lodLarge,
+        postFXHalfResolution, sharedMaterialLarge, multiDrawLarge })
+    {
+        // Multi-draw must render the same frames as the separate draws
+        std::vector<unsigned char>* lastFrame = nullptr;
+        if (settings.sharedMaterial)
+        {
+            lastFrame = settings.multiDraw ? &multiDrawFrame : &sharedMaterialFrame;
+        }
+
+        for (const Benchmark& benchmark : sceneBenchmark.Run(settings, lastFrame))
+        {
+            Report(benchmark);
+        }
+    }
+
+    unsigned int differentPixels = 0;
+    for (size_t i = 0; i < sharedMaterialFrame.size(); i += 4)
+    {
+        differentPixels += std::memcmp(&sharedMaterialFrame[i], &multiDrawFrame[i], 4) != 0 ? 1 : 0;
+    }
+    Validate("Multi-draw", differentPixels == 0);
+    std::printf("Multi-draw validation: %s (%u different pixels)\n", differentPixels == 0 ? "ok" : "FAILED", differentPixels);
+}
+
+void BenchmarkApplication::RunBenchmark(const char* name, unsigned int iterations, const Benchmark::Function& function, const Benchmark::Function& setup)
+{
+    Benchmark benchmark(name);
+    benchmark.Run(iterations, function, setup);
+    Report(benchmark);
+}
+
+bool BenchmarkApplication::Validate(const char* name, bool valid)
+{
+    if (!valid)
+    {
+        m_failedValidations.push_back(name);
+    }
+    return valid;
+}
+
+void BenchmarkApplication::Report(const Benchmark& benchmark)
+{
+    benchmark.Print();
+    m_results.push_back(benchmark);
+}
+
+bool BenchmarkApplication::WriteResults() const
+{
+    std::ofstream file(m_outputPath);
+    if (!file)
+    {
+        return false;
+    }
+
+    file << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < m_results.size(); ++i)
+    {
+        file << "    ";
+        m_results[i].WriteJson(file);
+        file << (i + 1 < m_results.size() ? ",\n" : "\n");
+    }
+    file << "  ]\n}\n";
+
+    return file.good();
+}
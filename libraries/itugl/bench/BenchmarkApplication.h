@@ -0,0 +1,88 @@
+#pragma once
+
+#include <ituGL/application/Application.h>
+
+#include "Benchmark.h"
+
+#include <string>
+#include <vector>
+
+// Runs the itugl micro benchmarks once the OpenGL context is ready, prints the results and exits
+// All the results are also written to a JSON file, to compare runs
+class BenchmarkApplication : public Application
+{
+public:
+    BenchmarkApplication(const char* outputPath = "itugl_bench.json");
+
+    // True if the result of any fast path didn't match its reference
+    bool HasFailedValidations() const { return !m_failedValidations.empty(); }
+
+protected:
+    void Initialize() override;
+
+private:
+    // Defined in RendererBenchmarks.cpp
+
+    // Packed sort keys and radix sort, compared with a comparator giving the same order, a simpler front to back comparator,
+    // and an order-independent collection
+    void RunSortBenchmarks();
+
+    // World-view, world-view-projection and normal matrices with the SIMD kernel, compared with glm
+    void RunTransformBenchmarks();
+
+    // Transform and light functions of the drawcalls called by shader program id, compared with the shared_ptr map lookup
+    void RunShaderProgramDispatchBenchmarks();
+
+    // Drawcall generation for a large scene, serial and split across the thread pool
+    void RunSceneTraversalBenchmarks();
+
+    // Defined in CullingBenchmarks.cpp
+
+    // Clustered light assignment, validated against the brute force reference
+    void RunLightClusterBenchmarks();
+
+    // Frustum culling of transformed boxes
+    void RunFrustumCullingBenchmarks();
+
+    // Occluders rasterized on the CPU with each kernel, and boxes tested against them
+    void RunOcclusionCullingBenchmarks();
+
+    // Defined in GeometryBenchmarks.cpp
+
+    // Quadric error simplification of a sphere, with the error at each ratio
+    void RunMeshSimplificationBenchmarks();
+
+    // Allocations, frees and defragmentations of many small ranges
+    void RunRangeAllocatorBenchmarks();
+
+    // Defined in GpuTransferBenchmarks.cpp
+
+    // Per-frame vertex uploads through the streaming buffer, compared with one BufferSubData per element
+    void RunStreamingBufferBenchmarks();
+
+    // 1080p frames read back every frame through the readback queue, compared with a synchronous glReadPixels
+    void RunReadbackBenchmarks();
+
+    // Defined in BenchmarkApplication.cpp
+
+    // Scripted scenes rendered along a fixed camera path, with the time of each stage of the renderer
+    void RunSceneBenchmarks();
+
+    // Run a benchmark and report it, see Benchmark::Run
+    void RunBenchmark(const char* name, unsigned int iterations, const Benchmark::Function& function, const Benchmark::Function& setup = nullptr);
+
+    // Keep the name of the failed validations, to fail the run. Returns valid
+    bool Validate(const char* name, bool valid);
+
+    // Print the results and keep them for the JSON file
+    void Report(const Benchmark& benchmark);
+
+    bool WriteResults() const;
+
+private:
+    std::string m_outputPath;
+
+    std::vector<Benchmark> m_results;
+
+    std::vector<std::string> m_failedValidations;
+};
@@ -0,0 +1,57 @@
+#include "BenchmarkUtils.h"
+
+#include <ituGL/renderer/Renderer.h>
+#include <glm/geometric.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+BenchmarkRandom::BenchmarkRandom(unsigned int seed) : m_engine(seed)
+{
+}
+
+float BenchmarkRandom::GetFloat(float min, float max)
+{
+    return std::uniform_real_distribution<float>(min, max)(m_engine);
+}
+
+unsigned int BenchmarkRandom::GetIndex(unsigned int count)
+{
+    return m_engine() % count;
+}
+
+glm::vec3 BenchmarkRandom::GetVec3(float min, float max)
+{
+    float x = GetFloat(min, max);
+    float y = GetFloat(min, max);
+    float z = GetFloat(min, max);
+    return glm::vec3(x, y, z);
+}
+
+glm::mat4 BenchmarkRandom::GetWorldMatrix(float positionExtent, float minSize, float maxSize)
+{
+    glm::vec3 position = GetVec3(-positionExtent, positionExtent);
+    float axisX = GetFloat(-positionExtent, positionExtent);
+    float axisY = GetFloat(-positionExtent, positionExtent);
+    glm::vec3 axis = glm::normalize(glm::vec3(axisX, axisY, 1.0f));
+    float angle = GetFloat(0.0f, 6.28f);
+    glm::vec3 size = GetVec3(minSize, maxSize);
+
+    glm::mat4 worldMatrix = glm::translate(glm::mat4(1.0f), position);
+    worldMatrix = glm::rotate(worldMatrix, angle, axis);
+    return glm::scale(worldMatrix, size);
+}
+
+// Only written, never read. Being volatile, the compiler must do every write, with the value computed
+static volatile std::size_t s_keptResult = 0;
+
+void KeepResult(std::size_t result)
+{
+    s_keptResult = s_keptResult + result;
+}
+
+void ResetRenderer(Renderer& renderer)
+{
+    if (renderer.HasCamera())
+    {
+        renderer.Render();
+    }
+}
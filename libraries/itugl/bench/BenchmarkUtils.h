@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include <cstddef>
+#include <random>
+
+class Renderer;
+
+// Random data for the benchmarks. Each benchmark uses its own fixed seed, so every run measures the same data
+// The values are drawn one by one, in the order of the calls, so they don't depend on the evaluation order of the compiler
+class BenchmarkRandom
+{
+public:
+    BenchmarkRandom(unsigned int seed);
+
+    // Uniform in [min, max)
+    float GetFloat(float min, float max);
+
+    // Uniform in [0, count)
+    unsigned int GetIndex(unsigned int count);
+
+    // Each component uniform in [min, max)
+    glm::vec3 GetVec3(float min, float max);
+
+    // Box of random size, translated by up to positionExtent and rotated around a random axis in front of the XY plane
+    glm::mat4 GetWorldMatrix(float positionExtent, float minSize, float maxSize);
+
+private:
+    std::mt19937 m_engine;
+};
+
+// Add a result of the measured function to a value the compiler can't see through, so the work that computes it is not
+// optimized away. Keep a count or a sum of the results, instead of each of them, so keeping them is not measured too
+void KeepResult(std::size_t result);
+
+// Rendering without passes only clears the drawcalls and the matrices of the frame, to submit them again
+void ResetRenderer(Renderer& renderer);
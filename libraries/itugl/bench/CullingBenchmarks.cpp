@@ -0,0 +1,174 @@
+#include "BenchmarkApplication.h"
+
+#include "BenchmarkUtils.h"
+
+#include <ituGL/camera/Camera.h>
+#include <ituGL/lighting/LightClusterGrid.h>
+#include <ituGL/lighting/PointLight.h>
+#include <ituGL/lighting/DirectionalLight.h>
+#include <ituGL/scene/Bounds.h>
+#include <ituGL/scene/OcclusionBuffer.h>
+#include <ituGL/utils/ThreadPool.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+void BenchmarkApplication::RunLightClusterBenchmarks()
+{
+    const unsigned int lightCount = 500;
+
+    BenchmarkRandom random(5678);
+
+    // Point lights spread around the camera, some of them behind it or out of the depth range
+    std::vector<PointLight> pointLights(lightCount);
+    std::vector<const Light*> lights;
+    for (PointLight& pointLight : pointLights)
+    {
+        float range = random.GetFloat(0.5f, 4.0f);
+        glm::vec3 position = random.GetVec3(-20.0f, 20.0f);
+        pointLight.SetPosition(glm::vec3(position.x, position.y * 0.25f, position.z));
+        pointLight.SetDistanceAttenuation(glm::vec2(range * 0.5f, range));
+        lights.push_back(&pointLight);
+    }
+    DirectionalLight directionalLight;
+    lights.push_back(&directionalLight);
+
+    Camera camera;
+    camera.SetViewMatrix(glm::vec3(0.0f, 3.0f, 15.0f), glm::vec3(0.0f));
+    camera.SetPerspectiveProjectionMatrix(1.0f, 16.0f / 9.0f, 0.1f, 30.0f);
+
+    ThreadPool threadPool;
+    LightClusterGrid grid;
+    LightClusterGrid referenceGrid;
+
+    // The fast paths must give exactly the same assignment as the reference
+    referenceGrid.BuildReference(lights, camera);
+    grid.Build(lights, camera);
+    bool validSingleThread = grid.HasSameAssignment(referenceGrid);
+    grid.Build(lights, camera, &threadPool);
+    bool validThreads = grid.HasSameAssignment(referenceGrid);
+    Validate("Light clusters", validSingleThread && validThreads);
+    std::printf("Light clusters: %u lights, %zu assignments, single thread %s, %u workers %s\n",
+        lightCount, grid.GetLightIndices().size(),
+        validSingleThread ? "valid" : "INVALID", threadPool.GetThreadCount(), validThreads ? "valid" : "INVALID");
+
+    const unsigned int iterations = 100;
+
+    RunBenchmark("Assign 500 lights to clusters (reference)", iterations, [&]() { referenceGrid.BuildReference(lights, camera); });
+    RunBenchmark("Assign 500 lights to clusters (single thread)", iterations, [&]() { grid.Build(lights, camera); });
+    RunBenchmark("Assign 500 lights to clusters (thread pool)", iterations, [&]() { grid.Build(lights, camera, &threadPool); });
+}
+
+void BenchmarkApplication::RunFrustumCullingBenchmarks()
+{
+    const unsigned int boxCount = 50000;
+
+    BenchmarkRandom random(4321);
+
+    AabbBounds localBounds(glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(1.0f, 0.5f, 1.0f));
+    std::vector<glm::mat4> worldMatrices;
+    for (unsigned int i = 0; i < boxCount; ++i)
+    {
+        worldMatrices.push_back(random.GetWorldMatrix(100.0f, 0.1f, 5.0f));
+    }
+
+    Camera camera;
+    camera.SetViewMatrix(glm::vec3(10.0f, 5.0f, 30.0f), glm::vec3(0.0f));
+    camera.SetPerspectiveProjectionMatrix(1.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+    FrustumBounds frustum(camera);
+
+    // The culled boxes are checked against the clip space reference in the frustum_bounds tests
+    auto countVisible = [&]()
+        {
+            unsigned int visibleCount = 0;
+            for (const glm::mat4& worldMatrix : worldMatrices)
+            {
+                visibleCount += Bounds::Intersects(frustum, BoxBounds(localBounds, worldMatrix)) ? 1 : 0;
+            }
+            return visibleCount;
+        };
+    std::printf("Frustum culling: %u of %u boxes visible\n", countVisible(), boxCount);
+
+    const unsigned int iterations = 100;
+
+    RunBenchmark("Cull 50k boxes against the frustum", iterations, [&]() { KeepResult(countVisible()); });
+}
+
+void BenchmarkApplication::RunOcclusionCullingBenchmarks()
+{
+    const unsigned int boxCount = 50000;
+
+    BenchmarkRandom random(2468);
+
+    // Indoor-like scene: rows of walls across the view, with gaps between them, and a floor
+    AabbBounds unitBounds(glm::vec3(0.0f), glm::vec3(0.5f));
+    std::vector<glm::mat4> occluderMatrices;
+    for (int row = 0; row < 4; ++row)
+    {
+        for (int column = -3; column <= 3; ++column)
+        {
+            glm::vec3 position(column * 24.0f + (row % 2) * 12.0f, 8.0f, -20.0f - row * 25.0f);
+            occluderMatrices.push_back(glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(20.0f, 16.0f, 1.0f)));
+        }
+    }
+    occluderMatrices.push_back(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.5f, -50.0f)), glm::vec3(200.0f, 1.0f, 200.0f)));
+
+    // Boxes between the walls, at the height of the camera, rotated around the vertical axis
+    AabbBounds localBounds(glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(1.0f, 0.5f, 1.0f));
+    std::vector<glm::mat4> worldMatrices;
+    for (unsigned int i = 0; i < boxCount; ++i)
+    {
+        glm::vec3 position = random.GetVec3(-100.0f, 100.0f);
+        float angle = random.GetFloat(0.0f, 6.28f);
+        glm::vec3 size = random.GetVec3(0.1f, 3.0f);
+        glm::mat4 worldMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(position.x, position.y * 0.05f + 5.0f, position.z * 0.5f - 50.0f));
+        worldMatrix = glm::rotate(worldMatrix, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+        worldMatrices.push_back(glm::scale(worldMatrix, size));
+    }
+
+    Camera camera;
+    camera.SetViewMatrix(glm::vec3(0.0f, 4.0f, 10.0f), glm::vec3(0.0f, 4.0f, -50.0f));
+    camera.SetPerspectiveProjectionMatrix(1.0f, 16.0f / 9.0f, 0.1f, 200.0f);
+
+    auto addOccluders = [&](OcclusionBuffer& occlusionBuffer)
+        {
+            occlusionBuffer.Clear(camera.GetViewProjectionMatrix());
+            for (const glm::mat4& occluderMatrix : occluderMatrices)
+            {
+                occlusionBuffer.AddOccluder(unitBounds, occluderMatrix);
+            }
+        };
+
+    // The kernels and the thread pool are checked against the reference in the occlusion_buffer tests
+    ThreadPool threadPool;
+    OcclusionBuffer referenceBuffer, occlusionBuffer;
+    addOccluders(referenceBuffer);
+    addOccluders(occlusionBuffer);
+    occlusionBuffer.Rasterize(&threadPool, OcclusionBuffer::Kernel::Simd);
+
+    auto countVisible = [&]()
+        {
+            unsigned int visibleCount = 0;
+            for (const glm::mat4& worldMatrix : worldMatrices)
+            {
+                visibleCount += occlusionBuffer.IsVisible(localBounds, worldMatrix) ? 1 : 0;
+            }
+            return visibleCount;
+        };
+    std::printf("Occlusion culling: %u triangles in %ux%u, SIMD kernel (%s), %u workers, %u of %u boxes visible\n",
+        occlusionBuffer.GetTriangleCount(), occlusionBuffer.GetWidth(), occlusionBuffer.GetHeight(),
+        OcclusionBuffer::GetSimdName(), threadPool.GetThreadCount(), countVisible(), boxCount);
+
+    const unsigned int iterations = 100;
+
+    RunBenchmark("Rasterize occluders (reference)", iterations, [&]() { referenceBuffer.Rasterize(nullptr, OcclusionBuffer::Kernel::Reference); });
+
+    RunBenchmark((std::string("Rasterize occluders (") + OcclusionBuffer::GetSimdName() + ")").c_str(), iterations,
+        [&]() { occlusionBuffer.Rasterize(nullptr, OcclusionBuffer::Kernel::Simd); });
+
+    RunBenchmark((std::string("Rasterize occluders (") + OcclusionBuffer::GetSimdName() + ", thread pool)").c_str(), iterations,
+        [&]() { occlusionBuffer.Rasterize(&threadPool, OcclusionBuffer::Kernel::Simd); });
+
+    RunBenchmark("Test 50k boxes against the occluders", iterations, [&]() { KeepResult(countVisible()); });
+}
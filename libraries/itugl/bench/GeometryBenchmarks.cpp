@@ -0,0 +1,142 @@
+#include "BenchmarkApplication.h"
+
+#include "BenchmarkUtils.h"
+
+#include <ituGL/geometry/MeshSimplifier.h>
+#include <ituGL/utils/RangeAllocator.h>
+#include <glm/geometric.hpp>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+
+void BenchmarkApplication::RunMeshSimplificationBenchmarks()
+{
+    // Cube subdivided in a grid on each face and projected on the unit sphere, with the vertices of the edges shared
+    const int gridSize = 64;
+    std::vector<glm::vec3> positions;
+    std::vector<unsigned int> indices;
+    std::unordered_map<int, unsigned int> gridVertices;
+    auto getVertex = [&](glm::ivec3 gridPosition)
+        {
+            int key = (gridPosition.x * (gridSize + 1) + gridPosition.y) * (gridSize + 1) + gridPosition.z;
+            auto itVertex = gridVertices.find(key);
+            if (itVertex != gridVertices.end())
+            {
+                return itVertex->second;
+            }
+            unsigned int vertex = static_cast<unsigned int>(positions.size());
+            positions.push_back(glm::normalize(glm::vec3(gridPosition) / static_cast<float>(gridSize) * 2.0f - 1.0f));
+            gridVertices[key] = vertex;
+            return vertex;
+        };
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        for (int side = 0; side < 2; ++side)
+        {
+            for (int i = 0; i < gridSize; ++i)
+            {
+                for (int j = 0; j < gridSize; ++j)
+                {
+                    auto getFaceVertex = [&](int u, int v)
+                        {
+                            glm::ivec3 gridPosition;
+                            gridPosition[axis] = side * gridSize;
+                            gridPosition[(axis + 1) % 3] = u;
+                            gridPosition[(axis + 2) % 3] = v;
+                            return getVertex(gridPosition);
+                        };
+                    unsigned int v00 = getFaceVertex(i, j), v10 = getFaceVertex(i + 1, j);
+                    unsigned int v11 = getFaceVertex(i + 1, j + 1), v01 = getFaceVertex(i, j + 1);
+                    if (side)
+                    {
+                        indices.insert(indices.end(), { v00, v10, v11, v00, v11, v01 });
+                    }
+                    else
+                    {
+                        indices.insert(indices.end(), { v00, v11, v10, v00, v01, v11 });
+                    }
+                }
+            }
+        }
+    }
+
+    // The results are checked in the mesh_simplifier tests
+    unsigned int triangleCount = static_cast<unsigned int>(indices.size() / 3);
+    MeshSimplifier simplifier;
+    for (float ratio : { 0.5f, 0.25f, 0.1f, 0.02f })
+    {
+        unsigned int targetIndexCount = static_cast<unsigned int>(triangleCount * ratio) * 3;
+        std::vector<unsigned int> simplified = simplifier.Simplify(positions, indices, targetIndexCount);
+        std::printf("Mesh simplification: %u to %zu triangles (target %u), error %g of the radius\n",
+            triangleCount, simplified.size() / 3, targetIndexCount / 3, simplifier.GetError());
+    }
+
+    const unsigned int iterations = 10;
+
+    RunBenchmark("Simplify 49k triangles to 25%", iterations, [&]()
+        {
+            simplifier.Simplify(positions, indices, triangleCount / 4 * 3);
+        });
+}
+
+void BenchmarkApplication::RunRangeAllocatorBenchmarks()
+{
+    const unsigned int size = 1u << 20;
+
+    // Overlaps and moves are checked in the range_allocator tests
+    BenchmarkRandom random(4321);
+
+    const unsigned int iterations = 50;
+    const unsigned int rangeCount = 10000;
+
+    std::vector<unsigned int> sizes;
+    for (unsigned int i = 0; i < rangeCount; ++i)
+    {
+        sizes.push_back(1 + random.GetIndex(100));
+    }
+
+    RangeAllocator benchmarkAllocator(size);
+    std::vector<RangeAllocator::AllocationId> ids;
+    auto allocateAll = [&]()
+        {
+            benchmarkAllocator.Reset(size);
+            ids.clear();
+            for (unsigned int rangeSize : sizes)
+            {
+                ids.push_back(benchmarkAllocator.Allocate(rangeSize).id);
+            }
+        };
+    // Free every other range, so the free space is split in many small ranges
+    auto freeHalf = [&](unsigned int first)
+        {
+            for (unsigned int i = first; i < ids.size(); i += 2)
+            {
+                if (ids[i] != RangeAllocator::InvalidId)
+                {
+                    benchmarkAllocator.Free(ids[i]);
+                }
+            }
+        };
+
+    RunBenchmark("Allocate and free 10k ranges", iterations, [&]()
+        {
+            allocateAll();
+            freeHalf(0);
+            freeHalf(1);
+        });
+
+    allocateAll();
+    freeHalf(0);
+    RangeAllocator::Stats fragmentedStats = benchmarkAllocator.GetStats();
+    std::printf("Range allocator: %u ranges, fragmentation %.3f in %u free ranges after freeing every other range\n",
+        rangeCount, fragmentedStats.GetFragmentation(), fragmentedStats.freeRangeCount);
+
+    RunBenchmark("Defragment 5k ranges", iterations, [&]()
+        {
+            benchmarkAllocator.Defragment();
+        }, [&]()
+        {
+            allocateAll();
+            freeHalf(0);
+        });
+}
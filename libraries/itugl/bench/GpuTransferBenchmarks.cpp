@@ -0,0 +1,187 @@
+#include "BenchmarkApplication.h"
+
+#include <ituGL/core/StreamingBuffer.h>
+#include <ituGL/geometry/VertexBufferObject.h>
+#include <ituGL/texture/FramebufferObject.h>
+#include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/texture/ReadbackQueue.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+void BenchmarkApplication::RunStreamingBufferBenchmarks()
+{
+    // Same layout as the particles of exercise 02
+    const unsigned int elementSize = 48;
+    const unsigned int elementCount = 4096;
+    const unsigned int frameCount = 16;
+
+    std::vector<std::byte> elements(elementCount * elementSize);
+    for (unsigned int i = 0; i < elements.size(); ++i)
+    {
+        elements[i] = static_cast<std::byte>(i * 31);
+    }
+
+    std::shared_ptr<VertexBufferObject> streamingVbo = std::make_shared<VertexBufferObject>();
+    StreamingBuffer streamingBuffer(streamingVbo, elements.size());
+
+    // Write a few frames, and check that the last one reads back at the returned offset
+    size_t offset = 0;
+    for (unsigned int frame = 0; frame < frameCount; ++frame)
+    {
+        streamingBuffer.BeginFrame();
+        std::span<std::byte> data = streamingBuffer.Allocate(elements.size(), elementSize, offset);
+        std::memcpy(data.data(), elements.data(), data.size());
+        streamingBuffer.Flush();
+        if (frame + 1 < frameCount)
+        {
+            streamingBuffer.EndFrame();
+        }
+    }
+    std::vector<std::byte> readback(elements.size());
+    streamingVbo->Bind();
+    glGetBufferSubData(GL_ARRAY_BUFFER, offset, readback.size(), readback.data());
+    VertexBufferObject::Unbind();
+    streamingBuffer.EndFrame();
+    bool valid = Validate("Streaming buffer", readback == elements);
+    std::printf("Streaming buffer: %s, %s\n", streamingBuffer.IsPersistent() ? "persistent mapping" : "orphaning", valid ? "valid" : "INVALID");
+
+    const unsigned int iterations = 200;
+
+    VertexBufferObject vbo;
+    vbo.Bind();
+    vbo.AllocateData(elements.size(), BufferObject::DynamicDraw);
+    VertexBufferObject::Unbind();
+
+    RunBenchmark("Upload 4096 elements (BufferSubData each)", iterations, [&]()
+        {
+            vbo.Bind();
+            for (unsigned int i = 0; i < elementCount; ++i)
+            {
+                vbo.UpdateData(std::span<const std::byte>(elements).subspan(i * elementSize, elementSize), i * elementSize);
+            }
+            VertexBufferObject::Unbind();
+            glFlush();
+        });
+
+    RunBenchmark("Upload 4096 elements (streaming buffer)", iterations, [&]()
+        {
+            streamingBuffer.BeginFrame();
+            std::span<std::byte> data = streamingBuffer.Allocate(elements.size(), elementSize, offset);
+            std::memcpy(data.data(), elements.data(), data.size());
+            streamingBuffer.EndFrame();
+            glFlush();
+        });
+}
+
+void BenchmarkApplication::RunReadbackBenchmarks()
+{
+    const int width = 1920;
+    const int height = 1080;
+
+    std::shared_ptr<Texture2DObject> colorTexture = std::make_shared<Texture2DObject>();
+    colorTexture->Bind();
+    colorTexture->SetImage(0, width, height, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA8);
+    Texture2DObject::Unbind();
+
+    FramebufferObject framebuffer;
+    framebuffer.Bind();
+    framebuffer.SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color0, *colorTexture);
+    FramebufferObject::Unbind();
+
+    DeviceGL& device = GetDevice();
+
+    // Stand-in for a rendered frame: a few rectangles that change with the frame index
+    auto renderFrame = [&](unsigned int frame)
+        {
+            framebuffer.Bind();
+            device.SetViewport(0, 0, width, height);
+            device.Clear(Color(0.1f, 0.2f, 0.3f, 1.0f));
+            glEnable(GL_SCISSOR_TEST);
+            for (unsigned int i = 0; i < 8; ++i)
+            {
+                unsigned int x = (frame * 37 + i * 211) % (width - 256);
+                unsigned int y = (frame * 17 + i * 113) % (height - 256);
+                glScissor(x, y, 256, 256);
+                device.Clear(Color((i & 1) * 1.0f, ((i >> 1) & 1) * 1.0f, ((i >> 2) & 1) * 1.0f, i / 8.0f));
+            }
+            glDisable(GL_SCISSOR_TEST);
+            FramebufferObject::Unbind();
+        };
+
+    std::vector<std::byte> pixels(static_cast<size_t>(width) * height * 4);
+    auto readPixels = [&]()
+        {
+            framebuffer.Bind(FramebufferObject::Target::Read);
+            glReadBuffer(GL_COLOR_ATTACHMENT0);
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            FramebufferObject::Unbind(FramebufferObject::Target::Read);
+        };
+
+    // Check that the framebuffer and texture reads return the same pixels as the synchronous read, in order
+    bool valid = true;
+    {
+        // Enough buffers for all the reads, so none is dropped
+        ReadbackQueue readbackQueue(6);
+        std::vector<std::vector<std::byte>> expected;
+        std::vector<unsigned int> ids;
+        std::vector<std::vector<std::byte>> results;
+        std::vector<unsigned int> resultIds;
+        auto callback = [&](const ReadbackQueue::Image& image)
+            {
+                // The worker thread doesn't touch the vectors until Finish returns
+                results.emplace_back(image.data.begin(), image.data.end());
+                resultIds.push_back(image.id);
+            };
+        for (unsigned int frame = 0; frame < 3; ++frame)
+        {
+            renderFrame(frame);
+            readPixels();
+            expected.push_back(pixels);
+            ids.push_back(readbackQueue.Read(framebuffer, 0, 0, width, height, TextureObject::FormatRGBA, Data::Type::UByte, callback));
+            expected.push_back(pixels);
+            ids.push_back(readbackQueue.Read(*colorTexture, 0, TextureObject::FormatRGBA, Data::Type::UByte, callback));
+            readbackQueue.Poll();
+        }
+        readbackQueue.Finish();
+        valid = results == expected && resultIds == ids && readbackQueue.GetDroppedCount() == 0;
+    }
+    Validate("Readback queue", valid);
+    std::printf("Readback queue: %s\n", valid ? "valid" : "INVALID");
+
+    const unsigned int iterations = 200;
+
+    unsigned int frame = 0;
+    RunBenchmark("Read 1080p frame (glReadPixels)", iterations, [&]()
+        {
+            renderFrame(frame++);
+            readPixels();
+        });
+
+    // The callback does a little work on each image, like a comparison would, in the worker thread
+    ReadbackQueue readbackQueue;
+    std::atomic<unsigned int> checksum = 0;
+    auto callback = [&](const ReadbackQueue::Image& image)
+        {
+            unsigned int sum = 0;
+            for (size_t i = 0; i < image.data.size(); i += 64)
+            {
+                sum += static_cast<unsigned int>(image.data[i]);
+            }
+            checksum += sum;
+        };
+
+    Benchmark asyncBenchmark("Read 1080p frame (readback queue)");
+    asyncBenchmark.Run(iterations, [&]()
+        {
+            renderFrame(frame++);
+            readbackQueue.Read(framebuffer, 0, 0, width, height, TextureObject::FormatRGBA, Data::Type::UByte, callback);
+            readbackQueue.Poll();
+        });
+    readbackQueue.Finish();
+    asyncBenchmark.SetCounter("dropped", readbackQueue.GetDroppedCount());
+    Report(asyncBenchmark);
+}
@@ -0,0 +1,382 @@
+#include "BenchmarkApplication.h"
+
+#include "BenchmarkUtils.h"
+
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/renderer/TransformBatch.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/geometry/Model.h>
+#include <ituGL/geometry/VertexFormat.h>
+#include <ituGL/shader/Material.h>
+#include <ituGL/shader/Shader.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/scene/Bounds.h>
+#include <ituGL/scene/Scene.h>
+#include <ituGL/scene/SceneCamera.h>
+#include <ituGL/scene/SceneModel.h>
+#include <ituGL/scene/Transform.h>
+#include <ituGL/scene/RendererSceneVisitor.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+void BenchmarkApplication::RunSortBenchmarks()
+{
+    const unsigned int meshCount = 32;
+    const unsigned int submeshCount = 4;
+    const unsigned int materialCount = 64;
+    const unsigned int drawcallCount = 50000;
+
+    BenchmarkRandom random(1234);
+
+    VertexFormat vertexFormat;
+    vertexFormat.AddVertexAttribute<float>(3, VertexAttribute::Semantic::Position);
+    std::vector<glm::vec3> vertices(3, glm::vec3(0.0f));
+
+    std::vector<std::shared_ptr<Material>> materials;
+    for (unsigned int i = 0; i < materialCount; ++i)
+    {
+        std::shared_ptr<Material> material = std::make_shared<Material>();
+        // One out of 8 materials is translucent
+        if (i % 8 == 0)
+        {
+            material->SetBlendEquation(Material::BlendEquation::Add);
+        }
+        materials.push_back(material);
+    }
+
+    std::vector<Model> models;
+    for (unsigned int i = 0; i < meshCount; ++i)
+    {
+        std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+        Model& model = models.emplace_back(mesh);
+        for (unsigned int j = 0; j < submeshCount; ++j)
+        {
+            mesh->AddSubmesh<glm::vec3, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles, vertices, vertexFormat.LayoutBegin(3, false), vertexFormat.LayoutEnd());
+            model.AddMaterial(materials[random.GetIndex(materialCount)]);
+        }
+    }
+
+    std::vector<glm::mat4> worldMatrices;
+    for (unsigned int i = 0; i < drawcallCount / submeshCount; ++i)
+    {
+        worldMatrices.push_back(glm::translate(glm::mat4(1.0f), random.GetVec3(-100.0f, 100.0f)));
+    }
+
+    Camera camera;
+    camera.SetViewMatrix(glm::vec3(0.0f, 0.0f, 150.0f), glm::vec3(0.0f));
+    camera.SetPerspectiveProjectionMatrix(1.0f, 1.0f, 0.1f, 500.0f);
+
+    // Submit the same drawcalls before each iteration
+    Renderer renderer(GetDevice());
+    auto submitDrawcalls = [&]()
+    {
+        ResetRenderer(renderer);
+        renderer.SetCurrentCamera(camera);
+        for (unsigned int i = 0; i < worldMatrices.size(); ++i)
+        {
+            renderer.AddModel(models[i % meshCount], worldMatrices[i]);
+        }
+    };
+
+    const unsigned int iterations = 100;
+
+    // Only the depth: a different and simpler order than the sort keys, that doesn't group the drawcalls by state
+    RunBenchmark("Sort 50k drawcalls front to back (comparator)", iterations, [&]()
+        {
+            renderer.SortDrawcallCollection(0, [&](const Renderer::DrawcallInfo& a, const Renderer::DrawcallInfo& b)
+                {
+                    return renderer.IsFrontToBack(a, b);
+                });
+        }, submitDrawcalls);
+
+    // Same order as the sort keys, without packing: opaque first, grouped by state and front to back, then translucent back to front
+    auto getState = [](const Renderer::DrawcallInfo& drawcallInfo)
+        {
+            const ShaderProgram* shaderProgram = drawcallInfo.GetMaterial().GetShaderProgramPointer();
+            return std::make_tuple(shaderProgram ? shaderProgram->GetHandle() : 0u, drawcallInfo.GetMaterial().GetSortId(), drawcallInfo.GetVAO().GetHandle());
+        };
+    RunBenchmark("Sort 50k drawcalls by state (comparator)", iterations, [&]()
+        {
+            renderer.SortDrawcallCollection(0, [&](const Renderer::DrawcallInfo& a, const Renderer::DrawcallInfo& b)
+                {
+                    bool translucentA = a.GetMaterial().HasBlend();
+                    bool translucentB = b.GetMaterial().HasBlend();
+                    if (translucentA != translucentB)
+                    {
+                        return translucentB;
+                    }
+                    if (translucentA)
+                    {
+                        return renderer.IsBackToFront(a, b);
+                    }
+                    auto stateA = getState(a), stateB = getState(b);
+                    return stateA != stateB ? stateA < stateB : renderer.IsFrontToBack(a, b);
+                });
+        }, submitDrawcalls);
+
+    RunBenchmark("Sort 50k drawcalls by state (sort keys)", iterations, [&]()
+        {
+            renderer.SortDrawcallCollection(0);
+        }, submitDrawcalls);
+
+    // Sorting and building the batches, as a pass would do. An order-independent collection skips the sort, and its
+    // translucent drawcalls can be batched like the opaque ones
+    auto sortAndBatch = [&]()
+        {
+            renderer.SortDrawcallCollection(0);
+            KeepResult(renderer.GetDrawcallBatches(0).size());
+        };
+    RunBenchmark("Sort and batch 50k drawcalls (sort keys)", iterations, sortAndBatch, submitDrawcalls);
+
+    renderer.SetDrawcallCollectionOrderIndependent(0, true);
+    RunBenchmark("Sort and batch 50k drawcalls (order independent)", iterations, sortAndBatch, submitDrawcalls);
+}
+
+void BenchmarkApplication::RunTransformBenchmarks()
+{
+    const unsigned int matrixCount = 50000;
+
+    BenchmarkRandom random(8765);
+
+    std::vector<glm::mat4> worldMatrices;
+    for (unsigned int i = 0; i < matrixCount; ++i)
+    {
+        worldMatrices.push_back(random.GetWorldMatrix(100.0f, 0.1f, 5.0f));
+    }
+
+    Camera camera;
+    camera.SetViewMatrix(glm::vec3(10.0f, 5.0f, 30.0f), glm::vec3(0.0f));
+    camera.SetPerspectiveProjectionMatrix(1.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+
+    // The SIMD kernel is checked against glm in the transform_batch tests
+    TransformBatch glmBatch, simdBatch;
+    std::printf("Transforms: SIMD kernel (%s)\n", TransformBatch::GetSimdName());
+
+    const unsigned int iterations = 100;
+
+    RunBenchmark("Transform 50k matrices (glm)", iterations, [&]()
+        {
+            glmBatch.Compute(worldMatrices, camera.GetViewMatrix(), camera.GetProjectionMatrix(), TransformBatch::Kernel::Glm);
+        });
+
+    RunBenchmark((std::string("Transform 50k matrices (") + TransformBatch::GetSimdName() + ")").c_str(), iterations, [&]()
+        {
+            simdBatch.Compute(worldMatrices, camera.GetViewMatrix(), camera.GetProjectionMatrix(), TransformBatch::Kernel::Simd);
+        });
+}
+
+void BenchmarkApplication::RunShaderProgramDispatchBenchmarks()
+{
+    const unsigned int shaderProgramCount = 16;
+    const unsigned int meshCount = 32;
+    const unsigned int drawcallCount = 50000;
+
+    BenchmarkRandom random(4321);
+
+    // Small shader programs, so the functions only measure the dispatch
+    Shader vertexShader(Shader::VertexShader);
+    vertexShader.SetSource("#version 330 core\nlayout (location = 0) in vec3 VertexPosition;\nvoid main() { gl_Position = vec4(VertexPosition, 1.0); }\n");
+    vertexShader.Compile();
+    Shader fragmentShader(Shader::FragmentShader);
+    fragmentShader.SetSource("#version 330 core\nout vec4 FragColor;\nvoid main() { FragColor = vec4(1.0); }\n");
+    fragmentShader.Compile();
+
+    std::vector<std::shared_ptr<Material>> materials;
+    for (unsigned int i = 0; i < shaderProgramCount; ++i)
+    {
+        std::shared_ptr<ShaderProgram> shaderProgram = std::make_shared<ShaderProgram>();
+        shaderProgram->Build(vertexShader, fragmentShader);
+        materials.push_back(std::make_shared<Material>(shaderProgram));
+    }
+
+    VertexFormat vertexFormat;
+    vertexFormat.AddVertexAttribute<float>(3, VertexAttribute::Semantic::Position);
+    std::vector<glm::vec3> vertices(3, glm::vec3(0.0f));
+
+    std::vector<Model> models;
+    for (unsigned int i = 0; i < meshCount; ++i)
+    {
+        std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+        Model& model = models.emplace_back(mesh);
+        mesh->AddSubmesh<glm::vec3, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles, vertices, vertexFormat.LayoutBegin(3, false), vertexFormat.LayoutEnd());
+        model.AddMaterial(materials[random.GetIndex(shaderProgramCount)]);
+    }
+
+    // The functions only add to a checksum, so both dispatches must call them the same way
+    double checksum = 0.0;
+    Renderer::UpdateTransformsFunction updateTransforms = [&](const ShaderProgram&, const glm::mat4& worldMatrix, const Camera&, bool)
+    {
+        checksum += worldMatrix[3][0];
+    };
+    Renderer::UpdateLightsFunction updateLights = [&](const ShaderProgram&, std::span<const Light* const>, unsigned int& lightIndex)
+    {
+        checksum += 1.0;
+        return lightIndex++ == 0;
+    };
+
+    Camera camera;
+    camera.SetViewMatrix(glm::vec3(0.0f, 0.0f, 150.0f), glm::vec3(0.0f));
+    camera.SetPerspectiveProjectionMatrix(1.0f, 1.0f, 0.1f, 500.0f);
+
+    Renderer renderer(GetDevice());
+    for (const std::shared_ptr<Material>& material : materials)
+    {
+        renderer.RegisterShaderProgram(material->GetShaderProgram(), updateTransforms, updateLights);
+    }
+    renderer.SetCurrentCamera(camera);
+    std::vector<glm::mat4> worldMatrices;
+    for (unsigned int i = 0; i < drawcallCount; ++i)
+    {
+        worldMatrices.push_back(glm::translate(glm::mat4(1.0f), random.GetVec3(-100.0f, 100.0f)));
+        renderer.AddModel(models[i % meshCount], worldMatrices.back());
+    }
+    std::span<const Renderer::DrawcallInfo> drawcallInfos = renderer.GetDrawcalls(0);
+
+    // Reference: the functions in maps keyed by the shared pointer of the shader program, as they were before the ids
+    std::unordered_map<std::shared_ptr<const ShaderProgram>, Renderer::UpdateTransformsFunction> updateTransformsMap;
+    std::unordered_map<std::shared_ptr<const ShaderProgram>, Renderer::UpdateLightsFunction> updateLightsMap;
+    for (const std::shared_ptr<Material>& material : materials)
+    {
+        updateTransformsMap[material->GetShaderProgram()] = updateTransforms;
+        updateLightsMap[material->GetShaderProgram()] = updateLights;
+    }
+
+    std::span<const Light* const> lights;
+    auto dispatchMap = [&]()
+    {
+        for (const Renderer::DrawcallInfo& drawcallInfo : drawcallInfos)
+        {
+            std::shared_ptr<const ShaderProgram> shaderProgram = drawcallInfo.GetMaterial().GetShaderProgram();
+            const auto& itTransforms = updateTransformsMap.find(shaderProgram);
+            if (itTransforms != updateTransformsMap.end())
+            {
+                itTransforms->second(*shaderProgram, worldMatrices[drawcallInfo.GetWorldMatrixIndex()], camera, false);
+            }
+            unsigned int lightIndex = 0;
+            const auto& itLights = updateLightsMap.find(shaderProgram);
+            while (itLights != updateLightsMap.end() && itLights->second(*shaderProgram, lights, lightIndex))
+            {
+            }
+        }
+    };
+    auto dispatchIds = [&]()
+    {
+        for (const Renderer::DrawcallInfo& drawcallInfo : drawcallInfos)
+        {
+            Renderer::ShaderProgramId shaderProgramId = drawcallInfo.GetShaderProgramId();
+            renderer.UpdateTransforms(shaderProgramId, drawcallInfo.GetWorldMatrixIndex(), false);
+            unsigned int lightIndex = 0;
+            while (renderer.UpdateLights(shaderProgramId, lights, lightIndex))
+            {
+            }
+        }
+    };
+
+    dispatchMap();
+    double mapChecksum = checksum;
+    checksum = 0.0;
+    dispatchIds();
+    bool valid = Validate("Shader program dispatch", checksum == mapChecksum);
+    std::printf("Shader program dispatch: %zu drawcalls, %u shader programs, ids %s\n",
+        drawcallInfos.size(), shaderProgramCount, valid ? "valid" : "INVALID");
+
+    const unsigned int iterations = 100;
+
+    RunBenchmark("Dispatch 50k drawcalls (shared_ptr map)", iterations, dispatchMap);
+    RunBenchmark("Dispatch 50k drawcalls (shader program ids)", iterations, dispatchIds);
+
+    ResetRenderer(renderer);
+}
+
+void BenchmarkApplication::RunSceneTraversalBenchmarks()
+{
+    const unsigned int meshCount = 16;
+    const unsigned int materialCount = 64;
+    const unsigned int modelCount = 100000;
+
+    BenchmarkRandom random(8765);
+
+    VertexFormat vertexFormat;
+    vertexFormat.AddVertexAttribute<float>(3, VertexAttribute::Semantic::Position);
+    std::vector<glm::vec3> vertices(3, glm::vec3(0.0f));
+
+    std::vector<std::shared_ptr<Material>> materials;
+    for (unsigned int i = 0; i < materialCount; ++i)
+    {
+        materials.push_back(std::make_shared<Material>());
+    }
+
+    std::vector<std::shared_ptr<Model>> models;
+    for (unsigned int i = 0; i < meshCount; ++i)
+    {
+        std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+        std::shared_ptr<Model> model = std::make_shared<Model>(mesh);
+        for (unsigned int j = 0; j < 2; ++j)
+        {
+            mesh->AddSubmesh<glm::vec3, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles, vertices, vertexFormat.LayoutBegin(3, false), vertexFormat.LayoutEnd());
+            model->AddMaterial(materials[random.GetIndex(materialCount)]);
+        }
+        model->SetLocalBounds(AabbBounds(glm::vec3(0.0f), glm::vec3(1.0f)));
+        models.push_back(model);
+    }
+
+    Scene scene;
+    std::shared_ptr<Camera> camera = std::make_shared<Camera>();
+    camera->SetViewMatrix(glm::vec3(0.0f, 0.0f, 250.0f), glm::vec3(0.0f));
+    camera->SetPerspectiveProjectionMatrix(1.0f, 1.0f, 0.1f, 500.0f);
+    scene.AddSceneNode(std::make_shared<SceneCamera>("camera", camera));
+    for (unsigned int i = 0; i < modelCount; ++i)
+    {
+        std::shared_ptr<Transform> transform = std::make_shared<Transform>();
+        transform->SetTranslation(random.GetVec3(-200.0f, 200.0f));
+        scene.AddSceneNode(std::make_shared<SceneModel>("model " + std::to_string(i), models[i % meshCount], transform));
+    }
+
+    Renderer renderer(GetDevice());
+    auto visitSerial = [&]()
+    {
+        RendererSceneVisitor rendererSceneVisitor(renderer);
+        rendererSceneVisitor.EnableFrustumCulling(*camera);
+        scene.AcceptVisitor(rendererSceneVisitor);
+    };
+    auto visitParallel = [&]()
+    {
+        RendererSceneVisitor rendererSceneVisitor(renderer);
+        rendererSceneVisitor.EnableFrustumCulling(*camera);
+        rendererSceneVisitor.VisitParallel(scene);
+    };
+
+    // Both visits must give the same drawcalls, in the same order
+    visitSerial();
+    std::vector<Renderer::SortKey> serialSortKeys;
+    std::vector<unsigned int> serialWorldMatrixIndices;
+    for (const Renderer::DrawcallInfo& drawcallInfo : renderer.GetDrawcalls(0))
+    {
+        serialSortKeys.push_back(drawcallInfo.GetSortKey());
+        serialWorldMatrixIndices.push_back(drawcallInfo.GetWorldMatrixIndex());
+    }
+    ResetRenderer(renderer);
+
+    visitParallel();
+    std::span<const Renderer::DrawcallInfo> parallelDrawcalls = renderer.GetDrawcalls(0);
+    bool valid = parallelDrawcalls.size() == serialSortKeys.size();
+    for (unsigned int i = 0; valid && i < parallelDrawcalls.size(); ++i)
+    {
+        valid = parallelDrawcalls[i].GetSortKey() == serialSortKeys[i] && parallelDrawcalls[i].GetWorldMatrixIndex() == serialWorldMatrixIndices[i];
+    }
+    ResetRenderer(renderer);
+    Validate("Scene traversal", valid);
+    std::printf("Scene traversal: %zu drawcalls, parallel merge %s, %u workers\n",
+        serialSortKeys.size(), valid ? "valid" : "INVALID", renderer.GetThreadPool().GetThreadCount());
+
+    const unsigned int iterations = 50;
+
+    auto resetRenderer = [&]() { ResetRenderer(renderer); };
+    RunBenchmark("Visit 100k models (serial)", iterations, visitSerial, resetRenderer);
+    RunBenchmark("Visit 100k models (parallel)", iterations, visitParallel, resetRenderer);
+}
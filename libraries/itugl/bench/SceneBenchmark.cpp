@@ -0,0 +1,587 @@
+#include "SceneBenchmark.h"
+
+#include "BenchmarkUtils.h"
+
+#include <ituGL/core/DeviceGL.h>
+#include <ituGL/asset/ShaderLoader.h>
+#include <ituGL/asset/ModelLoader.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/geometry/Model.h>
+#include <ituGL/geometry/MeshPool.h>
+#include <ituGL/lighting/DirectionalLight.h>
+#include <ituGL/lighting/PointLight.h>
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/renderer/RenderGraph.h>
+#include <ituGL/renderer/ForwardRenderPass.h>
+#include <ituGL/renderer/PostFXRenderPass.h>
+#include <ituGL/scene/Scene.h>
+#include <ituGL/scene/SceneCamera.h>
+#include <ituGL/scene/SceneLight.h>
+#include <ituGL/scene/SceneModel.h>
+#include <ituGL/scene/Transform.h>
+#include <ituGL/scene/RendererSceneVisitor.h>
+#include <ituGL/scene/RetainedSceneRegistry.h>
+#include <ituGL/shader/Material.h>
+#include <ituGL/shader/ShaderUniformCollection.h>
+#include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/texture/FramebufferObject.h>
+#include <ituGL/utils/Profiler.h>
+#include <ituGL/utils/ThreadPool.h>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+// Folder of the exercises, set by the build
+#ifndef ITUGL_BENCH_ASSETS_DIR
+#define ITUGL_BENCH_ASSETS_DIR "exercises/"
+#endif
+
+namespace
+{
+    // Calls to OpenGL functions, counted by the pre callback of the debug glad loader
+    unsigned int s_glCallCount = 0;
+    unsigned int s_glDrawCallCount = 0;
+
+    void CountGLCall(const char* name, void*, int, ...)
+    {
+        ++s_glCallCount;
+        if (std::strncmp(name, "glDraw", 6) == 0 || std::strncmp(name, "glMultiDraw", 11) == 0)
+        {
+            ++s_glDrawCallCount;
+        }
+    }
+
+    std::string GetAssetPath(const char* path)
+    {
+        return std::string(ITUGL_BENCH_ASSETS_DIR) + path;
+    }
+
+    Shader LoadShader(Shader::Type type, std::initializer_list<const char*> paths)
+    {
+        std::vector<std::string> assetPaths;
+        std::vector<const char*> assetPathPointers;
+        for (const char* path : paths)
+        {
+            assetPaths.push_back(GetAssetPath(path));
+        }
+        for (const std::string& assetPath : assetPaths)
+        {
+            assetPathPointers.push_back(assetPath.c_str());
+        }
+        return ShaderLoader(type).Load(assetPathPointers);
+    }
+
+    // The forward pass draws over the previous content, so the targets are cleared first
+    class ClearRenderPass : public RenderPass
+    {
+    public:
+        void Render() override
+        {
+            GetRenderer().GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), true, 1.0f);
+        }
+
+        const char* GetName() const override { return "Clear"; }
+    };
+}
+
+SceneBenchmark::SceneBenchmark(DeviceGL& device, Profiler& profiler, int width, int height)
+    : m_device(device)
+    , m_profiler(profiler)
+    , m_width(width)
+    , m_height(height)
+{
+}
+
+bool SceneBenchmark::Initialize()
+{
+    // Same forward material as exercise 08
+    Shader vertexShader = LoadShader(Shader::VertexShader, {
+        "exercise08/shaders/version330.glsl",
+        "exercise08/shaders/renderer/uniforms.glsl",
+        "exercise08/shaders/default.vert" });
+    Shader fragmentShader = LoadShader(Shader::FragmentShader, {
+        "exercise08/shaders/version330.glsl",
+        "exercise08/shaders/renderer/uniforms.glsl",
+        "exercise08/shaders/utils.glsl",
+        "exercise08/shaders/lambert-ggx.glsl",
+        "exercise08/shaders/lighting.glsl",
+        "exercise08/shaders/default_pbr.frag" });
+
+    m_forwardShaderProgram = std::make_shared<ShaderProgram>();
+    if (!m_forwardShaderProgram->Build(vertexShader, fragmentShader))
+    {
+        std::printf("Scene benchmarks: failed to build the forward shader program\n");
+        return false;
+    }
+
+    // Filter out uniforms that are not material properties
+    ShaderUniformCollection::NameSet filteredUniforms;
+    filteredUniforms.insert("WorldMatrix");
+    filteredUniforms.insert("LightIndirect");
+    filteredUniforms.insert("LightColor");
+    filteredUniforms.insert("LightPosition");
+    filteredUniforms.insert("LightDirection");
+    filteredUniforms.insert("LightAttenuation");
+
+    m_forwardMaterial = std::make_shared<Material>(m_forwardShaderProgram, filteredUniforms);
+    m_forwardMaterial->SetUniformValue("AmbientColor", glm::vec3(0.25f));
+    m_forwardMaterial->SetUniformValue("EnvironmentMaxLod", 0.0f);
+    m_forwardMaterial->SetUniformValue("Color", glm::vec3(1.0f));
+
+    // Same depth pre-pass material as exercise 08
+    Shader depthVertexShader = LoadShader(Shader::VertexShader, {
+        "exercise08/shaders/version330.glsl",
+        "exercise08/shaders/renderer/uniforms.glsl",
+        "exercise08/shaders/renderer/depth.vert" });
+    Shader depthFragmentShader = LoadShader(Shader::FragmentShader, {
+        "exercise08/shaders/version330.glsl",
+        "exercise08/shaders/renderer/depth.frag" });
+
+    m_depthShaderProgram = std::make_shared<ShaderProgram>();
+    if (!m_depthShaderProgram->Build(depthVertexShader, depthFragmentShader))
+    {
+        std::printf("Scene benchmarks: failed to build the depth shader program\n");
+        return false;
+    }
+
+    ShaderUniformCollection::NameSet depthFilteredUniforms;
+    depthFilteredUniforms.insert("WorldMatrix");
+    m_depthMaterial = std::make_shared<Material>(m_depthShaderProgram, depthFilteredUniforms);
+
+    // Configure loader
+    ModelLoader loader(m_forwardMaterial);
+    loader.SetCreateMaterials(true);
+    loader.GetTexture2DLoader().SetFlipVertical(true);
+    loader.SetMaterialAttribute(VertexAttribute::Semantic::Position, "VertexPosition");
+    loader.SetMaterialAttribute(VertexAttribute::Semantic::Normal, "VertexNormal");
+    loader.SetMaterialAttribute(VertexAttribute::Semantic::Tangent, "VertexTangent");
+    loader.SetMaterialAttribute(VertexAttribute::Semantic::Bitangent, "VertexBitangent");
+    loader.SetMaterialAttribute(VertexAttribute::Semantic::TexCoord0, "VertexTexCoord");
+    loader.SetMaterialProperty(ModelLoader::MaterialProperty::DiffuseColor, "Color");
+    loader.SetMaterialProperty(ModelLoader::MaterialProperty::DiffuseTexture, "ColorTexture");
+    loader.SetMaterialProperty(ModelLoader::MaterialProperty::NormalTexture, "NormalTexture");
+    loader.SetMaterialProperty(ModelLoader::MaterialProperty::SpecularTexture, "SpecularTexture");
+
+    // Every model gets levels of detail, only the lod scenes use them. They are not cached, to measure the simplification
+    ThreadPool threadPool;
+    loader.SetLodGeneration(3);
+    loader.SetThreadPool(&threadPool);
+
+    const char* modelPaths[] = {
+        "exercise09/models/cannon/cannon.obj",
+        "exercise08/models/camera/camera.obj",
+        "exercise08/models/tea_set/tea_set.obj",
+    };
+    for (const char* modelPath : modelPaths)
+    {
+        std::string path = GetAssetPath(modelPath);
+        if (!std::ifstream(path))
+        {
+            std::printf("Scene benchmarks: model not found: %s\n", path.c_str());
+            return false;
+        }
+
+        // Loading time is measured too, to track the loaders
+        auto startTime = std::chrono::steady_clock::now();
+        m_models.push_back(loader.LoadShared(path.c_str()));
+        std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - startTime;
+        std::printf("Load %-35s %9.4f ms\n", modelPath, duration.count());
+    }
+
+    // Instanced version of the forward material, shared by all the submeshes, so consecutive draws only change the geometry
+    Shader instancedVertexShader = LoadShader(Shader::VertexShader, {
+        "exercise08/shaders/version330.glsl",
+        "exercise08/shaders/renderer/uniforms.glsl",
+        "exercise08/shaders/default_instanced.vert" });
+
+    m_instancedShaderProgram = std::make_shared<ShaderProgram>();
+    if (!m_instancedShaderProgram->Build(instancedVertexShader, fragmentShader))
+    {
+        std::printf("Scene benchmarks: failed to build the instanced shader program\n");
+        return false;
+    }
+
+    m_sharedMaterial = std::make_shared<Material>(m_instancedShaderProgram, filteredUniforms);
+    m_sharedMaterial->SetUniformValue("AmbientColor", glm::vec3(0.25f));
+    m_sharedMaterial->SetUniformValue("EnvironmentMaxLod", 0.0f);
+    m_sharedMaterial->SetUniformValue("Color", glm::vec3(1.0f));
+
+    // Plain textures instead of the ones of the files: white albedo, flat normals, no occlusion, medium roughness, not metallic
+    auto setTexture = [&](const char* name, std::array<GLubyte, 4> texel)
+    {
+        std::shared_ptr<Texture2DObject> texture = std::make_shared<Texture2DObject>();
+        texture->Bind();
+        texture->SetImage<GLubyte>(0, 1, 1, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA8, texel);
+        texture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
+        texture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
+        Texture2DObject::Unbind();
+        m_sharedMaterial->SetUniformValue(name, texture);
+        m_sharedTextures.push_back(texture);
+    };
+    setTexture("ColorTexture", { 255, 255, 255, 255 });
+    setTexture("NormalTexture", { 128, 128, 255, 255 });
+    setTexture("SpecularTexture", { 255, 128, 0, 255 });
+
+    ModelLoader sharedLoader(m_sharedMaterial);
+    sharedLoader.SetMaterialAttribute(VertexAttribute::Semantic::Position, "VertexPosition");
+    sharedLoader.SetMaterialAttribute(VertexAttribute::Semantic::Normal, "VertexNormal");
+    sharedLoader.SetMaterialAttribute(VertexAttribute::Semantic::Tangent, "VertexTangent");
+    sharedLoader.SetMaterialAttribute(VertexAttribute::Semantic::Bitangent, "VertexBitangent");
+    sharedLoader.SetMaterialAttribute(VertexAttribute::Semantic::TexCoord0, "VertexTexCoord");
+    for (const char* modelPath : modelPaths)
+    {
+        m_sharedMaterialModels.push_back(sharedLoader.LoadShared(GetAssetPath(modelPath).c_str()));
+    }
+
+    // The pooled models share one VAO per vertex format
+    // A model loaded first and released leaves a hole before them, so the scene is drawn after moving them with a defragmentation
+    m_meshPool = std::make_shared<MeshPool>();
+    sharedLoader.SetMeshPool(m_meshPool);
+    std::shared_ptr<Model> releasedModel = std::make_shared<Model>(sharedLoader.Load(GetAssetPath(modelPaths[0]).c_str()));
+    for (const char* modelPath : modelPaths)
+    {
+        // Not LoadShared, it would return the models loaded above without the pool
+        m_pooledModels.push_back(std::make_shared<Model>(sharedLoader.Load(GetAssetPath(modelPath).c_str())));
+    }
+    releasedModel.reset();
+
+    auto getFragmentation = [&]()
+        {
+            float fragmentation = 0.0f;
+            for (unsigned int bucketIndex = 0; bucketIndex < m_meshPool->GetBucketCount(); ++bucketIndex)
+            {
+                fragmentation = std::max(fragmentation, m_meshPool->GetVertexAllocator(bucketIndex).GetStats().GetFragmentation());
+                fragmentation = std::max(fragmentation, m_meshPool->GetElementAllocator(bucketIndex).GetStats().GetFragmentation());
+            }
+            return fragmentation;
+        };
+    float fragmentation = getFragmentation();
+    size_t movedSize = m_meshPool->Defragment();
+    std::printf("Mesh pool: %u buffers, %.2f MB used of %.2f MB, fragmentation %.3f, defragmentation moved %.2f MB to %.3f\n",
+        m_meshPool->GetBucketCount(), m_meshPool->GetUsedSize() / (1024.0 * 1024.0), m_meshPool->GetAllocatedSize() / (1024.0 * 1024.0),
+        fragmentation, movedSize / (1024.0 * 1024.0), getFragmentation());
+
+    // Every scene counts the GL calls of its frames
+    glad_set_pre_callback(CountGLCall);
+
+    return true;
+}
+
+std::vector<Benchmark> SceneBenchmark::Run(const Settings& settings, std::vector<unsigned char>* lastFrame)
+{
+    BenchmarkRandom random(2468);
+
+    // Models on a square grid in the XZ plane
+    const float spacing = 1.5f;
+    const std::vector<std::shared_ptr<Model>>& models = settings.multiDraw ? m_pooledModels : settings.sharedMaterial ? m_sharedMaterialModels : m_models;
+    const unsigned int modelCount = settings.modelCopies * static_cast<unsigned int>(models.size());
+    const unsigned int gridSize = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<float>(modelCount))));
+    const float gridExtent = gridSize * spacing;
+
+    Scene scene;
+    for (unsigned int i = 0; i < modelCount; ++i)
+    {
+        std::shared_ptr<Transform> transform = std::make_shared<Transform>();
+        glm::vec3 position((i % gridSize + 0.5f) * spacing - gridExtent * 0.5f, 0.0f, (i / gridSize + 0.5f) * spacing - gridExtent * 0.5f);
+        float jitterX = random.GetFloat(-0.25f, 0.25f);
+        float jitterZ = random.GetFloat(-0.25f, 0.25f);
+        transform->SetTranslation(position + glm::vec3(jitterX, 0.0f, jitterZ));
+        transform->SetRotation(glm::vec3(0.0f, random.GetFloat(0.0f, glm::two_pi<float>()), 0.0f));
+        scene.AddSceneNode(std::make_shared<SceneModel>("model " + std::to_string(i), models[i % models.size()], transform));
+    }
+
+    std::shared_ptr<DirectionalLight> directionalLight = std::make_shared<DirectionalLight>();
+    directionalLight->SetDirection(glm::vec3(-0.3f, -1.0f, -0.3f));
+    directionalLight->SetIntensity(3.0f);
+    scene.AddSceneNode(std::make_shared<SceneLight>("directional light", directionalLight));
+
+    for (unsigned int i = 0; i < settings.pointLightCount; ++i)
+    {
+        std::shared_ptr<PointLight> pointLight = std::make_shared<PointLight>();
+        float positionX = random.GetFloat(-0.5f, 0.5f);
+        float positionZ = random.GetFloat(-0.5f, 0.5f);
+        pointLight->SetPosition(glm::vec3(positionX * gridExtent, 1.0f, positionZ * gridExtent));
+        pointLight->SetColor(random.GetVec3(0.0f, 1.0f));
+        pointLight->SetDistanceAttenuation(glm::vec2(2.0f, 4.0f));
+        scene.AddSceneNode(std::make_shared<SceneLight>("point light " + std::to_string(i), pointLight));
+    }
+
+    // The camera orbits the grid once along the frames
+    const float orbitRadius = gridExtent * 0.75f + 2.0f;
+    std::shared_ptr<Camera> camera = std::make_shared<Camera>();
+    camera->SetPerspectiveProjectionMatrix(1.0f, static_cast<float>(m_width) / m_height, 0.1f, orbitRadius * 3.0f);
+    scene.AddSceneNode(std::make_shared<SceneCamera>("camera", camera));
+
+    Renderer renderer(m_device);
+    RegisterShaderPrograms(renderer);
+    renderer.SetStageTimingEnabled(true);
+    if (settings.postFX)
+    {
+        AddPostFXPasses(renderer, settings.resolutionScale);
+    }
+    else
+    {
+        renderer.AddRenderPass(std::make_unique<ClearRenderPass>());
+        std::unique_ptr<ForwardRenderPass> forwardRenderPass = std::make_unique<ForwardRenderPass>();
+        if (settings.depthPrepass)
+        {
+            forwardRenderPass->SetDepthPrepassMaterial(m_depthMaterial);
+        }
+        forwardRenderPass->SetMultiDrawEnabled(settings.multiDraw);
+        renderer.AddRenderPass(std::move(forwardRenderPass));
+    }
+
+    // Destroyed before the renderer
+    RetainedSceneRegistry retainedSceneRegistry(renderer);
+    if (settings.retained)
+    {
+        scene.AcceptVisitor(retainedSceneRegistry);
+    }
+
+    std::vector<double> visitSamples, addModelSamples, sortSamples, prepareSamples, submissionSamples, frameSamples;
+    std::vector<unsigned int> profilerFrames;
+    unsigned int drawcallCount = 0;
+    double triangleCount = 0;
+    unsigned int glCallCount = 0;
+    unsigned int glDrawCallCount = 0;
+
+    // The first frames allocate the textures and upload the data, they are not measured
+    const unsigned int warmupFrames = 3;
+    for (unsigned int frame = 0; frame < warmupFrames + settings.frameCount; ++frame)
+    {
+        bool measured = frame >= warmupFrames;
+
+        float angle = glm::two_pi<float>() * (static_cast<float>(frame) - warmupFrames) / settings.frameCount;
+        glm::vec3 cameraPosition(std::cos(angle) * orbitRadius, orbitRadius * 0.4f, std::sin(angle) * orbitRadius);
+        camera->SetViewMatrix(cameraPosition, glm::vec3(0.0f));
+
+        m_profiler.BeginFrame();
+        profilerFrames.push_back(m_profiler.GetFrames().back().index);
+        renderer.ResetStageTimings();
+        s_glCallCount = 0;
+        s_glDrawCallCount = 0;
+
+        auto startTime = std::chrono::steady_clock::now();
+        {
+            // Retained models are not culled, the registry only sends the ones that moved
+            if (settings.retained)
+            {
+                retainedSceneRegistry.Update();
+            }
+            RendererSceneVisitor rendererSceneVisitor(renderer);
+            rendererSceneVisitor.SetModelsEnabled(!settings.retained);
+            rendererSceneVisitor.EnableFrustumCulling(*camera);
+            if (settings.lod)
+            {
+                rendererSceneVisitor.EnableLodSelection(*camera);
+            }
+            scene.AcceptVisitor(rendererSceneVisitor);
+        }
+        std::chrono::duration<double, std::milli> visitDuration = std::chrono::steady_clock::now() - startTime;
+
+        renderer.SortDrawcallCollection(0);
+        unsigned int frameDrawcallCount = static_cast<unsigned int>(renderer.GetDrawcalls(0).size());
+        unsigned int frameTriangleCount = 0;
+        for (const Renderer::DrawcallInfo& drawcallInfo : renderer.GetDrawcalls(0))
+        {
+            const Drawcall& drawcall = drawcallInfo.GetDrawcall();
+            frameTriangleCount += drawcall.GetPrimitive() == Drawcall::Primitive::Triangles ? drawcall.GetCount() / 3 : 0;
+        }
+
+        {
+            Profiler::Scope scope("Scene", true);
+            renderer.Render();
+        }
+        std::chrono::duration<double, std::milli> frameDuration = std::chrono::steady_clock::now() - startTime;
+
+        m_profiler.EndFrame();
+
+        // Wait for the GPU, so the work of one frame does not overlap with the measures of the next one
+        glFinish();
+
+        if (lastFrame && frame == warmupFrames + settings.frameCount - 1)
+        {
+            lastFrame->resize(static_cast<size_t>(m_width) * m_height * 4);
+            FramebufferObject::Unbind(FramebufferObject::Target::Read);
+            glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, lastFrame->data());
+        }
+
+        if (measured)
+        {
+            const Renderer::StageTimings& timings = renderer.GetStageTimings();
+            visitSamples.push_back(visitDuration.count() - timings.addModel);
+            addModelSamples.push_back(timings.addModel);
+            sortSamples.push_back(timings.sort);
+            prepareSamples.push_back(timings.prepareDrawcalls);
+            submissionSamples.push_back(timings.renderPasses - timings.prepareDrawcalls);
+            frameSamples.push_back(frameDuration.count());
+            drawcallCount += frameDrawcallCount;
+            triangleCount += frameTriangleCount;
+            glCallCount += s_glCallCount;
+            glDrawCallCount += s_glDrawCallCount;
+        }
+    }
+
+    // Empty frames until the timestamps of the last measured frame are resolved
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        m_profiler.BeginFrame();
+        m_profiler.EndFrame();
+    }
+
+    std::vector<double> gpuSamples;
+    for (const Profiler::Frame& profilerFrame : m_profiler.GetFrames())
+    {
+        bool measured = std::find(profilerFrames.begin() + warmupFrames, profilerFrames.end(), profilerFrame.index) != profilerFrames.end();
+        if (measured && profilerFrame.gpuResolved)
+        {
+            for (const Profiler::Event& event : profilerFrame.gpuEvents)
+            {
+                if (std::strcmp(event.name, "Scene") == 0)
+                {
+                    gpuSamples.push_back(event.duration * 0.001);
+                }
+            }
+        }
+    }
+
+    std::string prefix = std::string("Scene ") + settings.name + ": ";
+    std::vector<Benchmark> benchmarks;
+    auto addBenchmark = [&](const char* stage, std::vector<double>& samples) -> Benchmark&
+    {
+        Benchmark& benchmark = benchmarks.emplace_back((prefix + stage).c_str());
+        benchmark.SetSamples(std::move(samples));
+        return benchmark;
+    };
+
+    addBenchmark("scene visit", visitSamples);
+    addBenchmark("AddModel", addModelSamples);
+    addBenchmark("sort", sortSamples);
+    addBenchmark("PrepareDrawcall", prepareSamples);
+    addBenchmark("draw submission", submissionSamples);
+
+    // Counters are averages per frame
+    Benchmark& frameBenchmark = addBenchmark("frame", frameSamples);
+    double frameCount = settings.frameCount;
+    frameBenchmark.SetCounter("models", modelCount);
+    frameBenchmark.SetCounter("point_lights", settings.pointLightCount);
+    frameBenchmark.SetCounter("drawcalls", drawcallCount / frameCount);
+    frameBenchmark.SetCounter("triangles", triangleCount / frameCount);
+    frameBenchmark.SetCounter("gl_calls", glCallCount / frameCount);
+    frameBenchmark.SetCounter("gl_draw_calls", glDrawCallCount / frameCount);
+
+    // Timer queries might not be supported by the driver
+    if (!gpuSamples.empty())
+    {
+        addBenchmark("GPU", gpuSamples);
+    }
+
+    return benchmarks;
+}
+
+void SceneBenchmark::RegisterShaderPrograms(Renderer& renderer) const
+{
+    // The renderer sets WorldMatrix, camera uniforms are read from the FrameData block
+    renderer.RegisterShaderProgram(m_forwardShaderProgram,
+        nullptr,
+        renderer.GetDefaultUpdateLightsFunction(*m_forwardShaderProgram)
+    );
+    renderer.RegisterShaderProgram(m_depthShaderProgram, nullptr, nullptr);
+
+    // The world matrix comes in an instance attribute
+    renderer.RegisterShaderProgram(m_instancedShaderProgram,
+        nullptr,
+        renderer.GetDefaultUpdateLightsFunction(*m_instancedShaderProgram),
+        m_instancedShaderProgram->GetAttributeLocation("InstanceWorldMatrix")
+    );
+}
+
+void SceneBenchmark::AddPostFXPasses(Renderer& renderer, float resolutionScale) const
+{
+    // Same post-processing chain as exercise 09, after the forward pass
+    std::unique_ptr<RenderGraph> renderGraph = std::make_unique<RenderGraph>(m_width, m_height);
+    renderGraph->SetResolutionScale(resolutionScale);
+
+    RenderGraph::TextureDesc depthDesc;
+    depthDesc.format = TextureObject::FormatDepth;
+    depthDesc.internalFormat = TextureObject::InternalFormatDepth;
+    RenderGraph::TextureDesc sceneDesc;
+    RenderGraph::TextureDesc bloomDesc;
+    bloomDesc.scale = glm::vec2(0.5f);
+
+    RenderGraph::ResourceId depthTexture = renderGraph->CreateTexture("Depth", depthDesc);
+    RenderGraph::ResourceId sceneTexture = renderGraph->CreateTexture("Scene", sceneDesc);
+
+    unsigned int clearPass = renderGraph->AddPass(std::make_unique<ClearRenderPass>());
+    renderGraph->WriteTexture(clearPass, sceneTexture);
+    renderGraph->WriteTexture(clearPass, depthTexture);
+
+    unsigned int forwardPass = renderGraph->AddPass(std::make_unique<ForwardRenderPass>());
+    renderGraph->ReadTexture(forwardPass, sceneTexture);
+    renderGraph->ReadTexture(forwardPass, depthTexture);
+    renderGraph->WriteTexture(forwardPass, sceneTexture);
+    renderGraph->WriteTexture(forwardPass, depthTexture);
+
+    RenderGraph::ResourceId bloomTexture = renderGraph->CreateTexture("Bloom", bloomDesc);
+    std::shared_ptr<Material> bloomMaterial = CreatePostFXMaterial(renderer, "exercise09/shaders/postfx/bloom.frag");
+    bloomMaterial->SetUniformValue("Range", glm::vec2(2.0f, 3.0f));
+    bloomMaterial->SetUniformValue("Intensity", 1.0f);
+    unsigned int bloomPass = renderGraph->AddPass(std::make_unique<PostFXRenderPass>(bloomMaterial));
+    renderGraph->ReadTexture(bloomPass, sceneTexture, bloomMaterial, "SourceTexture");
+    renderGraph->WriteTexture(bloomPass, bloomTexture);
+
+    std::shared_ptr<Material> blurMaterial = CreatePostFXMaterial(renderer, "exercise09/shaders/postfx/blur.frag");
+    for (int direction = 0; direction < 2; ++direction)
+    {
+        std::shared_ptr<Material> blurPassMaterial = std::make_shared<Material>(*blurMaterial);
+        blurPassMaterial->SetUniformValue("Direction", direction == 0 ? glm::vec2(1.0f, 0.0f) : glm::vec2(0.0f, 1.0f));
+
+        RenderGraph::ResourceId blurTexture = renderGraph->CreateTexture("Blur", bloomDesc);
+        unsigned int blurPass = renderGraph->AddPass(std::make_unique<PostFXRenderPass>(blurPassMaterial));
+        renderGraph->ReadTexture(blurPass, bloomTexture, blurPassMaterial, "SourceTexture");
+        renderGraph->WriteTexture(blurPass, blurTexture);
+        bloomTexture = blurTexture;
+    }
+
+    std::shared_ptr<Material> composeMaterial = CreatePostFXMaterial(renderer, "exercise09/shaders/postfx/compose.frag");
+    composeMaterial->SetUniformValue("Exposure", 1.0f);
+    composeMaterial->SetUniformValue("Contrast", 1.0f);
+    composeMaterial->SetUniformValue("HueShift", 0.0f);
+    composeMaterial->SetUniformValue("Saturation", 1.0f);
+    composeMaterial->SetUniformValue("ColorFilter", glm::vec3(1.0f));
+    unsigned int composePass = renderGraph->AddPass(std::make_unique<PostFXRenderPass>(composeMaterial));
+    renderGraph->ReadTexture(composePass, sceneTexture, composeMaterial, "SourceTexture");
+    renderGraph->ReadTexture(composePass, bloomTexture, composeMaterial, "BloomTexture");
+    renderGraph->WriteTexture(composePass, RenderGraph::Backbuffer);
+
+    renderer.AddRenderPass(std::move(renderGraph));
+}
+
+std::shared_ptr<Material> SceneBenchmark::CreatePostFXMaterial(Renderer& renderer, const char* fragmentShaderPath) const
+{
+    Shader vertexShader = LoadShader(Shader::VertexShader, {
+        "exercise09/shaders/version330.glsl",
+        "exercise09/shaders/renderer/uniforms.glsl",
+        "exercise09/shaders/renderer/fullscreen.vert" });
+    Shader fragmentShader = LoadShader(Shader::FragmentShader, {
+        "exercise09/shaders/version330.glsl",
+        "exercise09/shaders/renderer/uniforms.glsl",
+        "exercise09/shaders/utils.glsl",
+        fragmentShaderPath });
+
+    std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
+    shaderProgramPtr->Build(vertexShader, fragmentShader);
+
+    // Only to bind the PassData block, for the resolution scale
+    renderer.RegisterShaderProgram(shaderProgramPtr, nullptr, nullptr);
+
+    return std::make_shared<Material>(shaderProgramPtr);
+}
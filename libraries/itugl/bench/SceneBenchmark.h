@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Benchmark.h"
+
+#include <memory>
+#include <vector>
+
+class DeviceGL;
+class Profiler;
+class Model;
+class Material;
+class ShaderProgram;
+class Renderer;
+class MeshPool;
+class Texture2DObject;
+
+// Renders a scripted scene along a fixed camera path and measures each stage of the renderer per frame
+// The scenes are made of copies of the models of the exercises, placed with a fixed seed, so every run renders the same frames
+class SceneBenchmark
+{
+public:
+    struct Settings
+    {
+        const char* name;
+        // Copies of each model
+        unsigned int modelCopies = 10;
+        // Point lights, added to one directional light
+        unsigned int pointLightCount = 4;
+        // Bloom, blur and compose passes after the forward pass
+        bool postFX = false;
+        // Frames along the camera path
+        unsigned int frameCount = 120;
+        // Models registered once as retained models, instead of visited every frame
+        bool retained = false;
+        // Depth pre-pass in the forward pass, without post-processing
+        bool depthPrepass = false;
+        // Levels of detail selected by the projected size of the models, instead of always the full meshes
+        bool lod = false;
+        // Part of the post-processing textures that is rendered and scaled up, as with dynamic resolution
+        float resolutionScale = 1.0f;
+        // One instanced material for all the submeshes, instead of the materials of the files. Without post-processing
+        bool sharedMaterial = false;
+        // Models with the shared material loaded into a mesh pool, and drawn with multi-draw when supported
+        bool multiDraw = false;
+    };
+
+public:
+    SceneBenchmark(DeviceGL& device, Profiler& profiler, int width, int height);
+
+    // Load the models and shaders shared by all the scenes. Returns false if the assets could not be loaded
+    bool Initialize();
+
+    // Render the scene and return the timings of each stage. The frame total has the counters
+    // The RGBA pixels of the last frame are copied to lastFrame if not null, to compare scenes that should look the same
+    std::vector<Benchmark> Run(const Settings& settings, std::vector<unsigned char>* lastFrame = nullptr);
+
+private:
+    void RegisterShaderPrograms(Renderer& renderer) const;
+    void AddPostFXPasses(Renderer& renderer, float resolutionScale) const;
+
+    std::shared_ptr<Material> CreatePostFXMaterial(Renderer& renderer, const char* fragmentShaderPath) const;
+
+private:
+    DeviceGL& m_device;
+    Profiler& m_profiler;
+    int m_width, m_height;
+
+    std::shared_ptr<ShaderProgram> m_forwardShaderProgram;
+    std::shared_ptr<Material> m_forwardMaterial;
+
+    std::shared_ptr<ShaderProgram> m_depthShaderProgram;
+    std::shared_ptr<Material> m_depthMaterial;
+
+    std::vector<std::shared_ptr<Model>> m_models;
+
+    // Same models with the shared material, in buffers of their own and in the mesh pool
+    std::shared_ptr<ShaderProgram> m_instancedShaderProgram;
+    std::shared_ptr<Material> m_sharedMaterial;
+    std::vector<std::shared_ptr<Texture2DObject>> m_sharedTextures;
+    std::shared_ptr<MeshPool> m_meshPool;
+    std::vector<std::shared_ptr<Model>> m_sharedMaterialModels;
+    std::vector<std::shared_ptr<Model>> m_pooledModels;
+};
@@ -0,0 +1,14 @@
+#include "BenchmarkApplication.h"
+
+int main(int argc, char* argv[])
+{
+    // Nothing is shown, so the benchmarks can also run on machines without a display
+    BenchmarkApplication::SetHeadless(1);
+
+    // The results are written to the path in the first argument, if any
+    BenchmarkApplication benchmarkApplication(argc > 1 ? argv[1] : "itugl_bench.json");
+    int exitCode = benchmarkApplication.Run();
+
+    // Results that don't match their reference fail the run, so scripts can check it
+    return exitCode == 0 && benchmarkApplication.HasFailedValidations() ? 1 : exitCode;
+}
@@ -2,7 +2,12 @@
 
 #include <ituGL/core/DeviceGL.h>
 #include <ituGL/application/Window.h>
+#include <ituGL/utils/Profiler.h>
 #include <string>
+#include <memory>
+
+class FramebufferObject;
+class Texture2DObject;
 
 class Application
 {
@@ -16,6 +21,12 @@ public:
     // Start the application
     int Run();
 
+    // Run without showing the window, for a fixed number of frames with a fixed time step, rendering to an offscreen framebuffer
+    // The last frame is saved to capturePath, if provided, as a PPM image. Must be called before creating the application
+    // It can also be enabled with the ITUGL_HEADLESS_FRAMES and ITUGL_HEADLESS_CAPTURE environment variables
+    static void SetHeadless(unsigned int frameCount, const char* capturePath = nullptr);
+    static bool IsHeadless();
+
 protected:
     // (C++) 1
     // Get the OpenGL device
@@ -27,6 +38,10 @@ protected:
     inline Window& GetMainWindow() { return m_mainWindow; }
     inline const Window& GetMainWindow() const { return m_mainWindow; }
 
+    // Get the profiler. Update, Render and SwapBuffers are measured every frame
+    inline Profiler& GetProfiler() { return m_profiler; }
+    inline const Profiler& GetProfiler() const { return m_profiler; }
+
     // Get time in seconds from the start of the application
     float GetCurrentTime() const { return m_currentTime; }
 
@@ -60,6 +75,15 @@ private:
     // Set the new current time and compute the delta since the last time
     void UpdateTime(float newCurrentTime);
 
+    // Create the framebuffer that replaces the default one in headless mode
+    void InitializeOffscreenFramebuffer();
+
+    // Save the contents of the offscreen framebuffer as a binary PPM image
+    bool SaveOffscreenFramebuffer(const char* path) const;
+
+    // Read the environment variables, if SetHeadless was not called
+    static void LoadHeadlessSettings();
+
 private:
     // OpenGL device
     DeviceGL m_device;
@@ -67,6 +91,9 @@ private:
     // Main window
     Window m_mainWindow;
 
+    // Profiler, destroyed before the window because it owns OpenGL queries
+    Profiler m_profiler;
+
     // Time in seconds from the start of the application
     float m_currentTime;
     // Time in seconds of the current frame
@@ -76,4 +103,14 @@ private:
     int m_exitCode;
     // Error message to display on exit
     std::string m_errorMessage;
+
+    // Offscreen framebuffer, only in headless mode
+    std::shared_ptr<FramebufferObject> m_offscreenFramebuffer;
+    std::shared_ptr<Texture2DObject> m_offscreenColorTexture;
+    std::shared_ptr<Texture2DObject> m_offscreenDepthTexture;
+
+    // Headless settings. 0 frames if the application runs in a window
+    static bool s_headlessSettingsLoaded;
+    static unsigned int s_headlessFrameCount;
+    static std::string s_headlessCapturePath;
 };
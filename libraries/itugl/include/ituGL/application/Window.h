@@ -6,7 +6,8 @@
 class Window
 {
 public:
-    Window(int width, int height, const char* title);
+    // Invisible windows still have a context, for offscreen rendering
+    Window(int width, int height, const char* title, bool visible = true);
     ~Window();
 
     // (C++) 1
@@ -7,9 +7,12 @@
 #include <ituGL/asset/Texture2DLoader.h>
 #include <vector>
 
+struct aiScene;
 struct aiMesh;
 struct aiMaterial;
 class VertexFormat;
+class ThreadPool;
+class MeshPool;
 
 // Asset loader for Models. Contains a pointer to a reference material for loaded submeshes
 class ModelLoader : public AssetLoader<Model>
@@ -30,6 +33,26 @@ public:
     Texture2DLoader& GetTexture2DLoader();
     const Texture2DLoader& GetTexture2DLoader() const;
 
+    // Generate lodCount lower levels of detail when loading, each one with triangleRatio of the triangles of the previous one
+    // The first one is used below screenSize (fraction of the screen height), and each next one at half the size. 0 disables it
+    void SetLodGeneration(unsigned int lodCount, float triangleRatio = 0.5f, float screenSize = 0.5f);
+    inline unsigned int GetLodCount() const { return m_lodCount; }
+
+    // Simplify the meshes of the file in parallel in the thread pool. Null to simplify them in the loading thread
+    inline void SetThreadPool(ThreadPool* threadPool) { m_threadPool = threadPool; }
+
+    // Store the simplified indices in files in this directory, and read them instead of simplifying the meshes again while
+    // the file is newer than the model and was generated with the same settings. Empty, the default, disables the cache
+    // The directory is created if needed. Use a build or cache directory, not the folder of the assets
+    inline void SetLodCacheDirectory(const std::string& directory) { m_lodCacheDirectory = directory; }
+    inline const std::string& GetLodCacheDirectory() const { return m_lodCacheDirectory; }
+
+    // Add the vertices and elements of the meshes, and of their levels of detail, to the pool instead of buffers of their own
+    // Then the submeshes with the same vertex format share a VAO, and can be drawn with multi-draw. Null to disable it
+    // The space in the pool is freed when the meshes are destroyed, and reused by the next models
+    inline std::shared_ptr<MeshPool> GetMeshPool() const { return m_meshPool; }
+    inline void SetMeshPool(std::shared_ptr<MeshPool> meshPool) { m_meshPool = meshPool; }
+
     // Load the model from the path
     Model Load(const char* path) override;
 
@@ -43,6 +66,21 @@ private:
     // Generate a submesh from the loaded mesh data
     void GenerateSubmesh(Mesh& mesh, const aiMesh& meshData);
 
+    // Add the lower levels of detail of all the submeshes to the model
+    void GenerateLods(Model& model, const aiScene& scene, const char* path);
+
+    // Simplified indices of each level, for a triangle mesh. Left empty for other primitives, that keep all their elements
+    void SimplifyMesh(const aiMesh& meshData, std::vector<std::vector<unsigned int>>& lodIndices) const;
+
+    // Generate a submesh with the vertices used by the indices of a level of detail
+    void GenerateLodSubmesh(Mesh& mesh, const aiMesh& meshData, std::span<const unsigned int> indices) const;
+
+    // Read and write the simplified indices. Reading fails if the file is older than the model or doesn't match the settings
+    // File in the cache directory for the model, named after its whole path so models with the same name don't share it
+    std::string GetLodCachePath(const char* path) const;
+    bool ReadLodCache(const std::string& cachePath, const char* path, const aiScene& scene, std::vector<std::vector<std::vector<unsigned int>>>& lodIndices) const;
+    void WriteLodCache(const std::string& cachePath, const aiScene& scene, const std::vector<std::vector<std::vector<unsigned int>>>& lodIndices) const;
+
     // Generate a material from the loaded material data
     std::shared_ptr<Material> GenerateMaterial(const aiMaterial& materialData);
 
@@ -53,8 +91,11 @@ private:
     // Build the vertex data from the mesh data
     static std::vector<GLubyte> CollectVertexData(const aiMesh& meshData, VertexFormat& vertexFormat, bool interleaved);
 
-    // Build the element data from the mesh data
-    static std::vector<GLubyte> CollectElementData(const aiMesh& meshData, Data::Type& elementType,
+    // Build the element data from a list of indices
+    static std::vector<GLubyte> PackElementData(std::span<const unsigned int> indices, Data::Type elementType);
+
+    // Build the element data from the mesh data, with elements of the type
+    static std::vector<GLubyte> CollectElementData(const aiMesh& meshData, Data::Type elementType,
         std::vector<Drawcall::Primitive>& primitives, std::vector<int>& elementCounts);
 
     // Get the correct vertex data pointer for a specific semantic
@@ -84,6 +125,16 @@ private:
 
     // Texture loader to cache already loaded shared textures
     mutable Texture2DLoader m_textureLoader;
+
+    // Levels of detail generated for each model
+    unsigned int m_lodCount;
+    float m_lodTriangleRatio;
+    float m_lodScreenSize;
+    std::string m_lodCacheDirectory;
+
+    ThreadPool* m_threadPool;
+
+    std::shared_ptr<MeshPool> m_meshPool;
 };
 
 enum class ModelLoader::MaterialProperty
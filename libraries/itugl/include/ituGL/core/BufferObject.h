@@ -13,6 +13,17 @@ public:
         ArrayBuffer = GL_ARRAY_BUFFER,
         // Element Buffer Object
         ElementArrayBuffer = GL_ELEMENT_ARRAY_BUFFER,
+        // Uniform Buffer Object
+        UniformBuffer = GL_UNIFORM_BUFFER,
+        // Data of a buffer texture
+        TextureBuffer = GL_TEXTURE_BUFFER,
+        // Destination of pixel reads, like glReadPixels and glGetTexImage
+        PixelPackBuffer = GL_PIXEL_PACK_BUFFER,
+        // Parameters of indirect draws, like glMultiDrawElementsIndirect
+        DrawIndirectBuffer = GL_DRAW_INDIRECT_BUFFER,
+        // Source and destination of copies between buffers, that don't disturb the other bindings
+        CopyReadBuffer = GL_COPY_READ_BUFFER,
+        CopyWriteBuffer = GL_COPY_WRITE_BUFFER,
         // TODO: There are more types, add them when they are supported
     };
 
@@ -58,6 +69,19 @@ public:
     // Modify the contents of the buffer, starting at offset
     void UpdateData(std::span<const std::byte> data, size_t offset = 0);
 
+    // Copy size bytes from another buffer, or from this one if the ranges don't overlap, without reading them back
+    void CopyData(const BufferObject& source, size_t sourceOffset, size_t offset, size_t size);
+
+    // Allocate immutable storage, with GL_MAP_* and GL_DYNAMIC_STORAGE_BIT flags. Requires OpenGL 4.4
+    void AllocateStorage(size_t size, GLbitfield flags);
+    // Check if the context supports AllocateStorage
+    static bool IsStorageSupported();
+
+    // Map a range of the buffer to client memory, with GL_MAP_* access flags. Returns an empty span on failure
+    std::span<std::byte> MapRange(size_t offset, size_t size, GLbitfield access);
+    // Release the mapping. Returns false if the contents got corrupted while mapped and must be written again
+    bool Unmap();
+
 protected:
     // Bind the specific target. Used by the Bind() method in derived classes
     void Bind(Target target) const;
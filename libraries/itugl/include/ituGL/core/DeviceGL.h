@@ -28,6 +28,8 @@ public:
 
     // Set the dimensions of the viewport
     void SetViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    // Get the dimensions of the viewport
+    void GetViewport(GLint& x, GLint& y, GLsizei& width, GLsizei& height) const;
 
     // Poll the events in the window event queue
     void PollEvents();
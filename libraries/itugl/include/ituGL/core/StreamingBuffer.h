@@ -0,0 +1,85 @@
+#pragma once
+
+#include <ituGL/core/BufferObject.h>
+#include <memory>
+#include <vector>
+#include <span>
+
+// Ring buffer for data that is written every frame, like particles, debug lines, instance data or per-draw constants
+// The buffer is split in regions, one per frame in flight. Each frame writes to its own region, and a fence tells when
+// the GPU is done with it, so writing never waits for draws of the previous frames
+// With OpenGL 4.4 the buffer is mapped persistently. Otherwise, the buffer is orphaned every frame and mapped while writing
+// Operations that need to map the buffer leave it bound to its target
+class StreamingBuffer
+{
+public:
+    // Usually one region for the frame being written, and two for the frames that the GPU could still be reading
+    StreamingBuffer(std::shared_ptr<BufferObject> buffer, size_t regionSize, unsigned int regionCount = 3);
+    ~StreamingBuffer();
+
+    StreamingBuffer(const StreamingBuffer&) = delete;
+    void operator = (const StreamingBuffer&) = delete;
+
+    inline std::shared_ptr<BufferObject> GetBuffer() const { return m_buffer; }
+
+    inline size_t GetRegionSize() const { return m_regionSize; }
+    inline unsigned int GetRegionCount() const { return m_regionCount; }
+
+    // True if the buffer is persistently mapped, false if it uses the orphaning fallback
+    inline bool IsPersistent() const { return m_persistent; }
+
+    // Start writing the next region. Waits only if the GPU is still reading it
+    void BeginFrame();
+
+    // Get space to write size bytes. Offset is the position in the buffer, to set up attributes, ranges or draws
+    // Returns an empty span if the region is full. The contents are only valid until EndFrame
+    std::span<std::byte> Allocate(size_t size, size_t alignment, size_t& offset);
+    template<typename T>
+    std::span<T> Allocate(size_t count, size_t& offset);
+
+    // Make the data written so far available to the GPU. Must be called before drawing with it
+    void Flush();
+
+    // Flush and mark the region as in use by the GPU
+    void EndFrame();
+
+    // Bytes allocated in the current frame
+    inline size_t GetUsedSize() const { return m_usedSize; }
+
+private:
+    // Offset of the current region in the buffer. With orphaning there is only one region
+    size_t GetRegionOffset() const;
+
+    void WaitRegion(unsigned int region);
+
+private:
+    std::shared_ptr<BufferObject> m_buffer;
+
+    size_t m_regionSize;
+    unsigned int m_regionCount;
+
+    bool m_persistent;
+
+    // Minimum alignment of the allocations. Uniform buffer ranges need GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    size_t m_minAlignment;
+
+    unsigned int m_currentRegion;
+    size_t m_usedSize;
+
+    // Fence placed at the end of the frame that wrote each region
+    std::vector<GLsync> m_fences;
+
+    // Mapped memory. The whole buffer when persistent, or the range written since the last flush when orphaning
+    std::span<std::byte> m_mappedData;
+    size_t m_mappedOffset;
+
+    // With orphaning, the storage is replaced the first time that the frame maps the buffer
+    bool m_orphaned;
+};
+
+template<typename T>
+std::span<T> StreamingBuffer::Allocate(size_t count, size_t& offset)
+{
+    std::span<std::byte> data = Allocate(count * sizeof(T), alignof(T), offset);
+    return std::span<T>(reinterpret_cast<T*>(data.data()), data.size() / sizeof(T));
+}
@@ -26,14 +26,26 @@ public:
 public:
     Drawcall();
     Drawcall(Primitive primitive, GLsizei count, GLint first = 0);
-    Drawcall(Primitive primitive, GLsizei count, Data::Type eboType, GLint first = 0);
+    // With an EBO, first is in bytes, and baseVertex is added to every element (for meshes that share buffers)
+    Drawcall(Primitive primitive, GLsizei count, Data::Type eboType, GLint first = 0, GLint baseVertex = 0);
 
     // Check if the drawcall is valid
     inline bool IsValid() const { return m_primitive != Primitive::Invalid && m_count > 0; }
 
+    inline Primitive GetPrimitive() const { return m_primitive; }
+    // Number of vertices or elements
+    inline GLsizei GetCount() const { return m_count; }
+    // First vertex, or offset of the first element in bytes
+    inline GLint GetFirst() const { return m_first; }
+    inline Data::Type GetEboType() const { return m_eboType; }
+    inline GLint GetBaseVertex() const { return m_baseVertex; }
+
     // Execute the drawcall
     void Draw() const;
 
+    // Execute the drawcall several times, using instanced vertex attributes
+    void DrawInstanced(GLsizei instanceCount) const;
+
 private:
     // Type of primitive to be rendered
     Primitive m_primitive;
@@ -46,4 +58,7 @@ private:
 
     // Data type of the elements in the EBO (int, uint, short, byte, etc.). A value of None means no EBO
     Data::Type m_eboType;
+
+    // Value added to the elements before reading the vertices. Only with an EBO
+    GLint m_baseVertex;
 };
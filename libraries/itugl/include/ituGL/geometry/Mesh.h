@@ -8,6 +8,10 @@
 #include <ituGL/shader/ShaderProgram.h>
 #include <vector>
 #include <unordered_map>
+#include <optional>
+#include <utility>
+
+class MeshPool;
 
 // Class that groups several VBO, EBO and VAO that are part of the same object
 // Can contain several drawcalls using the data in those objects
@@ -19,6 +23,8 @@ public:
 
 public:
     Mesh();
+    // Frees the ranges of mesh pools used by the submeshes
+    ~Mesh();
 
     // Adds a new VBO with uninitialized data
     unsigned int AddVertexData(size_t size);
@@ -52,6 +58,10 @@ public:
     // Adds a new submesh, with the index of the VAO to be bound, and the parameters to create a Drawcall
     unsigned int AddSubmesh(unsigned int vaoIndex, Drawcall::Primitive primitive, GLint first, GLsizei count, Data::Type eboType);
 
+    // Adds a new submesh that draws from a VAO owned by someone else, like a MeshPool, that must outlive the mesh
+    // The position-only VAO is optional
+    unsigned int AddSubmesh(const VertexArrayObject& vao, const VertexArrayObject* positionVao, const Drawcall& drawcall);
+
     // (C++) 7
     // Adds a new submesh, adding a new VAO that uses a single VBO, no EBO, and providing the parameters to create a Drawcall
     // vboIndex is the index inside m_vbos of the VBO to be used
@@ -110,8 +120,15 @@ public:
     inline const VertexArrayObject& GetVertexArray(unsigned int vaoIndex) const { return m_vaos[vaoIndex]; }
 
     inline unsigned int GetSubmeshCount() const { return static_cast<unsigned int>(m_submeshes.size()); }
-    inline const VertexArrayObject& GetSubmeshVertexArray(unsigned int submeshIndex) const { return m_vaos[m_submeshes[submeshIndex].vaoIndex]; }
+    const VertexArrayObject& GetSubmeshVertexArray(unsigned int submeshIndex) const;
     inline const Drawcall& GetSubmeshDrawcall(unsigned int submeshIndex) const { return m_submeshes[submeshIndex].drawcall; }
+    // Replace the drawcall of a submesh, keeping its VAO. Static render passes must record their commands again
+    void SetSubmeshDrawcall(unsigned int submeshIndex, const Drawcall& drawcall);
+
+    // VAO with only the position attribute, always in location 0, for passes that only write depth
+    // Created for the VAOs added with an attribute iterator. Null if the VAO has no position or it was set up manually
+    const VertexArrayObject* GetPositionVertexArray(unsigned int vaoIndex) const;
+    const VertexArrayObject* GetSubmeshPositionVertexArray(unsigned int submeshIndex) const;
 
     // Draws a submesh
     void DrawSubmesh(int submeshIndex) const;
@@ -123,6 +140,9 @@ private:
     {
         unsigned int vaoIndex;
         Drawcall drawcall;
+        // VAOs that are not in m_vaos, used instead of vaoIndex when not null
+        const VertexArrayObject* sharedVao = nullptr;
+        const VertexArrayObject* sharedPositionVao = nullptr;
     };
 
 private:
@@ -139,6 +159,12 @@ private:
     // Set a vertex attribute in a VAO, using the specified layout, and increases the location index according to the size of the attribute
     void SetupVertexAttribute(VertexArrayObject& vao, const VertexAttribute::Layout& attributeLayout, GLuint& location, const SemanticMap& locations);
 
+    // Add the position-only VAO of a VAO, reading the position from the VBO with the same layout
+    void AddPositionVertexArray(unsigned int vaoIndex, unsigned int vboIndex, const VertexAttribute::Layout& positionLayout);
+
+    // Bind the EBO to the VAO, and to its position-only VAO if there is one
+    void SetupElementBuffer(unsigned int vaoIndex, unsigned int eboIndex);
+
 private:
     // All the VBOs used in this mesh
     std::vector<VertexBufferObject> m_vbos;
@@ -149,8 +175,17 @@ private:
     // All the VAOs used in this mesh
     std::vector<VertexArrayObject> m_vaos;
 
+    // Position-only VAOs, and the index of the one of each VAO in m_vaos (-1 if none)
+    std::vector<VertexArrayObject> m_positionVaos;
+    std::vector<int> m_positionVaoIndices;
+
     // Submeshes contained in this mesh
     std::vector<Submesh> m_submeshes;
+
+    // Ranges of mesh pools drawn by the submeshes, owned by the mesh. Added by MeshPool::AddSubmesh
+    std::vector<std::pair<MeshPool*, unsigned int>> m_poolRanges;
+
+    friend class MeshPool;
 };
 
 template<typename T>
@@ -186,15 +221,26 @@ unsigned int Mesh::AddVertexArray(unsigned int vboIndex, TIterator& it, const TI
     GLuint location = 0;
     const VertexBufferObject& vbo = GetVertexBuffer(vboIndex);
     vbo.Bind();
+    std::optional<VertexAttribute::Layout> positionLayout;
     while (it != itEnd)
     {
-        SetupVertexAttribute(vao, *it, location, locations);
+        const VertexAttribute::Layout& attributeLayout = *it;
+        if (attributeLayout.GetAttribute().GetSemantic() == VertexAttribute::Semantic::Position)
+        {
+            positionLayout = attributeLayout;
+        }
+        SetupVertexAttribute(vao, attributeLayout, location, locations);
         it++;
     }
 
     VertexBufferObject::Unbind();
     VertexArrayObject::Unbind();
 
+    if (positionLayout)
+    {
+        AddPositionVertexArray(vaoIndex, vboIndex, *positionLayout);
+    }
+
     return vaoIndex;
 }
 
@@ -203,12 +249,14 @@ unsigned int Mesh::AddVertexArray(std::span<unsigned int> vboIndices, TIterator&
 {
     unsigned int vaoIndex = AddVertexArray();
 
-    const VertexArrayObject& vao = GetVertexArray(vaoIndex);
+    VertexArrayObject& vao = GetVertexArray(vaoIndex);
     vao.Bind();
 
     GLuint location = 0;
     int i = 0;
     int vboIndex = -1;
+    int positionVboIndex = -1;
+    std::optional<VertexAttribute::Layout> positionLayout;
     while (it != itEnd)
     {
         if (i < vboIndices.size() && vboIndex != vboIndices[i])
@@ -218,13 +266,24 @@ unsigned int Mesh::AddVertexArray(std::span<unsigned int> vboIndices, TIterator&
             vbo.Bind();
             i++;
         }
-        SetupVertexAttribute(vao, *it, location, locations);
+        const VertexAttribute::Layout& attributeLayout = *it;
+        if (attributeLayout.GetAttribute().GetSemantic() == VertexAttribute::Semantic::Position)
+        {
+            positionLayout = attributeLayout;
+            positionVboIndex = vboIndex;
+        }
+        SetupVertexAttribute(vao, attributeLayout, location, locations);
         it++;
     }
 
     VertexBufferObject::Unbind();
     VertexArrayObject::Unbind();
 
+    if (positionLayout && positionVboIndex >= 0)
+    {
+        AddPositionVertexArray(vaoIndex, positionVboIndex, *positionLayout);
+    }
+
     return vaoIndex;
 }
 
@@ -252,16 +311,7 @@ unsigned int Mesh::AddSubmesh(Drawcall::Primitive primitive, int firstElement, i
     TIterator it, const TIterator itEnd, const SemanticMap& locations)
 {
     unsigned int vaoIndex = AddVertexArray(vboIndex, it, itEnd, locations);
-
-    VertexArrayObject& vao = GetVertexArray(vaoIndex);
-    vao.Bind();
-
-    const ElementBufferObject& ebo = GetElementBuffer(eboIndex);
-    ebo.Bind();
-
-    VertexArrayObject::Unbind();
-    ElementBufferObject::Unbind();
-
+    SetupElementBuffer(vaoIndex, eboIndex);
     return AddSubmesh(vaoIndex, primitive, firstElement, elementCount, elementType);
 }
 
@@ -271,16 +321,7 @@ unsigned int Mesh::AddSubmesh(Drawcall::Primitive primitive, int firstElement, i
     TIterator it, const TIterator itEnd, const SemanticMap& locations)
 {
     unsigned int vaoIndex = AddVertexArray(vboIndices, it, itEnd, locations);
-
-    VertexArrayObject& vao = m_vaos[vaoIndex];
-    vao.Bind();
-
-    ElementBufferObject& ebo = m_ebos[eboIndex];
-    ebo.Bind();
-
-    VertexArrayObject::Unbind();
-    ElementBufferObject::Unbind();
-
+    SetupElementBuffer(vaoIndex, eboIndex);
     return AddSubmesh(vaoIndex, primitive, firstElement, elementCount, elementType);
 }
 
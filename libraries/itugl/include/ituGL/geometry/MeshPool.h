@@ -0,0 +1,136 @@
+#pragma once
+
+#include <ituGL/geometry/Mesh.h>
+#include <ituGL/geometry/VertexFormat.h>
+#include <ituGL/utils/RangeAllocator.h>
+#include <memory>
+#include <vector>
+#include <span>
+#include <cstddef>
+
+// Big vertex and element buffers shared by many meshes, with one VAO per vertex format
+// Submeshes select their vertices with a base vertex and their elements with an offset, so all the submeshes of a format
+// bind the same VAO, and the renderer can merge their draws in a single multi-draw (see Renderer::RecordDrawcallCollection)
+// Elements are always unsigned int, so all the drawcalls of the pool have the same element type
+// The space of the buffers is suballocated with RangeAllocator, so freed ranges are reused. Full buffers are not grown:
+// data that doesn't fit in the buffers of its format goes to a new set of buffers, with its own VAO
+// The pool must outlive the meshes that use it
+class MeshPool
+{
+public:
+    // Vertices and elements of some data added to the pool. Submeshes draw parts of its elements
+    // The offsets change when the pool is defragmented, GetRange returns the current ones
+    struct Range
+    {
+        unsigned int id;
+        // Set of buffers of the data
+        unsigned int bucketIndex;
+        // Added to the elements, it is the position of the first vertex in the buffer
+        GLint baseVertex;
+        unsigned int vertexCount;
+        // Position of the first element in the buffer
+        unsigned int firstElement;
+        unsigned int elementCount;
+    };
+
+public:
+    // Size in bytes of each new vertex and element buffer. Data that doesn't fit gets buffers of its own size
+    MeshPool(size_t vertexBufferSize = 32u << 20, size_t elementBufferSize = 8u << 20);
+
+    MeshPool(const MeshPool&) = delete;
+    void operator = (const MeshPool&) = delete;
+
+    // Copy interleaved vertices in the vertex format, and their elements, to buffers of the same format and attribute locations
+    Range AddData(const VertexFormat& vertexFormat, std::span<const std::byte> vertexData, std::span<const unsigned int> elements,
+        const Mesh::SemanticMap& locations = Mesh::SemanticMap());
+
+    const Range& GetRange(unsigned int rangeId) const;
+
+    // Free a range without submeshes. Ranges with submeshes belong to their mesh, and they are freed with it
+    void Free(unsigned int rangeId);
+
+    // Add a submesh to the mesh that draws elementCount elements of the range, starting at firstElement (relative to the range)
+    // The first submesh gives the range to the mesh. All the submeshes of a range must be in the same mesh
+    unsigned int AddSubmesh(Mesh& mesh, const Range& range, Drawcall::Primitive primitive, unsigned int firstElement, unsigned int elementCount);
+
+    // Move the ranges to the start of their buffers, so the free space of each buffer is in one piece at the end
+    // The data is copied in the GPU, and the drawcalls of the submeshes are updated. Commands recorded with the old drawcalls
+    // are stale, so moving any data increments the defragment generation. Returns the number of bytes moved
+    size_t Defragment();
+
+    // Incremented by every Defragment that moves data, in any pool. Static render passes and the drawcall batches of the
+    // renderer are recorded again when it changes, so they never replay the old offsets
+    static unsigned int GetDefragmentGeneration() { return s_defragmentGeneration; }
+
+    // Number of buffer sets, each one with a VAO
+    inline unsigned int GetBucketCount() const { return static_cast<unsigned int>(m_buckets.size()); }
+    const VertexArrayObject& GetVertexArray(unsigned int bucketIndex) const;
+
+    // Space of the buffers, in vertices and elements. Their stats show how fragmented they are
+    const RangeAllocator& GetVertexAllocator(unsigned int bucketIndex) const;
+    const RangeAllocator& GetElementAllocator(unsigned int bucketIndex) const;
+
+    // Memory used in all the buffers, and memory allocated for them, in bytes
+    size_t GetUsedSize() const;
+    size_t GetAllocatedSize() const;
+
+private:
+    struct Bucket
+    {
+        VertexFormat vertexFormat;
+        Mesh::SemanticMap locations;
+
+        VertexBufferObject vbo;
+        ElementBufferObject ebo;
+        VertexArrayObject vao;
+        // Only the position attribute in location 0, for depth passes. Unused if the format has no position
+        VertexArrayObject positionVao;
+        bool hasPositionVao = false;
+
+        RangeAllocator vertexAllocator;
+        RangeAllocator elementAllocator;
+    };
+
+    struct RangeInfo
+    {
+        Range range;
+        RangeAllocator::AllocationId vertexAllocation;
+        RangeAllocator::AllocationId elementAllocation;
+
+        // Mesh that owns the range, and its submeshes with their first element, relative to the range
+        Mesh* mesh = nullptr;
+        std::vector<std::pair<unsigned int, unsigned int>> submeshes;
+
+        bool used = false;
+    };
+
+    // Allocate the vertices and elements in a bucket of the format with enough space, or in a new one
+    void AllocateRange(const VertexFormat& vertexFormat, const Mesh::SemanticMap& locations, RangeInfo& rangeInfo);
+
+    // Allocate the buffers and set up the VAOs
+    void InitializeBucket(Bucket& bucket);
+
+    // Called by the mesh that owns the range when it is destroyed
+    void FreeMeshRange(unsigned int rangeId);
+
+    // Copy the data of the moved allocations to their new offsets. Returns the number of bytes moved
+    static size_t MoveData(BufferObject& buffer, size_t unitSize, std::span<const RangeAllocator::Move> moves);
+
+    // Drawcall of the elements of the range, starting at firstElement (relative to the range)
+    static Drawcall CreateDrawcall(const Range& range, Drawcall::Primitive primitive, unsigned int firstElement, unsigned int elementCount);
+
+private:
+    size_t m_vertexBufferSize;
+    size_t m_elementBufferSize;
+
+    // Pointers, so the VAOs don't move when buckets are added
+    std::vector<std::unique_ptr<Bucket>> m_buckets;
+
+    // Indexed by the range id, and the ids of the free ones to be reused
+    std::vector<RangeInfo> m_ranges;
+    std::vector<unsigned int> m_freeRangeIds;
+
+    static unsigned int s_defragmentGeneration;
+
+    friend class Mesh;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <span>
+#include <vector>
+#include <limits>
+
+// Reduces the triangles of an indexed mesh with quadric error edge collapses (Garland-Heckbert)
+// Vertices are never moved or created: each collapse merges a vertex into one of its neighbors, so the result is a new
+// index list for the same vertex data, and all the attributes stay valid. Vertices on open borders are locked, which
+// also keeps the seams of split vertices (UVs, normals) closed, at the cost of stopping earlier on meshes with many seams
+// The result only depends on the input, so the same mesh is always simplified in the same way
+// The working memory is kept between calls. Use one simplifier per thread
+class MeshSimplifier
+{
+public:
+    MeshSimplifier();
+
+    // Collapse edges until the mesh has at most targetIndexCount indices, or until the next collapse would move the
+    // surface more than maxError, in the units of the positions. The indices must be a triangle list
+    // The remaining triangles keep their original order
+    std::vector<unsigned int> Simplify(std::span<const glm::vec3> positions, std::span<const unsigned int> indices,
+        unsigned int targetIndexCount, float maxError = std::numeric_limits<float>::max());
+
+    // Approximate distance between the original surface and the result of the last call
+    float GetError() const { return m_error; }
+
+private:
+    // Symmetric 4x4 matrix that gives the sum of the squared distances to a set of planes
+    struct Quadric
+    {
+        double a00, a01, a02, a03;
+        double a11, a12, a13;
+        double a22, a23;
+        double a33;
+        // Sum of the weights of the planes, to turn the sum of distances into an average
+        double weight;
+
+        void AddPlane(const glm::vec3& normal, float distance, double weight);
+        void Add(const Quadric& other);
+        double Evaluate(const glm::vec3& position) const;
+    };
+
+    // Vertex "from" merged into vertex "to". The versions tell if the vertices changed after it was queued
+    struct Collapse
+    {
+        float cost;
+        unsigned int from, to;
+        unsigned int fromVersion, toVersion;
+    };
+
+    void Initialize(std::span<const glm::vec3> positions, std::span<const unsigned int> indices);
+
+    // Queue the cheapest direction of the edge, if any of the vertices can move
+    void QueueEdge(unsigned int vertexA, unsigned int vertexB);
+
+    bool CanCollapse(unsigned int from, unsigned int to);
+    void ApplyCollapse(unsigned int from, unsigned int to);
+
+    // Vertices connected to the vertex by a live triangle, without duplicates
+    void CollectNeighbors(unsigned int vertex, std::vector<unsigned int>& neighbors) const;
+
+private:
+    std::span<const glm::vec3> m_positions;
+
+    std::vector<unsigned int> m_indices;
+    std::vector<bool> m_triangleAlive;
+    unsigned int m_triangleCount;
+
+    std::vector<Quadric> m_quadrics;
+    std::vector<std::vector<unsigned int>> m_vertexTriangles;
+    std::vector<bool> m_vertexAlive;
+    std::vector<bool> m_vertexLocked;
+    std::vector<unsigned int> m_vertexVersions;
+
+    // Min-heap of the queued collapses, by cost
+    std::vector<Collapse> m_collapses;
+
+    // Scratch buffers for the neighbors in CanCollapse
+    std::vector<unsigned int> m_neighborsFrom, m_neighborsTo;
+
+    float m_error;
+};
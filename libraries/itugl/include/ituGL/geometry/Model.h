@@ -1,5 +1,6 @@
 #pragma once
 
+#include <ituGL/scene/Bounds.h>
 #include <memory>
 #include <vector>
 
@@ -9,6 +10,7 @@ class Material;
 class ShaderProgram;
 
 // Contains a pointer to a Mesh and a list of pointers to materials, one for each submesh
+// It can also contain lower levels of detail of the mesh, with the same submeshes, used when the model is small on screen
 class Model
 {
 public:
@@ -17,8 +19,23 @@ public:
     Mesh& GetMesh();
     const Mesh& GetMesh() const;
 
+    // Changing the mesh removes the levels of detail
     void SetMesh(std::shared_ptr<Mesh> mesh);
 
+    // Levels of detail, including the mesh as level 0
+    inline unsigned int GetLodCount() const { return static_cast<unsigned int>(m_lods.size()) + 1; }
+    const Mesh& GetLodMesh(unsigned int lod) const;
+    // Fraction of the screen height covered by the model below which the level is used
+    float GetLodScreenSize(unsigned int lod) const;
+
+    // Add the next lower level. The mesh must have the same submeshes, and the screen size must be smaller than the previous one
+    void AddLod(std::shared_ptr<Mesh> mesh, float screenSize);
+    void ClearLods();
+
+    // Level for the screen size of the model. Each level is kept until the size is past its threshold by the hysteresis
+    // fraction in either direction, so models close to a threshold don't switch every frame
+    unsigned int SelectLod(float screenSize, unsigned int currentLod, float hysteresis) const;
+
     unsigned int GetMaterialCount();
 
     Material& GetMaterial(unsigned int index);
@@ -36,10 +53,27 @@ public:
     // Draw all the submeshes of the mesh, each one with a material on the list
     void Draw();
 
+    // Bounds of the mesh vertices in model space. Models without bounds are never culled
+    inline bool HasLocalBounds() const { return m_hasLocalBounds; }
+    inline const AabbBounds& GetLocalBounds() const { return m_localBounds; }
+    void SetLocalBounds(const AabbBounds& localBounds);
+
 private:
     // Pointer to the model Mesh
     std::shared_ptr<Mesh> m_mesh;
 
+    // Lower levels of detail, starting at level 1
+    struct Lod
+    {
+        std::shared_ptr<Mesh> mesh;
+        float screenSize;
+    };
+    std::vector<Lod> m_lods;
+
     // List of material pointers, one for each submesh
     std::vector<std::shared_ptr<Material>> m_materials;
+
+    // Bounds of the mesh, in model space
+    AabbBounds m_localBounds;
+    bool m_hasLocalBounds;
 };
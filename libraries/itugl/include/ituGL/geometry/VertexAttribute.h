@@ -37,6 +37,9 @@ public:
     // Gets how many location indices the attribute needs (usually 1)
     int GetLocationSize() const;
 
+    bool operator == (const VertexAttribute& other) const;
+    inline bool operator != (const VertexAttribute& other) const { return !(*this == other); }
+
 private:
     // (C++) 6
     // Data type of the attribute. Usually an integer or floating point type
@@ -24,6 +24,10 @@ public:
     // Removes all the attributes
     void Clear();
 
+    // Same attributes in the same order
+    inline bool operator == (const VertexFormat& other) const { return m_attributes == other.m_attributes; }
+    inline bool operator != (const VertexFormat& other) const { return !(*this == other); }
+
     // Adds a new attribute (for integer types)
     template<typename T>
     void AddVertexAttribute(int components, bool normalized, VertexAttribute::Semantic semantic = VertexAttribute::Semantic::Unknown);
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <span>
+#include <vector>
+
+class Light;
+class Camera;
+class ThreadPool;
+
+// Assigns lights to the clusters (froxels) of the view frustum of a camera, so shading only loops the lights that reach each pixel
+// The frustum is split in tiles on screen, and in slices in depth, with exponential spacing between the near and far planes
+// Lights without range, like directional lights, reach every cluster and are stored in a separate global list
+class LightClusterGrid
+{
+public:
+    // Position of the lights of a cluster in the light index list
+    struct ClusterRange
+    {
+        // First element in the light index list
+        unsigned int offset;
+        // Number of lights in the cluster
+        unsigned int count;
+    };
+
+public:
+    LightClusterGrid(const glm::uvec3& dimensions = glm::uvec3(16, 9, 24));
+
+    // Number of clusters in screen X, screen Y and depth
+    const glm::uvec3& GetDimensions() const { return m_dimensions; }
+    unsigned int GetClusterCount() const { return m_dimensions.x * m_dimensions.y * m_dimensions.z; }
+
+    // Index of the cluster in the cluster range list. Clusters are sorted by slice, then row, then column
+    unsigned int GetClusterIndex(const glm::uvec3& cluster) const;
+
+    // Assign the lights to the clusters of the camera frustum. The camera must have a perspective projection
+    // Slices are processed in parallel if a thread pool is provided. Sphere tests run on 4 clusters at a time
+    void Build(std::span<const Light* const> lights, const Camera& camera, ThreadPool* threadPool = nullptr);
+
+    // Same result as Build, testing every light against every cluster one by one. Used to validate Build
+    void BuildReference(std::span<const Light* const> lights, const Camera& camera);
+
+    // Offset and count of every cluster, and the list with the light indices of all the clusters
+    std::span<const ClusterRange> GetClusterRanges() const { return m_clusterRanges; }
+    std::span<const unsigned int> GetLightIndices() const { return m_lightIndices; }
+
+    // Indices of the lights in a cluster, sorted
+    std::span<const unsigned int> GetClusterLightIndices(unsigned int clusterIndex) const;
+
+    // Indices of the lights without range, that reach every cluster
+    std::span<const unsigned int> GetGlobalLightIndices() const { return m_globalLightIndices; }
+
+    // Distance of the near and far planes of the camera in the last build
+    float GetNearDistance() const { return m_nearDistance; }
+    float GetFarDistance() const { return m_farDistance; }
+
+    // Scale and bias to find the slice of a view depth: slice = floor(log(depth) * scale + bias)
+    const glm::vec2& GetDepthSliceParams() const { return m_depthSliceParams; }
+
+    // Check if both grids assigned the same lights to every cluster
+    bool HasSameAssignment(const LightClusterGrid& other) const;
+
+private:
+    // Compute the near and far distances and the bounds of the clusters in view space
+    void SetupClusters(const Camera& camera);
+
+    // Compute the bounding spheres of the lights in view space, and the slices they reach
+    void SetupLights(std::span<const Light* const> lights, const Camera& camera);
+
+    // Assign the lights to the clusters of one slice
+    void AssignSlice(unsigned int slice);
+
+    // Join the lights of all the clusters in the final lists
+    void MergeClusters();
+
+    // Shared by the reference build and the scalar fallback, so both give the same results
+    static bool SphereIntersectsBox(const glm::vec4& sphere, float minX, float minY, float minZ, float maxX, float maxY, float maxZ);
+
+private:
+    glm::uvec3 m_dimensions;
+
+    float m_nearDistance;
+    float m_farDistance;
+    glm::vec2 m_depthSliceParams;
+
+    // Bounds of the clusters in view space, with positive depth. Stored by components, so 4 clusters can be tested at once
+    // The clusters of each slice are padded to a multiple of 4 with empty boxes
+    unsigned int m_sliceStride;
+    std::vector<float> m_boxMinX, m_boxMinY, m_boxMinZ;
+    std::vector<float> m_boxMaxX, m_boxMaxY, m_boxMaxZ;
+
+    // Bounding spheres of the lights with range, in view space with positive depth
+    std::vector<glm::vec4> m_lightSpheres;
+    // Index in the light list of each sphere
+    std::vector<unsigned int> m_lightSphereIndices;
+    // First and last slice reached by each sphere. Empty if first > last
+    std::vector<glm::uvec2> m_lightSphereSlices;
+
+    // Lights of each cluster while building, reused between frames
+    std::vector<std::vector<unsigned int>> m_clusterLights;
+
+    std::vector<ClusterRange> m_clusterRanges;
+    std::vector<unsigned int> m_lightIndices;
+    std::vector<unsigned int> m_globalLightIndices;
+};
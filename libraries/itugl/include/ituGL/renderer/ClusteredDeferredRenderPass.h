@@ -0,0 +1,57 @@
+#pragma once
+
+#include <ituGL/renderer/RenderPass.h>
+
+#include <ituGL/lighting/LightClusterGrid.h>
+#include <ituGL/core/BufferObject.h>
+#include <glm/vec4.hpp>
+#include <span>
+#include <vector>
+#include <memory>
+
+class Material;
+class Light;
+class TextureBufferObject;
+
+// Renders all the lights in a single fullscreen pass, reading the surface data from the G-buffer
+// Lights are assigned to the clusters of the view frustum on the CPU each frame. The shader finds the cluster of each pixel
+// and loops only the lights in it. The material gets these texture buffers and uniforms:
+// - LightDataBuffer (samplerBuffer): 4 texels per light, with color, position, direction and attenuation
+// - LightIndexBuffer (usamplerBuffer): the global lights first, and then the lights of every cluster
+// - ClusterBuffer (usamplerBuffer): offset in LightIndexBuffer and light count of each cluster
+// - ClusterGridSize (ivec3), ClusterDepthParams (vec2, see LightClusterGrid) and GlobalLightCount (int)
+class ClusteredDeferredRenderPass : public RenderPass
+{
+public:
+    ClusteredDeferredRenderPass(std::shared_ptr<Material> material, std::shared_ptr<const FramebufferObject> targetFramebuffer = nullptr,
+        const glm::uvec3& clusterDimensions = glm::uvec3(16, 9, 24));
+
+    const LightClusterGrid& GetLightClusterGrid() const { return m_lightClusterGrid; }
+
+    void Render() override;
+    const char* GetName() const override { return "Clustered deferred"; }
+
+private:
+    void InitializeTextures();
+
+    // Upload the light data and the light grid to the texture buffers
+    void UpdateTextures(std::span<const Light* const> lights);
+
+private:
+    std::shared_ptr<Material> m_material;
+
+    LightClusterGrid m_lightClusterGrid;
+
+    // Buffers with the data, and the textures to read them in the shader
+    BufferObjectBase<BufferObject::TextureBuffer> m_lightDataBuffer;
+    BufferObjectBase<BufferObject::TextureBuffer> m_lightIndexBuffer;
+    BufferObjectBase<BufferObject::TextureBuffer> m_clusterBuffer;
+    std::shared_ptr<TextureBufferObject> m_lightDataTexture;
+    std::shared_ptr<TextureBufferObject> m_lightIndexTexture;
+    std::shared_ptr<TextureBufferObject> m_clusterTexture;
+
+    // CPU copy of the data, reused every frame
+    std::vector<glm::vec4> m_lightData;
+    std::vector<unsigned int> m_lightIndices;
+    std::vector<LightClusterGrid::ClusterRange> m_clusterRanges;
+};
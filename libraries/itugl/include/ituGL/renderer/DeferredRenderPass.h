@@ -4,21 +4,38 @@
 
 #include <ituGL/shader/ShaderProgram.h>
 #include <ituGL/geometry/Mesh.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
 #include <memory>
 
 class Texture2DObject;
 class Material;
+class Light;
 
+// Renders the lights reading the surface data from the G-buffer, adding the contribution of each light
+// The first light, that also adds the indirect lighting, and directional lights cover the whole screen.
+// Point and spot lights draw the back faces of a volume that contains their range, limited to its scissor rect
 class DeferredRenderPass: public RenderPass
 {
 public:
     DeferredRenderPass(std::shared_ptr<Material> material, std::shared_ptr<const FramebufferObject> targetFramebuffer = nullptr);
 
     void Render() override;
+    const char* GetName() const override { return "Deferred"; }
 
 private:
     void InitializeMeshes();
 
+    // Get the mesh and world matrix of the volume of the light. Returns false if the light has no volume
+    bool GetLightVolume(const Light& light, const Mesh*& mesh, glm::mat4& worldMatrix) const;
+
+    // Get the rect of the viewport covered by a sphere. Returns false if the sphere is not visible
+    static bool ComputeScissorRect(const glm::mat4& viewProjMatrix, const glm::vec3& center, float radius, const glm::ivec4& viewport, glm::ivec4& scissorRect);
+
 private:
     std::shared_ptr<Material> m_material;
+
+    // Sphere for point lights and cone for spot lights. Both contain the unit volume: radius 1, and height 1 for the cone
+    Mesh m_sphereMesh;
+    Mesh m_coneMesh;
 };
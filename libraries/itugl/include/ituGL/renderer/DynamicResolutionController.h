@@ -0,0 +1,46 @@
+#pragma once
+
+class Profiler;
+
+// Chooses the resolution scale of the render graph to keep the GPU time of the frames under a budget
+// GPU time is assumed to grow with the number of pixels, so the scale moves by the square root of the budget ratio
+// It goes down right away when a frame is over the budget, and comes back slowly when there is time left, so a single
+// cheap frame doesn't bring back the stall. Small changes are ignored, to keep the image stable under a steady load
+class DynamicResolutionController
+{
+public:
+    // Budget in milliseconds. The default is a 60 Hz frame, with some time left for the CPU and the presentation
+    DynamicResolutionController(double targetFrameTime = 14.0, float minScale = 0.5f, float maxScale = 1.0f);
+
+    double GetTargetFrameTime() const { return m_targetFrameTime; }
+    void SetTargetFrameTime(double targetFrameTime);
+
+    float GetMinScale() const { return m_minScale; }
+    float GetMaxScale() const { return m_maxScale; }
+    void SetScaleBounds(float minScale, float maxScale);
+
+    // Current scale, for RenderGraph::SetResolutionScale
+    float GetScale() const { return m_scale; }
+
+    // GPU time in milliseconds of the last frame used to update the scale, 0 if there was none yet
+    double GetGpuFrameTime() const { return m_gpuFrameTime; }
+
+    // Update the scale with the GPU time of the newest frame of the profiler that has its GPU results, if it is new
+    // The results arrive a few frames late. Frames rendered before the last change of scale are skipped, so the scale
+    // doesn't keep moving while the results of the previous change are on their way. Call it before rendering the frame
+    float Update(const Profiler& profiler);
+
+    // Update the scale with the GPU time of a frame rendered with the current scale, in milliseconds
+    float Update(double gpuFrameTime);
+
+private:
+    double m_targetFrameTime;
+    float m_minScale, m_maxScale;
+
+    float m_scale;
+    double m_gpuFrameTime;
+
+    // Last profiler frame used, to use each frame once, and first frame rendered with the current scale
+    unsigned int m_lastFrameIndex;
+    unsigned int m_scaleFrameIndex;
+};
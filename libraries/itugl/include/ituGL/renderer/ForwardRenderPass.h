@@ -1,6 +1,11 @@
 #pragma once
 
 #include <ituGL/renderer/RenderPass.h>
+#include <ituGL/renderer/RenderCommandBuffer.h>
+#include <memory>
+#include <vector>
+
+class Material;
 
 class ForwardRenderPass : public RenderPass
 {
@@ -8,8 +13,35 @@ public:
     ForwardRenderPass();
     ForwardRenderPass(int drawcallCollectionIndex);
 
+    // Record the drawcalls once and execute the same commands in the next frames, for scenes that don't change
+    // The models must stay alive. Setting it again, or defragmenting a MeshPool, records the commands in the next frame
+    bool IsStatic() const { return m_static; }
+    void SetStatic(bool isStatic);
+
+    // Draw consecutive batches that share material and VAO with a single multi-draw (see Renderer::RecordDrawcallCollection)
+    // Only reduces the draws of meshes that share their buffers, like the ones loaded into a MeshPool
+    bool IsMultiDrawEnabled() const { return m_multiDraw; }
+    void SetMultiDrawEnabled(bool enabled);
+
+    // With a depth material, the opaque drawcalls first write only depth, front to back, with their positions
+    // Then all the lights are shaded with GL_EQUAL and no depth writes, so each pixel is shaded once per light
+    // The shader program must be registered in the renderer, and compute the same positions as the materials
+    // (same expression, and gl_Position declared invariant in both). Null to disable the pre-pass
+    std::shared_ptr<const Material> GetDepthPrepassMaterial() const { return m_depthPrepassMaterial; }
+    void SetDepthPrepassMaterial(std::shared_ptr<const Material> depthMaterial);
+
     void Render() override;
+    const char* GetName() const override { return "Forward"; }
 
 private:
     int m_drawcallCollectionIndex;
+
+    bool m_static;
+    // MeshPool defragment generation when the commands were recorded
+    unsigned int m_meshPoolGeneration;
+    bool m_multiDraw;
+    std::vector<RenderCommandBuffer> m_commandBuffers;
+
+    std::shared_ptr<const Material> m_depthPrepassMaterial;
+    std::vector<RenderCommandBuffer> m_depthPrepassCommandBuffers;
 };
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <ituGL/renderer/RenderPass.h>
+#include <ituGL/renderer/RenderCommandBuffer.h>
+#include <vector>
 
 class Texture2DObject;
 
@@ -8,8 +10,21 @@ class GBufferRenderPass : public RenderPass
 {
 public:
     GBufferRenderPass(int width, int height, int drawcallCollectionIndex = 0);
+    // Without textures, for passes that get the target framebuffer from outside, like a render graph
+    explicit GBufferRenderPass(int drawcallCollectionIndex = 0);
+
+    // Record the drawcalls once and execute the same commands in the next frames, for scenes that don't change
+    // The models must stay alive. Setting it again, or defragmenting a MeshPool, records the commands in the next frame
+    bool IsStatic() const { return m_static; }
+    void SetStatic(bool isStatic);
+
+    // Draw consecutive batches that share material and VAO with a single multi-draw (see Renderer::RecordDrawcallCollection)
+    // Only reduces the draws of meshes that share their buffers, like the ones loaded into a MeshPool
+    bool IsMultiDrawEnabled() const { return m_multiDraw; }
+    void SetMultiDrawEnabled(bool enabled);
 
     void Render() override;
+    const char* GetName() const override { return "GBuffer"; }
 
     const std::shared_ptr<Texture2DObject> GetDepthTexture() const { return m_depthTexture; }
     const std::shared_ptr<Texture2DObject> GetAlbedoTexture() const { return m_albedoTexture; }
@@ -23,6 +38,12 @@ private:
 private:
     int m_drawcallCollectionIndex;
 
+    bool m_static;
+    // MeshPool defragment generation when the commands were recorded
+    unsigned int m_meshPoolGeneration;
+    bool m_multiDraw;
+    std::vector<RenderCommandBuffer> m_commandBuffers;
+
     std::shared_ptr<Texture2DObject> m_depthTexture;
     std::shared_ptr<Texture2DObject> m_albedoTexture;
     std::shared_ptr<Texture2DObject> m_normalTexture;
@@ -13,6 +13,7 @@ public:
     PostFXRenderPass(std::shared_ptr<Material> material, std::shared_ptr<const FramebufferObject> targetFramebuffer = nullptr);
 
     void Render() override;
+    const char* GetName() const override { return "PostFX"; }
 
 private:
     std::shared_ptr<Material> m_material;
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/geometry/Drawcall.h>
+#include <glm/mat4x4.hpp>
+#include <vector>
+#include <memory>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <type_traits>
+
+class VertexArrayObject;
+class VertexBufferObject;
+
+// Compact stream of the GL work needed to draw the batches of a pass: material, transforms, VAO, instance data and draws
+// Commands are plain structs stored one after the other in an arena. They can be recorded from a worker thread, and
+// they are executed later by the renderer in the GL thread (see Renderer::RecordDrawcallCollection and ExecuteCommandBuffer)
+// The recorded world matrices are copies, so a buffer can be executed again in later frames without recording it again,
+// as long as the materials, VAOs and drawcalls that it points to are alive
+class RenderCommandBuffer
+{
+public:
+    enum class CommandType : std::uint32_t
+    {
+        UseMaterial,
+        UpdateTransforms,
+        BindVAO,
+        InstanceWorldMatrices,
+        WorldMatrixAttribute,
+        Draw,
+        MultiDraw
+    };
+
+    // Shader program, uniforms (including textures) and render states, skipping the parts in the override flags
+    struct UseMaterialCommand
+    {
+        static constexpr CommandType Type = CommandType::UseMaterial;
+        const Material* material;
+        int overrideFlags;
+        // Flags requested by the pass, kept even if the render states must be applied again
+        int passOverrideFlags;
+    };
+
+    // Call the update transforms function registered for the shader program, or set its transform uniforms
+    struct UpdateTransformsCommand
+    {
+        static constexpr CommandType Type = CommandType::UpdateTransforms;
+        Renderer::ShaderProgramId shaderProgramId;
+        glm::mat4 worldMatrix;
+        // Index of the world matrix in the renderer, to use the matrices computed for the frame. ~0u if there is none
+        unsigned int worldMatrixIndex;
+        bool cameraChanged;
+    };
+
+    struct BindVAOCommand
+    {
+        static constexpr CommandType Type = CommandType::BindVAO;
+        const VertexArrayObject* vao;
+    };
+
+    // Read the world matrix attribute from an instance buffer. If the buffer is null, from the instance data of the command buffer
+    struct InstanceWorldMatricesCommand
+    {
+        static constexpr CommandType Type = CommandType::InstanceWorldMatrices;
+        GLint location;
+        const VertexBufferObject* buffer;
+        unsigned int firstInstance;
+    };
+
+    // Constant world matrix attribute, for drawcalls of instanced shader programs that are not batched
+    struct WorldMatrixAttributeCommand
+    {
+        static constexpr CommandType Type = CommandType::WorldMatrixAttribute;
+        GLint location;
+        glm::mat4 worldMatrix;
+    };
+
+    // Draw once, or once per light if lit, with the lighting render states of the forward pass
+    struct DrawCommand
+    {
+        static constexpr CommandType Type = CommandType::Draw;
+        Drawcall drawcall;
+        // 0 if the drawcall is not instanced
+        GLsizei instanceCount;
+        // Shader program that receives the lights, invalid if not lit
+        Renderer::ShaderProgramId litShaderProgramId;
+    };
+
+    // Buffer with the indirect commands of the multi-draws
+    using IndirectBufferObject = BufferObjectBase<BufferObject::DrawIndirectBuffer>;
+
+    // Parameters of one draw of a multi-draw, with the layout required by glMultiDrawElementsIndirect
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        // In elements, not in bytes
+        GLuint firstIndex;
+        GLint baseVertex;
+        // Offset added to the instance index when reading instanced attributes, like the world matrices
+        GLuint baseInstance;
+    };
+
+    // Several indexed draws with the same VAO and element type, from the indirect commands of the buffer
+    // Drawn once, or once per light if lit, like the draw command
+    struct MultiDrawCommand
+    {
+        static constexpr CommandType Type = CommandType::MultiDraw;
+        Drawcall::Primitive primitive;
+        Data::Type eboType;
+        unsigned int firstIndirectCommand;
+        GLsizei drawCount;
+        Renderer::ShaderProgramId litShaderProgramId;
+    };
+
+    // Position in the command stream, to read the commands in the order they were added
+    class Reader
+    {
+    public:
+        Reader(const RenderCommandBuffer& commandBuffer) : m_data(commandBuffer.m_data), m_offset(0) {}
+
+        bool HasCommands() const { return m_offset < m_data.size(); }
+
+        CommandType GetType() const;
+
+        // Read the current command and move to the next one. T must match the type of the command
+        template<typename T>
+        T Read();
+
+    private:
+        const std::vector<std::byte>& m_data;
+        std::size_t m_offset;
+    };
+
+public:
+    RenderCommandBuffer();
+    ~RenderCommandBuffer();
+
+    RenderCommandBuffer(RenderCommandBuffer&&) noexcept;
+    RenderCommandBuffer& operator = (RenderCommandBuffer&&) noexcept;
+
+    // Remove the commands and the instance data, and forget the recorded states and cameras
+    void Clear();
+
+    bool IsEmpty() const { return m_data.empty(); }
+    unsigned int GetCommandCount() const { return m_commandCount; }
+    // Size of the command stream in bytes
+    std::size_t GetSize() const { return m_data.size(); }
+
+    template<typename T>
+    void AddCommand(const T& command);
+
+    // Copy world matrices to the instance data. Returns the index of the first one
+    unsigned int AddInstanceWorldMatrices(std::span<const glm::mat4> worldMatrices);
+
+    // Add the parameters of a draw for a multi-draw command. Returns its index
+    unsigned int AddIndirectCommand(const DrawElementsIndirectCommand& indirectCommand);
+
+private:
+    // Remove the commands, but keep the recorded states. Used by the renderer to prepare single drawcalls
+    void ClearCommands();
+
+    // Forget the recorded states, so the next commands set them again. The cameras are kept
+    void InvalidateStates();
+
+    // Upload the instance data if it changed since the last execution. Only from the GL thread
+    const VertexBufferObject* GetInstanceBuffer();
+
+    // Upload the indirect commands if they changed since the last execution. Only from the GL thread
+    const IndirectBufferObject* GetIndirectBuffer();
+
+private:
+    // Every command is stored as its type followed by its data, padded to keep the types aligned
+    // The data is copied in and out, so it doesn't need the alignment of the command struct
+    static constexpr std::size_t s_commandAlignment = sizeof(CommandType);
+    static constexpr std::size_t s_headerSize = (sizeof(CommandType) + s_commandAlignment - 1) / s_commandAlignment * s_commandAlignment;
+
+    std::vector<std::byte> m_data;
+    unsigned int m_commandCount;
+
+    std::vector<glm::mat4> m_instanceWorldMatrices;
+    std::unique_ptr<VertexBufferObject> m_instanceBuffer;
+    bool m_instanceBufferDirty;
+
+    std::vector<DrawElementsIndirectCommand> m_indirectCommands;
+    std::unique_ptr<IndirectBufferObject> m_indirectBuffer;
+    bool m_indirectBufferDirty;
+
+    // States set by the recorded commands, to skip the ones that don't change
+    const ShaderProgram* m_lastShaderProgram;
+    const Material* m_lastMaterial;
+    Material::OverrideFlags m_lastMaterialOverride;
+    const VertexArrayObject* m_lastVAO;
+    unsigned int m_lastWorldMatrixIndex;
+    // Shader programs that already received the current camera
+    std::vector<const ShaderProgram*> m_cameraUpdatedShaderPrograms;
+
+    // State changes issued and skipped while recording. Materials are counted when executed
+    Renderer::StateChangeCounters m_stateChangeCounters;
+
+    friend class Renderer;
+};
+
+template<typename T>
+void RenderCommandBuffer::AddCommand(const T& command)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Commands must be plain data");
+
+    std::size_t offset = m_data.size();
+    std::size_t size = (sizeof(T) + s_commandAlignment - 1) / s_commandAlignment * s_commandAlignment;
+    m_data.resize(offset + s_headerSize + size);
+
+    CommandType type = T::Type;
+    std::memcpy(m_data.data() + offset, &type, sizeof(type));
+    std::memcpy(m_data.data() + offset + s_headerSize, &command, sizeof(T));
+    ++m_commandCount;
+}
+
+template<typename T>
+T RenderCommandBuffer::Reader::Read()
+{
+    assert(GetType() == T::Type);
+
+    T command;
+    std::memcpy(&command, m_data.data() + m_offset + s_headerSize, sizeof(T));
+    m_offset += s_headerSize + (sizeof(T) + s_commandAlignment - 1) / s_commandAlignment * s_commandAlignment;
+    return command;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <ituGL/renderer/RenderPass.h>
+#include <ituGL/texture/TextureObject.h>
+#include <glm/vec2.hpp>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstddef>
+
+class Texture2DObject;
+class FramebufferObject;
+class Material;
+
+// Render pass made of other passes that declare the textures they read and write
+// Passes that don't contribute to the output are culled, and transient textures are only allocated
+// while they are used, so passes that don't overlap can share the same texture
+class RenderGraph : public RenderPass
+{
+public:
+    using ResourceId = unsigned int;
+
+    // Description of a transient texture, allocated by the graph
+    struct TextureDesc
+    {
+        TextureObject::Format format = TextureObject::FormatRGBA;
+        TextureObject::InternalFormat internalFormat = TextureObject::InternalFormatRGBA16F;
+        // Size relative to the size of the graph
+        glm::vec2 scale = glm::vec2(1.0f);
+    };
+
+    // Resource for the default framebuffer. Passes that write it are always rendered
+    static constexpr ResourceId Backbuffer = 0;
+
+public:
+    RenderGraph(int width, int height);
+    ~RenderGraph();
+
+    // Texture owned by the graph, allocated from the pool only during its lifetime
+    ResourceId CreateTexture(const char* name, const TextureDesc& desc);
+
+    // Texture owned outside the graph. It is never aliased, and passes that write it are always rendered
+    // It must have the size of the graph. The format tells if it is attached as depth when written
+    ResourceId ImportTexture(const char* name, std::shared_ptr<Texture2DObject> texture, TextureObject::Format format = TextureObject::FormatRGBA);
+
+    // Add a pass. Passes are rendered in the order they are added. Returns the pass index
+    unsigned int AddPass(std::unique_ptr<RenderPass> renderPass);
+
+    // Declare that the pass reads the texture. If a material is provided, the texture is set to the uniform when the graph is compiled
+    void ReadTexture(unsigned int passIndex, ResourceId resource, std::shared_ptr<Material> material = nullptr, const char* uniformName = nullptr);
+
+    // Declare that the pass writes the texture. Color textures are attached in the order they are written, depth textures as depth attachment
+    // Passes that draw over the previous content also need to read the texture
+    void WriteTexture(unsigned int passIndex, ResourceId resource);
+
+    // Size of the backbuffer. Transient textures are allocated again from the pool when it changes
+    void SetSize(int width, int height);
+    inline int GetWidth() const { return m_width; }
+    inline int GetHeight() const { return m_height; }
+
+    // Fraction of the size of the textures that is rendered, for dynamic resolution. Passes writing the backbuffer render
+    // all of it, scaling up the textures they read. The textures keep their size, so changing it every frame is cheap
+    // The renderer gets the exact scale of the full size textures, to scale the texture coordinates in the shaders
+    inline float GetResolutionScale() const { return m_resolutionScale; }
+    void SetResolutionScale(float resolutionScale);
+
+    // Texture assigned to the resource in the last compilation. Can be shared with other resources
+    std::shared_ptr<Texture2DObject> GetTexture(ResourceId resource) const;
+
+    bool IsPassCulled(unsigned int passIndex) const;
+
+    // Transient textures currently allocated in the pool, and their approximate size in bytes
+    unsigned int GetPoolTextureCount() const { return static_cast<unsigned int>(m_texturePool.size()); }
+    std::size_t GetPoolMemorySize() const;
+
+    void Render() override;
+    const char* GetName() const override { return "Render graph"; }
+
+private:
+    struct Resource
+    {
+        std::string name;
+        TextureDesc desc;
+        bool imported;
+
+        // Assigned in Compile
+        std::shared_ptr<Texture2DObject> texture;
+        int width, height;
+        int firstPass, lastPass;
+    };
+
+    struct ReadBinding
+    {
+        ResourceId resource;
+        std::shared_ptr<Material> material;
+        std::string uniformName;
+    };
+
+    struct Pass
+    {
+        std::unique_ptr<RenderPass> renderPass;
+        std::vector<ReadBinding> reads;
+        std::vector<ResourceId> writes;
+
+        // Assigned in Compile
+        bool culled;
+        std::shared_ptr<FramebufferObject> framebuffer;
+        int width, height;
+    };
+
+    struct PoolTexture
+    {
+        std::shared_ptr<Texture2DObject> texture;
+        int width, height;
+        TextureObject::Format format;
+        TextureObject::InternalFormat internalFormat;
+        bool inUse;
+        bool used;
+    };
+
+private:
+    // Cull the passes, compute the lifetimes, assign the textures and build the framebuffers
+    void Compile();
+
+    void CullPasses();
+    void AssignTextures();
+    void InitializeFramebuffers();
+
+    std::shared_ptr<Texture2DObject> AcquireTexture(const Resource& resource);
+    void ReleaseTexture(const std::shared_ptr<Texture2DObject>& texture);
+
+    static bool IsDepthFormat(TextureObject::Format format);
+
+private:
+    int m_width, m_height;
+
+    float m_resolutionScale;
+
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+
+    // Transient textures, reused between resources and between compilations
+    std::vector<PoolTexture> m_texturePool;
+
+    // Set when passes, resources or size change
+    bool m_dirty;
+};
@@ -12,9 +12,13 @@ public:
     virtual ~RenderPass();
 
     std::shared_ptr<const FramebufferObject> GetTargetFramebuffer() const;
+    void SetTargetFramebuffer(std::shared_ptr<const FramebufferObject> targetFramebuffer);
 
     virtual void Render() = 0;
 
+    // Name shown in the profiler
+    virtual const char* GetName() const { return "Render pass"; }
+
 protected:
     Renderer& GetRenderer();
     const Renderer& GetRenderer() const;
@@ -2,15 +2,23 @@
 
 #include <ituGL/core/DeviceGL.h>
 #include <ituGL/renderer/RenderPass.h>
+#include <ituGL/renderer/TransformBatch.h>
 #include <ituGL/geometry/Drawcall.h>
 #include <ituGL/geometry/Mesh.h>
+#include <ituGL/geometry/VertexBufferObject.h>
 #include <ituGL/shader/Material.h>
+#include <ituGL/shader/UniformBlockLayout.h>
+#include <ituGL/shader/UniformBufferObject.h>
+#include <ituGL/utils/ThreadPool.h>
 #include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
 #include <vector>
 #include <unordered_map>
 #include <memory>
 #include <span>
 #include <functional>
+#include <cstdint>
 
 class Camera;
 class Light;
@@ -20,25 +28,79 @@ class VertexArrayObject;
 class Drawcall;
 class Model;
 class FramebufferObject;
+class RenderCommandBuffer;
 
 class Renderer
 {
 public:
+    // Packed key used to sort drawcalls. From most to least significant bits:
+    // translucency, and then shader program, material, VAO and quantized view depth.
+    // Each collection is sorted on its own, so the key doesn't include the pass
+    // Translucent drawcalls place the depth (reversed) before the state, to be sorted back to front
+    using SortKey = std::uint64_t;
+
+    // Dense index of a shader program registered in the renderer, to reach its functions without hashing or refcounting
+    using ShaderProgramId = unsigned int;
+    static constexpr ShaderProgramId InvalidShaderProgramId = ~0u;
+
     class DrawcallInfo
     {
     public:
-        DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, const VertexArrayObject& vao, const Drawcall& drawcall);
+        DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, const VertexArrayObject& vao, const Drawcall& drawcall,
+            ShaderProgramId shaderProgramId, const VertexArrayObject* positionVAO = nullptr, SortKey sortKey = 0);
 
         const Material& GetMaterial() const { return m_material; }
         unsigned int GetWorldMatrixIndex() const { return m_worldMatrixIndex; }
         const VertexArrayObject& GetVAO() const { return m_vao; }
         const Drawcall& GetDrawcall() const { return m_drawcall; }
 
+        // VAO with only the position in location 0, for the depth pre-pass. Can be null
+        const VertexArrayObject* GetPositionVAO() const { return m_positionVAO; }
+
+        // Id of the shader program of the material when the drawcall was added, invalid if it was not registered
+        ShaderProgramId GetShaderProgramId() const { return m_shaderProgramId; }
+
+        SortKey GetSortKey() const { return m_sortKey; }
+        void SetSortKey(SortKey sortKey) { m_sortKey = sortKey; }
+
     private:
         std::reference_wrapper<const Material> m_material;
         unsigned int m_worldMatrixIndex;
         std::reference_wrapper<const VertexArrayObject> m_vao;
         std::reference_wrapper<const Drawcall> m_drawcall;
+        ShaderProgramId m_shaderProgramId;
+        const VertexArrayObject* m_positionVAO;
+        SortKey m_sortKey;
+
+        friend class Renderer;
+    };
+
+    // Group of drawcalls with the same material, VAO and drawcall, rendered with a single instanced draw
+    // Drawcalls that can't be instanced are in a batch of their own
+    class DrawcallBatch
+    {
+    public:
+        DrawcallBatch(const DrawcallInfo& drawcallInfo, bool instanced);
+
+        // First drawcall of the batch. The others only differ in the world matrix
+        const DrawcallInfo& GetDrawcallInfo() const { return m_drawcallInfo; }
+
+        bool IsInstanced() const { return m_instanced; }
+
+        // Range of the world matrices in the instance buffer
+        unsigned int GetFirstInstance() const { return m_firstInstance; }
+        unsigned int GetInstanceCount() const { return m_instanceCount; }
+
+        // Draw all the instances in the batch
+        void Draw() const;
+
+    private:
+        DrawcallInfo m_drawcallInfo;
+        bool m_instanced;
+        unsigned int m_firstInstance;
+        unsigned int m_instanceCount;
+
+        friend class Renderer;
     };
 
     using DrawcallSupportedFunction = std::function<bool(const DrawcallInfo& drawcallInfo)>;
@@ -56,22 +118,121 @@ public:
         void AddDrawcall(const DrawcallInfo& drawcallInfo);
         void Clear();
 
+        // Remove the drawcalls added for the current frame, keeping the retained ones in their current order
+        void ClearFrameDrawcalls(unsigned int firstFrameWorldMatrixIndex);
+
+        // Stable radix sort of the drawcalls by their sort key
+        void SortByKey();
+
     private:
         DrawcallSupportedFunction m_isSupported;
         std::vector<DrawcallInfo> m_drawcallInfos;
+
+        // Scratch buffers for sorting, kept to avoid allocating every frame
+        std::vector<SortKey> m_sortKeys, m_sortKeysScratch;
+        std::vector<unsigned int> m_sortIndices, m_sortIndicesScratch;
+        std::vector<DrawcallInfo> m_drawcallInfosScratch;
+
+        // Drawcalls grouped in batches, and the world matrices of the instanced ones. Rebuilt when the drawcalls change
+        std::vector<DrawcallBatch> m_batches;
+        std::vector<glm::mat4> m_instanceWorldMatrices;
+        bool m_batchesDirty;
+        // MeshPool defragment generation when the batches were built
+        unsigned int m_meshPoolGeneration;
+
+        // First batch of each multi-draw run, and the end of the last one, for RecordDrawcallCollection
+        std::vector<unsigned int> m_multiDrawRuns;
+
+        // Opaque batches sorted front to back for the depth pre-pass, and their view depths
+        std::vector<unsigned int> m_depthPrepassBatches;
+        std::vector<float> m_depthPrepassDepths;
+
+        // Drawcalls added for the current frame, the others are retained
+        unsigned int m_frameDrawcallCount;
+
+        // Translucent drawcalls are blended by a pass that doesn't depend on their order, so they are never sorted
+        bool m_orderIndependent;
+
+        // The sort keys or the drawcalls changed since the last sort by key, and the camera used for it
+        bool m_sortDirty;
+        glm::vec3 m_sortCameraPosition;
+        glm::vec3 m_sortCameraForward;
+
+        friend class Renderer;
+    };
+
+    // World matrices and drawcalls added from a single worker thread, to be merged later into the renderer
+    // The world matrix indices are local to the buffer until the merge
+    class DrawcallBuffer
+    {
+    public:
+        DrawcallBuffer();
+
+        std::span<const glm::mat4> GetWorldMatrices() const { return m_worldMatrices; }
+
+        void Clear();
+
+    private:
+        std::vector<glm::mat4> m_worldMatrices;
+
+        // Drawcalls for each collection, already filtered by the supported function
+        std::vector<std::vector<DrawcallInfo>> m_drawcallInfos;
+
+        friend class Renderer;
     };
 
     using DrawcallSortFunction = std::function<bool(const DrawcallInfo&, const DrawcallInfo&)>;
 
+    // Handle of a model that keeps its drawcalls between frames. The slot of the model goes in the low bits and its
+    // generation in the high bits, so the handle of a removed model never refers to a new model in the same slot
+    using RetainedModelId = std::uint64_t;
+
+    // Number of state changes issued and skipped in PrepareDrawcall, since the start of the last frame
+    struct StateChangeCounters
+    {
+        // Shader programs set as current
+        unsigned int shaderProgramsIssued = 0;
+        unsigned int shaderProgramsSkipped = 0;
+        // Materials applied (uniforms and render states)
+        unsigned int materialsIssued = 0;
+        unsigned int materialsSkipped = 0;
+        // Vertex array objects bound
+        unsigned int vaosIssued = 0;
+        unsigned int vaosSkipped = 0;
+        // Calls to the update transforms function
+        unsigned int transformsIssued = 0;
+        unsigned int transformsSkipped = 0;
+    };
+
+    // CPU time in milliseconds spent in each stage since the last reset. Only measured when enabled
+    struct StageTimings
+    {
+        // AddModel calls on the renderer, not on drawcall buffers
+        double addModel = 0.0;
+        double sort = 0.0;
+        double prepareDrawcalls = 0.0;
+        // Time inside the render passes, including PrepareDrawcall. The rest is mostly issuing the draws
+        double renderPasses = 0.0;
+    };
+
     using UpdateTransformsFunction = std::function<void(const ShaderProgram&, const glm::mat4&, const Camera&, bool)>;
     using UpdateLightsFunction = std::function<bool(const ShaderProgram&, std::span<const Light* const>, unsigned int&)>;
 
+    // Binding points of the uniform blocks shared by all the registered shader programs (see uniforms.glsl)
+    // FrameData has the camera matrices, uploaded once per frame. PassData has the size of the render target
+    static constexpr GLuint FrameDataBinding = 0;
+    static constexpr GLuint PassDataBinding = 1;
+
 public:
     Renderer(DeviceGL& device);
+    ~Renderer();
 
     const DeviceGL& GetDevice() const { return m_device; }
     DeviceGL& GetDevice() { return m_device; }
 
+    // Worker threads for the CPU work of the passes
+    ThreadPool& GetThreadPool() { return m_threadPool; }
+
     int AddRenderPass(std::unique_ptr<RenderPass> renderPass);
 
     bool HasCamera() const;
@@ -86,58 +247,254 @@ public:
     void AddLight(const Light& light);
 
     std::span<const DrawcallInfo> GetDrawcalls(unsigned int collectionIndex) const;
-    void AddModel(const Model& model, const glm::mat4& worldMatrix);
+    // Get the drawcalls grouped in batches, building them and uploading the instance data if needed
+    std::span<const DrawcallBatch> GetDrawcallBatches(unsigned int collectionIndex);
+    // Add the drawcalls of one level of detail of the model
+    void AddModel(const Model& model, const glm::mat4& worldMatrix, unsigned int lod = 0);
+
+    // Buffers to add models from several threads at the same time. They are cleared, and kept between frames to reuse memory
+    std::span<DrawcallBuffer> GetDrawcallBuffers(unsigned int count);
+    // Same as AddModel, but the drawcalls go to the buffer. Only reads the renderer, so it is safe to call it from worker threads
+    // The supported functions of the drawcall collections are called from the same thread, so they must be thread safe too
+    void AddModel(DrawcallBuffer& buffer, const Model& model, const glm::mat4& worldMatrix, unsigned int lod = 0) const;
+    // Append the content of the buffers, in order. The result is the same as adding their models with AddModel in that order
+    void MergeDrawcallBuffers(std::span<DrawcallBuffer> buffers);
+
+    // Retained models are added once, and their drawcalls stay in the collections until they are removed
+    // The sorted order is kept between frames, and SortDrawcallCollection only sorts again when the drawcalls change,
+    // or when the camera moves past the resort thresholds. They can be added at any point of the frame
+    // Retained models always draw level of detail 0
+    RetainedModelId AddRetainedModel(const Model& model, const glm::mat4& worldMatrix);
+    // The functions taking an id do nothing and return false if the model was already removed
+    bool RemoveRetainedModel(RetainedModelId id);
+    // Only translucent drawcalls are sorted again when their world matrix changes
+    bool SetRetainedModelWorldMatrix(RetainedModelId id, const glm::mat4& worldMatrix);
+    // Add the drawcalls again, after the materials of the model changed or were replaced
+    bool UpdateRetainedModelMaterials(RetainedModelId id);
+    bool IsRetainedModel(RetainedModelId id) const;
+    unsigned int GetRetainedModelCount() const;
+
+    // Camera translation and rotation (in radians) since the last sort that make the retained drawcalls sort again
+    void SetRetainedSortThresholds(float distance, float angle);
 
     unsigned int AddDrawcallCollection(const DrawcallSupportedFunction &drawcallSupportedFunction);
     void SetDrawcallCollectionSupportedFunction(unsigned int index, const DrawcallSupportedFunction& drawcallSupportedFunction);
 
+    // Collection drawn with an order-independent transparency pass, like WeightedBlendedOITRenderPass
+    // Its drawcalls are never sorted, and the translucent ones are instanced like the opaque ones
+    bool IsDrawcallCollectionOrderIndependent(unsigned int index) const;
+    void SetDrawcallCollectionOrderIndependent(unsigned int index, bool orderIndependent);
+
     void SortDrawcallCollection(unsigned int index, const DrawcallSortFunction& drawcallSortFunction);
+    // Sort using the packed sort keys: opaque drawcalls grouped by state and front to back, translucent back to front
+    // Does nothing for order independent collections
+    void SortDrawcallCollection(unsigned int index);
     bool IsBackToFront(const DrawcallInfo& a, const DrawcallInfo& b) const;
     bool IsFrontToBack(const DrawcallInfo& a, const DrawcallInfo& b) const;
 
     const Mesh& GetFullscreenMesh() const;
 
-    void RegisterShaderProgram(std::shared_ptr<const ShaderProgram> shaderProgramPtr,
+    // Register the functions to update transforms and lights of the shader program
+    // The FrameData and PassData uniform blocks of the shader program, if present, are bound to their binding points
+    // Without an update transforms function, the renderer sets the WorldMatrix, WorldViewMatrix, WorldViewProjMatrix and
+    // NormalMatrix (mat3) uniforms, if present, from the matrices it computes for all the models at the start of the frame
+    // If the shader program reads the world matrix from a mat4 vertex attribute, pass its location to enable instancing.
+    // Instanced shader programs always get the identity as world matrix in the update transforms function
+    // Returns the id of the shader program. Registering it again replaces the functions and keeps the id
+    // Drawcalls get the id when they are added, so shader programs must be registered before adding their models
+    ShaderProgramId RegisterShaderProgram(std::shared_ptr<const ShaderProgram> shaderProgramPtr,
         const UpdateTransformsFunction& updateTransformFunction,
-        const UpdateLightsFunction& updateLightsFunction);
+        const UpdateLightsFunction& updateLightsFunction,
+        ShaderProgram::Location instanceWorldMatrixLocation = -1);
+
+    // Invalid id if the shader program is not registered. Look it up once, not per draw
+    ShaderProgramId GetShaderProgramId(const ShaderProgram& shaderProgram) const;
+    ShaderProgramId GetShaderProgramId(const Material& material) const;
 
-    void UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgramPtr, const glm::mat4& worldMatrix, bool cameraChanged = true) const;
-    void UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgramPtr, unsigned int worldMatrixIndex, bool cameraChanged = true) const;
+    void UpdateTransforms(ShaderProgramId shaderProgramId, const glm::mat4& worldMatrix, bool cameraChanged = true) const;
+    void UpdateTransforms(ShaderProgramId shaderProgramId, unsigned int worldMatrixIndex, bool cameraChanged = true) const;
+
+    // Camera matrices of the world matrices of this frame, computed at the start of Render
+    const TransformBatch& GetTransformBatch() const { return m_transformBatch; }
 
     UpdateLightsFunction GetDefaultUpdateLightsFunction(const ShaderProgram& shaderProgram);
-    bool UpdateLights(std::shared_ptr<const ShaderProgram> shaderProgramPtr, std::span<const Light* const> lights, unsigned int& lightIndex) const;
+    bool UpdateLights(ShaderProgramId shaderProgramId, std::span<const Light* const> lights, unsigned int& lightIndex) const;
 
     void PrepareDrawcall(const DrawcallInfo& drawcallInfo, Material::OverrideFlags materialOverride = Material::NoOverride);
+    void PrepareDrawcallBatch(const DrawcallBatch& drawcallBatch, Material::OverrideFlags materialOverride = Material::NoOverride);
 
     void SetLightingRenderStates(bool firstPass);
 
+    // Record the drawcall batches of the collection in command buffers, one per range of batches, recorded in parallel
+    // The buffers are resized to the number of ranges, and they must be executed in order. Only from the GL thread
+    // If lit, each batch is drawn once per light with the update lights function, like in the forward pass
+    // The opaque override is added for the opaque batches, to keep the depth states set by the pass after a depth pre-pass
+    // With multi-draw, consecutive instanced batches with the same material, VAO, primitive and element type are drawn with
+    // a single glMultiDrawElementsIndirect. Each draw finds its world matrices with its base instance. It needs meshes that
+    // share their VAO, like the ones of a MeshPool, and it is ignored if the context doesn't support it
+    void RecordDrawcallCollection(std::vector<RenderCommandBuffer>& commandBuffers, unsigned int collectionIndex, bool lit,
+        Material::OverrideFlags materialOverride = Material::NoOverride, Material::OverrideFlags opaqueMaterialOverride = Material::NoOverride,
+        bool multiDraw = false);
+
+    // Check if the context supports multi-draw indirect with base instance. Requires OpenGL 4.3
+    static bool IsMultiDrawIndirectSupported();
+
+    // Record the opaque batches of the collection front to back with the depth material, reading only the positions
+    // The shader program of the depth material must be registered, and it must compute the same positions as the materials
+    // Batches without a position-only VAO, or instanced when the depth shader program is not, use their own material
+    // Color writes are not changed, the pass must disable them
+    void RecordDepthPrepass(std::vector<RenderCommandBuffer>& commandBuffers, unsigned int collectionIndex, const Material& depthMaterial);
+
+    // Execute the commands in the GL thread. A buffer can be executed again in later frames
+    void ExecuteCommandBuffer(RenderCommandBuffer& commandBuffer);
+
+    // Forget the states cached by PrepareDrawcall. Needed if GL state is changed outside of the renderer
+    void InvalidateStateCache();
+
+    const StateChangeCounters& GetStateChangeCounters() const { return m_stateChangeCounters; }
+
+    bool IsStageTimingEnabled() const { return m_stageTimingEnabled; }
+    void SetStageTimingEnabled(bool enabled) { m_stageTimingEnabled = enabled; }
+    const StageTimings& GetStageTimings() const { return m_stageTimings; }
+    void ResetStageTimings() { m_stageTimings = StageTimings(); }
+
+    // Part of the render targets rendered in this frame, when only a part is rendered to save GPU time (dynamic resolution)
+    // Shaders multiply their texture coordinates by ResolutionScale (PassData) to sample those targets. Set by RenderGraph
+    const glm::vec2& GetResolutionScale() const { return m_resolutionScale; }
+    void SetResolutionScale(const glm::vec2& resolutionScale) { m_resolutionScale = resolutionScale; }
+
     void Render();
 
+    // Bind the target framebuffer of the pass, update the pass data and render it. Used by passes that contain other passes
+    void ExecuteRenderPass(RenderPass& renderPass);
+
 private:
     void Reset();
 
     void InitializeFullscreenMesh();
 
+    void InitializeUniformBlocks();
+    void UpdateFrameData();
+    // Compute the camera matrices of all the world matrices, if any shader program uses them
+    void UpdateTransformBatch();
+    void UpdatePassData();
+
     const glm::mat4& GetWorldMatrix(const DrawcallInfo& drawcallInfo) const;
 
+    void PrepareDrawcall(const DrawcallInfo& drawcallInfo, Material::OverrideFlags materialOverride, const DrawcallBatch* drawcallBatch);
+
+    // Record the state changes for the drawcall, skipping the ones already recorded in the buffer
+    // The instance world matrices of batches are copied to the buffer if provided. Otherwise, they are read from the instance buffer
+    void RecordPrepareDrawcall(RenderCommandBuffer& commandBuffer, const DrawcallInfo& drawcallInfo, Material::OverrideFlags materialOverride,
+        const DrawcallBatch* drawcallBatch, const std::vector<glm::mat4>* instanceWorldMatrices) const;
+
+    ShaderProgram::Location GetInstanceWorldMatrixLocation(ShaderProgramId shaderProgramId) const;
+    void BuildDrawcallBatches(DrawcallCollection& collection) const;
+    // Build the batches of the collection if the drawcalls changed, without uploading the instance data
+    void UpdateDrawcallBatches(unsigned int collectionIndex);
+
+    // Group consecutive batches that can be drawn in the same multi-draw, into the runs of the collection
+    void BuildMultiDrawRuns(DrawcallCollection& collection) const;
+
+    // Split the batches in ranges and record each range in a command buffer, in parallel
+    void RecordBatchRanges(std::vector<RenderCommandBuffer>& commandBuffers, unsigned int batchCount,
+        const std::function<void(RenderCommandBuffer& commandBuffer, unsigned int batchIndex)>& recordBatch);
+
+    // Slot of a retained model, also the index of its world matrix. Returns false if the model was removed
+    bool GetRetainedModelIndex(RetainedModelId id, unsigned int& index) const;
+    // Add the drawcalls of a retained model to all the collections
+    void AddRetainedDrawcalls(unsigned int index);
+    void RemoveRetainedDrawcalls(unsigned int index);
+    // The camera moved too far from where the collection was sorted
+    bool IsSortCameraChanged(const DrawcallCollection& collection) const;
+
+    static SortKey ComputeSortKey(const Material& material, const VertexArrayObject& vao);
+    void UpdateSortKeyDepths(DrawcallCollection& collection) const;
+
 private:
     DeviceGL& m_device;
 
+    ThreadPool m_threadPool;
+
     const Camera *m_currentCamera;
 
-    std::shared_ptr<const Material> m_currentMaterial;
+    // PrepareDrawcall records to this buffer and executes it right away. It keeps the states applied by the last
+    // PrepareDrawcall, to skip the ones that don't change, and the shader programs that received the camera this frame
+    std::unique_ptr<RenderCommandBuffer> m_immediateCommandBuffer;
+    // Render states changed after the last material was applied (by additional light passes)
+    bool m_renderStatesDirty;
+
+    StateChangeCounters m_stateChangeCounters;
+
+    bool m_stageTimingEnabled;
+    StageTimings m_stageTimings;
+    // Passes inside other passes are not timed again
+    unsigned int m_renderPassDepth;
 
     std::shared_ptr<const FramebufferObject> m_defaultFramebuffer;
     std::shared_ptr<const FramebufferObject> m_currentFramebuffer;
 
     std::vector<const Light*> m_lights;
 
+    // The first world matrices belong to the retained models, one per slot. The matrices of the frame go after them
     std::vector<glm::mat4> m_worldMatrices;
 
+    // Models of the retained slots, null if the slot is free, and the generation of the slot, incremented when it is freed
+    std::vector<const Model*> m_retainedModels;
+    std::vector<unsigned int> m_retainedModelGenerations;
+    std::vector<unsigned int> m_freeRetainedModelIndices;
+    float m_retainedSortDistance;
+    float m_retainedSortCosAngle;
+
     std::vector<DrawcallCollection> m_drawcallCollections;
 
-    std::unordered_map<std::shared_ptr<const ShaderProgram>, UpdateTransformsFunction> m_updateTransformsFunctions;
-    std::unordered_map<std::shared_ptr<const ShaderProgram>, UpdateLightsFunction> m_updateLightsFunctions;
+    // Buffers for the models added from worker threads
+    std::vector<DrawcallBuffer> m_drawcallBuffers;
+
+    // Transform uniforms of the shader programs without update transforms function
+    struct TransformUniformLocations
+    {
+        ShaderProgram::Location worldMatrix;
+        ShaderProgram::Location worldViewMatrix;
+        ShaderProgram::Location worldViewProjMatrix;
+        ShaderProgram::Location normalMatrix;
+    };
+
+    // Everything registered for a shader program, indexed by its id
+    struct RegisteredShaderProgram
+    {
+        std::shared_ptr<const ShaderProgram> shaderProgram;
+        UpdateTransformsFunction updateTransformsFunction;
+        UpdateLightsFunction updateLightsFunction;
+        ShaderProgram::Location instanceWorldMatrixLocation;
+        // Only used if there is no update transforms function
+        bool hasTransformUniforms;
+        TransformUniformLocations transformUniformLocations;
+    };
+    std::vector<RegisteredShaderProgram> m_shaderPrograms;
+    std::unordered_map<const ShaderProgram*, ShaderProgramId> m_shaderProgramIds;
+    // Some registered shader program uses the transform batch
+    bool m_hasTransformUniforms;
+
+    // World-view, world-view-projection and normal matrices of m_worldMatrices, for the current frame
+    TransformBatch m_transformBatch;
+
+    // World matrices of the instanced batches, for one collection at a time
+    VertexBufferObject m_instanceBuffer;
+    int m_instanceBufferCollectionIndex;
+
+    // Uniform blocks shared by all shader programs, with the data per frame and per pass
+    UniformBlockLayout m_frameDataLayout;
+    UniformBufferObject m_frameDataBuffer;
+    UniformBlockLayout m_passDataLayout;
+    UniformBufferObject m_passDataBuffer;
+    // Target size and resolution scale in the pass data buffer, to upload them only when they change
+    glm::ivec2 m_passDataTargetSize;
+    glm::vec2 m_passDataResolutionScale;
+
+    glm::vec2 m_resolutionScale;
+    // CPU copy of the block data, reused for every upload
+    std::vector<std::byte> m_uniformBlockData;
 
     Mesh m_fullscreenMesh;
 
@@ -16,6 +16,7 @@ public:
     void SetTexture(std::shared_ptr<TextureCubemapObject> texture);
 
     void Render() override;
+    const char* GetName() const override { return "Skybox"; }
 
 private:
     std::shared_ptr<TextureCubemapObject> m_texture;
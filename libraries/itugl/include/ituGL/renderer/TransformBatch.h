@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/mat3x3.hpp>
+#include <span>
+#include <vector>
+
+// World matrices combined with the camera matrices in a single pass over all of them: world-view, world-view-projection,
+// and normal matrices (inverse transpose of the world-view rotation, to transform normals to view space)
+// The results are stored as structure of arrays, one array per matrix component, so each SIMD lane computes a different matrix
+class TransformBatch
+{
+public:
+    enum class Kernel
+    {
+        // One matrix at a time with glm
+        Glm,
+        // AVX or SSE, depending on the target of the compiler. Same as Glm if there is no SIMD support
+        Simd
+    };
+
+public:
+    TransformBatch();
+
+    void Compute(std::span<const glm::mat4> worldMatrices, const glm::mat4& viewMatrix, const glm::mat4& projMatrix, Kernel kernel = Kernel::Simd);
+    void Clear();
+
+    unsigned int GetCount() const { return m_count; }
+
+    glm::mat4 GetWorldViewMatrix(unsigned int index) const;
+    glm::mat4 GetWorldViewProjMatrix(unsigned int index) const;
+    glm::mat3 GetNormalMatrix(unsigned int index) const;
+
+    // Instruction set used by the SIMD kernel
+    static const char* GetSimdName();
+
+private:
+    // Resize the arrays for the number of matrices, padded to a multiple of the SIMD width
+    void Allocate(unsigned int count);
+
+    void ComputeGlm(std::span<const glm::mat4> worldMatrices, const glm::mat4& viewMatrix, const glm::mat4& projMatrix);
+    void ComputeSimd(std::span<const glm::mat4> worldMatrices, const glm::mat4& viewMatrix, const glm::mat4& projMatrix);
+
+private:
+    unsigned int m_count;
+    // Distance between two components of the same matrix in the arrays. It only grows, so it can be much larger than m_count
+    unsigned int m_stride;
+
+    // Component (column, row) of matrix i is at [(column * rows + row) * m_stride + i]
+    std::vector<float> m_worldMatrices;
+    std::vector<float> m_worldViewMatrices;
+    std::vector<float> m_worldViewProjMatrices;
+    std::vector<float> m_normalMatrices;
+};
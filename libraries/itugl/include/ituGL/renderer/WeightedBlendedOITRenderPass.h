@@ -0,0 +1,49 @@
+#pragma once
+
+#include <ituGL/renderer/RenderPass.h>
+#include <ituGL/renderer/RenderCommandBuffer.h>
+#include <memory>
+#include <vector>
+
+class Texture2DObject;
+
+// Weighted blended order-independent transparency (McGuire and Bavoil, 2013)
+// The translucent drawcalls are blended in any order into two targets: color attachment 0 accumulates the premultiplied
+// colors scaled by a weight that favors close and opaque fragments, and attachment 1 the product of (1 - alpha)
+// A PostFXRenderPass then composites the weighted average color over the opaque image, with 1 - revealage as alpha
+// The shaders must write both outputs (FragAccumulation and FragRevealage, see oit.glsl in the exercises)
+// Depth is tested against the opaque depth, but never written. Only translucent drawcalls can be in the collection
+class WeightedBlendedOITRenderPass : public RenderPass
+{
+public:
+    // Accumulation and revealage textures of the given size, with the depth texture of the opaque passes, if any
+    WeightedBlendedOITRenderPass(int width, int height, std::shared_ptr<const Texture2DObject> depthTexture, int drawcallCollectionIndex = 0);
+    // Without textures, for passes that get the target framebuffer from outside, like a render graph
+    explicit WeightedBlendedOITRenderPass(int drawcallCollectionIndex = 0);
+
+    // Record the drawcalls once and execute the same commands in the next frames, for scenes that don't change
+    // The models must stay alive. Setting it again, or defragmenting a MeshPool, records the commands in the next frame
+    bool IsStatic() const { return m_static; }
+    void SetStatic(bool isStatic);
+
+    void Render() override;
+    const char* GetName() const override { return "Weighted blended OIT"; }
+
+    const std::shared_ptr<Texture2DObject> GetAccumulationTexture() const { return m_accumulationTexture; }
+    const std::shared_ptr<Texture2DObject> GetRevealageTexture() const { return m_revealageTexture; }
+
+private:
+    void InitTextures(int width, int height);
+    void InitFramebuffer(std::shared_ptr<const Texture2DObject> depthTexture);
+
+private:
+    int m_drawcallCollectionIndex;
+
+    bool m_static;
+    // MeshPool defragment generation when the commands were recorded
+    unsigned int m_meshPoolGeneration;
+    std::vector<RenderCommandBuffer> m_commandBuffers;
+
+    std::shared_ptr<Texture2DObject> m_accumulationTexture;
+    std::shared_ptr<Texture2DObject> m_revealageTexture;
+};
@@ -1,7 +1,12 @@
 #pragma once
 
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 #include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <cassert>
+
+class Camera;
 
 class Bounds
 {
@@ -91,6 +96,8 @@ class BoxBounds : public RotatedBounds
 public:
     BoxBounds(const glm::vec3& center, const glm::mat3& rotationMatrix, const glm::vec3& size) : RotatedBounds(center, rotationMatrix), m_size(size) {}
     BoxBounds(const Bounds& bounds);
+    // Box that contains the local bounds after being transformed by the world matrix (without shear)
+    BoxBounds(const AabbBounds& localBounds, const glm::mat4& worldMatrix);
 
     inline Type GetType() const override { return Type::Box; }
 
@@ -103,21 +110,43 @@ private:
     glm::vec3 m_size;
 };
 
-class FrustumBounds : public RotatedBounds
+class FrustumBounds : public Bounds
 {
 public:
-    FrustumBounds(const glm::vec3& center, const glm::vec3& size);
+    FrustumBounds(const glm::mat4& viewProjMatrix);
+    FrustumBounds(const Camera& camera);
 
     inline Type GetType() const override { return Type::Frustum; }
 
+    // Extract the 6 planes from the matrix (Gribb-Hartmann). They are normalized and point inwards
+    void SetViewProjectionMatrix(const glm::mat4& viewProjMatrix);
+
+    // Plane order: left, right, bottom, top, near, far
+    inline const glm::vec4& GetPlane(unsigned int index) const { assert(index < 6); return m_planes[index]; }
+
+    // Conservative tests: false only if the volume is completely behind one of the planes
+    bool IntersectsSphere(const glm::vec3& center, float radius) const;
+    // The axes are the columns of the matrix, scaled by the half size of the box
+    bool IntersectsBox(const glm::vec3& center, const glm::mat3& scaledAxes) const;
+
 private:
+    bool IntersectsPlanes(const glm::vec3& center, const glm::mat3& scaledAxes, float radius) const;
+
+private:
+    glm::vec4 m_planes[6];
+
+    // Same planes stored by components, padded to 8 with repeated planes, so they can be tested 4 at a time
+    alignas(16) float m_planesX[8];
+    alignas(16) float m_planesY[8];
+    alignas(16) float m_planesZ[8];
+    alignas(16) float m_planesW[8];
 };
 
 
 template<typename T>
 bool Bounds::Intersects(const T& other) const
 {
-    Bounds::Intersects(this, other);
+    return Bounds::Intersects(*this, other);
 }
 
 template<typename TA, typename TB>
@@ -144,6 +173,8 @@ bool Bounds::Intersects(const Bounds& boundsA, const TB& boundsB)
         return Bounds::Intersects(static_cast<const AabbBounds&>(boundsA), boundsB);
     case Type::Box:
         return Bounds::Intersects(static_cast<const BoxBounds&>(boundsA), boundsB);
+    case Type::Frustum:
+        return Bounds::Intersects(static_cast<const FrustumBounds&>(boundsA), boundsB);
     default:
         assert(false);
         return false;
@@ -168,8 +199,8 @@ template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const AabbBounds& boundsB);
 template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const BoxBounds& boundsB);
-//template<>
-//bool Bounds::Intersects(const FrustumBounds& boundsA, const FrustumBounds& boundsB);
+template<>
+bool Bounds::Intersects(const FrustumBounds& boundsA, const FrustumBounds& boundsB);
 
 
 
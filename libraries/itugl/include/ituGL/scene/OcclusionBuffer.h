@@ -0,0 +1,96 @@
+#pragma once
+
+#include <ituGL/scene/Bounds.h>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+// Low resolution depth buffer rasterized on the CPU from a few large occluders, like walls and floors, to skip the models
+// hidden behind them before they are added to the renderer. The depth of each tile is also kept, to reject boxes quickly
+// Each tile is rasterized by a single task, with the triangles in the order they were added, so the result is the same
+// with any number of threads, and the SIMD kernel writes exactly the same depths as the reference one
+class OcclusionBuffer
+{
+public:
+    enum class Kernel
+    {
+        // One pixel at a time
+        Reference,
+        // Four pixels at a time with SSE2. Same as Reference if there is no SIMD support
+        Simd
+    };
+
+    // Side of the square tiles, in pixels. The resolution is rounded up to whole tiles
+    static constexpr unsigned int TileSize = 32;
+
+public:
+    OcclusionBuffer(unsigned int width = 256, unsigned int height = 128);
+
+    unsigned int GetWidth() const { return m_width; }
+    unsigned int GetHeight() const { return m_height; }
+    void SetResolution(unsigned int width, unsigned int height);
+
+    // Remove the occluders and set the camera for the next ones. Occluders must be added after it
+    void Clear(const glm::mat4& viewProjMatrix);
+
+    // Triangles of an occluder mesh, in model space. Triangles crossing the near plane are clipped
+    void AddOccluder(std::span<const glm::vec3> vertices, std::span<const unsigned int> indices, const glm::mat4& worldMatrix);
+    // Box occluder, in model space
+    void AddOccluder(const AabbBounds& localBounds, const glm::mat4& worldMatrix);
+
+    // Triangles after clipping, including the ones out of the screen
+    unsigned int GetTriangleCount() const { return static_cast<unsigned int>(m_triangles.size()); }
+
+    // Rasterize the occluders, one task per tile in the thread pool, if any
+    void Rasterize(ThreadPool* threadPool = nullptr, Kernel kernel = Kernel::Simd);
+
+    // Conservative test: false only if the box is behind the occluders in all the pixels it covers
+    // Boxes crossing the near plane, or out of the screen, are always visible. Thread safe after Rasterize
+    bool IsVisible(const AabbBounds& localBounds, const glm::mat4& worldMatrix) const;
+
+    // Depth in [0, 1] of the closest occluder in each pixel, row by row, 1 if there is none
+    std::span<const float> GetDepths() const { return m_depths; }
+    float GetDepth(unsigned int x, unsigned int y) const { return m_depths[y * m_width + x]; }
+
+    // Farthest depth of the pixels of the tile
+    float GetTileMaxDepth(unsigned int tileX, unsigned int tileY) const { return m_tileMaxDepths[tileY * m_tileCountX + tileX]; }
+
+    // Instruction set used by the SIMD kernel
+    static const char* GetSimdName();
+
+private:
+    // Triangle in screen space, with the depth as a plane and the edges as functions that are positive inside
+    // Pixel (x, y) is covered if the 3 edges are >= 0 at its center. The setup is shared by both kernels
+    struct Triangle
+    {
+        float edgeA[3], edgeB[3], edgeC[3];
+        float depthA, depthB, depthC;
+        // Pixels whose centers are in the bounds of the triangle, clamped to the screen
+        int minX, minY, maxX, maxY;
+    };
+
+    // Add a triangle in clip space, clipping it against the near plane
+    void AddClipTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2);
+    // Add a triangle in front of the near plane
+    void AddScreenTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2);
+
+    void RasterizeTile(unsigned int tileIndex, Kernel kernel);
+    void RasterizeTriangleReference(const Triangle& triangle, int minX, int minY, int maxX, int maxY);
+    void RasterizeTriangleSimd(const Triangle& triangle, int minX, int minY, int maxX, int maxY);
+
+private:
+    unsigned int m_width, m_height;
+    unsigned int m_tileCountX, m_tileCountY;
+
+    glm::mat4 m_viewProjMatrix;
+
+    std::vector<Triangle> m_triangles;
+    // Triangles overlapping each tile, in the order they were added
+    std::vector<std::vector<unsigned int>> m_tileTriangles;
+
+    std::vector<float> m_depths;
+    std::vector<float> m_tileMaxDepths;
+};
@@ -1,8 +1,14 @@
 #pragma once
 
 #include <ituGL/scene/SceneVisitor.h>
+#include <ituGL/scene/Bounds.h>
+#include <ituGL/renderer/Renderer.h>
+#include <vector>
 
-class Renderer;
+class Camera;
+class Light;
+class OcclusionBuffer;
+class Scene;
 class SceneCamera;
 class SceneLight;
 class SceneModel;
@@ -19,6 +25,64 @@ public:
 
     void VisitModel(SceneModel& sceneModel) override;
 
+    // Visit all the scene nodes, split in ranges across the renderer thread pool
+    // Each range fills its own drawcall buffer, and they are merged in order, so the result is the same as Scene::AcceptVisitor
+    // The transforms are updated first (see Scene::UpdateTransforms), the ranges only read them
+    void VisitParallel(Scene& scene);
+
+    // Skip the models outside the camera frustum. Needs to be set before visiting the scene
+    void EnableFrustumCulling(const Camera& camera);
+    void DisableFrustumCulling();
+    inline bool IsFrustumCullingEnabled() const { return m_frustumCulling; }
+
+    // Skip the models hidden behind the occluders, after the frustum culling. Only models with local bounds are tested
+    // The buffer must be rasterized for the same camera, and kept alive while visiting the scene
+    void EnableOcclusionCulling(const OcclusionBuffer& occlusionBuffer);
+    void DisableOcclusionCulling();
+    inline bool IsOcclusionCullingEnabled() const { return m_occlusionBuffer != nullptr; }
+
+    // Draw the models with levels of detail at the level for their projected size, see Model::SelectLod
+    // The selected level is stored in the scene model, to apply the hysteresis in the next frame
+    void EnableLodSelection(const Camera& camera, float hysteresis = 0.1f);
+    void DisableLodSelection();
+    inline bool IsLodSelectionEnabled() const { return m_lodSelection; }
+
+    // Skip all the models, when they are retained in the renderer (see RetainedSceneRegistry)
+    inline void SetModelsEnabled(bool enabled) { m_modelsEnabled = enabled; }
+    inline bool IsModelsEnabled() const { return m_modelsEnabled; }
+
+    // Number of models submitted to the renderer, and skipped by the culling. Culled models include the occluded ones
+    inline unsigned int GetVisibleModelCount() const { return m_visibleModelCount; }
+    inline unsigned int GetCulledModelCount() const { return m_culledModelCount; }
+    inline unsigned int GetOccludedModelCount() const { return m_occludedModelCount; }
+
+private:
+    // Visitor for one of the ranges of VisitParallel
+    RendererSceneVisitor(const RendererSceneVisitor& parent, Renderer::DrawcallBuffer& drawcallBuffer);
+
 private:
     Renderer& m_renderer;
+
+    // If set, models go to this buffer, and cameras and lights are kept to be added after the merge
+    Renderer::DrawcallBuffer* m_drawcallBuffer;
+    const Camera* m_bufferedCamera;
+    std::vector<const Light*> m_bufferedLights;
+
+    bool m_modelsEnabled;
+
+    bool m_frustumCulling;
+    FrustumBounds m_frustum;
+
+    const OcclusionBuffer* m_occlusionBuffer;
+
+    bool m_lodSelection;
+    glm::vec3 m_lodCameraPosition;
+    // Scale from the radius over the distance to the fraction of the screen height, from the projection matrix
+    float m_lodProjectionScale;
+    bool m_lodOrthographic;
+    float m_lodHysteresis;
+
+    unsigned int m_visibleModelCount;
+    unsigned int m_culledModelCount;
+    unsigned int m_occludedModelCount;
 };
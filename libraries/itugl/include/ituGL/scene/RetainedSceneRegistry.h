@@ -0,0 +1,58 @@
+#pragma once
+
+#include <ituGL/scene/SceneVisitor.h>
+#include <ituGL/renderer/Renderer.h>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+class Model;
+class SceneModel;
+
+// Keeps the scene models in the renderer as retained models, so their drawcalls are not added and sorted every frame
+// Visiting a scene with it registers all its models. Cameras and lights are not retained, they still need to be added
+// every frame, with a RendererSceneVisitor that skips the models. Scene models must be removed before they are destroyed
+class RetainedSceneRegistry : public SceneVisitor
+{
+public:
+    RetainedSceneRegistry(Renderer& renderer);
+    ~RetainedSceneRegistry();
+
+    RetainedSceneRegistry(const RetainedSceneRegistry&) = delete;
+    void operator = (const RetainedSceneRegistry&) = delete;
+
+    void VisitModel(SceneModel& sceneModel) override;
+
+    void AddModel(SceneModel& sceneModel);
+    void RemoveModel(const SceneModel& sceneModel);
+    void Clear();
+
+    // The materials of the model changed. Changes of the model itself are found in Update
+    void InvalidateMaterials(const SceneModel& sceneModel);
+
+    // Send the models with a changed transform, or a different model, to the renderer. Call it once per frame, before rendering
+    // Changes are found with the transform versions, so other code can read the transform matrices at any time
+    void Update();
+
+    inline unsigned int GetModelCount() const { return static_cast<unsigned int>(m_entries.size()); }
+    // Models updated in the last Update
+    inline unsigned int GetUpdatedModelCount() const { return m_updatedModelCount; }
+
+private:
+    struct Entry
+    {
+        SceneModel* sceneModel;
+        // Model when it was added to the renderer, to find when it is replaced
+        const Model* model;
+        // Version of the transform when the world matrix was sent to the renderer
+        std::uint64_t transformVersion;
+        Renderer::RetainedModelId id;
+    };
+
+    Renderer& m_renderer;
+
+    std::vector<Entry> m_entries;
+    std::unordered_map<const SceneModel*, unsigned int> m_entryIndices;
+
+    unsigned int m_updatedModelCount;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <unordered_map>
+#include <vector>
 #include <string>
 #include <memory>
 
@@ -20,9 +21,23 @@ public:
     bool RemoveSceneNode(std::shared_ptr<SceneNode> node);
     bool RemoveSceneNode(const std::string& name);
 
+    inline unsigned int GetNodeCount() const { return static_cast<unsigned int>(m_nodeList.size()); }
+
+    // Nodes are visited in the order they were added
     void AcceptVisitor(SceneVisitor& visitor);
     void AcceptVisitor(SceneVisitor& visitor) const;
 
+    // Visit only the nodes in [first, first + count). Different ranges can be visited from different threads
+    void AcceptVisitor(SceneVisitor& visitor, unsigned int first, unsigned int count);
+    void AcceptVisitor(SceneVisitor& visitor, unsigned int first, unsigned int count) const;
+
+    // Compute the world matrices cached by the transforms of the nodes, and of their parents
+    // After this, and until a transform changes, the matrices are only read, so ranges can be visited from different threads
+    void UpdateTransforms() const;
+
 private:
     std::unordered_map<std::string, std::shared_ptr<SceneNode>> m_nodes;
+
+    // Same nodes, in a fixed order, so they can be split in ranges
+    std::vector<std::shared_ptr<SceneNode>> m_nodeList;
 };
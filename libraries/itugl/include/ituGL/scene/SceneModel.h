@@ -11,9 +11,13 @@ public:
     SceneModel(const std::string& name, std::shared_ptr<Model> model);
     SceneModel(const std::string& name, std::shared_ptr<Model> model, std::shared_ptr<Transform> transform);
 
-    std::shared_ptr<Model> GetModel() const;
+    const std::shared_ptr<Model>& GetModel() const;
     void SetModel(std::shared_ptr<Model> model);
 
+    // Level of detail used in the last frame, kept by RendererSceneVisitor to select the next one with hysteresis
+    inline unsigned int GetLod() const { return m_lod; }
+    inline void SetLod(unsigned int lod) { m_lod = lod; }
+
     //glm::mat4 GetWorldMatrix() const override;
     //int GetDrawcallCount() const override;
     //const Drawcall& GetDrawcall(int index, const VertexArrayObject*& vao, const Material*& material) const override;
@@ -27,4 +31,6 @@ public:
 
 private:
     std::shared_ptr<Model> m_model;
+
+    unsigned int m_lod;
 };
@@ -19,7 +19,7 @@ public:
     const std::string& GetName() const;
     void Rename(const std::string& name);
 
-    std::shared_ptr<Transform> GetTransform();
+    const std::shared_ptr<Transform>& GetTransform();
     std::shared_ptr<const Transform> GetTransform() const;
     void SetTransform(std::shared_ptr<Transform> transform);
 
@@ -3,6 +3,8 @@
 #include <glm/vec3.hpp>
 #include <glm/mat4x4.hpp>
 #include <memory>
+#include <atomic>
+#include <cstdint>
 
 class Transform
 {
@@ -10,16 +12,16 @@ public:
     Transform();
 
     inline glm::vec3 GetTranslation() const { return m_translation; }
-    inline void SetTranslation(const glm::vec3& translation) { m_translation = translation; m_dirty = true; }
+    inline void SetTranslation(const glm::vec3& translation) { m_translation = translation; Invalidate(); }
 
     inline glm::vec3 GetRotation() const { return m_rotation; }
-    inline void SetRotation(const glm::vec3& rotation) { m_rotation = rotation; m_dirty = true; }
+    inline void SetRotation(const glm::vec3& rotation) { m_rotation = rotation; Invalidate(); }
 
     inline glm::vec3 GetScale() const { return m_scale; }
-    inline void SetScale(const glm::vec3& scale) { m_scale = scale; m_dirty = true; }
+    inline void SetScale(const glm::vec3& scale) { m_scale = scale; Invalidate(); }
 
     inline std::shared_ptr<Transform> GetParent() const { return m_parent; }
-    inline void SetParent(std::shared_ptr<Transform> parent) { m_parent = parent; m_dirty = true; }
+    inline void SetParent(std::shared_ptr<Transform> parent) { m_parent = parent; Invalidate(); }
 
     glm::mat4 GetTranslationMatrix() const;
     glm::mat4 GetRotationMatrix() const;
@@ -27,8 +29,16 @@ public:
 
     glm::mat4 GetTransformMatrix() const;
 
+    // The cached matrix is out of date
     bool IsDirty() const;
 
+    // Changes every time the matrix of the transform, or of any of its parents, changes. Reading the matrix doesn't change it,
+    // so each user can keep the last version it has seen
+    std::uint64_t GetVersion() const;
+
+private:
+    inline void Invalidate() { m_version = ++s_lastVersion; }
+
 private:
     glm::vec3 m_translation;
     glm::vec3 m_rotation;
@@ -36,7 +46,13 @@ private:
 
     std::shared_ptr<Transform> m_parent;
 
-    // Cached matrix
+    // Taken from a global counter on every change, so the largest version in the parents is also the latest change
+    std::uint64_t m_version;
+
+    // Cached matrix, and the version it was computed for
     mutable glm::mat4 m_matrix;
-    mutable bool m_dirty;
+    mutable std::uint64_t m_matrixVersion;
+
+    // Transforms can be created and modified while loading in worker threads
+    static std::atomic<std::uint64_t> s_lastVersion;
 };
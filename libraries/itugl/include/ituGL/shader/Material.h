@@ -5,18 +5,24 @@
 #include <ituGL/core/Color.h>
 #include <functional>
 #include <array>
+#include <atomic>
 
 // Class to group all the properties that may affect the look of a rendered geometry
 class Material : public ShaderUniformCollection
 {
 public:
     // Flags to skip setting blending, depth or stencil properties and use current value
+    // Shader program and uniforms can also be skipped, if they are known to be already set
     enum OverrideFlags
     {
         NoOverride = 0,
         OverrideBlend = 1 << 0,
         OverrideDepthTest = 1 << 1,
-        OverrideStencilTest = 1 << 2
+        OverrideStencilTest = 1 << 2,
+        OverrideShaderProgram = 1 << 3,
+        OverrideUniforms = 1 << 4,
+        OverrideRenderStates = OverrideBlend | OverrideDepthTest | OverrideStencilTest,
+        OverrideAll = OverrideRenderStates | OverrideShaderProgram | OverrideUniforms
     };
 
     // Different conditions for depth and stencil tests
@@ -123,9 +129,13 @@ public:
 
 
     // Use the shader program, set all uniforms, set depth properties, stencil properties, and blending
-    // You can skip depth, stencil or blending using the override flags
+    // You can skip any of them using the override flags
     void Use(OverrideFlags overrideFlags = OverrideFlags::NoOverride) const;
 
+    // Id to group the drawcalls of the material when sorting. Never reused, so a new material at the address of a
+    // deleted one doesn't inherit its id. Copies keep the id: they are sorted together, but never batched together
+    unsigned int GetSortId() const { return m_sortId; }
+
 private:
     // Set all the properties relative to depth
     void UseDepthTest() const;
@@ -173,6 +183,11 @@ private:
 
     // Blend color to use with ConstantColor or ConstantAlpha parameters. Default: white
     Color m_blendColor;
+
+    unsigned int m_sortId;
+
+    // Materials can be created while loading models in worker threads
+    static std::atomic<unsigned int> s_nextSortId;
 };
 
 // Different conditions for depth and stencil tests
@@ -90,6 +90,12 @@ public:
     // Get information about a specific uniform
     void GetUniformInfo(unsigned int index, int& size, GLenum& glType, std::span<char> uniformName) const;
 
+    // Find a uniform block index by name. Returns GL_INVALID_INDEX if not found
+    GLuint GetUniformBlockIndex(const char* name) const;
+
+    // Set the binding point the uniform block reads its UniformBufferObject from
+    void SetUniformBlockBinding(GLuint blockIndex, GLuint bindingIndex) const;
+
     // Template method combinations to simplify getting uniforms
     template<typename T>
     void GetUniform(Location location, T& value) const;
@@ -24,6 +24,8 @@ public:
     // Get the shader program
     std::shared_ptr<ShaderProgram> GetShaderProgram();
     std::shared_ptr<const ShaderProgram> GetShaderProgram() const;
+    // Get the shader program without copying the shared pointer (the reference count is shared between threads)
+    inline const ShaderProgram* GetShaderProgramPointer() const { return m_shaderProgram.get(); }
 
     // Reset the material with a different shader
     void ChangeShader(std::shared_ptr<ShaderProgram> shaderProgram, const NameSet& filteredUniforms = NameSet());
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <span>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include <algorithm>
+#include <cassert>
+
+// Builds the memory layout of a uniform block following the std140 rules, so the data can be shared by all programs
+// Members are added in the same order as they are declared in the shader. Structs are not supported
+class UniformBlockLayout
+{
+public:
+    UniformBlockLayout();
+
+    // Add a member at the end of the block. If arraySize is not 0, the member is an array
+    // Returns the offset of the member, in bytes
+    template<typename T>
+    unsigned int AddMember(const char* name, unsigned int arraySize = 0);
+
+    // Total size of the block, in bytes
+    unsigned int GetSize() const { return m_size; }
+
+    // Get the offset of a member by name. Returns -1 if not found
+    int GetMemberOffset(const char* name) const;
+
+    // Write the value of a member in the data buffer, adding the padding required by std140
+    template<typename T>
+    void SetValue(std::span<std::byte> data, const char* name, const T& value) const;
+
+    // Write several elements of an array member
+    template<typename T>
+    void SetValues(std::span<std::byte> data, const char* name, std::span<const T> values, unsigned int firstElement = 0) const;
+
+private:
+    // Properties of a type needed to compute the layout. Matrices are stored as arrays of column vectors
+    template<typename T>
+    struct TypeInfo
+    {
+        static constexpr unsigned int columns = 1;
+        static constexpr unsigned int rows = 1;
+    };
+    template<typename T, glm::length_t N>
+    struct TypeInfo<glm::vec<N, T>>
+    {
+        static constexpr unsigned int columns = 1;
+        static constexpr unsigned int rows = N;
+    };
+    template<typename T, glm::length_t C, glm::length_t R>
+    struct TypeInfo<glm::mat<C, R, T>>
+    {
+        static constexpr unsigned int columns = C;
+        static constexpr unsigned int rows = R;
+    };
+
+    // Struct to store a member of the block
+    struct Member
+    {
+        // Offset from the start of the block
+        unsigned int offset;
+        // Number of columns (1 if not a matrix) and components in each column
+        unsigned int columns;
+        unsigned int rows;
+        // Number of array elements (0 if not an array)
+        unsigned int arraySize;
+        // Distance between columns or array elements
+        unsigned int stride;
+    };
+
+private:
+    // Add a member with the properties of the type, following the std140 alignment rules
+    unsigned int AddMember(const char* name, unsigned int columns, unsigned int rows, unsigned int arraySize);
+
+    // Find a member by name
+    const Member& GetMember(const char* name) const;
+
+    // Copy the columns of an element, each one at its stride
+    void WriteElement(std::span<std::byte> data, const Member& member, unsigned int element, const float* values) const;
+
+private:
+    // Size of the block, including padding
+    unsigned int m_size;
+
+    // All the members in the block
+    std::vector<Member> m_members;
+
+    // Index of each member by name
+    std::unordered_map<std::string, unsigned int> m_memberIndices;
+};
+
+template<typename T>
+unsigned int UniformBlockLayout::AddMember(const char* name, unsigned int arraySize)
+{
+    // Only 32-bit components (float, int, uint, bool) are supported
+    static_assert(sizeof(T) == TypeInfo<T>::columns * TypeInfo<T>::rows * 4);
+    return AddMember(name, TypeInfo<T>::columns, TypeInfo<T>::rows, arraySize);
+}
+
+template<typename T>
+void UniformBlockLayout::SetValue(std::span<std::byte> data, const char* name, const T& value) const
+{
+    SetValues(data, name, std::span<const T>(&value, 1));
+}
+
+template<typename T>
+void UniformBlockLayout::SetValues(std::span<std::byte> data, const char* name, std::span<const T> values, unsigned int firstElement) const
+{
+    const Member& member = GetMember(name);
+    assert(member.columns == TypeInfo<T>::columns && member.rows == TypeInfo<T>::rows);
+    assert(firstElement + values.size() <= std::max(member.arraySize, 1u));
+
+    for (unsigned int i = 0; i < values.size(); ++i)
+    {
+        // Copy to floats, the data is copied as raw 32-bit values anyway
+        float elementValues[16];
+        std::memcpy(elementValues, &values[i], sizeof(T));
+        WriteElement(data, member, firstElement + i, elementValues);
+    }
+}
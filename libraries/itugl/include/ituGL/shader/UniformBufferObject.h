@@ -0,0 +1,28 @@
+#pragma once
+
+#include <ituGL/core/BufferObject.h>
+#include <ituGL/core/Data.h>
+
+// Uniform Buffer Object (UBO) is a BufferObject that provides the data of uniform blocks in shader programs
+// Shader blocks and buffers meet at indexed binding points: blocks read from the buffer bound to the same index
+class UniformBufferObject : public BufferObjectBase<BufferObject::UniformBuffer>
+{
+public:
+    UniformBufferObject();
+
+    // (C++) 3
+    // Use the same AllocateData methods from the base class
+    using BufferObject::AllocateData;
+    // Additionally, provide AllocateData methods with DynamicDraw as default usage
+    void AllocateData(size_t size);
+    void AllocateData(std::span<const std::byte> data);
+
+    // Bind the whole buffer to the binding point
+    void BindBase(GLuint bindingIndex) const;
+
+    // Bind a range of the buffer to the binding point. The offset must be aligned to GetOffsetAlignment()
+    void BindRange(GLuint bindingIndex, size_t offset, size_t size) const;
+
+    // Get the alignment required for offsets in BindRange
+    static size_t GetOffsetAlignment();
+};
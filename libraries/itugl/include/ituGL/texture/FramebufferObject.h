@@ -33,11 +33,15 @@ public:
 
     static std::shared_ptr<const FramebufferObject> GetDefault();
 
+    // Framebuffer bound instead of the default one, to render offscreen without changing the passes. Null to restore
+    static void SetDefaultRedirect(std::shared_ptr<const FramebufferObject> framebuffer);
+
 private:
     FramebufferObject(Handle handle);
 
 private:
     static std::shared_ptr<const FramebufferObject> s_defaultFramebuffer;
+    static std::shared_ptr<const FramebufferObject> s_defaultRedirect;
 };
 
 enum class FramebufferObject::Target : GLenum
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <ituGL/core/BufferObject.h>
+#include <ituGL/core/Data.h>
+#include <ituGL/texture/TextureObject.h>
+#include <ituGL/texture/FramebufferObject.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <span>
+
+class Texture2DObject;
+
+// Reads pixels from framebuffers and textures without stalling the pipeline
+// Each read copies the pixels to one of a ring of pixel pack buffers, and places a fence after it. Poll checks the fences
+// without waiting, usually one or two frames later, and maps the finished buffers. The data is then given to the callback
+// in a worker thread, so slow work like encoding or comparing images never blocks the rendering thread
+// Reads are not queued when all the buffers are busy: they are dropped, and counted, instead of waiting for the GPU
+class ReadbackQueue
+{
+public:
+    // Pixels of a finished read. Rows go from bottom to top, without padding
+    struct Image
+    {
+        // Value returned by the Read call
+        unsigned int id;
+        int width, height;
+        TextureObject::Format format;
+        Data::Type type;
+        std::span<const std::byte> data;
+    };
+
+    // Called in the worker thread, in the same order as the reads. Must not call OpenGL
+    // The data is only valid until the callback returns
+    using Callback = std::function<void(const Image& image)>;
+
+    // Value returned by Read when the read was dropped
+    static constexpr unsigned int InvalidId = 0;
+
+public:
+    // Usually one buffer for the frame being rendered, two for the frames in flight, and one being processed
+    ReadbackQueue(unsigned int bufferCount = 4);
+    // Waits for the pending reads and their callbacks
+    ~ReadbackQueue();
+
+    ReadbackQueue(const ReadbackQueue&) = delete;
+    void operator = (const ReadbackQueue&) = delete;
+
+    // Read a rectangle of an attachment of the framebuffer. The default framebuffer reads the back buffer
+    // The read buffer of the framebuffer is restored after the read, and the read framebuffer is left unbound
+    // Returns the id passed to the callback, or InvalidId if all the buffers are busy
+    unsigned int Read(const FramebufferObject& framebuffer, int x, int y, int width, int height,
+        TextureObject::Format format, Data::Type type, Callback callback,
+        FramebufferObject::Attachment attachment = FramebufferObject::Attachment::Color0);
+
+    // Read a whole level of the texture
+    unsigned int Read(const Texture2DObject& texture, int level,
+        TextureObject::Format format, Data::Type type, Callback callback);
+
+    // Give the finished reads to the worker thread, and recycle the buffers that it released. Never waits
+    // Call it once per frame. Returns the number of reads that finished
+    unsigned int Poll();
+
+    // Wait until all the reads are finished and their callbacks returned
+    void Finish();
+
+    // Reads that are on the GPU or in the worker thread
+    unsigned int GetPendingCount() const { return m_pendingCount; }
+
+    // Reads that were dropped because all the buffers were busy
+    unsigned int GetDroppedCount() const { return m_droppedCount; }
+
+private:
+    enum class State
+    {
+        // Ready for a new read
+        Free,
+        // Waiting for the fence
+        Copying,
+        // Mapped, queued or running in the worker thread
+        Processing,
+        // Callback returned, waiting to be unmapped
+        Processed
+    };
+
+    struct Slot
+    {
+        BufferObjectBase<BufferObject::PixelPackBuffer> buffer;
+        size_t capacity = 0;
+        // Bytes of the current read
+        size_t size = 0;
+        GLsync fence = nullptr;
+        Image image = {};
+        Callback callback;
+        // Protected by the mutex once the slot is given to the worker thread
+        State state = State::Free;
+    };
+
+    // Get the next slot, ready to be written, or null if it is busy
+    Slot* BeginRead(int width, int height, TextureObject::Format format, Data::Type type, Callback&& callback);
+    void EndRead(Slot& slot);
+
+    // Map the slots whose fence is signaled and queue them. If wait is true, wait for all of them
+    unsigned int ProcessFinishedCopies(bool wait);
+    // Unmap the slots released by the worker thread
+    void RecycleProcessedSlots();
+
+    void WorkerLoop();
+
+private:
+    std::vector<std::unique_ptr<Slot>> m_slots;
+
+    // Next slot to be written, and oldest slot waiting for its fence. Slots are used in order
+    unsigned int m_writeIndex;
+    unsigned int m_copyIndex;
+    // Slots waiting for their fence. Only changed in the rendering thread
+    unsigned int m_copyingCount;
+
+    unsigned int m_nextId;
+    unsigned int m_pendingCount;
+    unsigned int m_droppedCount;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    // Notifies the worker of new slots, or that it needs to stop
+    std::condition_variable m_workCondition;
+    // Notifies Finish that a slot was processed
+    std::condition_variable m_processedCondition;
+    std::deque<Slot*> m_queue;
+    bool m_stopping;
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <ituGL/texture/TextureObject.h>
+#include <ituGL/core/BufferObject.h>
+
+// Texture object that reads its texels from a buffer object. Shaders access it as a 1D array with texelFetch
+// Useful to pass large arrays of data that don't fit in uniforms
+class TextureBufferObject : public TextureObjectBase<TextureObject::TextureBuffer>
+{
+public:
+    TextureBufferObject();
+
+    // Attach the buffer, with the format to interpret its data. Usually a BufferObjectBase<BufferObject::TextureBuffer>
+    void SetBuffer(InternalFormat internalFormat, const BufferObject& buffer);
+
+    // Get the maximum number of texels of a texture buffer
+    static GLint GetMaxSize();
+};
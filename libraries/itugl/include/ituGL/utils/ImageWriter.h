@@ -0,0 +1,16 @@
+#pragma once
+
+#include <span>
+
+// Saves images to files, as binary PPM (color) or PGM (grayscale). Fast to write, with no compression
+// The functions don't use OpenGL, so they can run in any thread, for example in a ReadbackQueue callback
+class ImageWriter
+{
+public:
+    // ImageWriter class is static, so we delete the constructor
+    ImageWriter() = delete;
+
+    // Save 8-bit pixels with 1, 3 or 4 components, without padding between rows. Alpha is discarded
+    // If bottomToTop is true, the first row is the bottom one, like in the images read from OpenGL
+    static bool Save(const char* path, int width, int height, int components, std::span<const std::byte> data, bool bottomToTop = true);
+};
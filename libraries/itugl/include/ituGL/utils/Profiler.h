@@ -0,0 +1,149 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class DearImGui;
+
+// Collects CPU and GPU timings of named markers for the last frames
+// CPU markers can be added from any thread. GPU markers use timestamp queries, and their results are read
+// a few frames later, when they are available, so the profiler never waits for the GPU
+// Marker names are not copied, they must stay valid while the profiler is alive (usually string literals)
+class Profiler
+{
+public:
+    // Marker for the lifetime of the object, on the current profiler, if any
+    class Scope
+    {
+    public:
+        Scope(const char* name, bool gpu = false, const char* detail = nullptr);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        void operator = (const Scope&) = delete;
+
+    private:
+        Profiler* m_profiler;
+        int m_cpuMarker;
+        int m_gpuMarker;
+    };
+
+    struct Event
+    {
+        const char* name;
+        // Extra information, like the path of an asset
+        std::string detail;
+        // Times in microseconds since the profiler was created
+        double start;
+        double duration;
+        // 0 for GPU events, then one index per thread that added markers
+        unsigned int thread;
+        // Number of open markers in the same thread (or GPU) when it started
+        unsigned int depth;
+    };
+
+    struct Frame
+    {
+        unsigned int index;
+        std::vector<Event> cpuEvents;
+        // Filled a few frames later
+        std::vector<Event> gpuEvents;
+        bool gpuResolved;
+    };
+
+public:
+    // The last profiler created is the current one
+    Profiler();
+    ~Profiler();
+
+    Profiler(const Profiler&) = delete;
+    void operator = (const Profiler&) = delete;
+
+    // Profiler used by the scopes. Can be null
+    static Profiler* GetCurrent() { return s_current; }
+
+    bool IsEnabled() const { return m_enabled; }
+    void SetEnabled(bool enabled) { m_enabled = enabled; }
+
+    // Frames are the unit of the history. Markers before the first frame go to frame 0
+    void BeginFrame();
+    void EndFrame();
+
+    // Returns the marker index to pass to the end function, or -1 if disabled. Markers must end in the frame they began
+    int BeginCpuMarker(const char* name, const char* detail = nullptr);
+    void EndCpuMarker(int marker);
+
+    // GPU markers can only be added inside a frame, from the thread with the OpenGL context
+    int BeginGpuMarker(const char* name);
+    void EndGpuMarker(int marker);
+
+    // Last frames, oldest first. The GPU events of the most recent frames are not resolved yet
+    const std::deque<Frame>& GetFrames() const { return m_frames; }
+
+    // Rolling view with the frame time and the average time of each marker
+    // Defined in ProfilerGUI.cpp, only applications that call it need to link ImGui
+    void DrawGUI(DearImGui& imGui);
+
+    // Write the frames in the history in the Chrome trace event format (chrome://tracing, Perfetto)
+    bool SaveChromeTrace(const char* path) const;
+
+private:
+    struct GpuMarker
+    {
+        const char* name;
+        unsigned int depth;
+        // Begin and end timestamp queries
+        GLuint queries[2];
+    };
+
+    // GPU markers of one of the frames in flight
+    struct GpuFrame
+    {
+        unsigned int frameIndex;
+        std::vector<GpuMarker> markers;
+        // Queries created for this frame, reused by later frames
+        std::vector<GLuint> queryPool;
+        unsigned int usedQueries;
+        // CPU and GPU time when the frame started, to convert the timestamps
+        double cpuStart;
+        GLint64 gpuStart;
+        bool pending;
+    };
+
+    double GetTime() const;
+    unsigned int GetThreadIndex();
+
+    Frame& GetCurrentFrame() { return m_frames.back(); }
+    GLuint AcquireQuery(GpuFrame& gpuFrame);
+
+    // Read the results of the frame, if available. Returns false if they are not ready yet
+    bool ResolveGpuFrame(GpuFrame& gpuFrame);
+
+private:
+    static Profiler* s_current;
+
+    // Frames kept in the history
+    static const unsigned int s_historySize = 240;
+    // Frames that can be in flight in the GPU before reusing their queries
+    static const unsigned int s_gpuLatency = 3;
+
+    bool m_enabled;
+    std::chrono::steady_clock::time_point m_startTime;
+
+    std::deque<Frame> m_frames;
+    bool m_inFrame;
+    int m_frameMarker;
+
+    GpuFrame m_gpuFrames[s_gpuLatency];
+    unsigned int m_gpuDepth;
+    // Frames whose GPU results were still not available when their queries had to be reused
+    unsigned int m_droppedGpuFrames;
+
+    std::vector<std::thread::id> m_threadIds;
+    mutable std::mutex m_mutex;
+};
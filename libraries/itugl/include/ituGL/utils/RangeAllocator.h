@@ -0,0 +1,125 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+// Hands out ranges of a space of fixed size, like the vertices of a big buffer, without touching any memory
+// Free ranges are kept in segregated lists (TLSF): one per power of two, split in 8 linear steps, with bitmasks to find
+// a list with a big enough range in constant time. Freed ranges are merged with their free neighbours
+// Offsets and sizes are in any unit chosen by the user, like vertices or elements
+class RangeAllocator
+{
+public:
+    // Identifies an allocation. It stays the same when Defragment moves the allocation
+    using AllocationId = unsigned int;
+    static constexpr AllocationId InvalidId = ~0u;
+
+    struct Allocation
+    {
+        // InvalidId if there was not enough space
+        AllocationId id;
+        unsigned int offset;
+        unsigned int size;
+    };
+
+    // Allocation moved by Defragment. Moves are in increasing offset, and they always move the range down
+    // Applied in order, a move only overwrites ranges that are free or already moved, but its source and destination can overlap
+    struct Move
+    {
+        AllocationId id;
+        unsigned int oldOffset;
+        unsigned int newOffset;
+        unsigned int size;
+    };
+
+    struct Stats
+    {
+        unsigned int size;
+        unsigned int usedSize;
+        unsigned int allocationCount;
+        unsigned int freeSize;
+        unsigned int freeRangeCount;
+        unsigned int largestFreeRange;
+
+        // 0 when all the free space is in one range, close to 1 when it is split in many small ones
+        float GetFragmentation() const { return freeSize > 0 ? 1.0f - static_cast<float>(largestFreeRange) / freeSize : 0.0f; }
+    };
+
+public:
+    RangeAllocator(unsigned int size = 0);
+
+    // Free all the allocations, and change the size
+    void Reset(unsigned int size);
+
+    inline unsigned int GetSize() const { return m_size; }
+
+    // Find a free range of the size, that must be greater than 0
+    Allocation Allocate(unsigned int size);
+    void Free(AllocationId id);
+
+    // Current offset and size of an allocation
+    Allocation GetAllocation(AllocationId id) const;
+
+    // Move all the allocations to the start, in their current order, leaving the free space in a single range at the end
+    // The ids don't change. Returns the allocations that moved, so the user can move their data
+    std::vector<Move> Defragment();
+
+    // Computed when called. The largest free range walks one of the lists
+    Stats GetStats() const;
+
+    // Check the neighbours, the lists and the counters. Slow, for tests
+    bool IsValid() const;
+
+private:
+    static constexpr unsigned int SecondLevelBits = 3;
+    static constexpr unsigned int SecondLevelCount = 1u << SecondLevelBits;
+    // Sizes below SecondLevelCount go to the first level 0, one list each. The largest size has its top bit in 31
+    static constexpr unsigned int FirstLevelCount = 32 - SecondLevelBits + 1;
+    static constexpr unsigned int ListCount = FirstLevelCount * SecondLevelCount;
+
+    static constexpr unsigned int InvalidNode = ~0u;
+
+    // Used or free range. Node indices are the allocation ids
+    struct Node
+    {
+        unsigned int offset;
+        unsigned int size;
+        // Neighbour ranges, by offset
+        unsigned int previous;
+        unsigned int next;
+        // Free ranges in the same list
+        unsigned int previousFree;
+        unsigned int nextFree;
+        bool used;
+    };
+
+    // List for the size. Ranges in a list have sizes between its size and the size of the next list
+    static unsigned int GetListIndex(unsigned int size);
+
+    unsigned int CreateNode(unsigned int offset, unsigned int size, unsigned int previous, unsigned int next);
+    void ReleaseNode(unsigned int nodeIndex);
+
+    void AddFreeNode(unsigned int nodeIndex);
+    void RemoveFreeNode(unsigned int nodeIndex);
+
+    // Free node with at least the size, or InvalidNode
+    unsigned int FindFreeNode(unsigned int size) const;
+
+private:
+    unsigned int m_size;
+
+    std::vector<Node> m_nodes;
+    // Indices of the nodes that are not in use, to be reused
+    std::vector<unsigned int> m_unusedNodes;
+    // Node at offset 0
+    unsigned int m_firstNode;
+
+    // First node of each list, and bitmasks of the lists that are not empty
+    unsigned int m_freeLists[ListCount];
+    std::uint32_t m_firstLevelMask;
+    std::uint32_t m_secondLevelMasks[FirstLevelCount];
+
+    unsigned int m_usedSize;
+    unsigned int m_allocationCount;
+    unsigned int m_freeRangeCount;
+};
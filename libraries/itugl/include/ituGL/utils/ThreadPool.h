@@ -0,0 +1,58 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Fixed set of worker threads that run the iterations of a loop in parallel
+// The calling thread also runs iterations, and waits until all of them are finished
+class ThreadPool
+{
+public:
+    using Function = std::function<void(unsigned int index)>;
+
+public:
+    // If threadCount is 0, use one worker less than the hardware threads (the calling thread is the other one)
+    ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator = (const ThreadPool&) = delete;
+
+    // Number of worker threads, without counting the calling thread
+    unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_threads.size()); }
+
+    // Call the function for each index in [0, count) and wait until all calls return
+    // Calls happen in any order, from any thread. The function must not call ParallelFor again
+    void ParallelFor(unsigned int count, const Function& function);
+
+private:
+    void WorkerLoop();
+
+    // Run iterations of the current loop until there are none left
+    void RunIterations();
+
+private:
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    // Notifies the workers of a new loop, or that they need to stop
+    std::condition_variable m_startCondition;
+    // Notifies the calling thread that all workers finished the loop
+    std::condition_variable m_finishCondition;
+
+    // Current loop, only valid while ParallelFor is running
+    const Function* m_function;
+    unsigned int m_count;
+    std::atomic<unsigned int> m_nextIndex;
+
+    // Incremented for each loop, so workers know when there is a new one
+    unsigned int m_generation;
+    // Workers that didn't finish the current loop yet
+    unsigned int m_pendingWorkers;
+
+    bool m_stopping;
+};
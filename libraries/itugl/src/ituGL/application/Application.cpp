@@ -1,15 +1,26 @@
 #include <ituGL/application/Application.h>
 
+#include <ituGL/texture/FramebufferObject.h>
+#include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/utils/ImageWriter.h>
+
 // For breaking execution in debug when an unexpected condition is found
 #include <cassert>
 // For accurate application time
 #include <chrono>
 // For error messages
 #include <iostream>
+// For headless settings and captures
+#include <cstdlib>
+#include <vector>
+
+bool Application::s_headlessSettingsLoaded = false;
+unsigned int Application::s_headlessFrameCount = 0;
+std::string Application::s_headlessCapturePath;
 
 // DeviceGL and main Window are constructed in the correct order because they were declared like that!
 Application::Application(int width, int height, const char* title)
-    : m_mainWindow(width, height, title), m_currentTime(0), m_deltaTime(0), m_exitCode(0)
+    : m_mainWindow(width, height, title, !IsHeadless()), m_currentTime(0), m_deltaTime(0), m_exitCode(0)
 {
     // If the main window is not valid, exit with error
     if (!m_mainWindow.IsValid())
@@ -26,10 +37,21 @@ Application::Application(int width, int height, const char* title)
         Terminate(-2, "Failed to initialize OpenGL with GLAD");
         return;
     }
+
+    if (IsHeadless())
+    {
+        InitializeOffscreenFramebuffer();
+    }
 }
 
 Application::~Application()
 {
+    // Release the offscreen framebuffer while the context is still alive
+    if (m_offscreenFramebuffer)
+    {
+        FramebufferObject::SetDefaultRedirect(nullptr);
+    }
+
     // If something didn't go as expected, display an error message
     if (m_exitCode)
     {
@@ -47,20 +69,56 @@ int Application::Run()
         // current time when the application started
         auto startTime = std::chrono::steady_clock::now();
 
+        unsigned int frameIndex = 0;
+
         // Main loop
         while (IsRunning())
         {
-            // set current time relative to start time
-            std::chrono::duration<float> duration = std::chrono::steady_clock::now() - startTime;
-            UpdateTime(duration.count());
-
-            Update();
-
-            Render();
+            if (IsHeadless())
+            {
+                // Fixed time step, so every run renders the same frames
+                UpdateTime((frameIndex + 1) / 60.0f);
+            }
+            else
+            {
+                // set current time relative to start time
+                std::chrono::duration<float> duration = std::chrono::steady_clock::now() - startTime;
+                UpdateTime(duration.count());
+            }
+
+            m_profiler.BeginFrame();
+
+            {
+                Profiler::Scope scope("Update");
+                Update();
+            }
+
+            {
+                Profiler::Scope scope("Render", true);
+                Render();
+            }
 
             // Swap buffers and poll events at the end of the frame
-            m_mainWindow.SwapBuffers();
-            m_device.PollEvents();
+            {
+                Profiler::Scope scope("SwapBuffers");
+                if (!IsHeadless())
+                {
+                    m_mainWindow.SwapBuffers();
+                }
+                m_device.PollEvents();
+            }
+
+            m_profiler.EndFrame();
+
+            // In headless mode, save the last frame and exit
+            if (IsHeadless() && ++frameIndex == s_headlessFrameCount)
+            {
+                if (!s_headlessCapturePath.empty() && !SaveOffscreenFramebuffer(s_headlessCapturePath.c_str()))
+                {
+                    std::cout << "Failed to save capture: " << s_headlessCapturePath << std::endl;
+                }
+                m_mainWindow.Close();
+            }
         }
 
         Cleanup();
@@ -121,3 +179,65 @@ bool Application::IsRunning() const
     // Run while the window is valid and it has not been requested to close
     return m_mainWindow.IsValid() && !m_mainWindow.ShouldClose();
 }
+
+void Application::SetHeadless(unsigned int frameCount, const char* capturePath)
+{
+    s_headlessSettingsLoaded = true;
+    s_headlessFrameCount = frameCount;
+    s_headlessCapturePath = capturePath ? capturePath : "";
+}
+
+bool Application::IsHeadless()
+{
+    LoadHeadlessSettings();
+    return s_headlessFrameCount > 0;
+}
+
+void Application::LoadHeadlessSettings()
+{
+    if (!s_headlessSettingsLoaded)
+    {
+        const char* frameCount = std::getenv("ITUGL_HEADLESS_FRAMES");
+        const char* capturePath = std::getenv("ITUGL_HEADLESS_CAPTURE");
+        SetHeadless(frameCount ? std::strtoul(frameCount, nullptr, 10) : 0, capturePath);
+    }
+}
+
+void Application::InitializeOffscreenFramebuffer()
+{
+    int width, height;
+    m_mainWindow.GetDimensions(width, height);
+
+    m_offscreenColorTexture = std::make_shared<Texture2DObject>();
+    m_offscreenColorTexture->Bind();
+    m_offscreenColorTexture->SetImage(0, width, height, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA8);
+
+    m_offscreenDepthTexture = std::make_shared<Texture2DObject>();
+    m_offscreenDepthTexture->Bind();
+    m_offscreenDepthTexture->SetImage(0, width, height, TextureObject::FormatDepth, TextureObject::InternalFormatDepth24);
+    Texture2DObject::Unbind();
+
+    m_offscreenFramebuffer = std::make_shared<FramebufferObject>();
+    m_offscreenFramebuffer->Bind();
+    m_offscreenFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color0, *m_offscreenColorTexture);
+    m_offscreenFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Depth, *m_offscreenDepthTexture);
+    assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+    // From now on, binding the default framebuffer binds this one
+    FramebufferObject::SetDefaultRedirect(m_offscreenFramebuffer);
+    m_device.SetViewport(0, 0, width, height);
+}
+
+bool Application::SaveOffscreenFramebuffer(const char* path) const
+{
+    int width, height;
+    m_mainWindow.GetDimensions(width, height);
+
+    std::vector<unsigned char> pixels(width * height * 3);
+    m_offscreenFramebuffer->Bind(FramebufferObject::Target::Read);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    // OpenGL rows go from bottom to top
+    return ImageWriter::Save(path, width, height, 3, std::as_bytes(std::span<const unsigned char>(pixels)));
+}
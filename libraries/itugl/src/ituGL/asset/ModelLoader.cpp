@@ -3,15 +3,30 @@
 #include <ituGL/geometry/VertexFormat.h>
 #include <ituGL/shader/Material.h>
 #include <ituGL/asset/Texture2DLoader.h>
+#include <ituGL/geometry/MeshSimplifier.h>
+#include <ituGL/geometry/MeshPool.h>
+#include <ituGL/utils/Profiler.h>
+#include <ituGL/utils/ThreadPool.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <glm/common.hpp>
+#include <algorithm>
 #include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <limits>
 #include <bit>
 
+// Identifies the LOD cache files, and their version. Change it when the simplification changes
+static const char s_lodCacheTag[8] = { 'I', 'T', 'U', 'L', 'O', 'D', '0', '1' };
+
 ModelLoader::ModelLoader(std::shared_ptr<Material> referenceMaterial)
     : m_referenceMaterial(referenceMaterial)
     , m_createMaterials(false)
+    , m_lodCount(0), m_lodTriangleRatio(0.5f), m_lodScreenSize(0.5f)
+    , m_threadPool(nullptr)
 {
     m_textureLoader.SetGenerateMipmap(true);
 }
@@ -49,6 +64,15 @@ const Texture2DLoader& ModelLoader::GetTexture2DLoader() const
     return m_textureLoader;
 }
 
+void ModelLoader::SetLodGeneration(unsigned int lodCount, float triangleRatio, float screenSize)
+{
+    assert(triangleRatio > 0.0f && triangleRatio < 1.0f);
+    assert(screenSize > 0.0f);
+    m_lodCount = lodCount;
+    m_lodTriangleRatio = triangleRatio;
+    m_lodScreenSize = screenSize;
+}
+
 bool ModelLoader::SetMaterialAttribute(VertexAttribute::Semantic semantic, const char* attributeName)
 {
     bool found = false;
@@ -75,6 +99,8 @@ bool ModelLoader::SetMaterialProperty(MaterialProperty materialProperty, const c
 
 Model ModelLoader::Load(const char* path)
 {
+    Profiler::Scope scope("Load model", false, path);
+
     Model model;
 
     // Read the file using Assimp importer
@@ -90,11 +116,21 @@ Model ModelLoader::Load(const char* path)
     {
         model.SetMesh(std::make_shared<Mesh>());
         Mesh& mesh = model.GetMesh();
+        glm::vec3 boundsMin(std::numeric_limits<float>::max());
+        glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
         for (unsigned int meshIndex = 0; meshIndex < scene->mNumMeshes; ++meshIndex)
         {
             aiMesh& meshData = *scene->mMeshes[meshIndex];
             GenerateSubmesh(mesh, meshData);
 
+            // Grow the model bounds with the submesh vertices
+            for (unsigned int vertexIndex = 0; vertexIndex < meshData.mNumVertices; ++vertexIndex)
+            {
+                const aiVector3D& position = meshData.mVertices[vertexIndex];
+                boundsMin = glm::min(boundsMin, glm::vec3(position.x, position.y, position.z));
+                boundsMax = glm::max(boundsMax, glm::vec3(position.x, position.y, position.z));
+            }
+
             std::shared_ptr<Material> material = m_referenceMaterial;
             if (m_createMaterials)
             {
@@ -103,34 +139,301 @@ Model ModelLoader::Load(const char* path)
             }
             model.AddMaterial(material);
         }
+
+        if (scene->mNumMeshes > 0)
+        {
+            model.SetLocalBounds(AabbBounds((boundsMin + boundsMax) * 0.5f, (boundsMax - boundsMin) * 0.5f));
+        }
+
+        if (m_lodCount > 0 && scene->mNumMeshes > 0)
+        {
+            GenerateLods(model, *scene, path);
+        }
     }
 
     return model;
 }
 
+void ModelLoader::GenerateLods(Model& model, const aiScene& scene, const char* path)
+{
+    Profiler::Scope scope("Generate LODs", false, path);
+
+    std::vector<std::vector<std::vector<unsigned int>>> lodIndices(scene.mNumMeshes);
+    bool lodCacheEnabled = !m_lodCacheDirectory.empty();
+    std::string cachePath = lodCacheEnabled ? GetLodCachePath(path) : std::string();
+    if (!lodCacheEnabled || !ReadLodCache(cachePath, path, scene, lodIndices))
+    {
+        // Only the simplification runs in the workers, the GL objects are created below in this thread
+        auto simplifyMesh = [&](unsigned int meshIndex) { SimplifyMesh(*scene.mMeshes[meshIndex], lodIndices[meshIndex]); };
+        if (m_threadPool)
+        {
+            m_threadPool->ParallelFor(scene.mNumMeshes, simplifyMesh);
+        }
+        else
+        {
+            for (unsigned int meshIndex = 0; meshIndex < scene.mNumMeshes; ++meshIndex)
+            {
+                simplifyMesh(meshIndex);
+            }
+        }
+
+        if (lodCacheEnabled)
+        {
+            WriteLodCache(cachePath, scene, lodIndices);
+        }
+    }
+
+    float screenSize = m_lodScreenSize;
+    for (unsigned int lod = 1; lod <= m_lodCount; ++lod, screenSize *= 0.5f)
+    {
+        std::shared_ptr<Mesh> lodMesh = std::make_shared<Mesh>();
+        for (unsigned int meshIndex = 0; meshIndex < scene.mNumMeshes; ++meshIndex)
+        {
+            const aiMesh& meshData = *scene.mMeshes[meshIndex];
+            if (lodIndices[meshIndex].empty())
+            {
+                GenerateSubmesh(*lodMesh, meshData);
+            }
+            else
+            {
+                GenerateLodSubmesh(*lodMesh, meshData, lodIndices[meshIndex][lod - 1]);
+            }
+        }
+        model.AddLod(lodMesh, screenSize);
+    }
+}
+
+void ModelLoader::SimplifyMesh(const aiMesh& meshData, std::vector<std::vector<unsigned int>>& lodIndices) const
+{
+    if (meshData.mPrimitiveTypes != aiPrimitiveType_TRIANGLE)
+    {
+        return;
+    }
+
+    std::vector<glm::vec3> positions(meshData.mNumVertices);
+    for (unsigned int vertexIndex = 0; vertexIndex < meshData.mNumVertices; ++vertexIndex)
+    {
+        const aiVector3D& position = meshData.mVertices[vertexIndex];
+        positions[vertexIndex] = glm::vec3(position.x, position.y, position.z);
+    }
+
+    std::vector<unsigned int> indices;
+    indices.reserve(meshData.mNumFaces * 3);
+    for (unsigned int faceIndex = 0; faceIndex < meshData.mNumFaces; ++faceIndex)
+    {
+        const aiFace& face = meshData.mFaces[faceIndex];
+        assert(face.mNumIndices == 3);
+        indices.insert(indices.end(), face.mIndices, face.mIndices + 3);
+    }
+
+    // Each level is simplified from the previous one, which is faster than starting from the full mesh every time
+    MeshSimplifier simplifier;
+    lodIndices.resize(m_lodCount);
+    std::span<const unsigned int> sourceIndices = indices;
+    float triangleRatio = 1.0f;
+    for (std::vector<unsigned int>& levelIndices : lodIndices)
+    {
+        triangleRatio *= m_lodTriangleRatio;
+        unsigned int targetIndexCount = std::max(static_cast<unsigned int>(meshData.mNumFaces * triangleRatio), 1u) * 3;
+        levelIndices = simplifier.Simplify(positions, sourceIndices, targetIndexCount);
+
+        // Collapsing two-sided pieces can remove all the triangles, keep the previous level then
+        if (levelIndices.empty())
+        {
+            levelIndices.assign(sourceIndices.begin(), sourceIndices.end());
+        }
+        sourceIndices = levelIndices;
+    }
+}
+
+void ModelLoader::GenerateLodSubmesh(Mesh& mesh, const aiMesh& meshData, std::span<const unsigned int> indices) const
+{
+    VertexFormat vertexFormat;
+    bool interleaved = true;
+    std::vector<GLubyte> vertexData = CollectVertexData(meshData, vertexFormat, interleaved);
+
+    // Keep only the vertices used by the level, in the order of first use, so the vertex data shrinks with the triangles
+    unsigned int vertexSize = vertexFormat.GetSize();
+    std::vector<unsigned int> vertexRemap(meshData.mNumVertices, std::numeric_limits<unsigned int>::max());
+    std::vector<unsigned int> lodIndices(indices.size());
+    std::vector<GLubyte> lodVertexData;
+    unsigned int lodVertexCount = 0;
+    for (std::size_t i = 0; i < indices.size(); ++i)
+    {
+        unsigned int& remappedIndex = vertexRemap[indices[i]];
+        if (remappedIndex == std::numeric_limits<unsigned int>::max())
+        {
+            remappedIndex = lodVertexCount++;
+            auto itVertex = vertexData.begin() + static_cast<std::size_t>(indices[i]) * vertexSize;
+            lodVertexData.insert(lodVertexData.end(), itVertex, itVertex + vertexSize);
+        }
+        lodIndices[i] = remappedIndex;
+    }
+
+    if (m_meshPool)
+    {
+        MeshPool::Range range = m_meshPool->AddData(vertexFormat, Data::GetBytes(std::span<const GLubyte>(lodVertexData)), lodIndices, m_materialAttributeMap);
+        m_meshPool->AddSubmesh(mesh, range, Drawcall::Primitive::Triangles, 0, range.elementCount);
+        return;
+    }
+
+    int vboIndex = mesh.AddVertexData<GLubyte>(lodVertexData);
+
+    Data::Type elementType = ElementBufferObject::GetSmallestType(lodVertexCount);
+    std::vector<GLubyte> elementData = PackElementData(lodIndices, elementType);
+    int eboIndex = mesh.AddElementData<GLubyte>(elementData);
+
+    mesh.AddSubmesh(Drawcall::Primitive::Triangles, 0, static_cast<int>(lodIndices.size()), elementType, vboIndex, eboIndex,
+        vertexFormat.LayoutBegin(static_cast<int>(lodVertexCount), interleaved), vertexFormat.LayoutEnd(), m_materialAttributeMap);
+}
+
+std::string ModelLoader::GetLodCachePath(const char* path) const
+{
+    std::string fileName = std::filesystem::path(path).lexically_normal().generic_string() + ".lod";
+    std::replace_if(fileName.begin(), fileName.end(), [](char c) { return c == '/' || c == '\\' || c == ':'; }, '_');
+    return (std::filesystem::path(m_lodCacheDirectory) / fileName).string();
+}
+
+bool ModelLoader::ReadLodCache(const std::string& cachePath, const char* path, const aiScene& scene,
+    std::vector<std::vector<std::vector<unsigned int>>>& lodIndices) const
+{
+    std::error_code error;
+    if (!std::filesystem::exists(cachePath, error)
+        || std::filesystem::last_write_time(cachePath, error) < std::filesystem::last_write_time(path, error) || error)
+    {
+        return false;
+    }
+
+    std::ifstream file(cachePath, std::ios::binary);
+    auto read = [&](auto& value) { return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(value))); };
+
+    // Header: tag, settings and the size of each mesh, to detect files of other versions or of a modified model
+    char tag[sizeof(s_lodCacheTag)];
+    unsigned int lodCount = 0, meshCount = 0;
+    float triangleRatio = 0.0f;
+    if (!read(tag) || std::memcmp(tag, s_lodCacheTag, sizeof(tag)) != 0 || !read(lodCount) || !read(triangleRatio) || !read(meshCount)
+        || lodCount != m_lodCount || triangleRatio != m_lodTriangleRatio || meshCount != scene.mNumMeshes)
+    {
+        return false;
+    }
+    for (unsigned int meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+    {
+        unsigned int vertexCount = 0, faceCount = 0;
+        if (!read(vertexCount) || !read(faceCount)
+            || vertexCount != scene.mMeshes[meshIndex]->mNumVertices || faceCount != scene.mMeshes[meshIndex]->mNumFaces)
+        {
+            return false;
+        }
+    }
+
+    for (unsigned int meshIndex = 0; meshIndex < lodIndices.size(); ++meshIndex)
+    {
+        std::vector<std::vector<unsigned int>>& meshLodIndices = lodIndices[meshIndex];
+        const aiMesh& mesh = *scene.mMeshes[meshIndex];
+        unsigned int levelCount = 0;
+        if (!read(levelCount) || (levelCount != 0 && levelCount != m_lodCount))
+        {
+            return false;
+        }
+        meshLodIndices.resize(levelCount);
+        for (std::vector<unsigned int>& levelIndices : meshLodIndices)
+        {
+            // A level can't have more triangles than the mesh, and its indices must be in the vertices of the mesh
+            unsigned int indexCount = 0;
+            if (!read(indexCount) || indexCount > mesh.mNumFaces * 3ull)
+            {
+                return false;
+            }
+            levelIndices.resize(indexCount);
+            if (!file.read(reinterpret_cast<char*>(levelIndices.data()), indexCount * sizeof(unsigned int))
+                || std::any_of(levelIndices.begin(), levelIndices.end(), [&](unsigned int index) { return index >= mesh.mNumVertices; }))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void ModelLoader::WriteLodCache(const std::string& cachePath, const aiScene& scene,
+    const std::vector<std::vector<std::vector<unsigned int>>>& lodIndices) const
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_lodCacheDirectory, error);
+
+    std::ofstream file(cachePath, std::ios::binary);
+    auto write = [&](const auto& value) { file.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+
+    write(s_lodCacheTag);
+    write(m_lodCount);
+    write(m_lodTriangleRatio);
+    write(scene.mNumMeshes);
+    for (unsigned int meshIndex = 0; meshIndex < scene.mNumMeshes; ++meshIndex)
+    {
+        write(scene.mMeshes[meshIndex]->mNumVertices);
+        write(scene.mMeshes[meshIndex]->mNumFaces);
+    }
+
+    for (const std::vector<std::vector<unsigned int>>& meshLodIndices : lodIndices)
+    {
+        write(static_cast<unsigned int>(meshLodIndices.size()));
+        for (const std::vector<unsigned int>& levelIndices : meshLodIndices)
+        {
+            write(static_cast<unsigned int>(levelIndices.size()));
+            file.write(reinterpret_cast<const char*>(levelIndices.data()), levelIndices.size() * sizeof(unsigned int));
+        }
+    }
+
+    // A partial file would be rejected by the size checks when reading, but don't leave it around
+    if (!file)
+    {
+        file.close();
+        std::filesystem::remove(cachePath, error);
+    }
+}
+
 void ModelLoader::GenerateSubmesh(Mesh& mesh, const aiMesh& meshData)
 {
     // Collect vertex data
     VertexFormat vertexFormat;
     bool interleaved = true;
     std::vector<GLubyte> vertexData = CollectVertexData(meshData, vertexFormat, interleaved);
-    int vboIndex = mesh.AddVertexData<GLubyte>(vertexData);
 
-    // Collect element data
-    Data::Type elementType;
+    // Collect element data. The pool only has unsigned int elements
+    Data::Type elementType = m_meshPool ? Data::Type::UInt : ElementBufferObject::GetSmallestType(meshData.mNumVertices);
     std::vector<Drawcall::Primitive> primitives;
     std::vector<int> elementCounts;
     std::vector<GLubyte> elementData = CollectElementData(meshData, elementType, primitives, elementCounts);
+    assert(primitives.size() == elementCounts.size());
+
+    if (m_meshPool)
+    {
+        std::vector<unsigned int> elements(elementData.size() / sizeof(unsigned int));
+        std::memcpy(elements.data(), elementData.data(), elementData.size());
+        MeshPool::Range range = m_meshPool->AddData(vertexFormat, Data::GetBytes(std::span<const GLubyte>(vertexData)), elements, m_materialAttributeMap);
+
+        // Same submeshes as below, the element counts are offsets in bytes
+        unsigned int start = 0;
+        for (std::size_t i = 0; i < primitives.size(); ++i)
+        {
+            unsigned int end = elementCounts[i] / sizeof(unsigned int);
+            m_meshPool->AddSubmesh(mesh, range, primitives[i], start, end - start);
+            start = end;
+        }
+        return;
+    }
+
+    int vboIndex = mesh.AddVertexData<GLubyte>(vertexData);
     int eboIndex = mesh.AddElementData<GLubyte>(elementData);
 
-    // Add submeshes
+    // Add submeshes. The element counts are offsets in bytes, the drawcalls take the first one in bytes and the count in elements
     int start = 0;
-    assert(primitives.size() == elementCounts.size());
+    int elementSize = Data::GetTypeSize(elementType);
     for (int i = 0; i < primitives.size(); ++i)
     {
         Drawcall::Primitive primitive = primitives[i];
         int end = elementCounts[i];
-        mesh.AddSubmesh(primitive, start, end - start, elementType, eboIndex, vboIndex, vertexFormat.LayoutBegin(static_cast<int>(vertexData.size()), interleaved), vertexFormat.LayoutEnd(), m_materialAttributeMap);
+        mesh.AddSubmesh(primitive, start, (end - start) / elementSize, elementType, eboIndex, vboIndex, vertexFormat.LayoutBegin(static_cast<int>(vertexData.size()), interleaved), vertexFormat.LayoutEnd(), m_materialAttributeMap);
         start = end;
     }
 }
@@ -253,12 +556,27 @@ std::vector<GLubyte> ModelLoader::CollectVertexData(const aiMesh& meshData, Vert
     return vertexData;
 }
 
-std::vector<GLubyte> ModelLoader::CollectElementData(const aiMesh& meshData, Data::Type& elementType,
+std::vector<GLubyte> ModelLoader::PackElementData(std::span<const unsigned int> indices, Data::Type elementType)
+{
+    int elementSize = Data::GetTypeSize(elementType);
+    std::vector<GLubyte> elementData(indices.size() * elementSize);
+
+    // Same as CollectElementData, take the low bytes of each index
+    const void* srcBuffer = indices.data();
+    if (std::endian::native == std::endian::big)
+    {
+        srcBuffer = reinterpret_cast<const GLubyte*>(srcBuffer) + sizeof(unsigned int) - elementSize;
+    }
+    CopyBuffer(elementData.data(), elementSize, srcBuffer, sizeof(unsigned int), indices.size(), elementSize);
+
+    return elementData;
+}
+
+std::vector<GLubyte> ModelLoader::CollectElementData(const aiMesh& meshData, Data::Type elementType,
     std::vector<Drawcall::Primitive>& primitives, std::vector<int>& elementCounts)
 {
     std::vector<GLubyte> elementData;
 
-    elementType = ElementBufferObject::GetSmallestType(meshData.mNumVertices);
     int elementSize = Data::GetTypeSize(elementType);
 
     //Reserve max possible size
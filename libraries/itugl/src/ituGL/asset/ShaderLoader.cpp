@@ -1,5 +1,7 @@
 #include <ituGL/asset/ShaderLoader.h>
 
+#include <ituGL/utils/Profiler.h>
+
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -24,6 +26,8 @@ bool ShaderLoader::IsValid(std::span<const char*> paths)
 
 Shader ShaderLoader::Load(const char* path)
 {
+    Profiler::Scope scope("Load shader", false, path);
+
     Shader shader(m_type);
     std::ifstream file(path);
     assert(file.is_open());
@@ -36,6 +40,9 @@ Shader ShaderLoader::Load(const char* path)
 
 Shader ShaderLoader::Load(std::span<const char*> paths)
 {
+    // The main file is usually the last one, after the common includes
+    Profiler::Scope scope("Load shader", false, paths.empty() ? nullptr : paths.back());
+
     Shader shader(m_type);
     std::vector<std::stringstream> stringStreams(paths.size());
     std::vector<std::string> sourceCodeStrings(paths.size());
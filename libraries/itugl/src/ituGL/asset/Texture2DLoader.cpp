@@ -1,5 +1,6 @@
 #include <ituGL/asset/Texture2DLoader.h>
 
+#include <ituGL/utils/Profiler.h>
 #include <cassert>
 
 Texture2DLoader::Texture2DLoader()
@@ -15,6 +16,8 @@ Texture2DLoader::Texture2DLoader(TextureObject::Format format, TextureObject::In
 
 Texture2DObject Texture2DLoader::Load(const char* path)
 {
+    Profiler::Scope scope("Load texture", false, path);
+
     Texture2DObject texture2D;
 
     // Load texture data using stbimage library
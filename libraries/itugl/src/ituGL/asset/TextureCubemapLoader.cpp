@@ -1,5 +1,6 @@
 #include <ituGL/asset/TextureCubemapLoader.h>
 
+#include <ituGL/utils/Profiler.h>
 #include <cassert>
 #include <stb_image.h>
 
@@ -14,6 +15,8 @@ TextureCubemapLoader::TextureCubemapLoader(TextureObject::Format format, Texture
 
 TextureCubemapObject TextureCubemapLoader::Load(const char* path)
 {
+    Profiler::Scope scope("Load cubemap", false, path);
+
     TextureCubemapObject textureCubemap;
 
     int width, height;
@@ -63,3 +63,44 @@ void BufferObject::UpdateData(std::span<const std::byte> data, size_t offset)
     Target target = GetTarget();
     glBufferSubData(target, offset, data.size_bytes(), data.data());
 }
+
+// Bind both buffers to the copy targets, so the buffer doesn't need to be bound
+void BufferObject::CopyData(const BufferObject& source, size_t sourceOffset, size_t offset, size_t size)
+{
+    source.Bind(CopyReadBuffer);
+    Bind(CopyWriteBuffer);
+    glCopyBufferSubData(CopyReadBuffer, CopyWriteBuffer, sourceOffset, offset, size);
+    Unbind(CopyReadBuffer);
+    Unbind(CopyWriteBuffer);
+}
+
+// Get buffer Target and allocate immutable buffer storage
+void BufferObject::AllocateStorage(size_t size, GLbitfield flags)
+{
+    assert(IsBound());
+    assert(IsStorageSupported());
+    Target target = GetTarget();
+    glBufferStorage(target, size, nullptr, flags);
+}
+
+bool BufferObject::IsStorageSupported()
+{
+    return GLAD_GL_VERSION_4_4 != 0;
+}
+
+// Get buffer Target and map the range
+std::span<std::byte> BufferObject::MapRange(size_t offset, size_t size, GLbitfield access)
+{
+    assert(IsBound());
+    Target target = GetTarget();
+    std::byte* data = static_cast<std::byte*>(glMapBufferRange(target, offset, size, access));
+    return data ? std::span<std::byte>(data, size) : std::span<std::byte>();
+}
+
+// Get buffer Target and unmap it
+bool BufferObject::Unmap()
+{
+    assert(IsBound());
+    Target target = GetTarget();
+    return glUnmapBuffer(target) == GL_TRUE;
+}
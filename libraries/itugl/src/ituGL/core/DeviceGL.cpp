@@ -41,7 +41,18 @@ void DeviceGL::SetCurrentWindow(Window& window)
 // Set the dimensions of the viewport
 void DeviceGL::SetViewport(GLint x, GLint y, GLsizei width, GLsizei height)
 {
-    glViewport(0, 0, width, height);
+    glViewport(x, y, width, height);
+}
+
+// Get the dimensions of the viewport
+void DeviceGL::GetViewport(GLint& x, GLint& y, GLsizei& width, GLsizei& height) const
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    x = viewport[0];
+    y = viewport[1];
+    width = viewport[2];
+    height = viewport[3];
 }
 
 // Poll the events in the window event queue
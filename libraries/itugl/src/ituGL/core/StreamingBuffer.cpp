@@ -0,0 +1,156 @@
+#include <ituGL/core/StreamingBuffer.h>
+
+#include <cassert>
+
+StreamingBuffer::StreamingBuffer(std::shared_ptr<BufferObject> buffer, size_t regionSize, unsigned int regionCount)
+    : m_buffer(buffer)
+    , m_regionSize(regionSize)
+    , m_regionCount(regionCount)
+    , m_persistent(BufferObject::IsStorageSupported())
+    , m_minAlignment(1)
+    , m_currentRegion(0)
+    , m_usedSize(0)
+    , m_fences(regionCount, nullptr)
+    , m_mappedOffset(0)
+    , m_orphaned(false)
+{
+    assert(m_buffer);
+    assert(regionSize > 0 && regionCount > 0);
+
+    if (m_buffer->GetTarget() == BufferObject::UniformBuffer)
+    {
+        GLint alignment = 1;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        m_minAlignment = alignment;
+    }
+
+    m_buffer->Bind();
+    if (m_persistent)
+    {
+        // Map all the regions once. Coherent mapping makes the writes visible without flushing
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        m_buffer->AllocateStorage(m_regionSize * m_regionCount, flags);
+        m_mappedData = m_buffer->MapRange(0, m_regionSize * m_regionCount, flags);
+        assert(!m_mappedData.empty());
+    }
+    else
+    {
+        m_buffer->AllocateData(m_regionSize, BufferObject::StreamDraw);
+    }
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+    for (GLsync fence : m_fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+        }
+    }
+
+    if (!m_mappedData.empty())
+    {
+        m_buffer->Bind();
+        m_buffer->Unmap();
+    }
+}
+
+void StreamingBuffer::BeginFrame()
+{
+    assert(m_usedSize == 0);
+
+    if (m_persistent)
+    {
+        m_currentRegion = (m_currentRegion + 1) % m_regionCount;
+        WaitRegion(m_currentRegion);
+    }
+    else
+    {
+        m_orphaned = false;
+    }
+}
+
+std::span<std::byte> StreamingBuffer::Allocate(size_t size, size_t alignment, size_t& offset)
+{
+    // Alignment can be any value, for example the size of a vertex, so that offsets are a whole number of vertices
+    alignment = alignment > m_minAlignment ? alignment : m_minAlignment;
+    size_t localOffset = (m_usedSize + alignment - 1) / alignment * alignment;
+    if (localOffset + size > m_regionSize)
+    {
+        assert(false && "Streaming buffer region is full");
+        return std::span<std::byte>();
+    }
+
+    if (!m_persistent && m_mappedData.empty())
+    {
+        m_buffer->Bind();
+
+        // Orphan the storage of the previous frame, the driver keeps it alive while the GPU reads it
+        if (!m_orphaned)
+        {
+            m_buffer->AllocateData(m_regionSize, BufferObject::StreamDraw);
+            m_orphaned = true;
+        }
+
+        // The rest of the region was not used this frame, so there is nothing to synchronize with
+        GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        m_mappedOffset = localOffset;
+        m_mappedData = m_buffer->MapRange(m_mappedOffset, m_regionSize - m_mappedOffset, access);
+        assert(!m_mappedData.empty());
+    }
+
+    m_usedSize = localOffset + size;
+    offset = GetRegionOffset() + localOffset;
+    return m_mappedData.subspan(offset - m_mappedOffset, size);
+}
+
+void StreamingBuffer::Flush()
+{
+    // Persistent coherent memory is visible to the GPU as soon as it is written
+    if (!m_persistent && !m_mappedData.empty())
+    {
+        m_buffer->Bind();
+        [[maybe_unused]] bool valid = m_buffer->Unmap();
+        assert(valid);
+        m_mappedData = std::span<std::byte>();
+    }
+}
+
+void StreamingBuffer::EndFrame()
+{
+    Flush();
+
+    if (m_persistent)
+    {
+        assert(!m_fences[m_currentRegion]);
+        m_fences[m_currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    m_usedSize = 0;
+}
+
+size_t StreamingBuffer::GetRegionOffset() const
+{
+    return m_persistent ? m_currentRegion * m_regionSize : 0;
+}
+
+void StreamingBuffer::WaitRegion(unsigned int region)
+{
+    GLsync& fence = m_fences[region];
+    if (fence)
+    {
+        // Flush the commands the first time, otherwise the fence could never be signaled
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        GLenum result;
+        do
+        {
+            result = glClientWaitSync(fence, flags, 1000000); // 1 ms
+            flags = 0;
+        } while (result == GL_TIMEOUT_EXPIRED);
+        assert(result != GL_WAIT_FAILED);
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
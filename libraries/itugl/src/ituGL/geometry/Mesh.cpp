@@ -1,9 +1,19 @@
 #include <ituGL/geometry/Mesh.h>
 
+#include <ituGL/geometry/MeshPool.h>
+
 Mesh::Mesh()
 {
 }
 
+Mesh::~Mesh()
+{
+    for (auto& [meshPool, rangeId] : m_poolRanges)
+    {
+        meshPool->FreeMeshRange(rangeId);
+    }
+}
+
 unsigned int Mesh::AddVertexData(size_t size)
 {
     unsigned int vboIndex = GetVertexBufferCount();
@@ -17,9 +27,16 @@ unsigned int Mesh::AddVertexArray()
 {
     unsigned int vaoIndex = GetVertexArrayCount();
     m_vaos.emplace_back();
+    m_positionVaoIndices.push_back(-1);
     return vaoIndex;
 }
 
+const VertexArrayObject* Mesh::GetPositionVertexArray(unsigned int vaoIndex) const
+{
+    int positionVaoIndex = m_positionVaoIndices[vaoIndex];
+    return positionVaoIndex >= 0 ? &m_positionVaos[positionVaoIndex] : nullptr;
+}
+
 unsigned int Mesh::AddSubmesh(unsigned int vaoIndex, const Drawcall& drawcall)
 {
     unsigned int submeshIndex = GetSubmeshCount();
@@ -35,11 +52,39 @@ unsigned int Mesh::AddSubmesh(unsigned int vaoIndex,
     return AddSubmesh(vaoIndex, Drawcall(primitive, count, eboType, first));
 }
 
+unsigned int Mesh::AddSubmesh(const VertexArrayObject& vao, const VertexArrayObject* positionVao, const Drawcall& drawcall)
+{
+    unsigned int submeshIndex = GetSubmeshCount();
+    Submesh& submesh = m_submeshes.emplace_back();
+    submesh.vaoIndex = ~0u;
+    submesh.drawcall = drawcall;
+    submesh.sharedVao = &vao;
+    submesh.sharedPositionVao = positionVao;
+    return submeshIndex;
+}
+
+const VertexArrayObject& Mesh::GetSubmeshVertexArray(unsigned int submeshIndex) const
+{
+    const Submesh& submesh = GetSubmesh(submeshIndex);
+    return submesh.sharedVao ? *submesh.sharedVao : m_vaos[submesh.vaoIndex];
+}
+
+const VertexArrayObject* Mesh::GetSubmeshPositionVertexArray(unsigned int submeshIndex) const
+{
+    const Submesh& submesh = GetSubmesh(submeshIndex);
+    return submesh.sharedVao ? submesh.sharedPositionVao : GetPositionVertexArray(submesh.vaoIndex);
+}
+
+void Mesh::SetSubmeshDrawcall(unsigned int submeshIndex, const Drawcall& drawcall)
+{
+    GetSubmesh(submeshIndex).drawcall = drawcall;
+}
+
 // Bind the VAO and render the drawcall of the submesh
 void Mesh::DrawSubmesh(int submeshIndex) const
 {
     const Submesh& submesh = GetSubmesh(submeshIndex);
-    const VertexArrayObject& vao = GetVertexArray(submesh.vaoIndex);
+    const VertexArrayObject& vao = GetSubmeshVertexArray(submeshIndex);
     vao.Bind();
     submesh.drawcall.Draw();
     //VertexArrayObject::Unbind(); // No need to unbind
@@ -58,3 +103,34 @@ void Mesh::SetupVertexAttribute(VertexArrayObject& vao, const VertexAttribute::L
     vao.SetAttribute(location, attribute, attributeLayout.GetOffset(), attributeLayout.GetStride());
     location += attribute.GetLocationSize();
 }
+
+void Mesh::AddPositionVertexArray(unsigned int vaoIndex, unsigned int vboIndex, const VertexAttribute::Layout& positionLayout)
+{
+    m_positionVaoIndices[vaoIndex] = static_cast<int>(m_positionVaos.size());
+    VertexArrayObject& positionVao = m_positionVaos.emplace_back();
+    positionVao.Bind();
+
+    GetVertexBuffer(vboIndex).Bind();
+    positionVao.SetAttribute(0, positionLayout.GetAttribute(), positionLayout.GetOffset(), positionLayout.GetStride());
+
+    VertexBufferObject::Unbind();
+    VertexArrayObject::Unbind();
+}
+
+void Mesh::SetupElementBuffer(unsigned int vaoIndex, unsigned int eboIndex)
+{
+    const ElementBufferObject& ebo = GetElementBuffer(eboIndex);
+
+    GetVertexArray(vaoIndex).Bind();
+    ebo.Bind();
+
+    int positionVaoIndex = m_positionVaoIndices[vaoIndex];
+    if (positionVaoIndex >= 0)
+    {
+        m_positionVaos[positionVaoIndex].Bind();
+        ebo.Bind();
+    }
+
+    VertexArrayObject::Unbind();
+    ElementBufferObject::Unbind();
+}
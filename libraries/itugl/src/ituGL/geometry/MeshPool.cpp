@@ -0,0 +1,314 @@
+#include <ituGL/geometry/MeshPool.h>
+
+#include <algorithm>
+#include <cassert>
+
+unsigned int MeshPool::s_defragmentGeneration = 0;
+
+MeshPool::MeshPool(size_t vertexBufferSize, size_t elementBufferSize)
+    : m_vertexBufferSize(vertexBufferSize)
+    , m_elementBufferSize(elementBufferSize)
+{
+}
+
+MeshPool::Range MeshPool::AddData(const VertexFormat& vertexFormat, std::span<const std::byte> vertexData, std::span<const unsigned int> elements,
+    const Mesh::SemanticMap& locations)
+{
+    assert(vertexFormat.GetAttributeCount() > 0);
+    assert(vertexData.size() % vertexFormat.GetSize() == 0);
+    assert(!elements.empty());
+
+    unsigned int rangeId = static_cast<unsigned int>(m_ranges.size());
+    if (!m_freeRangeIds.empty())
+    {
+        rangeId = m_freeRangeIds.back();
+        m_freeRangeIds.pop_back();
+    }
+    else
+    {
+        m_ranges.emplace_back();
+    }
+
+    RangeInfo& rangeInfo = m_ranges[rangeId];
+    rangeInfo = RangeInfo();
+    rangeInfo.used = true;
+
+    Range& range = rangeInfo.range;
+    range.id = rangeId;
+    range.vertexCount = static_cast<unsigned int>(vertexData.size() / vertexFormat.GetSize());
+    range.elementCount = static_cast<unsigned int>(elements.size());
+    AllocateRange(vertexFormat, locations, rangeInfo);
+
+    // The elements keep their values, the base vertex of the drawcalls moves them to the vertices of the range
+    Bucket& bucket = *m_buckets[range.bucketIndex];
+    bucket.vbo.Bind();
+    bucket.vbo.UpdateData(vertexData, range.baseVertex * vertexFormat.GetSize());
+    VertexBufferObject::Unbind();
+
+    // The element buffer binding is part of the VAO, keep it bound while updating
+    bucket.vao.Bind();
+    bucket.ebo.Bind();
+    bucket.ebo.UpdateData(elements, range.firstElement * sizeof(unsigned int));
+    VertexArrayObject::Unbind();
+    ElementBufferObject::Unbind();
+
+    return range;
+}
+
+const MeshPool::Range& MeshPool::GetRange(unsigned int rangeId) const
+{
+    assert(rangeId < m_ranges.size() && m_ranges[rangeId].used);
+    return m_ranges[rangeId].range;
+}
+
+void MeshPool::Free(unsigned int rangeId)
+{
+    assert(rangeId < m_ranges.size() && m_ranges[rangeId].used);
+    RangeInfo& rangeInfo = m_ranges[rangeId];
+    assert(!rangeInfo.mesh);
+
+    Bucket& bucket = *m_buckets[rangeInfo.range.bucketIndex];
+    bucket.vertexAllocator.Free(rangeInfo.vertexAllocation);
+    bucket.elementAllocator.Free(rangeInfo.elementAllocation);
+
+    rangeInfo = RangeInfo();
+    m_freeRangeIds.push_back(rangeId);
+}
+
+void MeshPool::FreeMeshRange(unsigned int rangeId)
+{
+    m_ranges[rangeId].mesh = nullptr;
+    Free(rangeId);
+}
+
+unsigned int MeshPool::AddSubmesh(Mesh& mesh, const Range& range, Drawcall::Primitive primitive, unsigned int firstElement, unsigned int elementCount)
+{
+    assert(range.id < m_ranges.size() && m_ranges[range.id].used);
+    assert(firstElement + elementCount <= range.elementCount);
+
+    RangeInfo& rangeInfo = m_ranges[range.id];
+    assert(!rangeInfo.mesh || rangeInfo.mesh == &mesh);
+    if (!rangeInfo.mesh)
+    {
+        rangeInfo.mesh = &mesh;
+        mesh.m_poolRanges.emplace_back(this, range.id);
+    }
+
+    // The range passed can be a copy from before a defragmentation, use the current offsets
+    const Bucket& bucket = *m_buckets[rangeInfo.range.bucketIndex];
+    Drawcall drawcall = CreateDrawcall(rangeInfo.range, primitive, firstElement, elementCount);
+    unsigned int submeshIndex = mesh.AddSubmesh(bucket.vao, bucket.hasPositionVao ? &bucket.positionVao : nullptr, drawcall);
+    rangeInfo.submeshes.emplace_back(submeshIndex, firstElement);
+    return submeshIndex;
+}
+
+size_t MeshPool::Defragment()
+{
+    size_t movedSize = 0;
+    for (std::unique_ptr<Bucket>& bucket : m_buckets)
+    {
+        movedSize += MoveData(bucket->vbo, bucket->vertexFormat.GetSize(), bucket->vertexAllocator.Defragment());
+        movedSize += MoveData(bucket->ebo, sizeof(unsigned int), bucket->elementAllocator.Defragment());
+    }
+
+    // Update the ranges that moved, and the drawcalls of their submeshes
+    for (RangeInfo& rangeInfo : m_ranges)
+    {
+        if (!rangeInfo.used)
+        {
+            continue;
+        }
+
+        const Bucket& bucket = *m_buckets[rangeInfo.range.bucketIndex];
+        GLint baseVertex = static_cast<GLint>(bucket.vertexAllocator.GetAllocation(rangeInfo.vertexAllocation).offset);
+        unsigned int firstElement = bucket.elementAllocator.GetAllocation(rangeInfo.elementAllocation).offset;
+        if (rangeInfo.range.baseVertex == baseVertex && rangeInfo.range.firstElement == firstElement)
+        {
+            continue;
+        }
+        rangeInfo.range.baseVertex = baseVertex;
+        rangeInfo.range.firstElement = firstElement;
+
+        for (auto [submeshIndex, submeshFirstElement] : rangeInfo.submeshes)
+        {
+            const Drawcall& drawcall = rangeInfo.mesh->GetSubmeshDrawcall(submeshIndex);
+            rangeInfo.mesh->SetSubmeshDrawcall(submeshIndex,
+                CreateDrawcall(rangeInfo.range, drawcall.GetPrimitive(), submeshFirstElement, static_cast<unsigned int>(drawcall.GetCount())));
+        }
+    }
+
+    if (movedSize > 0)
+    {
+        ++s_defragmentGeneration;
+    }
+    return movedSize;
+}
+
+const VertexArrayObject& MeshPool::GetVertexArray(unsigned int bucketIndex) const
+{
+    return m_buckets[bucketIndex]->vao;
+}
+
+const RangeAllocator& MeshPool::GetVertexAllocator(unsigned int bucketIndex) const
+{
+    return m_buckets[bucketIndex]->vertexAllocator;
+}
+
+const RangeAllocator& MeshPool::GetElementAllocator(unsigned int bucketIndex) const
+{
+    return m_buckets[bucketIndex]->elementAllocator;
+}
+
+size_t MeshPool::GetUsedSize() const
+{
+    size_t size = 0;
+    for (const std::unique_ptr<Bucket>& bucket : m_buckets)
+    {
+        size += bucket->vertexAllocator.GetStats().usedSize * bucket->vertexFormat.GetSize()
+            + bucket->elementAllocator.GetStats().usedSize * sizeof(unsigned int);
+    }
+    return size;
+}
+
+size_t MeshPool::GetAllocatedSize() const
+{
+    size_t size = 0;
+    for (const std::unique_ptr<Bucket>& bucket : m_buckets)
+    {
+        size += bucket->vertexAllocator.GetSize() * bucket->vertexFormat.GetSize() + bucket->elementAllocator.GetSize() * sizeof(unsigned int);
+    }
+    return size;
+}
+
+void MeshPool::AllocateRange(const VertexFormat& vertexFormat, const Mesh::SemanticMap& locations, RangeInfo& rangeInfo)
+{
+    Range& range = rangeInfo.range;
+
+    // Both allocations must fit in the same bucket
+    auto tryAllocate = [&](unsigned int bucketIndex)
+        {
+            Bucket& bucket = *m_buckets[bucketIndex];
+            RangeAllocator::Allocation vertexAllocation = bucket.vertexAllocator.Allocate(range.vertexCount);
+            if (vertexAllocation.id == RangeAllocator::InvalidId)
+            {
+                return false;
+            }
+            RangeAllocator::Allocation elementAllocation = bucket.elementAllocator.Allocate(range.elementCount);
+            if (elementAllocation.id == RangeAllocator::InvalidId)
+            {
+                bucket.vertexAllocator.Free(vertexAllocation.id);
+                return false;
+            }
+
+            rangeInfo.vertexAllocation = vertexAllocation.id;
+            rangeInfo.elementAllocation = elementAllocation.id;
+            range.bucketIndex = bucketIndex;
+            range.baseVertex = static_cast<GLint>(vertexAllocation.offset);
+            range.firstElement = elementAllocation.offset;
+            return true;
+        };
+
+    for (unsigned int bucketIndex = 0; bucketIndex < m_buckets.size(); ++bucketIndex)
+    {
+        const Bucket& bucket = *m_buckets[bucketIndex];
+        if (bucket.vertexFormat == vertexFormat && bucket.locations == locations && tryAllocate(bucketIndex))
+        {
+            return;
+        }
+    }
+
+    Bucket& bucket = *m_buckets.emplace_back(std::make_unique<Bucket>());
+    bucket.vertexFormat = vertexFormat;
+    bucket.locations = locations;
+    bucket.vertexAllocator.Reset(std::max(static_cast<unsigned int>(m_vertexBufferSize / vertexFormat.GetSize()), range.vertexCount));
+    bucket.elementAllocator.Reset(std::max(static_cast<unsigned int>(m_elementBufferSize / sizeof(unsigned int)), range.elementCount));
+    InitializeBucket(bucket);
+
+    [[maybe_unused]] bool allocated = tryAllocate(static_cast<unsigned int>(m_buckets.size()) - 1);
+    assert(allocated);
+}
+
+void MeshPool::InitializeBucket(Bucket& bucket)
+{
+    unsigned int vertexCapacity = bucket.vertexAllocator.GetSize();
+
+    bucket.vbo.Bind();
+    bucket.vbo.AllocateData(vertexCapacity * bucket.vertexFormat.GetSize());
+
+    // Same locations as the VAOs of Mesh, from 0 unless the semantic is in the map
+    bucket.vao.Bind();
+    GLuint location = 0;
+    auto itEnd = bucket.vertexFormat.LayoutEnd();
+    for (auto it = bucket.vertexFormat.LayoutBegin(static_cast<int>(vertexCapacity), true); it != itEnd; it++)
+    {
+        const VertexAttribute& attribute = it->GetAttribute();
+        auto itLocation = bucket.locations.find(attribute.GetSemantic());
+        if (itLocation != bucket.locations.end())
+        {
+            location = itLocation->second;
+        }
+        bucket.vao.SetAttribute(location, attribute, it->GetOffset(), it->GetStride());
+        location += attribute.GetLocationSize();
+
+        if (attribute.GetSemantic() == VertexAttribute::Semantic::Position)
+        {
+            bucket.positionVao.Bind();
+            bucket.positionVao.SetAttribute(0, attribute, it->GetOffset(), it->GetStride());
+            bucket.hasPositionVao = true;
+            bucket.vao.Bind();
+        }
+    }
+
+    bucket.ebo.Bind();
+    bucket.ebo.AllocateData<unsigned int>(bucket.elementAllocator.GetSize());
+    if (bucket.hasPositionVao)
+    {
+        bucket.positionVao.Bind();
+        bucket.ebo.Bind();
+    }
+
+    VertexArrayObject::Unbind();
+    VertexBufferObject::Unbind();
+    ElementBufferObject::Unbind();
+}
+
+size_t MeshPool::MoveData(BufferObject& buffer, size_t unitSize, std::span<const RangeAllocator::Move> moves)
+{
+    size_t size = 0;
+    for (const RangeAllocator::Move& move : moves)
+    {
+        size += move.size * unitSize;
+    }
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    // The source and destination of a move can overlap, so the data goes through another buffer
+    BufferObjectBase<BufferObject::CopyWriteBuffer> scratchBuffer;
+    scratchBuffer.Bind();
+    scratchBuffer.AllocateData(size, BufferObject::StreamCopy);
+    BufferObjectBase<BufferObject::CopyWriteBuffer>::Unbind();
+
+    size_t scratchOffset = 0;
+    for (const RangeAllocator::Move& move : moves)
+    {
+        scratchBuffer.CopyData(buffer, move.oldOffset * unitSize, scratchOffset, move.size * unitSize);
+        scratchOffset += move.size * unitSize;
+    }
+
+    scratchOffset = 0;
+    for (const RangeAllocator::Move& move : moves)
+    {
+        buffer.CopyData(scratchBuffer, scratchOffset, move.newOffset * unitSize, move.size * unitSize);
+        scratchOffset += move.size * unitSize;
+    }
+
+    return size;
+}
+
+Drawcall MeshPool::CreateDrawcall(const Range& range, Drawcall::Primitive primitive, unsigned int firstElement, unsigned int elementCount)
+{
+    GLint firstByte = static_cast<GLint>((range.firstElement + firstElement) * sizeof(unsigned int));
+    return Drawcall(primitive, static_cast<GLsizei>(elementCount), Data::Type::UInt, firstByte, range.baseVertex);
+}
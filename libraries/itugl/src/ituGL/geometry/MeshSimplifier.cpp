@@ -0,0 +1,327 @@
+#include <ituGL/geometry/MeshSimplifier.h>
+
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdint>
+#include <cmath>
+#include <cassert>
+
+// Collapses that turn a triangle more than this (cosine of the angle between the normals) are rejected, to avoid folds
+static constexpr float s_minNormalCosine = 0.25f;
+
+static bool CompareCollapses(float costA, unsigned int fromA, unsigned int toA, float costB, unsigned int fromB, unsigned int toB)
+{
+    // Greater than, for a min-heap. Ties are broken by the vertices, so the order doesn't depend on the heap implementation
+    if (costA != costB)
+    {
+        return costA > costB;
+    }
+    return fromA != fromB ? fromA > fromB : toA > toB;
+}
+
+void MeshSimplifier::Quadric::AddPlane(const glm::vec3& normal, float distance, double planeWeight)
+{
+    double a = normal.x, b = normal.y, c = normal.z, d = distance;
+    a00 += planeWeight * a * a; a01 += planeWeight * a * b; a02 += planeWeight * a * c; a03 += planeWeight * a * d;
+    a11 += planeWeight * b * b; a12 += planeWeight * b * c; a13 += planeWeight * b * d;
+    a22 += planeWeight * c * c; a23 += planeWeight * c * d;
+    a33 += planeWeight * d * d;
+    weight += planeWeight;
+}
+
+void MeshSimplifier::Quadric::Add(const Quadric& other)
+{
+    a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+    a11 += other.a11; a12 += other.a12; a13 += other.a13;
+    a22 += other.a22; a23 += other.a23;
+    a33 += other.a33;
+    weight += other.weight;
+}
+
+double MeshSimplifier::Quadric::Evaluate(const glm::vec3& position) const
+{
+    double x = position.x, y = position.y, z = position.z;
+    double value = a00 * x * x + a11 * y * y + a22 * z * z + a33
+        + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z + a03 * x + a13 * y + a23 * z);
+    return std::max(value, 0.0);
+}
+
+MeshSimplifier::MeshSimplifier() : m_triangleCount(0), m_error(0.0f)
+{
+}
+
+std::vector<unsigned int> MeshSimplifier::Simplify(std::span<const glm::vec3> positions, std::span<const unsigned int> indices,
+    unsigned int targetIndexCount, float maxError)
+{
+    assert(indices.size() % 3 == 0);
+
+    Initialize(positions, indices);
+
+    double maxCost = static_cast<double>(maxError) * maxError;
+    float error = 0.0f;
+    while (m_triangleCount * 3 > targetIndexCount && !m_collapses.empty())
+    {
+        std::pop_heap(m_collapses.begin(), m_collapses.end(), [](const Collapse& a, const Collapse& b)
+            {
+                return CompareCollapses(a.cost, a.from, a.to, b.cost, b.from, b.to);
+            });
+        Collapse collapse = m_collapses.back();
+        m_collapses.pop_back();
+
+        // Skip the collapses queued before one of the vertices changed, they were queued again with the new cost
+        if (!m_vertexAlive[collapse.from] || !m_vertexAlive[collapse.to]
+            || m_vertexVersions[collapse.from] != collapse.fromVersion || m_vertexVersions[collapse.to] != collapse.toVersion)
+        {
+            continue;
+        }
+
+        // The heap is sorted by cost, so all the remaining collapses are above the error too
+        if (collapse.cost > maxCost)
+        {
+            break;
+        }
+
+        if (!CanCollapse(collapse.from, collapse.to))
+        {
+            continue;
+        }
+
+        ApplyCollapse(collapse.from, collapse.to);
+        error = std::max(error, collapse.cost);
+
+        // The merged vertex has a new quadric, so the cost of all its edges changed
+        CollectNeighbors(collapse.to, m_neighborsTo);
+        for (unsigned int neighbor : m_neighborsTo)
+        {
+            QueueEdge(collapse.to, neighbor);
+        }
+    }
+    m_error = std::sqrt(error);
+
+    std::vector<unsigned int> result;
+    result.reserve(m_triangleCount * 3);
+    for (unsigned int triangleIndex = 0; triangleIndex < m_triangleAlive.size(); ++triangleIndex)
+    {
+        if (m_triangleAlive[triangleIndex])
+        {
+            result.insert(result.end(), m_indices.begin() + triangleIndex * 3, m_indices.begin() + triangleIndex * 3 + 3);
+        }
+    }
+    return result;
+}
+
+void MeshSimplifier::Initialize(std::span<const glm::vec3> positions, std::span<const unsigned int> indices)
+{
+    unsigned int vertexCount = static_cast<unsigned int>(positions.size());
+    unsigned int triangleCount = static_cast<unsigned int>(indices.size() / 3);
+
+    m_positions = positions;
+    m_indices.assign(indices.begin(), indices.end());
+    m_triangleAlive.assign(triangleCount, true);
+    m_triangleCount = triangleCount;
+
+    m_quadrics.assign(vertexCount, Quadric{});
+    m_vertexTriangles.resize(vertexCount);
+    for (std::vector<unsigned int>& vertexTriangles : m_vertexTriangles)
+    {
+        vertexTriangles.clear();
+    }
+    m_vertexAlive.assign(vertexCount, true);
+    m_vertexLocked.assign(vertexCount, false);
+    m_vertexVersions.assign(vertexCount, 0);
+    m_collapses.clear();
+
+    // Plane of each triangle, weighted by its area, added to its 3 vertices
+    std::unordered_map<std::uint64_t, unsigned int> edgeTriangleCounts;
+    edgeTriangleCounts.reserve(indices.size());
+    for (unsigned int triangleIndex = 0; triangleIndex < triangleCount; ++triangleIndex)
+    {
+        const unsigned int* triangle = &m_indices[triangleIndex * 3];
+        assert(triangle[0] < vertexCount && triangle[1] < vertexCount && triangle[2] < vertexCount);
+
+        const glm::vec3& p0 = positions[triangle[0]];
+        glm::vec3 normal = glm::cross(positions[triangle[1]] - p0, positions[triangle[2]] - p0);
+        float doubleArea = glm::length(normal);
+        if (doubleArea > 0.0f)
+        {
+            normal /= doubleArea;
+            Quadric quadric{};
+            quadric.AddPlane(normal, -glm::dot(normal, p0), doubleArea * 0.5);
+            for (unsigned int i = 0; i < 3; ++i)
+            {
+                m_quadrics[triangle[i]].Add(quadric);
+            }
+        }
+
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            m_vertexTriangles[triangle[i]].push_back(triangleIndex);
+
+            unsigned int vertexA = std::min(triangle[i], triangle[(i + 1) % 3]);
+            unsigned int vertexB = std::max(triangle[i], triangle[(i + 1) % 3]);
+            ++edgeTriangleCounts[(static_cast<std::uint64_t>(vertexA) << 32) | vertexB];
+        }
+    }
+
+    // Edges of only one triangle are borders, and more than two are not manifold. Their vertices stay where they are
+    for (const auto& edgeTriangleCount : edgeTriangleCounts)
+    {
+        if (edgeTriangleCount.second != 2)
+        {
+            m_vertexLocked[static_cast<unsigned int>(edgeTriangleCount.first >> 32)] = true;
+            m_vertexLocked[static_cast<unsigned int>(edgeTriangleCount.first & 0xFFFFFFFF)] = true;
+        }
+    }
+
+    // Interior edges are in two triangles with opposite directions, so each one is queued once
+    for (unsigned int triangleIndex = 0; triangleIndex < triangleCount; ++triangleIndex)
+    {
+        const unsigned int* triangle = &m_indices[triangleIndex * 3];
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            if (triangle[i] < triangle[(i + 1) % 3])
+            {
+                QueueEdge(triangle[i], triangle[(i + 1) % 3]);
+            }
+        }
+    }
+}
+
+void MeshSimplifier::QueueEdge(unsigned int vertexA, unsigned int vertexB)
+{
+    if (m_vertexLocked[vertexA] && m_vertexLocked[vertexB])
+    {
+        return;
+    }
+
+    Quadric quadric = m_quadrics[vertexA];
+    quadric.Add(m_quadrics[vertexB]);
+    double weight = std::max(quadric.weight, 1e-12);
+
+    // Average squared distance to the planes of both vertices, with the merged vertex at the position of the other
+    double costToB = m_vertexLocked[vertexA] ? HUGE_VAL : quadric.Evaluate(m_positions[vertexB]) / weight;
+    double costToA = m_vertexLocked[vertexB] ? HUGE_VAL : quadric.Evaluate(m_positions[vertexA]) / weight;
+
+    Collapse collapse;
+    if (costToB <= costToA)
+    {
+        collapse.from = vertexA;
+        collapse.to = vertexB;
+        collapse.cost = static_cast<float>(costToB);
+    }
+    else
+    {
+        collapse.from = vertexB;
+        collapse.to = vertexA;
+        collapse.cost = static_cast<float>(costToA);
+    }
+    collapse.fromVersion = m_vertexVersions[collapse.from];
+    collapse.toVersion = m_vertexVersions[collapse.to];
+
+    m_collapses.push_back(collapse);
+    std::push_heap(m_collapses.begin(), m_collapses.end(), [](const Collapse& a, const Collapse& b)
+        {
+            return CompareCollapses(a.cost, a.from, a.to, b.cost, b.from, b.to);
+        });
+}
+
+bool MeshSimplifier::CanCollapse(unsigned int from, unsigned int to)
+{
+    // Link condition: the only vertices connected to both must be the ones of the triangles of the edge
+    // Otherwise the collapse would glue two parts of the surface together
+    CollectNeighbors(from, m_neighborsFrom);
+    CollectNeighbors(to, m_neighborsTo);
+    unsigned int sharedNeighborCount = 0;
+    for (unsigned int neighbor : m_neighborsFrom)
+    {
+        sharedNeighborCount += std::find(m_neighborsTo.begin(), m_neighborsTo.end(), neighbor) != m_neighborsTo.end() ? 1 : 0;
+    }
+
+    unsigned int edgeTriangleCount = 0;
+    const glm::vec3& target = m_positions[to];
+    for (unsigned int triangleIndex : m_vertexTriangles[from])
+    {
+        if (!m_triangleAlive[triangleIndex])
+        {
+            continue;
+        }
+
+        const unsigned int* triangle = &m_indices[triangleIndex * 3];
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+        {
+            // This triangle disappears with the collapse
+            ++edgeTriangleCount;
+            continue;
+        }
+
+        // The remaining triangles must not flip, or become too thin to have a normal
+        glm::vec3 positions[3], movedPositions[3];
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            positions[i] = m_positions[triangle[i]];
+            movedPositions[i] = triangle[i] == from ? target : positions[i];
+        }
+        glm::vec3 normal = glm::cross(positions[1] - positions[0], positions[2] - positions[0]);
+        glm::vec3 movedNormal = glm::cross(movedPositions[1] - movedPositions[0], movedPositions[2] - movedPositions[0]);
+        float lengths = glm::length(normal) * glm::length(movedNormal);
+        if (lengths <= 0.0f || glm::dot(normal, movedNormal) < s_minNormalCosine * lengths)
+        {
+            return false;
+        }
+    }
+
+    return edgeTriangleCount > 0 && sharedNeighborCount == edgeTriangleCount;
+}
+
+void MeshSimplifier::ApplyCollapse(unsigned int from, unsigned int to)
+{
+    std::vector<unsigned int>& toTriangles = m_vertexTriangles[to];
+    for (unsigned int triangleIndex : m_vertexTriangles[from])
+    {
+        if (!m_triangleAlive[triangleIndex])
+        {
+            continue;
+        }
+
+        unsigned int* triangle = &m_indices[triangleIndex * 3];
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+        {
+            m_triangleAlive[triangleIndex] = false;
+            --m_triangleCount;
+        }
+        else
+        {
+            std::replace(triangle, triangle + 3, from, to);
+            toTriangles.push_back(triangleIndex);
+        }
+    }
+
+    std::erase_if(toTriangles, [&](unsigned int triangleIndex) { return !m_triangleAlive[triangleIndex]; });
+    m_vertexTriangles[from].clear();
+
+    m_quadrics[to].Add(m_quadrics[from]);
+    m_vertexAlive[from] = false;
+    ++m_vertexVersions[to];
+}
+
+void MeshSimplifier::CollectNeighbors(unsigned int vertex, std::vector<unsigned int>& neighbors) const
+{
+    neighbors.clear();
+    for (unsigned int triangleIndex : m_vertexTriangles[vertex])
+    {
+        if (!m_triangleAlive[triangleIndex])
+        {
+            continue;
+        }
+
+        const unsigned int* triangle = &m_indices[triangleIndex * 3];
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            if (triangle[i] != vertex && std::find(neighbors.begin(), neighbors.end(), triangle[i]) == neighbors.end())
+            {
+                neighbors.push_back(triangle[i]);
+            }
+        }
+    }
+}
@@ -2,8 +2,10 @@
 
 #include <ituGL/geometry/Mesh.h>
 #include <ituGL/shader/Material.h>
+#include <algorithm>
+#include <limits>
 
-Model::Model(std::shared_ptr<Mesh> mesh) : m_mesh(mesh)
+Model::Model(std::shared_ptr<Mesh> mesh) : m_mesh(mesh), m_localBounds(glm::vec3(0.0f), glm::vec3(0.0f)), m_hasLocalBounds(false)
 {
 }
 
@@ -22,6 +24,51 @@ void Model::SetMesh(std::shared_ptr<Mesh> mesh)
     // Clear the material list before changing the mesh
     assert(m_materials.empty());
     m_mesh = mesh;
+    m_lods.clear();
+}
+
+const Mesh& Model::GetLodMesh(unsigned int lod) const
+{
+    assert(lod < GetLodCount());
+    return lod == 0 ? *m_mesh : *m_lods[lod - 1].mesh;
+}
+
+float Model::GetLodScreenSize(unsigned int lod) const
+{
+    assert(lod < GetLodCount());
+    return lod == 0 ? std::numeric_limits<float>::max() : m_lods[lod - 1].screenSize;
+}
+
+void Model::AddLod(std::shared_ptr<Mesh> mesh, float screenSize)
+{
+    assert(m_mesh && mesh);
+    assert(mesh->GetSubmeshCount() == m_mesh->GetSubmeshCount());
+    assert(screenSize < GetLodScreenSize(GetLodCount() - 1));
+    m_lods.push_back(Lod{ mesh, screenSize });
+}
+
+void Model::ClearLods()
+{
+    m_lods.clear();
+}
+
+unsigned int Model::SelectLod(float screenSize, unsigned int currentLod, float hysteresis) const
+{
+    unsigned int lod = std::min(currentLod, GetLodCount() - 1);
+
+    // Move to lower levels while the model is clearly smaller than their thresholds
+    while (lod + 1 < GetLodCount() && screenSize < m_lods[lod].screenSize * (1.0f - hysteresis))
+    {
+        ++lod;
+    }
+
+    // And to higher levels while it is clearly bigger than the threshold of the current one
+    while (lod > 0 && screenSize > m_lods[lod - 1].screenSize * (1.0f + hysteresis))
+    {
+        --lod;
+    }
+
+    return lod;
 }
 
 unsigned int Model::GetMaterialCount()
@@ -75,3 +122,9 @@ void Model::Draw()
         }
     }
 }
+
+void Model::SetLocalBounds(const AabbBounds& localBounds)
+{
+    m_localBounds = localBounds;
+    m_hasLocalBounds = true;
+}
@@ -19,6 +19,12 @@ int VertexAttribute::GetLocationSize() const
     return 1;
 }
 
+bool VertexAttribute::operator == (const VertexAttribute& other) const
+{
+    return m_type == other.m_type && m_components == other.m_components
+        && m_normalized == other.m_normalized && m_semantic == other.m_semantic;
+}
+
 VertexAttribute::Layout::Layout(const VertexAttribute& attribute, GLint offset, GLsizei stride)
     : m_attribute(attribute)
     , m_offset(offset)
@@ -0,0 +1,301 @@
+#include <ituGL/lighting/LightClusterGrid.h>
+
+#include <ituGL/lighting/Light.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/utils/ThreadPool.h>
+#include <glm/matrix.hpp>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cassert>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#define ITUGL_CLUSTER_SSE
+#endif
+
+LightClusterGrid::LightClusterGrid(const glm::uvec3& dimensions)
+    : m_dimensions(dimensions), m_nearDistance(0.0f), m_farDistance(0.0f), m_depthSliceParams(0.0f)
+    , m_sliceStride((dimensions.x * dimensions.y + 3) / 4 * 4)
+{
+    assert(dimensions.x > 0 && dimensions.y > 0 && dimensions.z > 0);
+
+    unsigned int boxCount = m_sliceStride * dimensions.z;
+    m_boxMinX.resize(boxCount);
+    m_boxMinY.resize(boxCount);
+    m_boxMinZ.resize(boxCount);
+    m_boxMaxX.resize(boxCount);
+    m_boxMaxY.resize(boxCount);
+    m_boxMaxZ.resize(boxCount);
+
+    m_clusterLights.resize(GetClusterCount());
+    m_clusterRanges.resize(GetClusterCount());
+}
+
+unsigned int LightClusterGrid::GetClusterIndex(const glm::uvec3& cluster) const
+{
+    assert(cluster.x < m_dimensions.x && cluster.y < m_dimensions.y && cluster.z < m_dimensions.z);
+    return (cluster.z * m_dimensions.y + cluster.y) * m_dimensions.x + cluster.x;
+}
+
+std::span<const unsigned int> LightClusterGrid::GetClusterLightIndices(unsigned int clusterIndex) const
+{
+    const ClusterRange& range = m_clusterRanges[clusterIndex];
+    return std::span<const unsigned int>(m_lightIndices).subspan(range.offset, range.count);
+}
+
+void LightClusterGrid::Build(std::span<const Light* const> lights, const Camera& camera, ThreadPool* threadPool)
+{
+    SetupClusters(camera);
+    SetupLights(lights, camera);
+
+    // Each slice writes only to its own clusters, so they can run in parallel
+    if (threadPool)
+    {
+        threadPool->ParallelFor(m_dimensions.z, [this](unsigned int slice) { AssignSlice(slice); });
+    }
+    else
+    {
+        for (unsigned int slice = 0; slice < m_dimensions.z; ++slice)
+        {
+            AssignSlice(slice);
+        }
+    }
+
+    MergeClusters();
+}
+
+void LightClusterGrid::BuildReference(std::span<const Light* const> lights, const Camera& camera)
+{
+    SetupClusters(camera);
+    SetupLights(lights, camera);
+
+    unsigned int sliceClusterCount = m_dimensions.x * m_dimensions.y;
+    for (unsigned int clusterIndex = 0; clusterIndex < GetClusterCount(); ++clusterIndex)
+    {
+        unsigned int box = (clusterIndex / sliceClusterCount) * m_sliceStride + clusterIndex % sliceClusterCount;
+
+        std::vector<unsigned int>& clusterLights = m_clusterLights[clusterIndex];
+        clusterLights.clear();
+        for (unsigned int i = 0; i < m_lightSpheres.size(); ++i)
+        {
+            if (SphereIntersectsBox(m_lightSpheres[i], m_boxMinX[box], m_boxMinY[box], m_boxMinZ[box], m_boxMaxX[box], m_boxMaxY[box], m_boxMaxZ[box]))
+            {
+                clusterLights.push_back(m_lightSphereIndices[i]);
+            }
+        }
+    }
+
+    MergeClusters();
+}
+
+bool LightClusterGrid::HasSameAssignment(const LightClusterGrid& other) const
+{
+    if (m_dimensions != other.m_dimensions
+        || !std::equal(m_lightIndices.begin(), m_lightIndices.end(), other.m_lightIndices.begin(), other.m_lightIndices.end())
+        || !std::equal(m_globalLightIndices.begin(), m_globalLightIndices.end(), other.m_globalLightIndices.begin(), other.m_globalLightIndices.end()))
+    {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < m_clusterRanges.size(); ++i)
+    {
+        if (m_clusterRanges[i].offset != other.m_clusterRanges[i].offset || m_clusterRanges[i].count != other.m_clusterRanges[i].count)
+            return false;
+    }
+
+    return true;
+}
+
+void LightClusterGrid::SetupClusters(const Camera& camera)
+{
+    const glm::mat4& projMatrix = camera.GetProjectionMatrix();
+
+    // Only perspective projections have clusters that grow with depth
+    assert(projMatrix[2][3] == -1.0f);
+
+    // Recover the near and far distances from the projection matrix
+    m_nearDistance = projMatrix[3][2] / (projMatrix[2][2] - 1.0f);
+    m_farDistance = projMatrix[3][2] / (projMatrix[2][2] + 1.0f);
+
+    float logDepthRange = std::log(m_farDistance / m_nearDistance);
+    m_depthSliceParams.x = m_dimensions.z / logDepthRange;
+    m_depthSliceParams.y = -(m_dimensions.z * std::log(m_nearDistance)) / logDepthRange;
+
+    // Direction of the rays through the tile corners, scaled to reach depth 1
+    glm::mat4 invProjMatrix = glm::inverse(projMatrix);
+    std::vector<glm::vec2> cornerRays((m_dimensions.x + 1) * (m_dimensions.y + 1));
+    for (unsigned int y = 0; y <= m_dimensions.y; ++y)
+    {
+        for (unsigned int x = 0; x <= m_dimensions.x; ++x)
+        {
+            glm::vec2 ndc = glm::vec2(x, y) / glm::vec2(m_dimensions) * 2.0f - 1.0f;
+            glm::vec4 nearPoint = invProjMatrix * glm::vec4(ndc, -1.0f, 1.0f);
+            nearPoint /= nearPoint.w;
+            cornerRays[y * (m_dimensions.x + 1) + x] = glm::vec2(nearPoint) / -nearPoint.z;
+        }
+    }
+
+    for (unsigned int z = 0; z < m_dimensions.z; ++z)
+    {
+        // Exponential slices: the depth is multiplied by the same factor in every slice
+        float sliceNear = m_nearDistance * std::pow(m_farDistance / m_nearDistance, static_cast<float>(z) / m_dimensions.z);
+        float sliceFar = m_nearDistance * std::pow(m_farDistance / m_nearDistance, static_cast<float>(z + 1) / m_dimensions.z);
+
+        unsigned int box = z * m_sliceStride;
+        for (unsigned int y = 0; y < m_dimensions.y; ++y)
+        {
+            for (unsigned int x = 0; x < m_dimensions.x; ++x, ++box)
+            {
+                glm::vec2 boxMin(std::numeric_limits<float>::max());
+                glm::vec2 boxMax(std::numeric_limits<float>::lowest());
+                for (unsigned int corner = 0; corner < 4; ++corner)
+                {
+                    const glm::vec2& ray = cornerRays[(y + (corner >> 1)) * (m_dimensions.x + 1) + x + (corner & 1)];
+                    boxMin = glm::min(boxMin, glm::min(ray * sliceNear, ray * sliceFar));
+                    boxMax = glm::max(boxMax, glm::max(ray * sliceNear, ray * sliceFar));
+                }
+                m_boxMinX[box] = boxMin.x;
+                m_boxMinY[box] = boxMin.y;
+                m_boxMinZ[box] = sliceNear;
+                m_boxMaxX[box] = boxMax.x;
+                m_boxMaxY[box] = boxMax.y;
+                m_boxMaxZ[box] = sliceFar;
+            }
+        }
+
+        // Padding boxes are inverted, so no sphere touches them
+        for (unsigned int box = z * m_sliceStride + m_dimensions.x * m_dimensions.y; box < (z + 1) * m_sliceStride; ++box)
+        {
+            m_boxMinX[box] = m_boxMinY[box] = m_boxMinZ[box] = std::numeric_limits<float>::max();
+            m_boxMaxX[box] = m_boxMaxY[box] = m_boxMaxZ[box] = std::numeric_limits<float>::lowest();
+        }
+    }
+}
+
+void LightClusterGrid::SetupLights(std::span<const Light* const> lights, const Camera& camera)
+{
+    const glm::mat4& viewMatrix = camera.GetViewMatrix();
+
+    m_lightSpheres.clear();
+    m_lightSphereIndices.clear();
+    m_lightSphereSlices.clear();
+    m_globalLightIndices.clear();
+
+    for (unsigned int i = 0; i < lights.size(); ++i)
+    {
+        const Light& light = *lights[i];
+
+        // The distance where the attenuation reaches 0. Spot lights use the same sphere as point lights
+        float range = light.GetAttenuation().y;
+        if (light.GetType() == Light::Type::Directional || range <= 0.0f)
+        {
+            m_globalLightIndices.push_back(i);
+            continue;
+        }
+
+        glm::vec3 center = viewMatrix * glm::vec4(light.GetPosition(), 1.0f);
+        center.z = -center.z;
+
+        // Lights completely out of the depth range don't reach any cluster
+        if (center.z + range < m_nearDistance || center.z - range > m_farDistance)
+            continue;
+
+        float minDepth = std::max(center.z - range, m_nearDistance);
+        float maxDepth = std::min(center.z + range, m_farDistance);
+        int firstSlice = static_cast<int>(std::floor(std::log(minDepth) * m_depthSliceParams.x + m_depthSliceParams.y));
+        int lastSlice = static_cast<int>(std::floor(std::log(maxDepth) * m_depthSliceParams.x + m_depthSliceParams.y));
+
+        m_lightSpheres.emplace_back(center, range);
+        m_lightSphereIndices.push_back(i);
+        // Clamping is also needed because of the rounding errors close to the slice limits. One more slice is just a few more tests
+        m_lightSphereSlices.emplace_back(std::clamp(firstSlice - 1, 0, static_cast<int>(m_dimensions.z) - 1),
+                                         std::clamp(lastSlice + 1, 0, static_cast<int>(m_dimensions.z) - 1));
+    }
+}
+
+void LightClusterGrid::AssignSlice(unsigned int slice)
+{
+    unsigned int sliceClusterCount = m_dimensions.x * m_dimensions.y;
+    unsigned int firstCluster = slice * sliceClusterCount;
+    unsigned int firstBox = slice * m_sliceStride;
+
+    for (unsigned int i = 0; i < sliceClusterCount; ++i)
+    {
+        m_clusterLights[firstCluster + i].clear();
+    }
+
+    for (unsigned int i = 0; i < m_lightSpheres.size(); ++i)
+    {
+        const glm::uvec2& sphereSlices = m_lightSphereSlices[i];
+        if (slice < sphereSlices.x || slice > sphereSlices.y)
+            continue;
+
+        const glm::vec4& sphere = m_lightSpheres[i];
+        unsigned int lightIndex = m_lightSphereIndices[i];
+
+#ifdef ITUGL_CLUSTER_SSE
+        __m128 centerX = _mm_set1_ps(sphere.x);
+        __m128 centerY = _mm_set1_ps(sphere.y);
+        __m128 centerZ = _mm_set1_ps(sphere.z);
+        __m128 radiusSqr = _mm_set1_ps(sphere.w * sphere.w);
+        __m128 zero = _mm_setzero_ps();
+#endif
+
+        for (unsigned int group = 0; group < m_sliceStride; group += 4)
+        {
+            unsigned int box = firstBox + group;
+            int mask = 0;
+
+#ifdef ITUGL_CLUSTER_SSE
+            // Distance from the center to the box, per axis. 0 if the center is inside
+            __m128 deltaX = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_boxMinX[box]), centerX), _mm_sub_ps(centerX, _mm_loadu_ps(&m_boxMaxX[box]))), zero);
+            __m128 deltaY = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_boxMinY[box]), centerY), _mm_sub_ps(centerY, _mm_loadu_ps(&m_boxMaxY[box]))), zero);
+            __m128 deltaZ = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_boxMinZ[box]), centerZ), _mm_sub_ps(centerZ, _mm_loadu_ps(&m_boxMaxZ[box]))), zero);
+            __m128 distanceSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(deltaX, deltaX), _mm_mul_ps(deltaY, deltaY)), _mm_mul_ps(deltaZ, deltaZ));
+            mask = _mm_movemask_ps(_mm_cmple_ps(distanceSqr, radiusSqr));
+#else
+            for (unsigned int j = 0; j < 4; ++j)
+            {
+                unsigned int b = box + j;
+                if (SphereIntersectsBox(sphere, m_boxMinX[b], m_boxMinY[b], m_boxMinZ[b], m_boxMaxX[b], m_boxMaxY[b], m_boxMaxZ[b]))
+                {
+                    mask |= 1 << j;
+                }
+            }
+#endif
+
+            // Lights are added in order, so the lists are sorted
+            for (unsigned int j = 0; mask; ++j, mask >>= 1)
+            {
+                if (mask & 1)
+                {
+                    m_clusterLights[firstCluster + group + j].push_back(lightIndex);
+                }
+            }
+        }
+    }
+}
+
+void LightClusterGrid::MergeClusters()
+{
+    m_lightIndices.clear();
+    for (unsigned int clusterIndex = 0; clusterIndex < GetClusterCount(); ++clusterIndex)
+    {
+        const std::vector<unsigned int>& clusterLights = m_clusterLights[clusterIndex];
+        ClusterRange& range = m_clusterRanges[clusterIndex];
+        range.offset = static_cast<unsigned int>(m_lightIndices.size());
+        range.count = static_cast<unsigned int>(clusterLights.size());
+        m_lightIndices.insert(m_lightIndices.end(), clusterLights.begin(), clusterLights.end());
+    }
+}
+
+bool LightClusterGrid::SphereIntersectsBox(const glm::vec4& sphere, float minX, float minY, float minZ, float maxX, float maxY, float maxZ)
+{
+    // Same operations, in the same order, as the SSE version
+    float deltaX = std::max(std::max(minX - sphere.x, sphere.x - maxX), 0.0f);
+    float deltaY = std::max(std::max(minY - sphere.y, sphere.y - maxY), 0.0f);
+    float deltaZ = std::max(std::max(minZ - sphere.z, sphere.z - maxZ), 0.0f);
+    float distanceSqr = (deltaX * deltaX + deltaY * deltaY) + deltaZ * deltaZ;
+    return distanceSqr <= sphere.w * sphere.w;
+}
@@ -0,0 +1,113 @@
+#include <ituGL/renderer/ClusteredDeferredRenderPass.h>
+
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/lighting/Light.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/shader/Material.h>
+#include <ituGL/texture/TextureBufferObject.h>
+#include <ituGL/core/Data.h>
+#include <glm/matrix.hpp>
+#include <cassert>
+
+ClusteredDeferredRenderPass::ClusteredDeferredRenderPass(std::shared_ptr<Material> material, std::shared_ptr<const FramebufferObject> framebuffer,
+    const glm::uvec3& clusterDimensions)
+    : RenderPass(framebuffer), m_material(material), m_lightClusterGrid(clusterDimensions)
+{
+    InitializeTextures();
+}
+
+void ClusteredDeferredRenderPass::Render()
+{
+    Renderer& renderer = GetRenderer();
+    DeviceGL& device = renderer.GetDevice();
+
+    const Camera& camera = renderer.GetCurrentCamera();
+    const auto& lights = renderer.GetLights();
+
+    m_lightClusterGrid.Build(lights, camera, &renderer.GetThreadPool());
+    UpdateTextures(lights);
+
+    device.DisableFeature(GL_DEPTH_TEST);
+
+    assert(m_material);
+    m_material->SetUniformValue("ClusterGridSize", glm::ivec3(m_lightClusterGrid.GetDimensions()));
+    m_material->SetUniformValue("ClusterDepthParams", m_lightClusterGrid.GetDepthSliceParams());
+    m_material->SetUniformValue("GlobalLightCount", static_cast<int>(m_lightClusterGrid.GetGlobalLightIndices().size()));
+    m_material->Use();
+    Renderer::ShaderProgramId shaderProgramId = renderer.GetShaderProgramId(*m_material);
+
+    // The lights come from the texture buffers. Updating with no lights sets only the indirect lighting
+    unsigned int lightIndex = 0;
+    renderer.UpdateLights(shaderProgramId, std::span<const Light* const>(), lightIndex);
+
+    // Our fullscreen triangle is directly in clip coordinates.
+    // Use the inverse view proj matrix to cancel view projection from the camera
+    renderer.UpdateTransforms(shaderProgramId, glm::inverse(camera.GetViewProjectionMatrix()));
+    renderer.GetFullscreenMesh().DrawSubmesh(0);
+
+    device.EnableFeature(GL_DEPTH_TEST);
+}
+
+void ClusteredDeferredRenderPass::InitializeTextures()
+{
+    m_lightDataTexture = std::make_shared<TextureBufferObject>();
+    m_lightIndexTexture = std::make_shared<TextureBufferObject>();
+    m_clusterTexture = std::make_shared<TextureBufferObject>();
+
+    // Textures read the current data of the buffers, so they are attached only once
+    m_lightDataTexture->Bind();
+    m_lightDataTexture->SetBuffer(TextureObject::InternalFormatRGBA32F, m_lightDataBuffer);
+    m_lightIndexTexture->Bind();
+    m_lightIndexTexture->SetBuffer(TextureObject::InternalFormatR32UI, m_lightIndexBuffer);
+    m_clusterTexture->Bind();
+    m_clusterTexture->SetBuffer(TextureObject::InternalFormatRG32UI, m_clusterBuffer);
+    TextureBufferObject::Unbind();
+
+    assert(m_material);
+    m_material->SetUniformValue("LightDataBuffer", m_lightDataTexture);
+    m_material->SetUniformValue("LightIndexBuffer", m_lightIndexTexture);
+    m_material->SetUniformValue("ClusterBuffer", m_clusterTexture);
+}
+
+void ClusteredDeferredRenderPass::UpdateTextures(std::span<const Light* const> lights)
+{
+    // Light properties, with the same meaning as the light uniforms in the other passes
+    m_lightData.clear();
+    for (const Light* light : lights)
+    {
+        m_lightData.emplace_back(light->GetColor() * light->GetIntensity(), 0.0f);
+        m_lightData.emplace_back(light->GetPosition(), 0.0f);
+        m_lightData.emplace_back(light->GetDirection(), 0.0f);
+        m_lightData.push_back(light->GetAttenuation());
+    }
+
+    // Global lights go first, so the cluster offsets skip them
+    std::span<const unsigned int> globalLightIndices = m_lightClusterGrid.GetGlobalLightIndices();
+    std::span<const unsigned int> clusterLightIndices = m_lightClusterGrid.GetLightIndices();
+    m_lightIndices.assign(globalLightIndices.begin(), globalLightIndices.end());
+    m_lightIndices.insert(m_lightIndices.end(), clusterLightIndices.begin(), clusterLightIndices.end());
+
+    unsigned int globalLightCount = static_cast<unsigned int>(globalLightIndices.size());
+    std::span<const LightClusterGrid::ClusterRange> clusterRanges = m_lightClusterGrid.GetClusterRanges();
+    m_clusterRanges.resize(clusterRanges.size());
+    for (unsigned int i = 0; i < clusterRanges.size(); ++i)
+    {
+        m_clusterRanges[i].offset = clusterRanges[i].offset + globalLightCount;
+        m_clusterRanges[i].count = clusterRanges[i].count;
+    }
+
+    // Avoid empty buffers
+    if (m_lightData.empty())
+        m_lightData.emplace_back(0.0f);
+    if (m_lightIndices.empty())
+        m_lightIndices.push_back(0);
+
+    // Allocate again every frame, so the driver doesn't wait for the previous frame to finish reading
+    m_lightDataBuffer.Bind();
+    m_lightDataBuffer.AllocateData(Data::GetBytes(std::span<const glm::vec4>(m_lightData)), BufferObject::StreamDraw);
+    m_lightIndexBuffer.Bind();
+    m_lightIndexBuffer.AllocateData(Data::GetBytes(std::span<const unsigned int>(m_lightIndices)), BufferObject::StreamDraw);
+    m_clusterBuffer.Bind();
+    m_clusterBuffer.AllocateData(Data::GetBytes(std::span<const LightClusterGrid::ClusterRange>(m_clusterRanges)), BufferObject::StreamDraw);
+    BufferObjectBase<BufferObject::TextureBuffer>::Unbind();
+}
@@ -7,6 +7,16 @@
 #include <ituGL/shader/Material.h>
 #include <ituGL/texture/Texture2DObject.h>
 #include <glm/gtx/transform.hpp>
+#include <glm/gtc/constants.hpp>
+#include <vector>
+
+// Tesselation of the light volume meshes
+static constexpr unsigned int s_sphereSectors = 16;
+static constexpr unsigned int s_sphereStacks = 8;
+static constexpr unsigned int s_coneSectors = 16;
+
+// Spot lights wider than this use the sphere, the cone would be too flat to save anything
+static constexpr float s_maxConeAngle = glm::pi<float>() / 3.0f;
 
 DeferredRenderPass::DeferredRenderPass(std::shared_ptr<Material> material, std::shared_ptr<const FramebufferObject> framebuffer)
     : RenderPass(framebuffer), m_material(material)
@@ -17,24 +27,29 @@ DeferredRenderPass::DeferredRenderPass(std::shared_ptr<Material> material, std::
 void DeferredRenderPass::Render()
 {
     Renderer& renderer = GetRenderer();
+    DeviceGL& device = renderer.GetDevice();
 
-    //TODO: temp hack
-    renderer.GetDevice().DisableFeature(GL_DEPTH_TEST);
+    // Lights don't test against the scene depth, the shader attenuation discards the pixels out of range
+    device.DisableFeature(GL_DEPTH_TEST);
 
     const Camera& camera = renderer.GetCurrentCamera();
+    glm::mat4 viewProjMatrix = camera.GetViewProjectionMatrix();
+
+    glm::ivec4 viewport;
+    device.GetViewport(viewport.x, viewport.y, viewport.z, viewport.w);
 
     assert(m_material);
     m_material->Use();
-    std::shared_ptr<const ShaderProgram> shaderProgram = m_material->GetShaderProgram();
+    Renderer::ShaderProgramId shaderProgramId = renderer.GetShaderProgramId(*m_material);
 
     // Our fullscreen triangle is directly in clip coordinates.
     // Use the inverse view proj matrix to cancel view projection from the camera
-    glm::mat4 fullscreenMatrix = glm::inverse(camera.GetViewProjectionMatrix());
+    glm::mat4 fullscreenMatrix = glm::inverse(viewProjMatrix);
 
     bool first = true;
     unsigned int lightIndex = 0;
     const auto& lights = renderer.GetLights();
-    while (renderer.UpdateLights(shaderProgram, lights, lightIndex))
+    while (renderer.UpdateLights(shaderProgramId, lights, lightIndex))
     {
         const Light* light = lightIndex <= lights.size() ? lights[lightIndex - 1] : nullptr;
         assert(first || light);
@@ -42,21 +57,181 @@ void DeferredRenderPass::Render()
         const Mesh* mesh = &renderer.GetFullscreenMesh();
         glm::mat4 worldMatrix = fullscreenMatrix;
 
-        // TODO: select different meshes depending on the type
+        // The first light also adds the indirect lighting, so it always covers the whole screen
+        bool volume = !first && GetLightVolume(*light, mesh, worldMatrix);
+        if (volume)
+        {
+            // Skip the light if its range is out of the screen
+            glm::ivec4 scissorRect;
+            if (!ComputeScissorRect(viewProjMatrix, light->GetPosition(), light->GetAttenuation().y, viewport, scissorRect))
+                continue;
+
+            glScissor(scissorRect.x, scissorRect.y, scissorRect.z, scissorRect.w);
+        }
 
         // Set the render states for the first and additional lights
         renderer.SetLightingRenderStates(first);
 
-        renderer.UpdateTransforms(shaderProgram, fullscreenMatrix, first);
+        // Draw the back faces of the volumes, so they are still drawn when the camera is inside.
+        // Depth clamp keeps the back faces beyond the far plane
+        glCullFace(volume ? GL_FRONT : GL_BACK);
+        device.SetFeatureEnabled(GL_DEPTH_CLAMP, volume);
+        device.SetFeatureEnabled(GL_SCISSOR_TEST, volume);
+
+        renderer.UpdateTransforms(shaderProgramId, worldMatrix, first);
         mesh->DrawSubmesh(0);
         first = false;
     }
 
-    //TODO: temp hack
-    renderer.GetDevice().EnableFeature(GL_DEPTH_TEST);
+    glCullFace(GL_BACK);
+    device.DisableFeature(GL_DEPTH_CLAMP);
+    device.DisableFeature(GL_SCISSOR_TEST);
+    device.EnableFeature(GL_DEPTH_TEST);
+}
+
+bool DeferredRenderPass::GetLightVolume(const Light& light, const Mesh*& mesh, glm::mat4& worldMatrix) const
+{
+    // Distance where the light fades out completely. Without it, the light reaches everywhere
+    glm::vec4 attenuation = light.GetAttenuation();
+    float range = attenuation.y;
+    if (light.GetType() == Light::Type::Directional || range <= 0.0f)
+        return false;
+
+    glm::vec3 position = light.GetPosition();
+
+    float angle = attenuation.w;
+    if (light.GetType() == Light::Type::Spot && angle > 0.0f && angle < s_maxConeAngle)
+    {
+        // The angular attenuation in the shader lights the points in the opposite side of the light direction
+        glm::vec3 axis = -light.GetDirection();
+        glm::vec3 up = std::abs(axis.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        glm::vec3 right = glm::normalize(glm::cross(up, axis));
+        up = glm::cross(axis, right);
+
+        // Cone with the apex in the light position. The base radius covers the angle at the full range
+        float radius = range * std::tan(angle);
+        worldMatrix = glm::mat4(glm::vec4(right * radius, 0.0f), glm::vec4(up * radius, 0.0f), glm::vec4(axis * range, 0.0f), glm::vec4(position, 1.0f));
+        mesh = &m_coneMesh;
+    }
+    else
+    {
+        worldMatrix = glm::translate(position) * glm::scale(glm::vec3(range));
+        mesh = &m_sphereMesh;
+    }
+
+    return true;
+}
+
+bool DeferredRenderPass::ComputeScissorRect(const glm::mat4& viewProjMatrix, const glm::vec3& center, float radius, const glm::ivec4& viewport, glm::ivec4& scissorRect)
+{
+    glm::vec2 ndcMin(1.0f);
+    glm::vec2 ndcMax(-1.0f);
+    unsigned int behindCount = 0;
+
+    // Project the corners of the box around the sphere
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        glm::vec3 corner = center + radius * glm::vec3(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f);
+        glm::vec4 clipCorner = viewProjMatrix * glm::vec4(corner, 1.0f);
+        if (clipCorner.w <= 0.0f)
+        {
+            behindCount++;
+            continue;
+        }
+        glm::vec2 ndcCorner = glm::vec2(clipCorner) / clipCorner.w;
+        ndcMin = glm::min(ndcMin, ndcCorner);
+        ndcMax = glm::max(ndcMax, ndcCorner);
+    }
+
+    // Completely behind the camera
+    if (behindCount == 8)
+        return false;
+
+    // Crossing the camera plane, the projection is not bounded
+    if (behindCount > 0)
+    {
+        scissorRect = viewport;
+        return true;
+    }
+
+    ndcMin = glm::max(ndcMin, glm::vec2(-1.0f));
+    ndcMax = glm::min(ndcMax, glm::vec2(1.0f));
+    if (ndcMin.x >= ndcMax.x || ndcMin.y >= ndcMax.y)
+        return false;
+
+    // Convert to pixels, rounding outwards
+    glm::vec2 viewportOffset(viewport.x, viewport.y);
+    glm::vec2 viewportSize(viewport.z, viewport.w);
+    glm::ivec2 pixelMin = glm::floor(viewportOffset + (ndcMin * 0.5f + 0.5f) * viewportSize);
+    glm::ivec2 pixelMax = glm::ceil(viewportOffset + (ndcMax * 0.5f + 0.5f) * viewportSize);
+    scissorRect = glm::ivec4(pixelMin, pixelMax - pixelMin);
+
+    return true;
 }
 
 void DeferredRenderPass::InitializeMeshes()
 {
-    //TODO: Create meshes for spot and point lights
+    VertexFormat vertexFormat;
+    vertexFormat.AddVertexAttribute<float>(3, VertexAttribute::Semantic::Position);
+
+    // Sphere
+    {
+        // Push the vertices out, so the flat faces contain the sphere
+        float scale = 1.0f / (std::cos(glm::pi<float>() / s_sphereSectors) * std::cos(glm::pi<float>() / (2 * s_sphereStacks)));
+
+        std::vector<glm::vec3> vertices;
+        for (unsigned int i = 0; i <= s_sphereStacks; ++i)
+        {
+            float phi = glm::pi<float>() * i / s_sphereStacks;
+            for (unsigned int j = 0; j <= s_sphereSectors; ++j)
+            {
+                float theta = glm::two_pi<float>() * j / s_sphereSectors;
+                vertices.push_back(scale * glm::vec3(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta)));
+            }
+        }
+
+        // Counter-clockwise from the outside
+        std::vector<unsigned short> indices;
+        for (unsigned int i = 0; i < s_sphereStacks; ++i)
+        {
+            for (unsigned int j = 0; j < s_sphereSectors; ++j)
+            {
+                unsigned short k1 = i * (s_sphereSectors + 1) + j;
+                unsigned short k2 = k1 + s_sphereSectors + 1;
+                indices.insert(indices.end(), { k1, static_cast<unsigned short>(k1 + 1), k2 });
+                indices.insert(indices.end(), { static_cast<unsigned short>(k1 + 1), static_cast<unsigned short>(k2 + 1), k2 });
+            }
+        }
+
+        m_sphereMesh.AddSubmesh<glm::vec3, unsigned short, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles, vertices, indices,
+            vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), false), vertexFormat.LayoutEnd());
+    }
+
+    // Cone, with the apex in the origin and the base at Z = 1
+    {
+        // Push the base vertices out, so the flat faces contain the round cone
+        float scale = 1.0f / std::cos(glm::pi<float>() / s_coneSectors);
+
+        std::vector<glm::vec3> vertices;
+        vertices.emplace_back(0.0f, 0.0f, 0.0f);
+        vertices.emplace_back(0.0f, 0.0f, 1.0f);
+        for (unsigned int j = 0; j < s_coneSectors; ++j)
+        {
+            float theta = glm::two_pi<float>() * j / s_coneSectors;
+            vertices.emplace_back(scale * std::cos(theta), scale * std::sin(theta), 1.0f);
+        }
+
+        // Counter-clockwise from the outside
+        std::vector<unsigned short> indices;
+        for (unsigned int j = 0; j < s_coneSectors; ++j)
+        {
+            unsigned short current = 2 + j;
+            unsigned short next = 2 + (j + 1) % s_coneSectors;
+            indices.insert(indices.end(), { 0, next, current });
+            indices.insert(indices.end(), { 1, current, next });
+        }
+
+        m_coneMesh.AddSubmesh<glm::vec3, unsigned short, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles, vertices, indices,
+            vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), false), vertexFormat.LayoutEnd());
+    }
 }
@@ -0,0 +1,108 @@
+#include <ituGL/renderer/DynamicResolutionController.h>
+
+#include <ituGL/utils/Profiler.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+// Fraction of the distance to the ideal scale covered in each update, going down and up
+static const float s_decreaseRate = 0.75f;
+static const float s_increaseRate = 0.1f;
+// Changes smaller than this are ignored
+static const float s_minScaleChange = 0.02f;
+// Part of the budget the scale aims for
+static const double s_headroom = 0.9;
+
+DynamicResolutionController::DynamicResolutionController(double targetFrameTime, float minScale, float maxScale)
+    : m_targetFrameTime(targetFrameTime)
+    , m_minScale(minScale)
+    , m_maxScale(maxScale)
+    , m_scale(maxScale)
+    , m_gpuFrameTime(0.0)
+    , m_lastFrameIndex(0)
+    , m_scaleFrameIndex(0)
+{
+    assert(targetFrameTime > 0.0);
+    assert(minScale > 0.0f && minScale <= maxScale && maxScale <= 1.0f);
+}
+
+void DynamicResolutionController::SetTargetFrameTime(double targetFrameTime)
+{
+    assert(targetFrameTime > 0.0);
+    m_targetFrameTime = targetFrameTime;
+}
+
+void DynamicResolutionController::SetScaleBounds(float minScale, float maxScale)
+{
+    assert(minScale > 0.0f && minScale <= maxScale && maxScale <= 1.0f);
+    m_minScale = minScale;
+    m_maxScale = maxScale;
+    m_scale = std::clamp(m_scale, minScale, maxScale);
+}
+
+float DynamicResolutionController::Update(const Profiler& profiler)
+{
+    // Newest frame with GPU results. Frame 0 has the initialization, not a rendered frame
+    const auto& frames = profiler.GetFrames();
+    for (auto itFrame = frames.rbegin(); itFrame != frames.rend(); ++itFrame)
+    {
+        if (itFrame->index <= m_lastFrameIndex || itFrame->index < m_scaleFrameIndex)
+        {
+            break;
+        }
+        if (itFrame->gpuResolved && !itFrame->gpuEvents.empty())
+        {
+            m_lastFrameIndex = itFrame->index;
+
+            // Markers at depth 0 don't overlap, so their sum is the time the GPU spent in the frame
+            double gpuFrameTime = 0.0;
+            for (const Profiler::Event& event : itFrame->gpuEvents)
+            {
+                if (event.depth == 0)
+                {
+                    gpuFrameTime += event.duration;
+                }
+            }
+            // Microseconds to milliseconds. The new scale is used from the next frame, if this one already started
+            float previousScale = m_scale;
+            Update(gpuFrameTime * 0.001);
+            if (m_scale != previousScale)
+            {
+                m_scaleFrameIndex = frames.back().index + 1;
+            }
+            return m_scale;
+        }
+    }
+    return m_scale;
+}
+
+float DynamicResolutionController::Update(double gpuFrameTime)
+{
+    m_gpuFrameTime = gpuFrameTime;
+    if (gpuFrameTime <= 0.0)
+    {
+        return m_scale;
+    }
+
+    // Aim a bit under the budget, to leave room for variations of the load
+    float idealScale = m_scale * static_cast<float>(std::sqrt(m_targetFrameTime * s_headroom / gpuFrameTime));
+    idealScale = std::clamp(idealScale, m_minScale, m_maxScale);
+    float scaleChange = idealScale - m_scale;
+
+    // Small changes are ignored, unless the frame is over the budget or they reach the bounds
+    bool overBudget = gpuFrameTime > m_targetFrameTime;
+    bool isBound = idealScale == m_minScale || idealScale == m_maxScale;
+    if (!overBudget && !isBound && std::abs(scaleChange) < s_minScaleChange)
+    {
+        return m_scale;
+    }
+
+    // Steps are never smaller than the ignored changes, so the ideal scale is always reached
+    float step = scaleChange * (scaleChange < 0.0f ? s_decreaseRate : s_increaseRate);
+    if (std::abs(step) < s_minScaleChange)
+    {
+        step = std::clamp(scaleChange, -s_minScaleChange, s_minScaleChange);
+    }
+    m_scale += step;
+    return m_scale;
+}
@@ -1,9 +1,9 @@
 #include <ituGL/renderer/ForwardRenderPass.h>
 
-#include <ituGL/camera/Camera.h>
-#include <ituGL/shader/Material.h>
-#include <ituGL/geometry/VertexArrayObject.h>
 #include <ituGL/renderer/Renderer.h>
+#include <ituGL/geometry/MeshPool.h>
+#include <ituGL/shader/Material.h>
+#include <ituGL/utils/Profiler.h>
 
 ForwardRenderPass::ForwardRenderPass()
     : ForwardRenderPass(0)
@@ -12,37 +12,79 @@ ForwardRenderPass::ForwardRenderPass()
 
 ForwardRenderPass::ForwardRenderPass(int drawcallCollectionIndex)
     : m_drawcallCollectionIndex(drawcallCollectionIndex)
+    , m_static(false)
+    , m_meshPoolGeneration(0)
+    , m_multiDraw(false)
 {
 }
 
+void ForwardRenderPass::SetStatic(bool isStatic)
+{
+    m_static = isStatic;
+    m_commandBuffers.clear();
+    m_depthPrepassCommandBuffers.clear();
+}
+
+void ForwardRenderPass::SetMultiDrawEnabled(bool enabled)
+{
+    m_multiDraw = enabled;
+    m_commandBuffers.clear();
+}
+
+void ForwardRenderPass::SetDepthPrepassMaterial(std::shared_ptr<const Material> depthMaterial)
+{
+    m_depthPrepassMaterial = depthMaterial;
+    m_commandBuffers.clear();
+    m_depthPrepassCommandBuffers.clear();
+}
+
 void ForwardRenderPass::Render()
 {
     Renderer& renderer = GetRenderer();
+    bool record = !m_static || m_commandBuffers.empty() || m_meshPoolGeneration != MeshPool::GetDefragmentGeneration();
+    m_meshPoolGeneration = MeshPool::GetDefragmentGeneration();
 
-    const Camera& camera = renderer.GetCurrentCamera();
-    const auto& lights = renderer.GetLights();
-    const auto& drawcallCollection = renderer.GetDrawcalls(m_drawcallCollectionIndex);
-
-    // for all drawcalls
-    for (const Renderer::DrawcallInfo& drawcallInfo : drawcallCollection)
+    // The opaque drawcalls keep the depth states set here, instead of the ones of their materials
+    Material::OverrideFlags opaqueMaterialOverride = Material::NoOverride;
+    if (m_depthPrepassMaterial)
     {
-        // Prepare drawcall states
-        renderer.PrepareDrawcall(drawcallInfo);
-
-        std::shared_ptr<const ShaderProgram> shaderProgram = drawcallInfo.GetMaterial().GetShaderProgram();
+        if (record)
+        {
+            renderer.RecordDepthPrepass(m_depthPrepassCommandBuffers, m_drawcallCollectionIndex, *m_depthPrepassMaterial);
+        }
 
-        //for all lights
-        bool first = true;
-        unsigned int lightIndex = 0;
-        while (renderer.UpdateLights(shaderProgram, lights, lightIndex))
         {
-            // Set the renderstates
-            renderer.SetLightingRenderStates(first);
+            Profiler::Scope scope("Depth pre-pass", true);
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            for (RenderCommandBuffer& commandBuffer : m_depthPrepassCommandBuffers)
+            {
+                renderer.ExecuteCommandBuffer(commandBuffer);
+            }
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        }
 
-            // Draw
-            drawcallInfo.GetDrawcall().Draw();
+        // Only the closest surfaces pass, and the depth is already written
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+        opaqueMaterialOverride = Material::OverrideDepthTest;
+    }
 
-            first = false;
-        }
+    // Record the drawcall batches, drawn once per light
+    if (record)
+    {
+        renderer.RecordDrawcallCollection(m_commandBuffers, m_drawcallCollectionIndex, true, Material::NoOverride, opaqueMaterialOverride, m_multiDraw);
+    }
+
+    for (RenderCommandBuffer& commandBuffer : m_commandBuffers)
+    {
+        renderer.ExecuteCommandBuffer(commandBuffer);
+    }
+
+    if (m_depthPrepassMaterial)
+    {
+        // Restore default values
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+        renderer.InvalidateStateCache();
     }
 }
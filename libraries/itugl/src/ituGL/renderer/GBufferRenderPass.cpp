@@ -4,16 +4,40 @@
 #include <ituGL/shader/Material.h>
 #include <ituGL/geometry/VertexArrayObject.h>
 #include <ituGL/renderer/Renderer.h>
+#include <ituGL/geometry/MeshPool.h>
 #include <ituGL/texture/Texture2DObject.h>
 #include <ituGL/texture/FramebufferObject.h>
 
 GBufferRenderPass::GBufferRenderPass(int width, int height, int drawcallCollectionIndex)
     : m_drawcallCollectionIndex(drawcallCollectionIndex)
+    , m_static(false)
+    , m_meshPoolGeneration(0)
+    , m_multiDraw(false)
 {
     InitTextures(width, height);
     InitFramebuffer();
 }
 
+GBufferRenderPass::GBufferRenderPass(int drawcallCollectionIndex)
+    : m_drawcallCollectionIndex(drawcallCollectionIndex)
+    , m_static(false)
+    , m_meshPoolGeneration(0)
+    , m_multiDraw(false)
+{
+}
+
+void GBufferRenderPass::SetStatic(bool isStatic)
+{
+    m_static = isStatic;
+    m_commandBuffers.clear();
+}
+
+void GBufferRenderPass::SetMultiDrawEnabled(bool enabled)
+{
+    m_multiDraw = enabled;
+    m_commandBuffers.clear();
+}
+
 void GBufferRenderPass::InitFramebuffer()
 {
     std::shared_ptr<FramebufferObject> targetFramebuffer = std::make_shared<FramebufferObject>();
@@ -81,28 +105,29 @@ void GBufferRenderPass::Render()
 {
     Renderer& renderer = GetRenderer();
 
-    const Camera& camera = renderer.GetCurrentCamera();
-    const auto& lights = renderer.GetLights();
-    const auto& drawcallCollection = renderer.GetDrawcalls(m_drawcallCollectionIndex);
-
     renderer.GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), true, 1.0f);
 
     bool wasSRGB = renderer.GetDevice().IsFeatureEnabled(GL_FRAMEBUFFER_SRGB);
     renderer.GetDevice().EnableFeature(GL_FRAMEBUFFER_SRGB);
 
-    // for all drawcalls
-    for (const Renderer::DrawcallInfo& drawcallInfo : drawcallCollection)
+    // Record the drawcall batches, without lighting
+    if (!m_static || m_commandBuffers.empty() || m_meshPoolGeneration != MeshPool::GetDefragmentGeneration())
     {
-        const Material& material = drawcallInfo.GetMaterial();
-        assert(material.GetBlendEquationColor() == Material::BlendEquation::None);
-        assert(material.GetBlendEquationAlpha() == Material::BlendEquation::None);
-        assert(material.GetDepthWrite());
+        m_meshPoolGeneration = MeshPool::GetDefragmentGeneration();
+        for (const Renderer::DrawcallInfo& drawcallInfo : renderer.GetDrawcalls(m_drawcallCollectionIndex))
+        {
+            [[maybe_unused]] const Material& material = drawcallInfo.GetMaterial();
+            assert(material.GetBlendEquationColor() == Material::BlendEquation::None);
+            assert(material.GetBlendEquationAlpha() == Material::BlendEquation::None);
+            assert(material.GetDepthWrite());
+        }
 
-        // Prepare drawcall (similar to forward)
-        renderer.PrepareDrawcall(drawcallInfo);
+        renderer.RecordDrawcallCollection(m_commandBuffers, m_drawcallCollectionIndex, false, Material::NoOverride, Material::NoOverride, m_multiDraw);
+    }
 
-        // Render drawcall
-        drawcallInfo.GetDrawcall().Draw();
+    for (RenderCommandBuffer& commandBuffer : m_commandBuffers)
+    {
+        renderer.ExecuteCommandBuffer(commandBuffer);
     }
 
     renderer.GetDevice().SetFeatureEnabled(GL_FRAMEBUFFER_SRGB, wasSRGB);
@@ -0,0 +1,107 @@
+#include <ituGL/renderer/RenderCommandBuffer.h>
+
+#include <ituGL/geometry/VertexBufferObject.h>
+
+RenderCommandBuffer::RenderCommandBuffer()
+    : m_commandCount(0)
+    , m_instanceBufferDirty(false)
+    , m_indirectBufferDirty(false)
+{
+    InvalidateStates();
+}
+
+RenderCommandBuffer::~RenderCommandBuffer()
+{
+}
+
+RenderCommandBuffer::RenderCommandBuffer(RenderCommandBuffer&&) noexcept = default;
+
+RenderCommandBuffer& RenderCommandBuffer::operator = (RenderCommandBuffer&&) noexcept = default;
+
+void RenderCommandBuffer::Clear()
+{
+    ClearCommands();
+    InvalidateStates();
+    m_cameraUpdatedShaderPrograms.clear();
+
+    m_instanceWorldMatrices.clear();
+    m_instanceBufferDirty = true;
+
+    m_indirectCommands.clear();
+    m_indirectBufferDirty = true;
+}
+
+unsigned int RenderCommandBuffer::AddInstanceWorldMatrices(std::span<const glm::mat4> worldMatrices)
+{
+    unsigned int firstInstance = static_cast<unsigned int>(m_instanceWorldMatrices.size());
+    m_instanceWorldMatrices.insert(m_instanceWorldMatrices.end(), worldMatrices.begin(), worldMatrices.end());
+    m_instanceBufferDirty = true;
+    return firstInstance;
+}
+
+unsigned int RenderCommandBuffer::AddIndirectCommand(const DrawElementsIndirectCommand& indirectCommand)
+{
+    unsigned int index = static_cast<unsigned int>(m_indirectCommands.size());
+    m_indirectCommands.push_back(indirectCommand);
+    m_indirectBufferDirty = true;
+    return index;
+}
+
+void RenderCommandBuffer::ClearCommands()
+{
+    m_data.clear();
+    m_commandCount = 0;
+    m_stateChangeCounters = Renderer::StateChangeCounters();
+}
+
+void RenderCommandBuffer::InvalidateStates()
+{
+    m_lastShaderProgram = nullptr;
+    m_lastMaterial = nullptr;
+    m_lastMaterialOverride = Material::NoOverride;
+    m_lastVAO = nullptr;
+    m_lastWorldMatrixIndex = 0;
+}
+
+const VertexBufferObject* RenderCommandBuffer::GetInstanceBuffer()
+{
+    if (m_instanceBufferDirty && !m_instanceWorldMatrices.empty())
+    {
+        if (!m_instanceBuffer)
+        {
+            m_instanceBuffer = std::make_unique<VertexBufferObject>();
+        }
+        m_instanceBuffer->Bind();
+        m_instanceBuffer->AllocateData(std::span<const glm::mat4>(m_instanceWorldMatrices), BufferObject::Usage::StaticDraw);
+        VertexBufferObject::Unbind();
+    }
+    m_instanceBufferDirty = false;
+
+    return m_instanceBuffer.get();
+}
+
+const RenderCommandBuffer::IndirectBufferObject* RenderCommandBuffer::GetIndirectBuffer()
+{
+    if (m_indirectBufferDirty && !m_indirectCommands.empty())
+    {
+        if (!m_indirectBuffer)
+        {
+            m_indirectBuffer = std::make_unique<IndirectBufferObject>();
+        }
+        m_indirectBuffer->Bind();
+        m_indirectBuffer->AllocateData(Data::GetBytes(std::span<const DrawElementsIndirectCommand>(m_indirectCommands)), BufferObject::Usage::StaticDraw);
+        IndirectBufferObject::Unbind();
+    }
+    m_indirectBufferDirty = false;
+
+    return m_indirectBuffer.get();
+}
+
+RenderCommandBuffer::CommandType RenderCommandBuffer::Reader::GetType() const
+{
+    assert(HasCommands());
+
+    CommandType type;
+    std::memcpy(&type, m_data.data() + m_offset, sizeof(type));
+    return type;
+}
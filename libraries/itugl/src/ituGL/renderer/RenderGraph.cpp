@@ -0,0 +1,416 @@
+#include <ituGL/renderer/RenderGraph.h>
+
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/texture/FramebufferObject.h>
+#include <ituGL/shader/Material.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+RenderGraph::RenderGraph(int width, int height) : m_width(width), m_height(height), m_resolutionScale(1.0f), m_dirty(true)
+{
+    // Resource 0 is the backbuffer. It has no texture
+    Resource& backbuffer = m_resources.emplace_back();
+    backbuffer.name = "Backbuffer";
+    backbuffer.imported = true;
+    backbuffer.width = width;
+    backbuffer.height = height;
+    backbuffer.firstPass = backbuffer.lastPass = -1;
+}
+
+RenderGraph::~RenderGraph()
+{
+}
+
+RenderGraph::ResourceId RenderGraph::CreateTexture(const char* name, const TextureDesc& desc)
+{
+    ResourceId id = static_cast<ResourceId>(m_resources.size());
+    Resource& resource = m_resources.emplace_back();
+    resource.name = name;
+    resource.desc = desc;
+    resource.imported = false;
+    resource.width = resource.height = 0;
+    resource.firstPass = resource.lastPass = -1;
+    m_dirty = true;
+    return id;
+}
+
+RenderGraph::ResourceId RenderGraph::ImportTexture(const char* name, std::shared_ptr<Texture2DObject> texture, TextureObject::Format format)
+{
+    assert(texture);
+
+    ResourceId id = static_cast<ResourceId>(m_resources.size());
+    Resource& resource = m_resources.emplace_back();
+    resource.name = name;
+    resource.desc.format = format;
+    resource.imported = true;
+    resource.texture = texture;
+    resource.width = m_width;
+    resource.height = m_height;
+    resource.firstPass = resource.lastPass = -1;
+    m_dirty = true;
+    return id;
+}
+
+unsigned int RenderGraph::AddPass(std::unique_ptr<RenderPass> renderPass)
+{
+    assert(renderPass);
+
+    unsigned int passIndex = static_cast<unsigned int>(m_passes.size());
+    Pass& pass = m_passes.emplace_back();
+    pass.renderPass = std::move(renderPass);
+    pass.culled = false;
+    pass.width = pass.height = 0;
+    m_dirty = true;
+    return passIndex;
+}
+
+void RenderGraph::ReadTexture(unsigned int passIndex, ResourceId resource, std::shared_ptr<Material> material, const char* uniformName)
+{
+    assert(passIndex < m_passes.size());
+    assert(resource < m_resources.size() && resource != Backbuffer);
+    assert(!material || uniformName);
+
+    ReadBinding& binding = m_passes[passIndex].reads.emplace_back();
+    binding.resource = resource;
+    binding.material = material;
+    binding.uniformName = uniformName ? uniformName : "";
+    m_dirty = true;
+}
+
+void RenderGraph::WriteTexture(unsigned int passIndex, ResourceId resource)
+{
+    assert(passIndex < m_passes.size());
+    assert(resource < m_resources.size());
+
+    m_passes[passIndex].writes.push_back(resource);
+    m_dirty = true;
+}
+
+void RenderGraph::SetSize(int width, int height)
+{
+    if (width != m_width || height != m_height)
+    {
+        m_width = width;
+        m_height = height;
+        m_dirty = true;
+    }
+}
+
+void RenderGraph::SetResolutionScale(float resolutionScale)
+{
+    assert(resolutionScale > 0.0f && resolutionScale <= 1.0f);
+    m_resolutionScale = resolutionScale;
+}
+
+std::shared_ptr<Texture2DObject> RenderGraph::GetTexture(ResourceId resource) const
+{
+    assert(resource < m_resources.size());
+    return m_resources[resource].texture;
+}
+
+bool RenderGraph::IsPassCulled(unsigned int passIndex) const
+{
+    assert(passIndex < m_passes.size());
+    return m_passes[passIndex].culled;
+}
+
+std::size_t RenderGraph::GetPoolMemorySize() const
+{
+    std::size_t size = 0;
+    for (const PoolTexture& poolTexture : m_texturePool)
+    {
+        // Components are counted as 4 bytes, except for the common half float and 8 bit formats
+        std::size_t texelSize = 4;
+        switch (poolTexture.internalFormat)
+        {
+        case TextureObject::InternalFormatRGBA16F:
+            texelSize = 8;
+            break;
+        case TextureObject::InternalFormatRGBA32F:
+            texelSize = 16;
+            break;
+        case TextureObject::InternalFormatRGB16F:
+            texelSize = 6;
+            break;
+        case TextureObject::InternalFormatRG16F:
+        case TextureObject::InternalFormatR32F:
+        case TextureObject::InternalFormatRGBA8:
+            texelSize = 4;
+            break;
+        case TextureObject::InternalFormatR16F:
+            texelSize = 2;
+            break;
+        default:
+            break;
+        }
+        size += texelSize * poolTexture.width * poolTexture.height;
+    }
+    return size;
+}
+
+void RenderGraph::Render()
+{
+    if (m_dirty)
+    {
+        Compile();
+    }
+
+    Renderer& renderer = GetRenderer();
+    DeviceGL& device = renderer.GetDevice();
+
+    GLint viewportX, viewportY;
+    GLsizei viewportWidth, viewportHeight;
+    device.GetViewport(viewportX, viewportY, viewportWidth, viewportHeight);
+
+    // Rounded for the full size textures, so their texels match the pixels of the passes exactly
+    int scaledWidth = std::max(static_cast<int>(std::lround(m_width * m_resolutionScale)), 1);
+    int scaledHeight = std::max(static_cast<int>(std::lround(m_height * m_resolutionScale)), 1);
+    glm::vec2 resolutionScale(static_cast<float>(scaledWidth) / m_width, static_cast<float>(scaledHeight) / m_height);
+    renderer.SetResolutionScale(resolutionScale);
+
+    for (Pass& pass : m_passes)
+    {
+        if (!pass.culled)
+        {
+            // Transient textures can be smaller than the backbuffer, and only a part of them is rendered
+            // Passes without framebuffer write the backbuffer
+            int width = pass.width;
+            int height = pass.height;
+            if (pass.framebuffer)
+            {
+                width = std::max(static_cast<int>(std::lround(width * resolutionScale.x)), 1);
+                height = std::max(static_cast<int>(std::lround(height * resolutionScale.y)), 1);
+            }
+            device.SetViewport(0, 0, width, height);
+            renderer.ExecuteRenderPass(*pass.renderPass);
+        }
+    }
+
+    renderer.SetResolutionScale(glm::vec2(1.0f));
+    device.SetViewport(viewportX, viewportY, viewportWidth, viewportHeight);
+}
+
+void RenderGraph::Compile()
+{
+    CullPasses();
+    AssignTextures();
+    InitializeFramebuffers();
+
+    // Textures are fixed until the next compilation, so they are assigned to the materials only once
+    for (Pass& pass : m_passes)
+    {
+        for (ReadBinding& binding : pass.reads)
+        {
+            if (!pass.culled && binding.material)
+            {
+                binding.material->SetUniformValue(binding.uniformName.c_str(), m_resources[binding.resource].texture);
+            }
+        }
+    }
+
+    m_dirty = false;
+}
+
+void RenderGraph::CullPasses()
+{
+    // Walk the passes backwards, keeping the resources that are needed by the passes already visited
+    std::vector<bool> needed(m_resources.size(), false);
+    for (auto itPass = m_passes.rbegin(); itPass != m_passes.rend(); ++itPass)
+    {
+        Pass& pass = *itPass;
+
+        // Passes are needed if they write something outside the graph, or something needed later
+        bool isNeeded = false;
+        for (ResourceId resource : pass.writes)
+        {
+            isNeeded |= m_resources[resource].imported || needed[resource];
+        }
+        pass.culled = !isNeeded;
+
+        if (isNeeded)
+        {
+            // Writes replace the previous content, unless the pass reads it too
+            for (ResourceId resource : pass.writes)
+            {
+                needed[resource] = false;
+            }
+            for (const ReadBinding& binding : pass.reads)
+            {
+                needed[binding.resource] = true;
+            }
+        }
+    }
+}
+
+void RenderGraph::AssignTextures()
+{
+    // Lifetimes of the transient resources, from the first to the last pass that uses them
+    for (Resource& resource : m_resources)
+    {
+        resource.firstPass = resource.lastPass = -1;
+        if (resource.imported)
+        {
+            resource.width = m_width;
+            resource.height = m_height;
+        }
+        else
+        {
+            resource.texture = nullptr;
+            resource.width = std::max(static_cast<int>(m_width * resource.desc.scale.x), 1);
+            resource.height = std::max(static_cast<int>(m_height * resource.desc.scale.y), 1);
+        }
+    }
+    for (int passIndex = 0; passIndex < static_cast<int>(m_passes.size()); ++passIndex)
+    {
+        const Pass& pass = m_passes[passIndex];
+        if (pass.culled)
+        {
+            continue;
+        }
+
+        auto useResource = [&](ResourceId resourceId)
+        {
+            Resource& resource = m_resources[resourceId];
+            if (resource.firstPass < 0)
+            {
+                resource.firstPass = passIndex;
+            }
+            resource.lastPass = passIndex;
+        };
+        for (const ReadBinding& binding : pass.reads)
+        {
+            useResource(binding.resource);
+        }
+        for (ResourceId resource : pass.writes)
+        {
+            useResource(resource);
+        }
+    }
+
+    for (PoolTexture& poolTexture : m_texturePool)
+    {
+        poolTexture.inUse = false;
+        poolTexture.used = false;
+    }
+
+    // Take the textures from the pool at the start of each lifetime, and give them back at the end
+    for (int passIndex = 0; passIndex < static_cast<int>(m_passes.size()); ++passIndex)
+    {
+        for (Resource& resource : m_resources)
+        {
+            if (!resource.imported && resource.firstPass == passIndex)
+            {
+                resource.texture = AcquireTexture(resource);
+            }
+        }
+        for (Resource& resource : m_resources)
+        {
+            if (!resource.imported && resource.lastPass == passIndex)
+            {
+                ReleaseTexture(resource.texture);
+            }
+        }
+    }
+
+    // Textures not used anymore (for instance, after a resize) are freed
+    std::erase_if(m_texturePool, [](const PoolTexture& poolTexture) { return !poolTexture.used; });
+}
+
+void RenderGraph::InitializeFramebuffers()
+{
+    for (Pass& pass : m_passes)
+    {
+        pass.framebuffer = nullptr;
+        pass.width = m_width;
+        pass.height = m_height;
+        if (pass.culled)
+        {
+            continue;
+        }
+
+        // Passes that write the backbuffer can't write anything else
+        bool writesBackbuffer = std::find(pass.writes.begin(), pass.writes.end(), Backbuffer) != pass.writes.end();
+        if (writesBackbuffer)
+        {
+            assert(pass.writes.size() == 1);
+            pass.renderPass->SetTargetFramebuffer(GetRenderer().GetDefaultFramebuffer());
+            continue;
+        }
+
+        std::vector<FramebufferObject::Attachment> drawBuffers;
+        pass.framebuffer = std::make_shared<FramebufferObject>();
+        pass.framebuffer->Bind();
+        for (ResourceId resourceId : pass.writes)
+        {
+            const Resource& resource = m_resources[resourceId];
+            assert(resource.texture);
+
+            // All the attachments must have the same size, that is also the viewport of the pass
+            assert(resourceId == pass.writes.front() || (resource.width == pass.width && resource.height == pass.height));
+            pass.width = resource.width;
+            pass.height = resource.height;
+
+            bool isDepth = IsDepthFormat(resource.desc.format);
+            FramebufferObject::Attachment attachment = isDepth ? FramebufferObject::Attachment::Depth
+                : static_cast<FramebufferObject::Attachment>(static_cast<GLenum>(FramebufferObject::Attachment::Color0) + drawBuffers.size());
+            pass.framebuffer->SetTexture(FramebufferObject::Target::Draw, attachment, *resource.texture);
+            if (!isDepth)
+            {
+                drawBuffers.push_back(attachment);
+            }
+        }
+        pass.framebuffer->SetDrawBuffers(drawBuffers);
+        pass.renderPass->SetTargetFramebuffer(pass.framebuffer);
+    }
+    FramebufferObject::Unbind();
+}
+
+std::shared_ptr<Texture2DObject> RenderGraph::AcquireTexture(const Resource& resource)
+{
+    // Reuse a free texture with the same size and format
+    for (PoolTexture& poolTexture : m_texturePool)
+    {
+        if (!poolTexture.inUse && poolTexture.width == resource.width && poolTexture.height == resource.height
+            && poolTexture.format == resource.desc.format && poolTexture.internalFormat == resource.desc.internalFormat)
+        {
+            poolTexture.inUse = true;
+            poolTexture.used = true;
+            return poolTexture.texture;
+        }
+    }
+
+    PoolTexture& poolTexture = m_texturePool.emplace_back();
+    poolTexture.width = resource.width;
+    poolTexture.height = resource.height;
+    poolTexture.format = resource.desc.format;
+    poolTexture.internalFormat = resource.desc.internalFormat;
+    poolTexture.inUse = true;
+    poolTexture.used = true;
+
+    bool isDepth = IsDepthFormat(resource.desc.format);
+    poolTexture.texture = std::make_shared<Texture2DObject>();
+    poolTexture.texture->Bind();
+    poolTexture.texture->SetImage(0, resource.width, resource.height, resource.desc.format, resource.desc.internalFormat);
+    poolTexture.texture->SetParameter(TextureObject::ParameterEnum::WrapS, GL_CLAMP_TO_EDGE);
+    poolTexture.texture->SetParameter(TextureObject::ParameterEnum::WrapT, GL_CLAMP_TO_EDGE);
+    poolTexture.texture->SetParameter(TextureObject::ParameterEnum::MinFilter, isDepth ? GL_NEAREST : GL_LINEAR);
+    poolTexture.texture->SetParameter(TextureObject::ParameterEnum::MagFilter, isDepth ? GL_NEAREST : GL_LINEAR);
+    Texture2DObject::Unbind();
+
+    return poolTexture.texture;
+}
+
+void RenderGraph::ReleaseTexture(const std::shared_ptr<Texture2DObject>& texture)
+{
+    auto itPoolTexture = std::find_if(m_texturePool.begin(), m_texturePool.end(),
+        [&](const PoolTexture& poolTexture) { return poolTexture.texture == texture; });
+    assert(itPoolTexture != m_texturePool.end());
+    itPoolTexture->inUse = false;
+}
+
+bool RenderGraph::IsDepthFormat(TextureObject::Format format)
+{
+    return format == TextureObject::FormatDepth || format == TextureObject::FormatDepthStencil;
+}
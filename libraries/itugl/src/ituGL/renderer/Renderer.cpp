@@ -1,24 +1,106 @@
 #include <ituGL/renderer/Renderer.h>
 
+#include <ituGL/renderer/RenderCommandBuffer.h>
 #include <ituGL/geometry/VertexFormat.h>
 #include <ituGL/geometry/VertexArrayObject.h>
 #include <ituGL/geometry/Drawcall.h>
 #include <ituGL/geometry/Mesh.h>
 #include <ituGL/geometry/Model.h>
+#include <ituGL/geometry/MeshPool.h>
 #include <ituGL/lighting/Light.h>
 #include <ituGL/camera/Camera.h>
 #include <ituGL/texture/FramebufferObject.h>
 #include <ituGL/renderer/RenderPass.h>
+#include <ituGL/utils/Profiler.h>
+#include <glm/matrix.hpp>
+#include <glm/geometric.hpp>
 #include <span>
+#include <array>
+#include <bit>
 #include <algorithm>
+#include <unordered_map>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 
-Renderer::DrawcallInfo::DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, const VertexArrayObject& vao, const Drawcall& drawcall)
-    : m_material(material), m_worldMatrixIndex(worldMatrixIndex), m_vao(vao), m_drawcall(drawcall)
+// Adds the time between construction and destruction to a stage timing, if there is one
+class StageTimer
 {
+public:
+    StageTimer(double* time) : m_time(time)
+    {
+        if (m_time)
+        {
+            m_startTime = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~StageTimer()
+    {
+        if (m_time)
+        {
+            std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - m_startTime;
+            *m_time += duration.count();
+        }
+    }
+
+private:
+    double* m_time;
+    std::chrono::steady_clock::time_point m_startTime;
+};
+
+// Bit layout of the sort keys, see Renderer::SortKey
+static constexpr unsigned int s_sortKeyTranslucentShift = 63;
+static constexpr unsigned int s_sortKeyDepthBits = 20;
+static constexpr unsigned int s_sortKeyShaderProgramBits = 12;
+static constexpr unsigned int s_sortKeyMaterialBits = 16;
+static constexpr unsigned int s_sortKeyVAOBits = 15;
+static constexpr unsigned int s_sortKeyStateBits = s_sortKeyShaderProgramBits + s_sortKeyMaterialBits + s_sortKeyVAOBits;
+static constexpr Renderer::SortKey s_sortKeyDepthMask = (Renderer::SortKey(1) << s_sortKeyDepthBits) - 1;
+
+// Batches per range in RecordDrawcallCollection, fewer are not worth the cost of another command buffer
+static constexpr unsigned int s_minBatchesPerRange = 64;
+
+// Default camera movement that makes the retained drawcalls sort again
+static constexpr float s_defaultRetainedSortDistance = 0.5f;
+static constexpr float s_defaultRetainedSortAngle = 0.1f;
+
+// Quantize a view depth to the bits available in the sort key
+static Renderer::SortKey QuantizeSortDepth(float depth)
+{
+    // The bit pattern of positive floats grows with their value, so we keep the highest bits after the sign
+    std::uint32_t depthBits = std::bit_cast<std::uint32_t>(std::max(depth, 0.0f));
+    return depthBits >> (31 - s_sortKeyDepthBits);
 }
 
-Renderer::DrawcallCollection::DrawcallCollection(const DrawcallSupportedFunction& isSupported) : m_isSupported(isSupported)
+Renderer::DrawcallInfo::DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, const VertexArrayObject& vao, const Drawcall& drawcall,
+    ShaderProgramId shaderProgramId, const VertexArrayObject* positionVAO, SortKey sortKey)
+    : m_material(material), m_worldMatrixIndex(worldMatrixIndex), m_vao(vao), m_drawcall(drawcall), m_shaderProgramId(shaderProgramId)
+    , m_positionVAO(positionVAO), m_sortKey(sortKey)
+{
+}
+
+Renderer::DrawcallBatch::DrawcallBatch(const DrawcallInfo& drawcallInfo, bool instanced)
+    : m_drawcallInfo(drawcallInfo), m_instanced(instanced), m_firstInstance(0), m_instanceCount(1)
+{
+}
+
+void Renderer::DrawcallBatch::Draw() const
+{
+    const Drawcall& drawcall = m_drawcallInfo.GetDrawcall();
+    if (m_instanced)
+    {
+        drawcall.DrawInstanced(m_instanceCount);
+    }
+    else
+    {
+        drawcall.Draw();
+    }
+}
+
+Renderer::DrawcallCollection::DrawcallCollection(const DrawcallSupportedFunction& isSupported) : m_isSupported(isSupported), m_batchesDirty(true)
+    , m_meshPoolGeneration(MeshPool::GetDefragmentGeneration())
+    , m_frameDrawcallCount(0), m_orderIndependent(false), m_sortDirty(true), m_sortCameraPosition(0.0f), m_sortCameraForward(0.0f)
 {
 }
 
@@ -37,23 +119,145 @@ void Renderer::DrawcallCollection::AddDrawcall(const DrawcallInfo& drawcallInfo)
     if (IsSupported(drawcallInfo))
     {
         m_drawcallInfos.push_back(drawcallInfo);
+        m_frameDrawcallCount++;
+        m_batchesDirty = true;
+        m_sortDirty = true;
+    }
+}
+
+Renderer::DrawcallBuffer::DrawcallBuffer()
+{
+}
+
+void Renderer::DrawcallBuffer::Clear()
+{
+    m_worldMatrices.clear();
+    for (std::vector<DrawcallInfo>& drawcallInfos : m_drawcallInfos)
+    {
+        drawcallInfos.clear();
     }
 }
 
 void Renderer::DrawcallCollection::Clear()
 {
     m_drawcallInfos.clear();
+    m_frameDrawcallCount = 0;
+    m_batchesDirty = true;
+    m_sortDirty = true;
+}
+
+void Renderer::DrawcallCollection::ClearFrameDrawcalls(unsigned int firstFrameWorldMatrixIndex)
+{
+    if (m_frameDrawcallCount == 0)
+    {
+        return;
+    }
+
+    if (m_frameDrawcallCount == m_drawcallInfos.size())
+    {
+        m_drawcallInfos.clear();
+    }
+    else
+    {
+        // Erasing keeps the order, so the retained drawcalls stay sorted
+        std::erase_if(m_drawcallInfos, [=](const DrawcallInfo& drawcallInfo)
+            {
+                return drawcallInfo.GetWorldMatrixIndex() >= firstFrameWorldMatrixIndex;
+            });
+    }
+    m_frameDrawcallCount = 0;
+    m_batchesDirty = true;
+}
+
+void Renderer::DrawcallCollection::SortByKey()
+{
+    const unsigned int count = static_cast<unsigned int>(m_drawcallInfos.size());
+    if (count < 2)
+        return;
+
+    constexpr unsigned int digitBits = 8;
+    constexpr unsigned int digitCount = sizeof(SortKey) * 8 / digitBits;
+    constexpr unsigned int bucketCount = 1 << digitBits;
+
+    m_sortKeys.resize(count);
+    m_sortKeysScratch.resize(count);
+    m_sortIndices.resize(count);
+    m_sortIndicesScratch.resize(count);
+
+    // Build the histograms of all the digits in a single pass
+    std::array<std::array<unsigned int, bucketCount>, digitCount> histograms = {};
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        SortKey key = m_drawcallInfos[i].GetSortKey();
+        m_sortKeys[i] = key;
+        m_sortIndices[i] = i;
+        for (unsigned int digit = 0; digit < digitCount; ++digit)
+        {
+            histograms[digit][(key >> (digit * digitBits)) & (bucketCount - 1)]++;
+        }
+    }
+
+    // LSD radix sort, one pass per digit. Each pass is stable, so the final order is stable too
+    for (unsigned int digit = 0; digit < digitCount; ++digit)
+    {
+        unsigned int shift = digit * digitBits;
+        std::array<unsigned int, bucketCount>& histogram = histograms[digit];
+
+        // If all the keys have the same digit, this pass would not change the order
+        if (histogram[(m_sortKeys[0] >> shift) & (bucketCount - 1)] == count)
+            continue;
+
+        // Convert the counts into the offset of each bucket
+        unsigned int offset = 0;
+        for (unsigned int& bucket : histogram)
+        {
+            unsigned int bucketSize = bucket;
+            bucket = offset;
+            offset += bucketSize;
+        }
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            unsigned int target = histogram[(m_sortKeys[i] >> shift) & (bucketCount - 1)]++;
+            m_sortKeysScratch[target] = m_sortKeys[i];
+            m_sortIndicesScratch[target] = m_sortIndices[i];
+        }
+        m_sortKeys.swap(m_sortKeysScratch);
+        m_sortIndices.swap(m_sortIndicesScratch);
+    }
+
+    // Reorder the drawcalls following the sorted indices
+    m_drawcallInfosScratch.clear();
+    m_drawcallInfosScratch.reserve(count);
+    for (unsigned int index : m_sortIndices)
+    {
+        m_drawcallInfosScratch.push_back(m_drawcallInfos[index]);
+    }
+    m_drawcallInfos.swap(m_drawcallInfosScratch);
+    m_batchesDirty = true;
 }
 
 
 Renderer::Renderer(DeviceGL& device)
     : m_device(device)
     , m_currentCamera(nullptr)
+    , m_immediateCommandBuffer(std::make_unique<RenderCommandBuffer>())
+    , m_renderStatesDirty(true)
+    , m_stageTimingEnabled(false)
+    , m_renderPassDepth(0)
     , m_defaultFramebuffer(FramebufferObject::GetDefault())
     , m_currentFramebuffer(m_defaultFramebuffer)
+    , m_retainedSortDistance(s_defaultRetainedSortDistance)
+    , m_retainedSortCosAngle(std::cos(s_defaultRetainedSortAngle))
     , m_drawcallCollections(1)
+    , m_hasTransformUniforms(false)
+    , m_instanceBufferCollectionIndex(-1)
+    , m_passDataTargetSize(0)
+    , m_passDataResolutionScale(0.0f)
+    , m_resolutionScale(1.0f)
 {
     InitializeFullscreenMesh();
+    InitializeUniformBlocks();
 
     device.EnableFeature(GL_FRAMEBUFFER_SRGB);
     device.EnableFeature(GL_DEPTH_TEST);
@@ -62,6 +266,10 @@ Renderer::Renderer(DeviceGL& device)
     device.SetVSyncEnabled(true);
 }
 
+Renderer::~Renderer()
+{
+}
+
 bool Renderer::HasCamera() const
 {
     return m_currentCamera;
@@ -74,7 +282,11 @@ const Camera& Renderer::GetCurrentCamera() const
 
 void Renderer::SetCurrentCamera(const Camera& camera)
 {
-    m_currentCamera = &camera;
+    if (m_currentCamera != &camera)
+    {
+        m_currentCamera = &camera;
+        m_immediateCommandBuffer->m_cameraUpdatedShaderPrograms.clear();
+    }
 }
 
 std::shared_ptr<const FramebufferObject> Renderer::GetDefaultFramebuffer() const
@@ -106,26 +318,57 @@ void Renderer::Render()
 {
     assert(m_currentCamera);
 
+    m_stateChangeCounters = StateChangeCounters();
+
+    // Camera data is the same for all the passes, upload it once
+    UpdateFrameData();
+    UpdateTransformBatch();
+
     for (auto& pass : m_passes)
     {
-        SetCurrentFramebuffer(pass->GetTargetFramebuffer());
-        pass->Render();
+        ExecuteRenderPass(*pass);
     }
 
+    InvalidateStateCache();
+
     Reset();
 }
 
+void Renderer::ExecuteRenderPass(RenderPass& renderPass)
+{
+    // Passes inside other passes are not added to the renderer
+    renderPass.SetRenderer(this);
+
+    // Passes can change GL state without going through the renderer
+    InvalidateStateCache();
+
+    Profiler::Scope scope(renderPass.GetName(), true);
+    StageTimer timer(m_stageTimingEnabled && m_renderPassDepth == 0 ? &m_stageTimings.renderPasses : nullptr);
+    ++m_renderPassDepth;
+
+    SetCurrentFramebuffer(renderPass.GetTargetFramebuffer());
+    UpdatePassData();
+    renderPass.Render();
+
+    --m_renderPassDepth;
+}
+
 void Renderer::Reset()
 {
-    m_worldMatrices.clear();
+    // Only the world matrices of the retained models are kept
+    unsigned int retainedModelCount = static_cast<unsigned int>(m_retainedModels.size());
+    m_worldMatrices.resize(retainedModelCount);
     m_lights.clear();
 
+    // Collections with only retained drawcalls keep their batches, and the instance buffer stays valid
     for (auto& collection : m_drawcallCollections)
     {
-        collection.Clear();
+        collection.ClearFrameDrawcalls(retainedModelCount);
     }
 
     m_currentCamera = nullptr;
+    m_immediateCommandBuffer->m_cameraUpdatedShaderPrograms.clear();
+    m_transformBatch.Clear();
 }
 
 int Renderer::AddRenderPass(std::unique_ptr<RenderPass> renderPass)
@@ -137,35 +380,123 @@ int Renderer::AddRenderPass(std::unique_ptr<RenderPass> renderPass)
     return passIndex;
 }
 
-void Renderer::RegisterShaderProgram(std::shared_ptr<const ShaderProgram> shaderProgramPtr,
+Renderer::ShaderProgramId Renderer::RegisterShaderProgram(std::shared_ptr<const ShaderProgram> shaderProgramPtr,
     const UpdateTransformsFunction& updateTransformFunction,
-    const UpdateLightsFunction& updateLightsFunction)
+    const UpdateLightsFunction& updateLightsFunction,
+    ShaderProgram::Location instanceWorldMatrixLocation)
 {
     assert(shaderProgramPtr);
 
-    if (updateTransformFunction)
+    // Connect the shared uniform blocks to the buffers of the renderer
+    GLuint frameDataBlockIndex = shaderProgramPtr->GetUniformBlockIndex("FrameData");
+    if (frameDataBlockIndex != GL_INVALID_INDEX)
+    {
+        shaderProgramPtr->SetUniformBlockBinding(frameDataBlockIndex, FrameDataBinding);
+    }
+    GLuint passDataBlockIndex = shaderProgramPtr->GetUniformBlockIndex("PassData");
+    if (passDataBlockIndex != GL_INVALID_INDEX)
+    {
+        shaderProgramPtr->SetUniformBlockBinding(passDataBlockIndex, PassDataBinding);
+    }
+
+    auto result = m_shaderProgramIds.try_emplace(shaderProgramPtr.get(), static_cast<ShaderProgramId>(m_shaderPrograms.size()));
+    ShaderProgramId shaderProgramId = result.first->second;
+    if (result.second)
     {
-        m_updateTransformsFunctions[shaderProgramPtr] = updateTransformFunction;
+        m_shaderPrograms.emplace_back();
     }
 
-    if (updateLightsFunction)
+    RegisteredShaderProgram& registered = m_shaderPrograms[shaderProgramId];
+    registered.shaderProgram = shaderProgramPtr;
+    registered.updateTransformsFunction = updateTransformFunction;
+    registered.updateLightsFunction = updateLightsFunction;
+    registered.instanceWorldMatrixLocation = instanceWorldMatrixLocation;
+
+    // Without update transforms function, the renderer sets the transform uniforms that the shader program has
+    registered.hasTransformUniforms = false;
+    if (!updateTransformFunction)
     {
-        m_updateLightsFunctions[shaderProgramPtr] = updateLightsFunction;
+        TransformUniformLocations& locations = registered.transformUniformLocations;
+        locations.worldMatrix = shaderProgramPtr->GetUniformLocation("WorldMatrix");
+        locations.worldViewMatrix = shaderProgramPtr->GetUniformLocation("WorldViewMatrix");
+        locations.worldViewProjMatrix = shaderProgramPtr->GetUniformLocation("WorldViewProjMatrix");
+        locations.normalMatrix = shaderProgramPtr->GetUniformLocation("NormalMatrix");
+        registered.hasTransformUniforms = locations.worldMatrix >= 0 || locations.worldViewMatrix >= 0 || locations.worldViewProjMatrix >= 0 || locations.normalMatrix >= 0;
+        m_hasTransformUniforms |= registered.hasTransformUniforms;
     }
+
+    return shaderProgramId;
+}
+
+Renderer::ShaderProgramId Renderer::GetShaderProgramId(const ShaderProgram& shaderProgram) const
+{
+    const auto& itFind = m_shaderProgramIds.find(&shaderProgram);
+    return itFind != m_shaderProgramIds.end() ? itFind->second : InvalidShaderProgramId;
 }
 
-void Renderer::UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgramPtr, unsigned int worldMatrixIndex, bool cameraChanged) const
+Renderer::ShaderProgramId Renderer::GetShaderProgramId(const Material& material) const
 {
+    const ShaderProgram* shaderProgram = material.GetShaderProgramPointer();
+    return shaderProgram ? GetShaderProgramId(*shaderProgram) : InvalidShaderProgramId;
+}
+
+void Renderer::UpdateTransforms(ShaderProgramId shaderProgramId, unsigned int worldMatrixIndex, bool cameraChanged) const
+{
+    if (shaderProgramId == InvalidShaderProgramId)
+    {
+        return;
+    }
+
     const glm::mat4& worldMatrix = m_worldMatrices[worldMatrixIndex];
-    UpdateTransforms(shaderProgramPtr, worldMatrix);
+
+    // Matrices computed at the start of the frame, only for world matrices that existed then
+    const RegisteredShaderProgram& registered = m_shaderPrograms[shaderProgramId];
+    if (registered.hasTransformUniforms && worldMatrixIndex < m_transformBatch.GetCount())
+    {
+        const ShaderProgram& shaderProgram = *registered.shaderProgram;
+        const TransformUniformLocations& locations = registered.transformUniformLocations;
+        if (locations.worldMatrix >= 0)
+            shaderProgram.SetUniform(locations.worldMatrix, worldMatrix);
+        if (locations.worldViewMatrix >= 0)
+            shaderProgram.SetUniform(locations.worldViewMatrix, m_transformBatch.GetWorldViewMatrix(worldMatrixIndex));
+        if (locations.worldViewProjMatrix >= 0)
+            shaderProgram.SetUniform(locations.worldViewProjMatrix, m_transformBatch.GetWorldViewProjMatrix(worldMatrixIndex));
+        if (locations.normalMatrix >= 0)
+            shaderProgram.SetUniform(locations.normalMatrix, m_transformBatch.GetNormalMatrix(worldMatrixIndex));
+        return;
+    }
+
+    UpdateTransforms(shaderProgramId, worldMatrix, cameraChanged);
 }
 
-void Renderer::UpdateTransforms(std::shared_ptr<const ShaderProgram> shaderProgramPtr, const glm::mat4& worldMatrix, bool cameraChanged) const
+void Renderer::UpdateTransforms(ShaderProgramId shaderProgramId, const glm::mat4& worldMatrix, bool cameraChanged) const
 {
-    const auto& itFind = m_updateTransformsFunctions.find(shaderProgramPtr);
-    if (itFind != m_updateTransformsFunctions.end())
+    if (shaderProgramId == InvalidShaderProgramId)
+    {
+        return;
+    }
+
+    const RegisteredShaderProgram& registered = m_shaderPrograms[shaderProgramId];
+    if (registered.updateTransformsFunction)
+    {
+        registered.updateTransformsFunction(*registered.shaderProgram, worldMatrix, *m_currentCamera, cameraChanged);
+        return;
+    }
+
+    // Matrices that are not in the batch, like the light volumes, are computed here
+    if (registered.hasTransformUniforms)
     {
-        itFind->second(*shaderProgramPtr, worldMatrix, *m_currentCamera, cameraChanged);
+        const ShaderProgram& shaderProgram = *registered.shaderProgram;
+        const TransformUniformLocations& locations = registered.transformUniformLocations;
+        glm::mat4 worldViewMatrix = m_currentCamera->GetViewMatrix() * worldMatrix;
+        if (locations.worldMatrix >= 0)
+            shaderProgram.SetUniform(locations.worldMatrix, worldMatrix);
+        if (locations.worldViewMatrix >= 0)
+            shaderProgram.SetUniform(locations.worldViewMatrix, worldViewMatrix);
+        if (locations.worldViewProjMatrix >= 0)
+            shaderProgram.SetUniform(locations.worldViewProjMatrix, m_currentCamera->GetProjectionMatrix() * worldViewMatrix);
+        if (locations.normalMatrix >= 0)
+            shaderProgram.SetUniform(locations.normalMatrix, glm::transpose(glm::inverse(glm::mat3(worldViewMatrix))));
     }
 }
 
@@ -205,12 +536,17 @@ Renderer::UpdateLightsFunction Renderer::GetDefaultUpdateLightsFunction(const Sh
     };
 }
 
-bool Renderer::UpdateLights(std::shared_ptr<const ShaderProgram> shaderProgramPtr, std::span<const Light* const> lights, unsigned int& lightIndex) const
+bool Renderer::UpdateLights(ShaderProgramId shaderProgramId, std::span<const Light* const> lights, unsigned int& lightIndex) const
 {
-    const auto& itFind = m_updateLightsFunctions.find(shaderProgramPtr);
-    if (itFind != m_updateLightsFunctions.end())
+    if (shaderProgramId == InvalidShaderProgramId)
     {
-        return itFind->second(*shaderProgramPtr, lights, lightIndex);
+        return false;
+    }
+
+    const RegisteredShaderProgram& registered = m_shaderPrograms[shaderProgramId];
+    if (registered.updateLightsFunction)
+    {
+        return registered.updateLightsFunction(*registered.shaderProgram, lights, lightIndex);
     }
     return false;
 }
@@ -230,24 +566,290 @@ std::span<const Renderer::DrawcallInfo> Renderer::GetDrawcalls(unsigned int coll
     return m_drawcallCollections[collectionIndex].GetDrawcalls();
 }
 
-void Renderer::AddModel(const Model& model, const glm::mat4& worldMatrix)
+std::span<const Renderer::DrawcallBatch> Renderer::GetDrawcallBatches(unsigned int collectionIndex)
 {
+    UpdateDrawcallBatches(collectionIndex);
+    DrawcallCollection& collection = m_drawcallCollections[collectionIndex];
+
+    // Upload the world matrices of this collection, unless they are already in the buffer
+    if (m_instanceBufferCollectionIndex != static_cast<int>(collectionIndex) && !collection.m_instanceWorldMatrices.empty())
+    {
+        m_instanceBuffer.Bind();
+        m_instanceBuffer.AllocateData(std::span<const glm::mat4>(collection.m_instanceWorldMatrices), BufferObject::Usage::StreamDraw);
+        VertexBufferObject::Unbind();
+        m_instanceBufferCollectionIndex = collectionIndex;
+    }
+
+    return collection.m_batches;
+}
+
+void Renderer::AddModel(const Model& model, const glm::mat4& worldMatrix, unsigned int lod)
+{
+    StageTimer timer(m_stageTimingEnabled ? &m_stageTimings.addModel : nullptr);
+
     unsigned int worldMatrixIndex = static_cast<unsigned int>(m_worldMatrices.size());
     m_worldMatrices.push_back(worldMatrix);
 
+    const Mesh& mesh = model.GetLodMesh(lod);
+    for (unsigned int submeshIndex = 0; submeshIndex < mesh.GetSubmeshCount(); ++submeshIndex)
+    {
+        const Material& material = model.GetMaterial(submeshIndex);
+        const VertexArrayObject& vao = mesh.GetSubmeshVertexArray(submeshIndex);
+        DrawcallInfo drawcallInfo(material, worldMatrixIndex, vao, mesh.GetSubmeshDrawcall(submeshIndex), GetShaderProgramId(material),
+            mesh.GetSubmeshPositionVertexArray(submeshIndex));
+
+        // The key is the same for all collections
+        drawcallInfo.SetSortKey(ComputeSortKey(material, vao));
+        for (unsigned int collectionIndex = 0; collectionIndex < m_drawcallCollections.size(); ++collectionIndex)
+        {
+            m_drawcallCollections[collectionIndex].AddDrawcall(drawcallInfo);
+        }
+    }
+}
+
+std::span<Renderer::DrawcallBuffer> Renderer::GetDrawcallBuffers(unsigned int count)
+{
+    if (m_drawcallBuffers.size() < count)
+    {
+        m_drawcallBuffers.resize(count);
+    }
+
+    std::span<DrawcallBuffer> buffers(m_drawcallBuffers.data(), count);
+    for (DrawcallBuffer& buffer : buffers)
+    {
+        buffer.Clear();
+        buffer.m_drawcallInfos.resize(m_drawcallCollections.size());
+    }
+    return buffers;
+}
+
+void Renderer::AddModel(DrawcallBuffer& buffer, const Model& model, const glm::mat4& worldMatrix, unsigned int lod) const
+{
+    assert(buffer.m_drawcallInfos.size() == m_drawcallCollections.size());
+
+    unsigned int worldMatrixIndex = static_cast<unsigned int>(buffer.m_worldMatrices.size());
+    buffer.m_worldMatrices.push_back(worldMatrix);
+
+    const Mesh& mesh = model.GetLodMesh(lod);
+    for (unsigned int submeshIndex = 0; submeshIndex < mesh.GetSubmeshCount(); ++submeshIndex)
+    {
+        const Material& material = model.GetMaterial(submeshIndex);
+        const VertexArrayObject& vao = mesh.GetSubmeshVertexArray(submeshIndex);
+        DrawcallInfo drawcallInfo(material, worldMatrixIndex, vao, mesh.GetSubmeshDrawcall(submeshIndex), GetShaderProgramId(material),
+            mesh.GetSubmeshPositionVertexArray(submeshIndex));
+
+        drawcallInfo.SetSortKey(ComputeSortKey(material, vao));
+        for (unsigned int collectionIndex = 0; collectionIndex < m_drawcallCollections.size(); ++collectionIndex)
+        {
+            if (m_drawcallCollections[collectionIndex].IsSupported(drawcallInfo))
+            {
+                buffer.m_drawcallInfos[collectionIndex].push_back(drawcallInfo);
+            }
+        }
+    }
+}
+
+void Renderer::MergeDrawcallBuffers(std::span<DrawcallBuffer> buffers)
+{
+    for (DrawcallBuffer& buffer : buffers)
+    {
+        assert(buffer.m_drawcallInfos.size() == m_drawcallCollections.size());
+
+        unsigned int worldMatrixOffset = static_cast<unsigned int>(m_worldMatrices.size());
+        m_worldMatrices.insert(m_worldMatrices.end(), buffer.m_worldMatrices.begin(), buffer.m_worldMatrices.end());
+
+        for (unsigned int collectionIndex = 0; collectionIndex < m_drawcallCollections.size(); ++collectionIndex)
+        {
+            DrawcallCollection& collection = m_drawcallCollections[collectionIndex];
+            std::span<const DrawcallInfo> drawcallInfos = buffer.m_drawcallInfos[collectionIndex];
+            if (drawcallInfos.empty())
+            {
+                continue;
+            }
+
+            collection.m_drawcallInfos.reserve(collection.m_drawcallInfos.size() + drawcallInfos.size());
+            for (const DrawcallInfo& bufferDrawcallInfo : drawcallInfos)
+            {
+                collection.m_drawcallInfos.emplace_back(bufferDrawcallInfo.GetMaterial(),
+                    bufferDrawcallInfo.GetWorldMatrixIndex() + worldMatrixOffset, bufferDrawcallInfo.GetVAO(), bufferDrawcallInfo.GetDrawcall(),
+                    bufferDrawcallInfo.GetShaderProgramId(), bufferDrawcallInfo.GetPositionVAO(), bufferDrawcallInfo.GetSortKey());
+            }
+            collection.m_frameDrawcallCount += static_cast<unsigned int>(drawcallInfos.size());
+            collection.m_batchesDirty = true;
+            collection.m_sortDirty = true;
+        }
+    }
+}
+
+Renderer::RetainedModelId Renderer::AddRetainedModel(const Model& model, const glm::mat4& worldMatrix)
+{
+    StageTimer timer(m_stageTimingEnabled ? &m_stageTimings.addModel : nullptr);
+
+    unsigned int index;
+    if (!m_freeRetainedModelIndices.empty())
+    {
+        index = m_freeRetainedModelIndices.back();
+        m_freeRetainedModelIndices.pop_back();
+        m_retainedModels[index] = &model;
+        m_worldMatrices[index] = worldMatrix;
+    }
+    else
+    {
+        index = static_cast<unsigned int>(m_retainedModels.size());
+        m_retainedModels.push_back(&model);
+        m_retainedModelGenerations.push_back(0);
+
+        // The new world matrix goes before the ones of the frame, if models were already added
+        m_worldMatrices.insert(m_worldMatrices.begin() + index, worldMatrix);
+        if (m_worldMatrices.size() > m_retainedModels.size())
+        {
+            for (DrawcallCollection& collection : m_drawcallCollections)
+            {
+                for (DrawcallInfo& drawcallInfo : collection.m_drawcallInfos)
+                {
+                    if (drawcallInfo.m_worldMatrixIndex >= index)
+                    {
+                        ++drawcallInfo.m_worldMatrixIndex;
+                    }
+                }
+                collection.m_batchesDirty = true;
+            }
+        }
+    }
+
+    AddRetainedDrawcalls(index);
+    return (static_cast<RetainedModelId>(m_retainedModelGenerations[index]) << 32) | index;
+}
+
+bool Renderer::RemoveRetainedModel(RetainedModelId id)
+{
+    unsigned int index;
+    if (!GetRetainedModelIndex(id, index))
+    {
+        return false;
+    }
+
+    RemoveRetainedDrawcalls(index);
+    m_retainedModels[index] = nullptr;
+    ++m_retainedModelGenerations[index];
+    m_freeRetainedModelIndices.push_back(index);
+    return true;
+}
+
+bool Renderer::SetRetainedModelWorldMatrix(RetainedModelId id, const glm::mat4& worldMatrix)
+{
+    unsigned int index;
+    if (!GetRetainedModelIndex(id, index))
+    {
+        return false;
+    }
+
+    m_worldMatrices[index] = worldMatrix;
+
+    // Opaque drawcalls keep their order, a slightly wrong front to back order only costs some overdraw
+    bool translucent = false;
+    const Model& model = *m_retainedModels[index];
+    for (unsigned int submeshIndex = 0; submeshIndex < model.GetMesh().GetSubmeshCount(); ++submeshIndex)
+    {
+        translucent |= model.GetMaterial(submeshIndex).HasBlend();
+    }
+
+    // The instance data is copied when the batches are built
+    for (DrawcallCollection& collection : m_drawcallCollections)
+    {
+        collection.m_batchesDirty = true;
+        collection.m_sortDirty |= translucent;
+    }
+    return true;
+}
+
+bool Renderer::UpdateRetainedModelMaterials(RetainedModelId id)
+{
+    unsigned int index;
+    if (!GetRetainedModelIndex(id, index))
+    {
+        return false;
+    }
+
+    // Sort keys, supported collections and batches can all change
+    RemoveRetainedDrawcalls(index);
+    AddRetainedDrawcalls(index);
+    return true;
+}
+
+bool Renderer::IsRetainedModel(RetainedModelId id) const
+{
+    unsigned int index;
+    return GetRetainedModelIndex(id, index);
+}
+
+unsigned int Renderer::GetRetainedModelCount() const
+{
+    return static_cast<unsigned int>(m_retainedModels.size() - m_freeRetainedModelIndices.size());
+}
+
+void Renderer::SetRetainedSortThresholds(float distance, float angle)
+{
+    m_retainedSortDistance = distance;
+    m_retainedSortCosAngle = std::cos(angle);
+}
+
+bool Renderer::GetRetainedModelIndex(RetainedModelId id, unsigned int& index) const
+{
+    index = static_cast<unsigned int>(id);
+    unsigned int generation = static_cast<unsigned int>(id >> 32);
+    return index < m_retainedModels.size() && m_retainedModels[index] && m_retainedModelGenerations[index] == generation;
+}
+
+void Renderer::AddRetainedDrawcalls(unsigned int index)
+{
+    const Model& model = *m_retainedModels[index];
     const Mesh& mesh = model.GetMesh();
     for (unsigned int submeshIndex = 0; submeshIndex < mesh.GetSubmeshCount(); ++submeshIndex)
     {
-        DrawcallInfo drawcallInfo(model.GetMaterial(submeshIndex), worldMatrixIndex,
-            mesh.GetSubmeshVertexArray(submeshIndex), mesh.GetSubmeshDrawcall(submeshIndex));
+        const Material& material = model.GetMaterial(submeshIndex);
+        const VertexArrayObject& vao = mesh.GetSubmeshVertexArray(submeshIndex);
+        DrawcallInfo drawcallInfo(material, index, vao, mesh.GetSubmeshDrawcall(submeshIndex), GetShaderProgramId(material),
+            mesh.GetSubmeshPositionVertexArray(submeshIndex));
 
-        for (DrawcallCollection& collection : m_drawcallCollections)
+        drawcallInfo.SetSortKey(ComputeSortKey(material, vao));
+        for (unsigned int collectionIndex = 0; collectionIndex < m_drawcallCollections.size(); ++collectionIndex)
         {
-            collection.AddDrawcall(drawcallInfo);
+            DrawcallCollection& collection = m_drawcallCollections[collectionIndex];
+            if (collection.IsSupported(drawcallInfo))
+            {
+                collection.m_drawcallInfos.push_back(drawcallInfo);
+                collection.m_batchesDirty = true;
+                collection.m_sortDirty = true;
+            }
         }
     }
 }
 
+void Renderer::RemoveRetainedDrawcalls(unsigned int index)
+{
+    for (DrawcallCollection& collection : m_drawcallCollections)
+    {
+        // The remaining drawcalls keep their order, so they don't need to be sorted again
+        if (std::erase_if(collection.m_drawcallInfos, [=](const DrawcallInfo& drawcallInfo) { return drawcallInfo.GetWorldMatrixIndex() == index; }))
+        {
+            collection.m_batchesDirty = true;
+        }
+    }
+}
+
+bool Renderer::IsSortCameraChanged(const DrawcallCollection& collection) const
+{
+    const Camera& camera = GetCurrentCamera();
+
+    glm::vec3 right, up, forward;
+    camera.ExtractVectors(right, up, forward);
+    glm::vec3 offset = camera.ExtractTranslation() - collection.m_sortCameraPosition;
+
+    return glm::dot(offset, offset) > m_retainedSortDistance * m_retainedSortDistance
+        || glm::dot(forward, collection.m_sortCameraForward) < m_retainedSortCosAngle;
+}
+
 unsigned int Renderer::AddDrawcallCollection(const DrawcallSupportedFunction& drawcallSupportedFunction)
 {
     unsigned int index = static_cast<unsigned int>(m_drawcallCollections.size());
@@ -260,10 +862,55 @@ void Renderer::SetDrawcallCollectionSupportedFunction(unsigned int index, const
     m_drawcallCollections[index].SetSupportedFunction(drawcallSupportedFunction);
 }
 
+bool Renderer::IsDrawcallCollectionOrderIndependent(unsigned int index) const
+{
+    return m_drawcallCollections[index].m_orderIndependent;
+}
+
+void Renderer::SetDrawcallCollectionOrderIndependent(unsigned int index, bool orderIndependent)
+{
+    DrawcallCollection& collection = m_drawcallCollections[index];
+    collection.m_orderIndependent = orderIndependent;
+    collection.m_batchesDirty = true;
+    collection.m_sortDirty = true;
+}
+
 void Renderer::SortDrawcallCollection(unsigned int index, const DrawcallSortFunction& drawcallSortFunction)
 {
-    auto drawcalls = m_drawcallCollections[index].GetDrawcalls();
+    StageTimer timer(m_stageTimingEnabled ? &m_stageTimings.sort : nullptr);
+
+    DrawcallCollection& collection = m_drawcallCollections[index];
+    auto drawcalls = collection.GetDrawcalls();
     std::sort(drawcalls.begin(), drawcalls.end(), drawcallSortFunction);
+    collection.m_batchesDirty = true;
+    // The order is not the order of the keys anymore
+    collection.m_sortDirty = true;
+}
+
+void Renderer::SortDrawcallCollection(unsigned int index)
+{
+    StageTimer timer(m_stageTimingEnabled ? &m_stageTimings.sort : nullptr);
+
+    // The batches already group the drawcalls by state, and the blending doesn't depend on the order
+    DrawcallCollection& collection = m_drawcallCollections[index];
+    if (collection.m_orderIndependent)
+    {
+        return;
+    }
+
+    // Retained drawcalls are still in order, unless something changed since the last sort
+    if (!collection.m_sortDirty && !IsSortCameraChanged(collection))
+    {
+        return;
+    }
+
+    UpdateSortKeyDepths(collection);
+    collection.SortByKey();
+
+    glm::vec3 right, up;
+    GetCurrentCamera().ExtractVectors(right, up, collection.m_sortCameraForward);
+    collection.m_sortCameraPosition = GetCurrentCamera().ExtractTranslation();
+    collection.m_sortDirty = false;
 }
 
 bool Renderer::IsBackToFront(const DrawcallInfo& a, const DrawcallInfo& b) const
@@ -285,19 +932,484 @@ bool Renderer::IsFrontToBack(const DrawcallInfo& a, const DrawcallInfo& b) const
 
 void Renderer::PrepareDrawcall(const DrawcallInfo& drawcallInfo, Material::OverrideFlags materialOverride)
 {
-    std::shared_ptr<const ShaderProgram> shaderProgram = drawcallInfo.GetMaterial().GetShaderProgram();
+    PrepareDrawcall(drawcallInfo, materialOverride, nullptr);
+}
 
-    // TODO: Room for optimization here, caching current material, current worldMatrixIndex and current VAO
+void Renderer::PrepareDrawcallBatch(const DrawcallBatch& drawcallBatch, Material::OverrideFlags materialOverride)
+{
+    PrepareDrawcall(drawcallBatch.GetDrawcallInfo(), materialOverride, &drawcallBatch);
+}
 
-    // Setup material
-    drawcallInfo.GetMaterial().Use(materialOverride);
+void Renderer::PrepareDrawcall(const DrawcallInfo& drawcallInfo, Material::OverrideFlags materialOverride, const DrawcallBatch* drawcallBatch)
+{
+    StageTimer timer(m_stageTimingEnabled ? &m_stageTimings.prepareDrawcalls : nullptr);
+
+    // Same path as the recorded passes. The buffer keeps the states, so only the changes are executed
+    RenderCommandBuffer& commandBuffer = *m_immediateCommandBuffer;
+    commandBuffer.ClearCommands();
+    RecordPrepareDrawcall(commandBuffer, drawcallInfo, materialOverride, drawcallBatch, nullptr);
+    ExecuteCommandBuffer(commandBuffer);
+}
 
-    // Setup world matrix
-    // Setup camera
-    UpdateTransforms(shaderProgram, drawcallInfo.GetWorldMatrixIndex());
+void Renderer::RecordPrepareDrawcall(RenderCommandBuffer& commandBuffer, const DrawcallInfo& drawcallInfo, Material::OverrideFlags materialOverride,
+    const DrawcallBatch* drawcallBatch, const std::vector<glm::mat4>* instanceWorldMatrices) const
+{
+    StateChangeCounters& counters = commandBuffer.m_stateChangeCounters;
+
+    const Material& material = drawcallInfo.GetMaterial();
+    const ShaderProgram* shaderProgram = material.GetShaderProgramPointer();
+    ShaderProgramId shaderProgramId = drawcallInfo.GetShaderProgramId();
+
+    // Setup material, skipping the parts that are already set
+    bool sameShaderProgram = shaderProgram == commandBuffer.m_lastShaderProgram;
+    bool sameMaterial = &material == commandBuffer.m_lastMaterial && materialOverride == commandBuffer.m_lastMaterialOverride;
+
+    int overrideFlags = materialOverride;
+    if (sameShaderProgram)
+    {
+        overrideFlags |= Material::OverrideShaderProgram;
+        counters.shaderProgramsSkipped++;
+    }
+    else
+    {
+        counters.shaderProgramsIssued++;
+    }
+
+    // Render states are applied anyway when executed, if the lighting of a previous drawcall changed them
+    if (sameMaterial)
+    {
+        overrideFlags |= Material::OverrideUniforms | Material::OverrideRenderStates;
+    }
+    commandBuffer.AddCommand(RenderCommandBuffer::UseMaterialCommand{ &material, overrideFlags, materialOverride });
+
+    // Setup world matrix and camera. Camera only once per shader program and frame
+    // Instanced shader programs read the world matrix from a vertex attribute, they only need the camera
+    ShaderProgram::Location instanceWorldMatrixLocation = GetInstanceWorldMatrixLocation(shaderProgramId);
+    std::vector<const ShaderProgram*>& cameraUpdatedShaderPrograms = commandBuffer.m_cameraUpdatedShaderPrograms;
+    bool cameraChanged = std::find(cameraUpdatedShaderPrograms.begin(), cameraUpdatedShaderPrograms.end(), shaderProgram) == cameraUpdatedShaderPrograms.end();
+    bool transformsChanged = cameraChanged;
+    if (instanceWorldMatrixLocation < 0)
+    {
+        transformsChanged |= !sameShaderProgram || drawcallInfo.GetWorldMatrixIndex() != commandBuffer.m_lastWorldMatrixIndex;
+    }
+    if (transformsChanged)
+    {
+        // The world matrix is copied, so the command does not depend on the drawcalls of this frame
+        bool instanced = instanceWorldMatrixLocation >= 0;
+        glm::mat4 worldMatrix = instanced ? glm::mat4(1.0f) : GetWorldMatrix(drawcallInfo);
+        unsigned int worldMatrixIndex = instanced ? ~0u : drawcallInfo.GetWorldMatrixIndex();
+        commandBuffer.AddCommand(RenderCommandBuffer::UpdateTransformsCommand{ shaderProgramId, worldMatrix, worldMatrixIndex, cameraChanged });
+        if (cameraChanged)
+        {
+            cameraUpdatedShaderPrograms.push_back(shaderProgram);
+        }
+        counters.transformsIssued++;
+    }
+    else
+    {
+        counters.transformsSkipped++;
+    }
 
     // Setup VAO
-    drawcallInfo.GetVAO().Bind();
+    const VertexArrayObject& vao = drawcallInfo.GetVAO();
+    if (&vao != commandBuffer.m_lastVAO)
+    {
+        commandBuffer.AddCommand(RenderCommandBuffer::BindVAOCommand{ &vao });
+        counters.vaosIssued++;
+    }
+    else
+    {
+        counters.vaosSkipped++;
+    }
+
+    // Setup world matrix vertex attribute
+    if (instanceWorldMatrixLocation >= 0)
+    {
+        if (drawcallBatch && drawcallBatch->IsInstanced())
+        {
+            RenderCommandBuffer::InstanceWorldMatricesCommand command{ instanceWorldMatrixLocation, &m_instanceBuffer, drawcallBatch->GetFirstInstance() };
+            if (instanceWorldMatrices)
+            {
+                std::span<const glm::mat4> batchWorldMatrices(instanceWorldMatrices->data() + drawcallBatch->GetFirstInstance(), drawcallBatch->GetInstanceCount());
+                command.buffer = nullptr;
+                command.firstInstance = commandBuffer.AddInstanceWorldMatrices(batchWorldMatrices);
+            }
+            commandBuffer.AddCommand(command);
+        }
+        else
+        {
+            commandBuffer.AddCommand(RenderCommandBuffer::WorldMatrixAttributeCommand{ instanceWorldMatrixLocation, GetWorldMatrix(drawcallInfo) });
+        }
+    }
+
+    commandBuffer.m_lastShaderProgram = shaderProgram;
+    commandBuffer.m_lastMaterial = &material;
+    commandBuffer.m_lastMaterialOverride = materialOverride;
+    commandBuffer.m_lastVAO = &vao;
+    commandBuffer.m_lastWorldMatrixIndex = drawcallInfo.GetWorldMatrixIndex();
+}
+
+void Renderer::RecordDrawcallCollection(std::vector<RenderCommandBuffer>& commandBuffers, unsigned int collectionIndex, bool lit,
+    Material::OverrideFlags materialOverride, Material::OverrideFlags opaqueMaterialOverride, bool multiDraw)
+{
+    StageTimer timer(m_stageTimingEnabled ? &m_stageTimings.prepareDrawcalls : nullptr);
+    Profiler::Scope scope("Record commands");
+
+    UpdateDrawcallBatches(collectionIndex);
+    DrawcallCollection& collection = m_drawcallCollections[collectionIndex];
+    const std::vector<DrawcallBatch>& batches = collection.m_batches;
+
+    Material::OverrideFlags batchOverrides[2] = { materialOverride, static_cast<Material::OverrideFlags>(materialOverride | opaqueMaterialOverride) };
+    auto recordBatch = [&](RenderCommandBuffer& commandBuffer, unsigned int batchIndex)
+        {
+            const DrawcallBatch& drawcallBatch = batches[batchIndex];
+            const DrawcallInfo& drawcallInfo = drawcallBatch.GetDrawcallInfo();
+            Material::OverrideFlags batchOverride = batchOverrides[drawcallInfo.GetMaterial().HasBlend() ? 0 : 1];
+            RecordPrepareDrawcall(commandBuffer, drawcallInfo, batchOverride, &drawcallBatch, &collection.m_instanceWorldMatrices);
+
+            GLsizei instanceCount = drawcallBatch.IsInstanced() ? drawcallBatch.GetInstanceCount() : 0;
+            ShaderProgramId litShaderProgramId = lit ? drawcallInfo.GetShaderProgramId() : InvalidShaderProgramId;
+            commandBuffer.AddCommand(RenderCommandBuffer::DrawCommand{ drawcallInfo.GetDrawcall(), instanceCount, litShaderProgramId });
+        };
+
+    if (!multiDraw || !IsMultiDrawIndirectSupported())
+    {
+        RecordBatchRanges(commandBuffers, static_cast<unsigned int>(batches.size()), recordBatch);
+        return;
+    }
+
+    BuildMultiDrawRuns(collection);
+    const std::vector<unsigned int>& runs = collection.m_multiDrawRuns;
+    RecordBatchRanges(commandBuffers, static_cast<unsigned int>(runs.size()) - 1, [&](RenderCommandBuffer& commandBuffer, unsigned int runIndex)
+        {
+            unsigned int begin = runs[runIndex];
+            unsigned int end = runs[runIndex + 1];
+            if (end - begin == 1)
+            {
+                recordBatch(commandBuffer, begin);
+                return;
+            }
+
+            // The instances of the run are contiguous, so they are prepared like a single batch that contains all of them
+            const DrawcallBatch& firstBatch = batches[begin];
+            const DrawcallInfo& drawcallInfo = firstBatch.GetDrawcallInfo();
+            DrawcallBatch runBatch(drawcallInfo, true);
+            runBatch.m_firstInstance = firstBatch.GetFirstInstance();
+            runBatch.m_instanceCount = batches[end - 1].GetFirstInstance() + batches[end - 1].GetInstanceCount() - runBatch.m_firstInstance;
+
+            Material::OverrideFlags batchOverride = batchOverrides[drawcallInfo.GetMaterial().HasBlend() ? 0 : 1];
+            RecordPrepareDrawcall(commandBuffer, drawcallInfo, batchOverride, &runBatch, &collection.m_instanceWorldMatrices);
+
+            // Each draw reads its world matrices from its position in the run
+            const Drawcall& firstDrawcall = drawcallInfo.GetDrawcall();
+            GLuint elementSize = Data::GetTypeSize(firstDrawcall.GetEboType());
+            unsigned int firstIndirectCommand = 0;
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                const DrawcallBatch& drawcallBatch = batches[i];
+                const Drawcall& drawcall = drawcallBatch.GetDrawcallInfo().GetDrawcall();
+                RenderCommandBuffer::DrawElementsIndirectCommand indirectCommand{ static_cast<GLuint>(drawcall.GetCount()), drawcallBatch.GetInstanceCount(),
+                    static_cast<GLuint>(drawcall.GetFirst()) / elementSize, drawcall.GetBaseVertex(), drawcallBatch.GetFirstInstance() - runBatch.m_firstInstance };
+                unsigned int indirectCommandIndex = commandBuffer.AddIndirectCommand(indirectCommand);
+                if (i == begin)
+                {
+                    firstIndirectCommand = indirectCommandIndex;
+                }
+            }
+
+            ShaderProgramId litShaderProgramId = lit ? drawcallInfo.GetShaderProgramId() : InvalidShaderProgramId;
+            commandBuffer.AddCommand(RenderCommandBuffer::MultiDrawCommand{ firstDrawcall.GetPrimitive(), firstDrawcall.GetEboType(),
+                firstIndirectCommand, static_cast<GLsizei>(end - begin), litShaderProgramId });
+        });
+}
+
+bool Renderer::IsMultiDrawIndirectSupported()
+{
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+void Renderer::BuildMultiDrawRuns(DrawcallCollection& collection) const
+{
+    const std::vector<DrawcallBatch>& batches = collection.m_batches;
+    std::vector<unsigned int>& runs = collection.m_multiDrawRuns;
+    runs.clear();
+
+    // Instanced batches get their instances in order, so the instances of consecutive ones are contiguous
+    // Translucent batches are not instanced unless the collection is order independent, so their order is kept
+    for (unsigned int i = 0; i < batches.size(); ++i)
+    {
+        bool merge = false;
+        if (i > 0 && batches[i].IsInstanced() && batches[i - 1].IsInstanced())
+        {
+            const DrawcallInfo& previous = batches[i - 1].GetDrawcallInfo();
+            const DrawcallInfo& current = batches[i].GetDrawcallInfo();
+            const Drawcall& previousDrawcall = previous.GetDrawcall();
+            const Drawcall& currentDrawcall = current.GetDrawcall();
+            merge = &previous.GetMaterial() == &current.GetMaterial() && &previous.GetVAO() == &current.GetVAO()
+                && previousDrawcall.GetPrimitive() == currentDrawcall.GetPrimitive()
+                && previousDrawcall.GetEboType() == currentDrawcall.GetEboType() && currentDrawcall.GetEboType() != Data::Type::None;
+            assert(!merge || batches[i].GetFirstInstance() == batches[i - 1].GetFirstInstance() + batches[i - 1].GetInstanceCount());
+        }
+        if (!merge)
+        {
+            runs.push_back(i);
+        }
+    }
+    runs.push_back(static_cast<unsigned int>(batches.size()));
+}
+
+void Renderer::RecordDepthPrepass(std::vector<RenderCommandBuffer>& commandBuffers, unsigned int collectionIndex, const Material& depthMaterial)
+{
+    StageTimer timer(m_stageTimingEnabled ? &m_stageTimings.prepareDrawcalls : nullptr);
+    Profiler::Scope scope("Record depth pre-pass");
+
+    ShaderProgramId depthShaderProgramId = GetShaderProgramId(depthMaterial);
+    assert(depthShaderProgramId != InvalidShaderProgramId);
+    bool depthInstanced = GetInstanceWorldMatrixLocation(depthShaderProgramId) >= 0;
+
+    UpdateDrawcallBatches(collectionIndex);
+    DrawcallCollection& collection = m_drawcallCollections[collectionIndex];
+    const std::vector<DrawcallBatch>& batches = collection.m_batches;
+
+    // Only the opaque batches write depth. All of them use the same material, so they are sorted only by depth
+    std::vector<unsigned int>& prepassBatches = collection.m_depthPrepassBatches;
+    std::vector<float>& prepassDepths = collection.m_depthPrepassDepths;
+    prepassBatches.clear();
+    prepassDepths.resize(batches.size());
+    const glm::mat4& viewMatrix = GetCurrentCamera().GetViewMatrix();
+    for (unsigned int i = 0; i < batches.size(); ++i)
+    {
+        const DrawcallInfo& drawcallInfo = batches[i].GetDrawcallInfo();
+        if (!drawcallInfo.GetMaterial().HasBlend())
+        {
+            // Camera looks towards negative Z in view space. Instanced batches use their first instance
+            prepassDepths[i] = -(viewMatrix * GetWorldMatrix(drawcallInfo)[3]).z;
+            prepassBatches.push_back(i);
+        }
+    }
+    std::sort(prepassBatches.begin(), prepassBatches.end(), [&](unsigned int a, unsigned int b)
+        {
+            return prepassDepths[a] < prepassDepths[b];
+        });
+
+    RecordBatchRanges(commandBuffers, static_cast<unsigned int>(prepassBatches.size()), [&](RenderCommandBuffer& commandBuffer, unsigned int index)
+        {
+            const DrawcallBatch& drawcallBatch = batches[prepassBatches[index]];
+            const DrawcallInfo& drawcallInfo = drawcallBatch.GetDrawcallInfo();
+            const VertexArrayObject* positionVAO = drawcallInfo.GetPositionVAO();
+            if (positionVAO && (depthInstanced || !drawcallBatch.IsInstanced()))
+            {
+                DrawcallInfo depthDrawcallInfo(depthMaterial, drawcallInfo.GetWorldMatrixIndex(), *positionVAO, drawcallInfo.GetDrawcall(), depthShaderProgramId);
+                RecordPrepareDrawcall(commandBuffer, depthDrawcallInfo, Material::NoOverride, &drawcallBatch, &collection.m_instanceWorldMatrices);
+            }
+            else
+            {
+                RecordPrepareDrawcall(commandBuffer, drawcallInfo, Material::NoOverride, &drawcallBatch, &collection.m_instanceWorldMatrices);
+            }
+
+            GLsizei instanceCount = drawcallBatch.IsInstanced() ? drawcallBatch.GetInstanceCount() : 0;
+            commandBuffer.AddCommand(RenderCommandBuffer::DrawCommand{ drawcallInfo.GetDrawcall(), instanceCount, InvalidShaderProgramId });
+        });
+}
+
+void Renderer::UpdateDrawcallBatches(unsigned int collectionIndex)
+{
+    DrawcallCollection& collection = m_drawcallCollections[collectionIndex];
+
+    // Pooled meshes moved since the batches were built
+    if (collection.m_meshPoolGeneration != MeshPool::GetDefragmentGeneration())
+    {
+        collection.m_meshPoolGeneration = MeshPool::GetDefragmentGeneration();
+        collection.m_batchesDirty = true;
+    }
+
+    if (collection.m_batchesDirty)
+    {
+        BuildDrawcallBatches(collection);
+        if (m_instanceBufferCollectionIndex == static_cast<int>(collectionIndex))
+        {
+            m_instanceBufferCollectionIndex = -1;
+        }
+    }
+}
+
+void Renderer::RecordBatchRanges(std::vector<RenderCommandBuffer>& commandBuffers, unsigned int batchCount,
+    const std::function<void(RenderCommandBuffer& commandBuffer, unsigned int batchIndex)>& recordBatch)
+{
+    // Each range starts with no states recorded, so more ranges means more state changes
+    unsigned int maxRangeCount = m_threadPool.GetThreadCount() + 1;
+    unsigned int rangeCount = std::clamp(batchCount / s_minBatchesPerRange, 1u, maxRangeCount);
+    commandBuffers.resize(rangeCount);
+
+    m_threadPool.ParallelFor(rangeCount, [&](unsigned int rangeIndex)
+        {
+            RenderCommandBuffer& commandBuffer = commandBuffers[rangeIndex];
+            commandBuffer.Clear();
+
+            unsigned int begin = batchCount * rangeIndex / rangeCount;
+            unsigned int end = batchCount * (rangeIndex + 1) / rangeCount;
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                recordBatch(commandBuffer, i);
+            }
+        });
+}
+
+void Renderer::ExecuteCommandBuffer(RenderCommandBuffer& commandBuffer)
+{
+    const VertexBufferObject* instanceBuffer = commandBuffer.GetInstanceBuffer();
+    const RenderCommandBuffer::IndirectBufferObject* indirectBuffer = commandBuffer.GetIndirectBuffer();
+
+    // Draw once, or once per light if lit, additive after the first one
+    auto drawLit = [&](ShaderProgramId litShaderProgramId, const auto& draw)
+    {
+        if (litShaderProgramId != InvalidShaderProgramId)
+        {
+            bool first = true;
+            unsigned int lightIndex = 0;
+            while (UpdateLights(litShaderProgramId, m_lights, lightIndex))
+            {
+                SetLightingRenderStates(first);
+                draw();
+                first = false;
+            }
+        }
+        else
+        {
+            draw();
+        }
+    };
+
+    RenderCommandBuffer::Reader reader(commandBuffer);
+    while (reader.HasCommands())
+    {
+        switch (reader.GetType())
+        {
+        case RenderCommandBuffer::CommandType::UseMaterial:
+        {
+            RenderCommandBuffer::UseMaterialCommand command = reader.Read<RenderCommandBuffer::UseMaterialCommand>();
+            int overrideFlags = command.overrideFlags;
+            if (m_renderStatesDirty)
+            {
+                overrideFlags &= ~(Material::OverrideRenderStates & ~command.passOverrideFlags);
+            }
+
+            if (overrideFlags == Material::OverrideAll)
+            {
+                m_stateChangeCounters.materialsSkipped++;
+            }
+            else
+            {
+                command.material->Use(static_cast<Material::OverrideFlags>(overrideFlags));
+                m_stateChangeCounters.materialsIssued++;
+            }
+            m_renderStatesDirty = false;
+            break;
+        }
+        case RenderCommandBuffer::CommandType::UpdateTransforms:
+        {
+            RenderCommandBuffer::UpdateTransformsCommand command = reader.Read<RenderCommandBuffer::UpdateTransformsCommand>();
+
+            // Buffers executed again in later frames may have indices of other world matrices, then the copy is used
+            if (command.worldMatrixIndex < m_transformBatch.GetCount() && m_worldMatrices[command.worldMatrixIndex] == command.worldMatrix)
+            {
+                UpdateTransforms(command.shaderProgramId, command.worldMatrixIndex, command.cameraChanged);
+            }
+            else
+            {
+                UpdateTransforms(command.shaderProgramId, command.worldMatrix, command.cameraChanged);
+            }
+            break;
+        }
+        case RenderCommandBuffer::CommandType::BindVAO:
+        {
+            RenderCommandBuffer::BindVAOCommand command = reader.Read<RenderCommandBuffer::BindVAOCommand>();
+            command.vao->Bind();
+            break;
+        }
+        case RenderCommandBuffer::CommandType::InstanceWorldMatrices:
+        {
+            RenderCommandBuffer::InstanceWorldMatricesCommand command = reader.Read<RenderCommandBuffer::InstanceWorldMatricesCommand>();
+            const VertexBufferObject* buffer = command.buffer ? command.buffer : instanceBuffer;
+            assert(buffer);
+
+            // Read one matrix per instance from the instance buffer, starting at the first instance of the batch, a column in each location
+            buffer->Bind();
+            GLsizei stride = sizeof(glm::mat4);
+            const unsigned char* pointer = nullptr; // Actual base pointer is in VBO
+            pointer += command.firstInstance * stride;
+            for (int column = 0; column < 4; ++column)
+            {
+                GLuint location = command.location + column;
+                glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, pointer + column * sizeof(glm::vec4));
+                glVertexAttribDivisor(location, 1);
+                glEnableVertexAttribArray(location);
+            }
+            VertexBufferObject::Unbind();
+            break;
+        }
+        case RenderCommandBuffer::CommandType::WorldMatrixAttribute:
+        {
+            // Single drawcall: disable the arrays and use a constant value for the attribute
+            RenderCommandBuffer::WorldMatrixAttributeCommand command = reader.Read<RenderCommandBuffer::WorldMatrixAttributeCommand>();
+            for (int column = 0; column < 4; ++column)
+            {
+                GLuint location = command.location + column;
+                glDisableVertexAttribArray(location);
+                glVertexAttrib4fv(location, &command.worldMatrix[column][0]);
+            }
+            break;
+        }
+        case RenderCommandBuffer::CommandType::Draw:
+        {
+            RenderCommandBuffer::DrawCommand command = reader.Read<RenderCommandBuffer::DrawCommand>();
+            drawLit(command.litShaderProgramId, [&]()
+                {
+                    if (command.instanceCount > 0)
+                    {
+                        command.drawcall.DrawInstanced(command.instanceCount);
+                    }
+                    else
+                    {
+                        command.drawcall.Draw();
+                    }
+                });
+            break;
+        }
+        case RenderCommandBuffer::CommandType::MultiDraw:
+        {
+            RenderCommandBuffer::MultiDrawCommand command = reader.Read<RenderCommandBuffer::MultiDrawCommand>();
+            assert(indirectBuffer);
+            assert(VertexArrayObject::IsAnyBound());
+
+            // With an indirect buffer bound, the pointer is an offset in the buffer
+            indirectBuffer->Bind();
+            const char* pointer = nullptr;
+            pointer += command.firstIndirectCommand * sizeof(RenderCommandBuffer::DrawElementsIndirectCommand);
+            drawLit(command.litShaderProgramId, [&]()
+                {
+                    glMultiDrawElementsIndirect(static_cast<GLenum>(command.primitive), static_cast<GLenum>(command.eboType), pointer, command.drawCount, 0);
+                });
+            RenderCommandBuffer::IndirectBufferObject::Unbind();
+            break;
+        }
+        }
+    }
+
+    // Materials are counted above, the rest when they were recorded
+    const StateChangeCounters& recordedCounters = commandBuffer.m_stateChangeCounters;
+    m_stateChangeCounters.shaderProgramsIssued += recordedCounters.shaderProgramsIssued;
+    m_stateChangeCounters.shaderProgramsSkipped += recordedCounters.shaderProgramsSkipped;
+    m_stateChangeCounters.vaosIssued += recordedCounters.vaosIssued;
+    m_stateChangeCounters.vaosSkipped += recordedCounters.vaosSkipped;
+    m_stateChangeCounters.transformsIssued += recordedCounters.transformsIssued;
+    m_stateChangeCounters.transformsSkipped += recordedCounters.transformsSkipped;
+
+    // The states cached for PrepareDrawcall are not the current ones anymore
+    if (&commandBuffer != m_immediateCommandBuffer.get())
+    {
+        m_immediateCommandBuffer->InvalidateStates();
+    }
 }
 
 void Renderer::SetLightingRenderStates(bool firstPass)
@@ -308,9 +1420,18 @@ void Renderer::SetLightingRenderStates(bool firstPass)
         m_device.SetFeatureEnabled(GL_BLEND, true);
         glDepthFunc(firstPass ? GL_LESS : GL_EQUAL);
         glBlendFunc(GL_ONE, GL_ONE);
+
+        // The material render states need to be set again for the next drawcall
+        m_renderStatesDirty = true;
     }
 }
 
+void Renderer::InvalidateStateCache()
+{
+    m_immediateCommandBuffer->InvalidateStates();
+    m_renderStatesDirty = true;
+}
+
 void Renderer::InitializeFullscreenMesh()
 {
     VertexFormat vertexFormat;
@@ -324,7 +1445,238 @@ void Renderer::InitializeFullscreenMesh()
     m_fullscreenMesh.AddSubmesh<glm::vec3, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles, fullscreenVertices, vertexFormat.LayoutBegin(3, false), vertexFormat.LayoutEnd());
 }
 
+void Renderer::InitializeUniformBlocks()
+{
+    // Members in the same order as the FrameData block in uniforms.glsl
+    m_frameDataLayout.AddMember<glm::mat4>("ViewMatrix");
+    m_frameDataLayout.AddMember<glm::mat4>("ProjMatrix");
+    m_frameDataLayout.AddMember<glm::mat4>("ViewProjMatrix");
+    m_frameDataLayout.AddMember<glm::mat4>("InvViewMatrix");
+    m_frameDataLayout.AddMember<glm::mat4>("InvProjMatrix");
+    m_frameDataLayout.AddMember<glm::vec3>("CameraPosition");
+
+    // Members in the same order as the PassData block in uniforms.glsl
+    m_passDataLayout.AddMember<glm::vec2>("TargetSize");
+    m_passDataLayout.AddMember<glm::vec2>("InvTargetSize");
+    m_passDataLayout.AddMember<glm::vec2>("ResolutionScale");
+
+    m_frameDataBuffer.Bind();
+    m_frameDataBuffer.AllocateData(m_frameDataLayout.GetSize());
+    m_passDataBuffer.Bind();
+    m_passDataBuffer.AllocateData(m_passDataLayout.GetSize());
+    UniformBufferObject::Unbind();
+
+    // The buffers stay bound to their binding points, programs only need to select the binding point
+    m_frameDataBuffer.BindBase(FrameDataBinding);
+    m_passDataBuffer.BindBase(PassDataBinding);
+
+    m_uniformBlockData.resize(std::max(m_frameDataLayout.GetSize(), m_passDataLayout.GetSize()));
+}
+
+void Renderer::UpdateFrameData()
+{
+    const glm::mat4& viewMatrix = m_currentCamera->GetViewMatrix();
+    const glm::mat4& projMatrix = m_currentCamera->GetProjectionMatrix();
+    glm::mat4 invViewMatrix = glm::inverse(viewMatrix);
+
+    std::span<std::byte> data(m_uniformBlockData.data(), m_frameDataLayout.GetSize());
+    m_frameDataLayout.SetValue(data, "ViewMatrix", viewMatrix);
+    m_frameDataLayout.SetValue(data, "ProjMatrix", projMatrix);
+    m_frameDataLayout.SetValue(data, "ViewProjMatrix", projMatrix * viewMatrix);
+    m_frameDataLayout.SetValue(data, "InvViewMatrix", invViewMatrix);
+    m_frameDataLayout.SetValue(data, "InvProjMatrix", glm::inverse(projMatrix));
+    m_frameDataLayout.SetValue(data, "CameraPosition", glm::vec3(invViewMatrix[3]));
+
+    m_frameDataBuffer.Bind();
+    m_frameDataBuffer.UpdateData(data);
+}
+
+void Renderer::UpdateTransformBatch()
+{
+    // Only the shader programs without update transforms function use the batch
+    if (!m_hasTransformUniforms)
+    {
+        m_transformBatch.Clear();
+        return;
+    }
+
+    Profiler::Scope scope("Transforms");
+    m_transformBatch.Compute(m_worldMatrices, m_currentCamera->GetViewMatrix(), m_currentCamera->GetProjectionMatrix());
+}
+
+void Renderer::UpdatePassData()
+{
+    // Passes render to the whole viewport, so it gives the size of the target
+    GLint x, y;
+    GLsizei width, height;
+    m_device.GetViewport(x, y, width, height);
+
+    glm::ivec2 targetSize(width, height);
+    if (targetSize == m_passDataTargetSize && m_resolutionScale == m_passDataResolutionScale)
+        return;
+
+    m_passDataTargetSize = targetSize;
+    m_passDataResolutionScale = m_resolutionScale;
+
+    std::span<std::byte> data(m_uniformBlockData.data(), m_passDataLayout.GetSize());
+    m_passDataLayout.SetValue(data, "TargetSize", glm::vec2(targetSize));
+    m_passDataLayout.SetValue(data, "InvTargetSize", 1.0f / glm::vec2(targetSize));
+    m_passDataLayout.SetValue(data, "ResolutionScale", m_resolutionScale);
+
+    m_passDataBuffer.Bind();
+    m_passDataBuffer.UpdateData(data);
+}
+
 const glm::mat4& Renderer::GetWorldMatrix(const DrawcallInfo& drawcallInfo) const
 {
     return m_worldMatrices[drawcallInfo.GetWorldMatrixIndex()];
 }
+
+ShaderProgram::Location Renderer::GetInstanceWorldMatrixLocation(ShaderProgramId shaderProgramId) const
+{
+    return shaderProgramId != InvalidShaderProgramId ? m_shaderPrograms[shaderProgramId].instanceWorldMatrixLocation : -1;
+}
+
+// Drawcalls with the same material, VAO and drawcall can be merged in a single instanced draw
+struct DrawcallBatchKey
+{
+    const Material* material;
+    const VertexArrayObject* vao;
+    const Drawcall* drawcall;
+
+    bool operator == (const DrawcallBatchKey& other) const
+    {
+        return material == other.material && vao == other.vao && drawcall == other.drawcall;
+    }
+};
+
+struct DrawcallBatchKeyHash
+{
+    size_t operator()(const DrawcallBatchKey& key) const
+    {
+        std::hash<const void*> hash;
+        size_t value = hash(key.material);
+        value ^= hash(key.vao) + 0x9e3779b9 + (value << 6) + (value >> 2);
+        value ^= hash(key.drawcall) + 0x9e3779b9 + (value << 6) + (value >> 2);
+        return value;
+    }
+};
+
+void Renderer::BuildDrawcallBatches(DrawcallCollection& collection) const
+{
+    std::vector<DrawcallBatch>& batches = collection.m_batches;
+    batches.clear();
+
+    // Batch of each drawcall, to gather the world matrices later
+    std::vector<unsigned int> drawcallBatchIndices;
+    drawcallBatchIndices.reserve(collection.m_drawcallInfos.size());
+
+    // Merge opaque drawcalls of instanced shader programs. Each batch stays where its first drawcall was.
+    // Translucent drawcalls are not merged, because their order matters, unless the collection is order independent
+    std::unordered_map<DrawcallBatchKey, unsigned int, DrawcallBatchKeyHash> batchIndices;
+    for (const DrawcallInfo& drawcallInfo : collection.m_drawcallInfos)
+    {
+        const Material& material = drawcallInfo.GetMaterial();
+        bool mergeable = !material.HasBlend() || collection.m_orderIndependent;
+        bool instanced = mergeable && GetInstanceWorldMatrixLocation(drawcallInfo.GetShaderProgramId()) >= 0;
+        if (instanced)
+        {
+            DrawcallBatchKey key{ &material, &drawcallInfo.GetVAO(), &drawcallInfo.GetDrawcall() };
+            auto result = batchIndices.try_emplace(key, static_cast<unsigned int>(batches.size()));
+            if (result.second)
+            {
+                batches.emplace_back(drawcallInfo, true);
+                batches.back().m_instanceCount = 0;
+            }
+            unsigned int batchIndex = result.first->second;
+            batches[batchIndex].m_instanceCount++;
+            drawcallBatchIndices.push_back(batchIndex);
+        }
+        else
+        {
+            batches.emplace_back(drawcallInfo, false);
+            drawcallBatchIndices.push_back(~0u);
+        }
+    }
+
+    // Assign a range in the instance buffer to each instanced batch
+    unsigned int instanceCount = 0;
+    for (DrawcallBatch& batch : batches)
+    {
+        if (batch.m_instanced)
+        {
+            batch.m_firstInstance = instanceCount;
+            instanceCount += batch.m_instanceCount;
+        }
+    }
+
+    // Gather the world matrices, in the same order as the drawcalls
+    std::vector<glm::mat4>& instanceWorldMatrices = collection.m_instanceWorldMatrices;
+    instanceWorldMatrices.resize(instanceCount);
+    std::vector<unsigned int> batchInstanceCounts(batches.size(), 0);
+    for (unsigned int i = 0; i < collection.m_drawcallInfos.size(); ++i)
+    {
+        unsigned int batchIndex = drawcallBatchIndices[i];
+        if (batchIndex != ~0u)
+        {
+            unsigned int instanceIndex = batches[batchIndex].m_firstInstance + batchInstanceCounts[batchIndex]++;
+            instanceWorldMatrices[instanceIndex] = GetWorldMatrix(collection.m_drawcallInfos[i]);
+        }
+    }
+
+    collection.m_batchesDirty = false;
+}
+
+Renderer::SortKey Renderer::ComputeSortKey(const Material& material, const VertexArrayObject& vao)
+{
+    const ShaderProgram* shaderProgram = material.GetShaderProgramPointer();
+    SortKey shaderProgramId = shaderProgram ? shaderProgram->GetHandle() : 0;
+    SortKey materialId = material.GetSortId();
+
+    SortKey vaoId = vao.GetHandle();
+
+    // Ids that don't fit are wrapped around. That could only break the grouping, never the order of translucent objects
+    SortKey state = shaderProgramId & ((SortKey(1) << s_sortKeyShaderProgramBits) - 1);
+    state = (state << s_sortKeyMaterialBits) | (materialId & ((SortKey(1) << s_sortKeyMaterialBits) - 1));
+    state = (state << s_sortKeyVAOBits) | (vaoId & ((SortKey(1) << s_sortKeyVAOBits) - 1));
+
+    SortKey sortKey = 0;
+    if (material.HasBlend())
+    {
+        // Translucent: depth goes first, set later in UpdateSortKeyDepths
+        sortKey |= (SortKey(1) << s_sortKeyTranslucentShift) | state;
+    }
+    else
+    {
+        // Opaque: state goes first, depth is only used for drawcalls with the same state
+        sortKey |= state << s_sortKeyDepthBits;
+    }
+    return sortKey;
+}
+
+void Renderer::UpdateSortKeyDepths(DrawcallCollection& collection) const
+{
+    // The camera may be set after the models are added, so depth is computed once per drawcall right before sorting
+    const glm::mat4& viewMatrix = GetCurrentCamera().GetViewMatrix();
+
+    for (DrawcallInfo& drawcallInfo : collection.GetDrawcalls())
+    {
+        // Camera looks towards negative Z in view space
+        float viewDepth = -(viewMatrix * GetWorldMatrix(drawcallInfo)[3]).z;
+        SortKey depth = QuantizeSortDepth(viewDepth);
+
+        SortKey sortKey = drawcallInfo.GetSortKey();
+        if (sortKey & (SortKey(1) << s_sortKeyTranslucentShift))
+        {
+            // Reverse the depth to sort back to front
+            sortKey &= ~(s_sortKeyDepthMask << s_sortKeyStateBits);
+            sortKey |= (s_sortKeyDepthMask - depth) << s_sortKeyStateBits;
+        }
+        else
+        {
+            sortKey &= ~s_sortKeyDepthMask;
+            sortKey |= depth;
+        }
+        drawcallInfo.SetSortKey(sortKey);
+    }
+}
@@ -0,0 +1,251 @@
+#include <ituGL/renderer/TransformBatch.h>
+
+#include <glm/matrix.hpp>
+#include <algorithm>
+#include <cassert>
+
+// Lanes of a SIMD register, one matrix per lane. The kernels are written once with these helpers
+#if defined(__AVX__)
+#include <immintrin.h>
+#define ITUGL_TRANSFORM_BATCH_SIMD "AVX"
+using Lanes = __m256;
+static constexpr unsigned int s_laneCount = 8;
+static inline Lanes LoadLanes(const float* data) { return _mm256_loadu_ps(data); }
+static inline void StoreLanes(float* data, Lanes value) { _mm256_storeu_ps(data, value); }
+static inline Lanes SetLanes(float value) { return _mm256_set1_ps(value); }
+static inline Lanes AddLanes(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+static inline Lanes SubLanes(Lanes a, Lanes b) { return _mm256_sub_ps(a, b); }
+static inline Lanes MulLanes(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+static inline Lanes DivLanes(Lanes a, Lanes b) { return _mm256_div_ps(a, b); }
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ITUGL_TRANSFORM_BATCH_SIMD "SSE2"
+using Lanes = __m128;
+static constexpr unsigned int s_laneCount = 4;
+static inline Lanes LoadLanes(const float* data) { return _mm_loadu_ps(data); }
+static inline void StoreLanes(float* data, Lanes value) { _mm_storeu_ps(data, value); }
+static inline Lanes SetLanes(float value) { return _mm_set1_ps(value); }
+static inline Lanes AddLanes(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+static inline Lanes SubLanes(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+static inline Lanes MulLanes(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+static inline Lanes DivLanes(Lanes a, Lanes b) { return _mm_div_ps(a, b); }
+#else
+static constexpr unsigned int s_laneCount = 1;
+#endif
+
+#ifdef ITUGL_TRANSFORM_BATCH_SIMD
+// out = matrix * in, for the first count matrices in the arrays. The constant matrix is broadcast to all the lanes
+static void MultiplyLanes(const glm::mat4& matrix, const float* in, float* out, unsigned int count, unsigned int stride)
+{
+    Lanes broadcast[4][4];
+    for (int k = 0; k < 4; ++k)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            broadcast[k][row] = SetLanes(matrix[k][row]);
+        }
+    }
+
+    for (unsigned int i = 0; i < count; i += s_laneCount)
+    {
+        for (int column = 0; column < 4; ++column)
+        {
+            Lanes inColumn[4];
+            for (int k = 0; k < 4; ++k)
+            {
+                inColumn[k] = LoadLanes(in + (column * 4 + k) * stride + i);
+            }
+
+            for (int row = 0; row < 4; ++row)
+            {
+                Lanes value = MulLanes(broadcast[0][row], inColumn[0]);
+                value = AddLanes(value, MulLanes(broadcast[1][row], inColumn[1]));
+                value = AddLanes(value, MulLanes(broadcast[2][row], inColumn[2]));
+                value = AddLanes(value, MulLanes(broadcast[3][row], inColumn[3]));
+                StoreLanes(out + (column * 4 + row) * stride + i, value);
+            }
+        }
+    }
+}
+
+// Inverse transpose of the upper 3x3 of the matrices. With columns a, b, c, its columns are b x c, c x a and a x b over the determinant
+static void NormalMatrixLanes(const float* in, float* out, unsigned int count, unsigned int stride)
+{
+    for (unsigned int i = 0; i < count; i += s_laneCount)
+    {
+        Lanes m[3][3];
+        for (int column = 0; column < 3; ++column)
+        {
+            for (int row = 0; row < 3; ++row)
+            {
+                m[column][row] = LoadLanes(in + (column * 4 + row) * stride + i);
+            }
+        }
+
+        Lanes cross[3][3];
+        for (int column = 0; column < 3; ++column)
+        {
+            const Lanes* a = m[(column + 1) % 3];
+            const Lanes* b = m[(column + 2) % 3];
+            cross[column][0] = SubLanes(MulLanes(a[1], b[2]), MulLanes(a[2], b[1]));
+            cross[column][1] = SubLanes(MulLanes(a[2], b[0]), MulLanes(a[0], b[2]));
+            cross[column][2] = SubLanes(MulLanes(a[0], b[1]), MulLanes(a[1], b[0]));
+        }
+
+        Lanes determinant = MulLanes(m[0][0], cross[0][0]);
+        determinant = AddLanes(determinant, MulLanes(m[0][1], cross[0][1]));
+        determinant = AddLanes(determinant, MulLanes(m[0][2], cross[0][2]));
+
+        for (int column = 0; column < 3; ++column)
+        {
+            for (int row = 0; row < 3; ++row)
+            {
+                StoreLanes(out + (column * 3 + row) * stride + i, DivLanes(cross[column][row], determinant));
+            }
+        }
+    }
+}
+#endif
+
+TransformBatch::TransformBatch() : m_count(0), m_stride(0)
+{
+}
+
+void TransformBatch::Compute(std::span<const glm::mat4> worldMatrices, const glm::mat4& viewMatrix, const glm::mat4& projMatrix, Kernel kernel)
+{
+    Allocate(static_cast<unsigned int>(worldMatrices.size()));
+
+#ifdef ITUGL_TRANSFORM_BATCH_SIMD
+    if (kernel == Kernel::Simd)
+    {
+        ComputeSimd(worldMatrices, viewMatrix, projMatrix);
+        return;
+    }
+#endif
+    ComputeGlm(worldMatrices, viewMatrix, projMatrix);
+}
+
+void TransformBatch::Clear()
+{
+    m_count = 0;
+}
+
+glm::mat4 TransformBatch::GetWorldViewMatrix(unsigned int index) const
+{
+    assert(index < m_count);
+    glm::mat4 matrix;
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            matrix[column][row] = m_worldViewMatrices[(column * 4 + row) * m_stride + index];
+        }
+    }
+    return matrix;
+}
+
+glm::mat4 TransformBatch::GetWorldViewProjMatrix(unsigned int index) const
+{
+    assert(index < m_count);
+    glm::mat4 matrix;
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            matrix[column][row] = m_worldViewProjMatrices[(column * 4 + row) * m_stride + index];
+        }
+    }
+    return matrix;
+}
+
+glm::mat3 TransformBatch::GetNormalMatrix(unsigned int index) const
+{
+    assert(index < m_count);
+    glm::mat3 matrix;
+    for (int column = 0; column < 3; ++column)
+    {
+        for (int row = 0; row < 3; ++row)
+        {
+            matrix[column][row] = m_normalMatrices[(column * 3 + row) * m_stride + index];
+        }
+    }
+    return matrix;
+}
+
+const char* TransformBatch::GetSimdName()
+{
+#ifdef ITUGL_TRANSFORM_BATCH_SIMD
+    return ITUGL_TRANSFORM_BATCH_SIMD;
+#else
+    return "none";
+#endif
+}
+
+void TransformBatch::Allocate(unsigned int count)
+{
+    m_count = count;
+
+    // Arrays only grow, to avoid allocations when the number of matrices changes a little every frame
+    unsigned int stride = (count + s_laneCount - 1) / s_laneCount * s_laneCount;
+    if (stride > m_stride)
+    {
+        m_stride = std::max(stride, m_stride * 2);
+        m_worldMatrices.resize(16 * m_stride);
+        m_worldViewMatrices.resize(16 * m_stride);
+        m_worldViewProjMatrices.resize(16 * m_stride);
+        m_normalMatrices.resize(9 * m_stride);
+    }
+}
+
+void TransformBatch::ComputeGlm(std::span<const glm::mat4> worldMatrices, const glm::mat4& viewMatrix, const glm::mat4& projMatrix)
+{
+    for (unsigned int i = 0; i < m_count; ++i)
+    {
+        glm::mat4 worldViewMatrix = viewMatrix * worldMatrices[i];
+        glm::mat4 worldViewProjMatrix = projMatrix * worldViewMatrix;
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(worldViewMatrix)));
+
+        for (int column = 0; column < 4; ++column)
+        {
+            for (int row = 0; row < 4; ++row)
+            {
+                m_worldMatrices[(column * 4 + row) * m_stride + i] = worldMatrices[i][column][row];
+                m_worldViewMatrices[(column * 4 + row) * m_stride + i] = worldViewMatrix[column][row];
+                m_worldViewProjMatrices[(column * 4 + row) * m_stride + i] = worldViewProjMatrix[column][row];
+            }
+        }
+        for (int column = 0; column < 3; ++column)
+        {
+            for (int row = 0; row < 3; ++row)
+            {
+                m_normalMatrices[(column * 3 + row) * m_stride + i] = normalMatrix[column][row];
+            }
+        }
+    }
+}
+
+void TransformBatch::ComputeSimd(std::span<const glm::mat4> worldMatrices, const glm::mat4& viewMatrix, const glm::mat4& projMatrix)
+{
+#ifdef ITUGL_TRANSFORM_BATCH_SIMD
+    // The arrays can be much larger than the matrices of this frame, only the last SIMD lanes are padded and computed
+    unsigned int paddedCount = (m_count + s_laneCount - 1) / s_laneCount * s_laneCount;
+
+    // Scatter the world matrices to the arrays. The padding gets identity matrices, so the normal matrices are finite
+    for (int component = 0; component < 16; ++component)
+    {
+        float* worldComponent = m_worldMatrices.data() + component * m_stride;
+        int column = component / 4, row = component % 4;
+        for (unsigned int i = 0; i < m_count; ++i)
+        {
+            worldComponent[i] = worldMatrices[i][column][row];
+        }
+        std::fill(worldComponent + m_count, worldComponent + paddedCount, column == row ? 1.0f : 0.0f);
+    }
+
+    MultiplyLanes(viewMatrix, m_worldMatrices.data(), m_worldViewMatrices.data(), paddedCount, m_stride);
+    MultiplyLanes(projMatrix, m_worldViewMatrices.data(), m_worldViewProjMatrices.data(), paddedCount, m_stride);
+    NormalMatrixLanes(m_worldViewMatrices.data(), m_normalMatrices.data(), paddedCount, m_stride);
+#else
+    ComputeGlm(worldMatrices, viewMatrix, projMatrix);
+#endif
+}
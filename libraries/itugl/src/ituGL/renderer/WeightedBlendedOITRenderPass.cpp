@@ -0,0 +1,124 @@
+#include <ituGL/renderer/WeightedBlendedOITRenderPass.h>
+
+#include <ituGL/shader/Material.h>
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/geometry/MeshPool.h>
+#include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/texture/FramebufferObject.h>
+
+WeightedBlendedOITRenderPass::WeightedBlendedOITRenderPass(int width, int height, std::shared_ptr<const Texture2DObject> depthTexture, int drawcallCollectionIndex)
+    : m_drawcallCollectionIndex(drawcallCollectionIndex)
+    , m_static(false)
+    , m_meshPoolGeneration(0)
+{
+    InitTextures(width, height);
+    InitFramebuffer(depthTexture);
+}
+
+WeightedBlendedOITRenderPass::WeightedBlendedOITRenderPass(int drawcallCollectionIndex)
+    : m_drawcallCollectionIndex(drawcallCollectionIndex)
+    , m_static(false)
+    , m_meshPoolGeneration(0)
+{
+}
+
+void WeightedBlendedOITRenderPass::SetStatic(bool isStatic)
+{
+    m_static = isStatic;
+    m_commandBuffers.clear();
+}
+
+void WeightedBlendedOITRenderPass::InitFramebuffer(std::shared_ptr<const Texture2DObject> depthTexture)
+{
+    std::shared_ptr<FramebufferObject> targetFramebuffer = std::make_shared<FramebufferObject>();
+
+    targetFramebuffer->Bind();
+
+    // Depth of the opaque passes, only for testing
+    if (depthTexture)
+    {
+        targetFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Depth, *depthTexture);
+    }
+
+    targetFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color0, *m_accumulationTexture);
+    targetFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color1, *m_revealageTexture);
+
+    targetFramebuffer->SetDrawBuffers(std::array<FramebufferObject::Attachment, 2>(
+        {
+            FramebufferObject::Attachment::Color0,
+            FramebufferObject::Attachment::Color1
+        }));
+
+    m_targetFramebuffer = targetFramebuffer;
+
+    FramebufferObject::Unbind();
+}
+
+void WeightedBlendedOITRenderPass::InitTextures(int width, int height)
+{
+    // Accumulation: sums of weighted colors go well over 1, so it needs a float format
+    m_accumulationTexture = std::make_shared<Texture2DObject>();
+    m_accumulationTexture->Bind();
+    m_accumulationTexture->SetImage(0, width, height, TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA16F);
+    m_accumulationTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
+    m_accumulationTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
+
+    // Revealage: product of (1 - alpha), always in [0, 1]
+    m_revealageTexture = std::make_shared<Texture2DObject>();
+    m_revealageTexture->Bind();
+    m_revealageTexture->SetImage(0, width, height, TextureObject::FormatR, TextureObject::InternalFormatR8);
+    m_revealageTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
+    m_revealageTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
+
+    Texture2DObject::Unbind();
+}
+
+void WeightedBlendedOITRenderPass::Render()
+{
+    Renderer& renderer = GetRenderer();
+    DeviceGL& device = renderer.GetDevice();
+
+    // Nothing accumulated, and the opaque image fully revealed
+    const GLfloat accumulationClear[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const GLfloat revealageClear[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glClearBufferfv(GL_COLOR, 0, accumulationClear);
+    glClearBufferfv(GL_COLOR, 1, revealageClear);
+
+    // Both blend functions are commutative, so the order of the drawcalls doesn't matter
+    device.EnableFeature(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFunci(0, GL_ONE, GL_ONE);
+    glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+
+    // Hidden by the opaque surfaces, but never hiding each other
+    device.EnableFeature(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_FALSE);
+
+    // Record the drawcall batches, keeping the states set here instead of the ones of the materials
+    // Without lighting: the additional light passes would also multiply the revealage once per light
+    if (!m_static || m_commandBuffers.empty() || m_meshPoolGeneration != MeshPool::GetDefragmentGeneration())
+    {
+        m_meshPoolGeneration = MeshPool::GetDefragmentGeneration();
+#ifndef NDEBUG
+        for (const Renderer::DrawcallInfo& drawcallInfo : renderer.GetDrawcalls(m_drawcallCollectionIndex))
+        {
+            assert(drawcallInfo.GetMaterial().HasBlend());
+        }
+#endif
+
+        Material::OverrideFlags materialOverride = static_cast<Material::OverrideFlags>(Material::OverrideBlend | Material::OverrideDepthTest);
+        renderer.RecordDrawcallCollection(m_commandBuffers, m_drawcallCollectionIndex, false, materialOverride);
+    }
+
+    for (RenderCommandBuffer& commandBuffer : m_commandBuffers)
+    {
+        renderer.ExecuteCommandBuffer(commandBuffer);
+    }
+
+    // Restore default values
+    glBlendFunc(GL_ONE, GL_ZERO);
+    device.DisableFeature(GL_BLEND);
+    glDepthMask(GL_TRUE);
+    renderer.InvalidateStateCache();
+}
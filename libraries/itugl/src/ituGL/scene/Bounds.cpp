@@ -1,5 +1,15 @@
 #include <ituGL/scene/Bounds.h>
 
+#include <ituGL/camera/Camera.h>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#define ITUGL_BOUNDS_SSE
+#endif
+
 SphereBounds::SphereBounds(const Bounds& bounds) : Bounds(bounds.GetCenter()), m_radius(0.0f)
 {
     switch (bounds.GetType())
@@ -8,10 +18,10 @@ SphereBounds::SphereBounds(const Bounds& bounds) : Bounds(bounds.GetCenter()), m
         m_radius = static_cast<const SphereBounds&>(bounds).GetRadius();
         break;
     case Type::AABB:
-        m_radius = static_cast<const AabbBounds&>(bounds).GetSize().length();
+        m_radius = glm::length(static_cast<const AabbBounds&>(bounds).GetSize());
         break;
     case Type::Box:
-        m_radius = static_cast<const BoxBounds&>(bounds).GetSize().length();
+        m_radius = glm::length(static_cast<const BoxBounds&>(bounds).GetSize());
         break;
     default:
         assert(false);
@@ -30,10 +40,9 @@ AabbBounds::AabbBounds(const Bounds& bounds) : Bounds(bounds.GetCenter()), m_siz
         break;
     case Type::Box:
         {
+            // The extent on each axis is the sum of the projections of the 3 box axes
             glm::mat3 scaledMatrix = static_cast<const BoxBounds&>(bounds).GetScaledMatrix();
-            m_size = glm::abs(scaledMatrix[0]);
-            m_size = glm::max(m_size, glm::abs(scaledMatrix[1]));
-            m_size = glm::max(m_size, glm::abs(scaledMatrix[2]));
+            m_size = glm::abs(scaledMatrix[0]) + glm::abs(scaledMatrix[1]) + glm::abs(scaledMatrix[2]);
         }
         break;
     default:
@@ -61,6 +70,122 @@ BoxBounds::BoxBounds(const Bounds& bounds) : RotatedBounds(bounds.GetCenter(), g
     }
 }
 
+BoxBounds::BoxBounds(const AabbBounds& localBounds, const glm::mat4& worldMatrix)
+    : RotatedBounds(worldMatrix * glm::vec4(localBounds.GetCenter(), 1.0f), glm::mat3(1.0f)), m_size(0.0f)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        glm::vec3 axis(worldMatrix[i]);
+        float scale = glm::length(axis);
+        if (scale > 0.0f)
+        {
+            m_rotationMatrix[i] = axis / scale;
+        }
+        m_size[i] = scale * localBounds.GetSize()[i];
+    }
+}
+
+FrustumBounds::FrustumBounds(const glm::mat4& viewProjMatrix) : Bounds(glm::vec3(0.0f))
+{
+    SetViewProjectionMatrix(viewProjMatrix);
+}
+
+FrustumBounds::FrustumBounds(const Camera& camera) : FrustumBounds(camera.GetViewProjectionMatrix())
+{
+}
+
+void FrustumBounds::SetViewProjectionMatrix(const glm::mat4& viewProjMatrix)
+{
+    // Rows of the matrix (glm matrices are column major)
+    glm::mat4 rows = glm::transpose(viewProjMatrix);
+    m_planes[0] = rows[3] + rows[0];
+    m_planes[1] = rows[3] - rows[0];
+    m_planes[2] = rows[3] + rows[1];
+    m_planes[3] = rows[3] - rows[1];
+    m_planes[4] = rows[3] + rows[2];
+    m_planes[5] = rows[3] - rows[2];
+
+    for (int i = 0; i < 8; ++i)
+    {
+        // Normalize, so the plane equation gives the signed distance
+        glm::vec4& plane = m_planes[i % 6];
+        if (i < 6)
+        {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        m_planesX[i] = plane.x;
+        m_planesY[i] = plane.y;
+        m_planesZ[i] = plane.z;
+        m_planesW[i] = plane.w;
+    }
+
+    // Center of the NDC cube, in world space
+    glm::vec4 center = glm::inverse(viewProjMatrix) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    m_center = glm::vec3(center) / center.w;
+}
+
+bool FrustumBounds::IntersectsSphere(const glm::vec3& center, float radius) const
+{
+    // A sphere is a box without axes, with the radius as extent on every plane
+    return IntersectsPlanes(center, glm::mat3(0.0f), radius);
+}
+
+bool FrustumBounds::IntersectsBox(const glm::vec3& center, const glm::mat3& scaledAxes) const
+{
+    return IntersectsPlanes(center, scaledAxes, 0.0f);
+}
+
+bool FrustumBounds::IntersectsPlanes(const glm::vec3& center, const glm::mat3& scaledAxes, float radius) const
+{
+#ifdef ITUGL_BOUNDS_SSE
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 centerX = _mm_set1_ps(center.x);
+    const __m128 centerY = _mm_set1_ps(center.y);
+    const __m128 centerZ = _mm_set1_ps(center.z);
+    const __m128 extent = _mm_set1_ps(radius);
+    for (int i = 0; i < 8; i += 4)
+    {
+        __m128 planeX = _mm_load_ps(m_planesX + i);
+        __m128 planeY = _mm_load_ps(m_planesY + i);
+        __m128 planeZ = _mm_load_ps(m_planesZ + i);
+
+        // Signed distance from the center to 4 planes
+        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_load_ps(m_planesW + i), extent),
+            _mm_add_ps(_mm_mul_ps(planeX, centerX), _mm_add_ps(_mm_mul_ps(planeY, centerY), _mm_mul_ps(planeZ, centerZ))));
+
+        // Extent of the box along the plane normals
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const glm::vec3& scaledAxis = scaledAxes[axis];
+            __m128 projection = _mm_add_ps(_mm_mul_ps(planeX, _mm_set1_ps(scaledAxis.x)),
+                _mm_add_ps(_mm_mul_ps(planeY, _mm_set1_ps(scaledAxis.y)), _mm_mul_ps(planeZ, _mm_set1_ps(scaledAxis.z))));
+            distance = _mm_add_ps(distance, _mm_andnot_ps(signMask, projection));
+        }
+
+        if (_mm_movemask_ps(_mm_cmplt_ps(distance, _mm_setzero_ps())))
+        {
+            return false;
+        }
+    }
+    return true;
+#else
+    for (const glm::vec4& plane : m_planes)
+    {
+        glm::vec3 normal(plane);
+        float distance = glm::dot(normal, center) + plane.w + radius;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            distance += std::abs(glm::dot(normal, scaledAxes[axis]));
+        }
+        if (distance < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
 template<>
 bool Bounds::Intersects(const SphereBounds& boundsA, const SphereBounds& boundsB)
 {
@@ -100,7 +225,8 @@ bool Bounds::Intersects(const BoxBounds& boundsA, const AabbBounds& boundsB)
     return Bounds::Intersects(boundsA, BoxBounds(boundsB.GetCenter(), glm::mat3(1.0f), boundsB.GetSize()));
 }
 
-bool TestSeparationAxis(const glm::vec3& axis, const glm::vec3& distance, const glm::mat3& mA, const glm::mat3& mB)
+// Returns true if the projections of both boxes on the axis don't overlap
+static bool TestSeparationAxis(const glm::vec3& axis, const glm::vec3& distance, const glm::mat3& mA, const glm::mat3& mB)
 {
     float projDistance = std::abs(glm::dot(distance, axis));
     float projSize = 0.0f;
@@ -109,7 +235,8 @@ bool TestSeparationAxis(const glm::vec3& axis, const glm::vec3& distance, const
         projSize += std::abs(glm::dot(mA[i], axis));
         projSize += std::abs(glm::dot(mB[i], axis));
     }
-    return projSize <= projDistance;
+    // Degenerate axes (cross product of parallel axes) have size and distance 0, and never separate
+    return projSize < projDistance;
 }
 
 template<>
@@ -117,38 +244,46 @@ bool Bounds::Intersects(const BoxBounds& boundsA, const BoxBounds& boundsB)
 {
     glm::vec3 distance = boundsB.GetCenter() - boundsA.GetCenter();
     glm::mat3 mA = boundsA.GetScaledMatrix();
-    glm::mat3 mB = boundsA.GetScaledMatrix();
-    return TestSeparationAxis(boundsA.GetXVector(), distance, mA, mB)
-        && TestSeparationAxis(boundsA.GetYVector(), distance, mA, mB)
-        && TestSeparationAxis(boundsA.GetZVector(), distance, mA, mB)
-        && TestSeparationAxis(boundsB.GetXVector(), distance, mA, mB)
-        && TestSeparationAxis(boundsB.GetYVector(), distance, mA, mB)
-        && TestSeparationAxis(boundsB.GetZVector(), distance, mA, mB)
-        && TestSeparationAxis(glm::cross(boundsA.GetXVector(), boundsB.GetXVector()), distance, mA, mB)
-        && TestSeparationAxis(glm::cross(boundsA.GetXVector(), boundsB.GetYVector()), distance, mA, mB)
-        && TestSeparationAxis(glm::cross(boundsA.GetXVector(), boundsB.GetZVector()), distance, mA, mB)
-        && TestSeparationAxis(glm::cross(boundsA.GetYVector(), boundsB.GetXVector()), distance, mA, mB)
-        && TestSeparationAxis(glm::cross(boundsA.GetYVector(), boundsB.GetYVector()), distance, mA, mB)
-        && TestSeparationAxis(glm::cross(boundsA.GetYVector(), boundsB.GetZVector()), distance, mA, mB)
-        && TestSeparationAxis(glm::cross(boundsA.GetZVector(), boundsB.GetXVector()), distance, mA, mB)
-        && TestSeparationAxis(glm::cross(boundsA.GetZVector(), boundsB.GetYVector()), distance, mA, mB)
-        && TestSeparationAxis(glm::cross(boundsA.GetZVector(), boundsB.GetZVector()), distance, mA, mB);
+    glm::mat3 mB = boundsB.GetScaledMatrix();
+    return !(TestSeparationAxis(boundsA.GetXVector(), distance, mA, mB)
+        || TestSeparationAxis(boundsA.GetYVector(), distance, mA, mB)
+        || TestSeparationAxis(boundsA.GetZVector(), distance, mA, mB)
+        || TestSeparationAxis(boundsB.GetXVector(), distance, mA, mB)
+        || TestSeparationAxis(boundsB.GetYVector(), distance, mA, mB)
+        || TestSeparationAxis(boundsB.GetZVector(), distance, mA, mB)
+        || TestSeparationAxis(glm::cross(boundsA.GetXVector(), boundsB.GetXVector()), distance, mA, mB)
+        || TestSeparationAxis(glm::cross(boundsA.GetXVector(), boundsB.GetYVector()), distance, mA, mB)
+        || TestSeparationAxis(glm::cross(boundsA.GetXVector(), boundsB.GetZVector()), distance, mA, mB)
+        || TestSeparationAxis(glm::cross(boundsA.GetYVector(), boundsB.GetXVector()), distance, mA, mB)
+        || TestSeparationAxis(glm::cross(boundsA.GetYVector(), boundsB.GetYVector()), distance, mA, mB)
+        || TestSeparationAxis(glm::cross(boundsA.GetYVector(), boundsB.GetZVector()), distance, mA, mB)
+        || TestSeparationAxis(glm::cross(boundsA.GetZVector(), boundsB.GetXVector()), distance, mA, mB)
+        || TestSeparationAxis(glm::cross(boundsA.GetZVector(), boundsB.GetYVector()), distance, mA, mB)
+        || TestSeparationAxis(glm::cross(boundsA.GetZVector(), boundsB.GetZVector()), distance, mA, mB));
 }
 
 template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const SphereBounds& boundsB)
 {
-    return true;
+    return boundsA.IntersectsSphere(boundsB.GetCenter(), boundsB.GetRadius());
 }
 
 template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const AabbBounds& boundsB)
 {
-    return true;
+    const glm::vec3& size = boundsB.GetSize();
+    return boundsA.IntersectsBox(boundsB.GetCenter(), glm::mat3(size.x, 0.0f, 0.0f, 0.0f, size.y, 0.0f, 0.0f, 0.0f, size.z));
 }
 
 template<>
 bool Bounds::Intersects(const FrustumBounds& boundsA, const BoxBounds& boundsB)
+{
+    return boundsA.IntersectsBox(boundsB.GetCenter(), boundsB.GetScaledMatrix());
+}
+
+// Not supported: conservative, frustums always intersect
+template<>
+bool Bounds::Intersects(const FrustumBounds&, const FrustumBounds&)
 {
     return true;
 }
@@ -163,6 +298,8 @@ bool Bounds::Intersects(const Bounds& boundsA, const Bounds& boundsB)
         return Bounds::Intersects(static_cast<const AabbBounds&>(boundsA), boundsB);
     case Type::Box:
         return Bounds::Intersects(static_cast<const BoxBounds&>(boundsA), boundsB);
+    case Type::Frustum:
+        return Bounds::Intersects(static_cast<const FrustumBounds&>(boundsA), boundsB);
     default:
         assert(false);
         return false;
@@ -0,0 +1,462 @@
+#include <ituGL/scene/OcclusionBuffer.h>
+
+#include <ituGL/utils/ThreadPool.h>
+#include <glm/vec4.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ITUGL_OCCLUSION_BUFFER_SIMD "SSE2"
+#endif
+
+// Triangles are clipped to this many times the screen size, to keep the screen coordinates in a range with enough precision
+static constexpr float s_guardBand = 4.0f;
+
+// Clip planes, as dot products with the clip space position: near plane and the 4 sides of the guard band
+static const glm::vec4 s_clipPlanes[] =
+{
+    glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),
+    glm::vec4(1.0f, 0.0f, 0.0f, s_guardBand),
+    glm::vec4(-1.0f, 0.0f, 0.0f, s_guardBand),
+    glm::vec4(0.0f, 1.0f, 0.0f, s_guardBand),
+    glm::vec4(0.0f, -1.0f, 0.0f, s_guardBand),
+};
+static constexpr unsigned int s_clipPlaneCount = sizeof(s_clipPlanes) / sizeof(s_clipPlanes[0]);
+
+// A triangle clipped by all the planes has at most one extra vertex per plane
+static constexpr unsigned int s_maxClippedVertices = 3 + s_clipPlaneCount;
+
+// Boxes must be this much behind the occluders to be hidden, to absorb the error of the interpolated depths
+static constexpr float s_depthBias = 1e-5f;
+
+// Triangles with a smaller area, in square pixels, don't cover any pixel in a stable way
+static constexpr float s_minTriangleArea = 1e-6f;
+
+OcclusionBuffer::OcclusionBuffer(unsigned int width, unsigned int height)
+    : m_width(0), m_height(0), m_tileCountX(0), m_tileCountY(0), m_viewProjMatrix(1.0f)
+{
+    SetResolution(width, height);
+}
+
+void OcclusionBuffer::SetResolution(unsigned int width, unsigned int height)
+{
+    assert(width > 0 && height > 0);
+
+    m_tileCountX = (width + TileSize - 1) / TileSize;
+    m_tileCountY = (height + TileSize - 1) / TileSize;
+    m_width = m_tileCountX * TileSize;
+    m_height = m_tileCountY * TileSize;
+
+    m_depths.assign(m_width * m_height, 1.0f);
+    m_tileMaxDepths.assign(m_tileCountX * m_tileCountY, 1.0f);
+    m_tileTriangles.resize(m_tileCountX * m_tileCountY);
+}
+
+void OcclusionBuffer::Clear(const glm::mat4& viewProjMatrix)
+{
+    m_viewProjMatrix = viewProjMatrix;
+    m_triangles.clear();
+}
+
+void OcclusionBuffer::AddOccluder(std::span<const glm::vec3> vertices, std::span<const unsigned int> indices, const glm::mat4& worldMatrix)
+{
+    assert(indices.size() % 3 == 0);
+
+    glm::mat4 matrix = m_viewProjMatrix * worldMatrix;
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        assert(indices[i] < vertices.size() && indices[i + 1] < vertices.size() && indices[i + 2] < vertices.size());
+        AddClipTriangle(matrix * glm::vec4(vertices[indices[i]], 1.0f),
+            matrix * glm::vec4(vertices[indices[i + 1]], 1.0f),
+            matrix * glm::vec4(vertices[indices[i + 2]], 1.0f));
+    }
+}
+
+void OcclusionBuffer::AddOccluder(const AabbBounds& localBounds, const glm::mat4& worldMatrix)
+{
+    static const unsigned int indices[] =
+    {
+        0, 2, 1,  1, 2, 3, // -Z
+        4, 5, 6,  5, 7, 6, // +Z
+        0, 1, 4,  1, 5, 4, // -Y
+        2, 6, 3,  3, 6, 7, // +Y
+        0, 4, 2,  2, 4, 6, // -X
+        1, 3, 5,  3, 7, 5, // +X
+    };
+
+    glm::vec3 min = localBounds.GetMin();
+    glm::vec3 max = localBounds.GetMax();
+    glm::vec3 vertices[8];
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        vertices[i] = glm::vec3(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+    }
+
+    AddOccluder(vertices, indices, worldMatrix);
+}
+
+void OcclusionBuffer::AddClipTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2)
+{
+    // Skip the clipping if the triangle is inside all the planes, and drop it if it is outside any of them
+    unsigned int insideMask = 0;
+    for (unsigned int planeIndex = 0; planeIndex < s_clipPlaneCount; ++planeIndex)
+    {
+        const glm::vec4& plane = s_clipPlanes[planeIndex];
+        unsigned int inside = (glm::dot(plane, v0) >= 0.0f) + (glm::dot(plane, v1) >= 0.0f) + (glm::dot(plane, v2) >= 0.0f);
+        if (inside == 0)
+        {
+            return;
+        }
+        insideMask |= (inside == 3) << planeIndex;
+    }
+
+    if (insideMask == (1u << s_clipPlaneCount) - 1)
+    {
+        AddScreenTriangle(v0, v1, v2);
+        return;
+    }
+
+    // Sutherland-Hodgman, only against the planes crossed by the triangle
+    glm::vec4 polygon[s_maxClippedVertices] = { v0, v1, v2 };
+    glm::vec4 clipped[s_maxClippedVertices];
+    unsigned int vertexCount = 3;
+    for (unsigned int planeIndex = 0; planeIndex < s_clipPlaneCount && vertexCount >= 3; ++planeIndex)
+    {
+        if (insideMask & (1u << planeIndex))
+        {
+            continue;
+        }
+
+        const glm::vec4& plane = s_clipPlanes[planeIndex];
+        unsigned int clippedCount = 0;
+        for (unsigned int i = 0; i < vertexCount; ++i)
+        {
+            const glm::vec4& current = polygon[i];
+            const glm::vec4& next = polygon[(i + 1) % vertexCount];
+            float currentDistance = glm::dot(plane, current);
+            float nextDistance = glm::dot(plane, next);
+            if (currentDistance >= 0.0f)
+            {
+                clipped[clippedCount++] = current;
+            }
+            if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+            {
+                float t = currentDistance / (currentDistance - nextDistance);
+                clipped[clippedCount++] = current + (next - current) * t;
+            }
+        }
+        assert(clippedCount <= s_maxClippedVertices);
+
+        std::copy(clipped, clipped + clippedCount, polygon);
+        vertexCount = clippedCount;
+    }
+
+    // Fan of triangles in the same order, so the result doesn't depend on anything but the input
+    for (unsigned int i = 2; i < vertexCount; ++i)
+    {
+        AddScreenTriangle(polygon[0], polygon[i - 1], polygon[i]);
+    }
+}
+
+void OcclusionBuffer::AddScreenTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2)
+{
+    // Viewport transform, with pixel (x, y) covering [x, x+1] x [y, y+1]
+    glm::vec3 screen[3];
+    const glm::vec4* clip[3] = { &v0, &v1, &v2 };
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        glm::vec3 ndc = glm::vec3(*clip[i]) / clip[i]->w;
+        screen[i] = glm::vec3((ndc.x * 0.5f + 0.5f) * m_width, (ndc.y * 0.5f + 0.5f) * m_height, ndc.z * 0.5f + 0.5f);
+    }
+
+    // Edge i goes from vertex i+1 to vertex i+2, and it is zero at both of them, and the area at vertex i
+    float edgeA[3], edgeB[3], edgeC[3];
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        const glm::vec3& a = screen[(i + 1) % 3];
+        const glm::vec3& b = screen[(i + 2) % 3];
+        edgeA[i] = a.y - b.y;
+        edgeB[i] = b.x - a.x;
+        edgeC[i] = a.x * b.y - a.y * b.x;
+    }
+
+    float area = edgeC[0] + edgeC[1] + edgeC[2];
+    if (std::abs(area) < s_minTriangleArea)
+    {
+        return;
+    }
+
+    // Occluders are two-sided, so flip the edges of the triangles facing away, to have them positive inside
+    if (area < 0.0f)
+    {
+        area = -area;
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            edgeA[i] = -edgeA[i];
+            edgeB[i] = -edgeB[i];
+            edgeC[i] = -edgeC[i];
+        }
+    }
+
+    float minX = std::min({ screen[0].x, screen[1].x, screen[2].x });
+    float maxX = std::max({ screen[0].x, screen[1].x, screen[2].x });
+    float minY = std::min({ screen[0].y, screen[1].y, screen[2].y });
+    float maxY = std::max({ screen[0].y, screen[1].y, screen[2].y });
+
+    Triangle triangle;
+    triangle.minX = std::max(static_cast<int>(std::ceil(minX - 0.5f)), 0);
+    triangle.maxX = std::min(static_cast<int>(std::floor(maxX - 0.5f)), static_cast<int>(m_width) - 1);
+    triangle.minY = std::max(static_cast<int>(std::ceil(minY - 0.5f)), 0);
+    triangle.maxY = std::min(static_cast<int>(std::floor(maxY - 0.5f)), static_cast<int>(m_height) - 1);
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+    {
+        return;
+    }
+
+    // The edges divided by the area are the barycentric coordinates, so they give the depth as a plane
+    float invArea = 1.0f / area;
+    triangle.depthA = (edgeA[0] * screen[0].z + edgeA[1] * screen[1].z + edgeA[2] * screen[2].z) * invArea;
+    triangle.depthB = (edgeB[0] * screen[0].z + edgeB[1] * screen[1].z + edgeB[2] * screen[2].z) * invArea;
+    triangle.depthC = (edgeC[0] * screen[0].z + edgeC[1] * screen[1].z + edgeC[2] * screen[2].z) * invArea;
+    std::copy(edgeA, edgeA + 3, triangle.edgeA);
+    std::copy(edgeB, edgeB + 3, triangle.edgeB);
+    std::copy(edgeC, edgeC + 3, triangle.edgeC);
+
+    m_triangles.push_back(triangle);
+}
+
+void OcclusionBuffer::Rasterize(ThreadPool* threadPool, Kernel kernel)
+{
+    // Bin the triangles serially, so every tile gets them in the order they were added
+    for (std::vector<unsigned int>& tileTriangles : m_tileTriangles)
+    {
+        tileTriangles.clear();
+    }
+    for (unsigned int triangleIndex = 0; triangleIndex < m_triangles.size(); ++triangleIndex)
+    {
+        const Triangle& triangle = m_triangles[triangleIndex];
+        for (unsigned int tileY = triangle.minY / TileSize; tileY <= triangle.maxY / TileSize; ++tileY)
+        {
+            for (unsigned int tileX = triangle.minX / TileSize; tileX <= triangle.maxX / TileSize; ++tileX)
+            {
+                m_tileTriangles[tileY * m_tileCountX + tileX].push_back(triangleIndex);
+            }
+        }
+    }
+
+    unsigned int tileCount = m_tileCountX * m_tileCountY;
+    if (threadPool)
+    {
+        threadPool->ParallelFor(tileCount, [&](unsigned int tileIndex) { RasterizeTile(tileIndex, kernel); });
+    }
+    else
+    {
+        for (unsigned int tileIndex = 0; tileIndex < tileCount; ++tileIndex)
+        {
+            RasterizeTile(tileIndex, kernel);
+        }
+    }
+}
+
+void OcclusionBuffer::RasterizeTile(unsigned int tileIndex, Kernel kernel)
+{
+    int tileMinX = static_cast<int>(tileIndex % m_tileCountX * TileSize);
+    int tileMinY = static_cast<int>(tileIndex / m_tileCountX * TileSize);
+    int tileMaxX = tileMinX + static_cast<int>(TileSize) - 1;
+    int tileMaxY = tileMinY + static_cast<int>(TileSize) - 1;
+
+    for (int y = tileMinY; y <= tileMaxY; ++y)
+    {
+        std::fill_n(m_depths.begin() + y * m_width + tileMinX, TileSize, 1.0f);
+    }
+
+    for (unsigned int triangleIndex : m_tileTriangles[tileIndex])
+    {
+        const Triangle& triangle = m_triangles[triangleIndex];
+        int minX = std::max(triangle.minX, tileMinX);
+        int minY = std::max(triangle.minY, tileMinY);
+        int maxX = std::min(triangle.maxX, tileMaxX);
+        int maxY = std::min(triangle.maxY, tileMaxY);
+        if (kernel == Kernel::Simd)
+        {
+            RasterizeTriangleSimd(triangle, minX, minY, maxX, maxY);
+        }
+        else
+        {
+            RasterizeTriangleReference(triangle, minX, minY, maxX, maxY);
+        }
+    }
+
+    float maxDepth = 0.0f;
+    for (int y = tileMinY; y <= tileMaxY; ++y)
+    {
+        const float* row = m_depths.data() + y * m_width;
+        maxDepth = std::max(maxDepth, *std::max_element(row + tileMinX, row + tileMaxX + 1));
+    }
+    m_tileMaxDepths[tileIndex] = maxDepth;
+}
+
+void OcclusionBuffer::RasterizeTriangleReference(const Triangle& triangle, int minX, int minY, int maxX, int maxY)
+{
+    for (int y = minY; y <= maxY; ++y)
+    {
+        float py = static_cast<float>(y) + 0.5f;
+        float* row = m_depths.data() + y * m_width;
+        for (int x = minX; x <= maxX; ++x)
+        {
+            float px = static_cast<float>(x) + 0.5f;
+
+            // Same operations, in the same order, as the SIMD kernel
+            float edge0 = triangle.edgeA[0] * px + triangle.edgeB[0] * py + triangle.edgeC[0];
+            float edge1 = triangle.edgeA[1] * px + triangle.edgeB[1] * py + triangle.edgeC[1];
+            float edge2 = triangle.edgeA[2] * px + triangle.edgeB[2] * py + triangle.edgeC[2];
+            if (edge0 >= 0.0f && edge1 >= 0.0f && edge2 >= 0.0f)
+            {
+                float depth = triangle.depthA * px + triangle.depthB * py + triangle.depthC;
+                row[x] = depth < row[x] ? depth : row[x];
+            }
+        }
+    }
+}
+
+void OcclusionBuffer::RasterizeTriangleSimd(const Triangle& triangle, int minX, int minY, int maxX, int maxY)
+{
+#ifdef ITUGL_OCCLUSION_BUFFER_SIMD
+    __m128 edgeA[3], edgeB[3], edgeC[3];
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        edgeA[i] = _mm_set1_ps(triangle.edgeA[i]);
+        edgeB[i] = _mm_set1_ps(triangle.edgeB[i]);
+        edgeC[i] = _mm_set1_ps(triangle.edgeC[i]);
+    }
+    __m128 depthA = _mm_set1_ps(triangle.depthA);
+    __m128 depthB = _mm_set1_ps(triangle.depthB);
+    __m128 depthC = _mm_set1_ps(triangle.depthC);
+    __m128 zero = _mm_setzero_ps();
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128i laneOffsets = _mm_set_epi32(3, 2, 1, 0);
+    // Inclusive range as an open one, for the greater than comparisons
+    __m128i rangeMin = _mm_set1_epi32(minX - 1);
+    __m128i rangeMax = _mm_set1_epi32(maxX + 1);
+
+    // Groups of 4 aligned to the tile, so they never leave it. The lanes out of the range are masked
+    int firstX = minX & ~3;
+    for (int y = minY; y <= maxY; ++y)
+    {
+        __m128 py = _mm_set1_ps(static_cast<float>(y) + 0.5f);
+        float* row = m_depths.data() + y * m_width;
+
+        __m128 edgeRow0 = _mm_mul_ps(edgeB[0], py);
+        __m128 edgeRow1 = _mm_mul_ps(edgeB[1], py);
+        __m128 edgeRow2 = _mm_mul_ps(edgeB[2], py);
+        __m128 depthRow = _mm_mul_ps(depthB, py);
+
+        for (int x = firstX; x <= maxX; x += 4)
+        {
+            __m128i lanesX = _mm_add_epi32(_mm_set1_epi32(x), laneOffsets);
+            __m128 px = _mm_add_ps(_mm_cvtepi32_ps(lanesX), half);
+
+            __m128 edge0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[0], px), edgeRow0), edgeC[0]);
+            __m128 edge1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[1], px), edgeRow1), edgeC[1]);
+            __m128 edge2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[2], px), edgeRow2), edgeC[2]);
+            __m128 mask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)), _mm_cmpge_ps(edge2, zero));
+            __m128i inRange = _mm_and_si128(_mm_cmpgt_epi32(lanesX, rangeMin), _mm_cmplt_epi32(lanesX, rangeMax));
+            mask = _mm_and_ps(mask, _mm_castsi128_ps(inRange));
+            if (_mm_movemask_ps(mask) == 0)
+            {
+                continue;
+            }
+
+            __m128 depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(depthA, px), depthRow), depthC);
+            __m128 current = _mm_loadu_ps(row + x);
+            __m128 closest = _mm_min_ps(depth, current);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(mask, closest), _mm_andnot_ps(mask, current)));
+        }
+    }
+#else
+    RasterizeTriangleReference(triangle, minX, minY, maxX, maxY);
+#endif
+}
+
+bool OcclusionBuffer::IsVisible(const AabbBounds& localBounds, const glm::mat4& worldMatrix) const
+{
+    glm::mat4 matrix = m_viewProjMatrix * worldMatrix;
+    glm::vec3 min = localBounds.GetMin();
+    glm::vec3 max = localBounds.GetMax();
+
+    float minX = static_cast<float>(m_width), maxX = 0.0f;
+    float minY = static_cast<float>(m_height), maxY = 0.0f;
+    float nearestDepth = 1.0f;
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        glm::vec4 clip = matrix * glm::vec4(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z, 1.0f);
+
+        // Crossing the near plane, the projection is not bounded by the corners
+        if (clip.z < -clip.w || clip.w <= 0.0f)
+        {
+            return true;
+        }
+
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        float x = (ndc.x * 0.5f + 0.5f) * m_width;
+        float y = (ndc.y * 0.5f + 0.5f) * m_height;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+    }
+
+    // Pixels touched by the rectangle, clamped to the screen. The parts out of the screen are left to the frustum culling
+    int pixelMinX = std::max(static_cast<int>(std::floor(minX)), 0);
+    int pixelMaxX = std::min(static_cast<int>(std::floor(maxX)), static_cast<int>(m_width) - 1);
+    int pixelMinY = std::max(static_cast<int>(std::floor(minY)), 0);
+    int pixelMaxY = std::min(static_cast<int>(std::floor(maxY)), static_cast<int>(m_height) - 1);
+    if (pixelMinX > pixelMaxX || pixelMinY > pixelMaxY)
+    {
+        return true;
+    }
+
+    nearestDepth -= s_depthBias;
+
+    for (unsigned int tileY = pixelMinY / TileSize; tileY <= pixelMaxY / TileSize; ++tileY)
+    {
+        for (unsigned int tileX = pixelMinX / TileSize; tileX <= pixelMaxX / TileSize; ++tileX)
+        {
+            // The whole tile is in front of the box
+            if (nearestDepth > m_tileMaxDepths[tileY * m_tileCountX + tileX])
+            {
+                continue;
+            }
+
+            int minTileX = std::max(pixelMinX, static_cast<int>(tileX * TileSize));
+            int maxTileX = std::min(pixelMaxX, static_cast<int>((tileX + 1) * TileSize) - 1);
+            int minTileY = std::max(pixelMinY, static_cast<int>(tileY * TileSize));
+            int maxTileY = std::min(pixelMaxY, static_cast<int>((tileY + 1) * TileSize) - 1);
+            for (int y = minTileY; y <= maxTileY; ++y)
+            {
+                const float* row = m_depths.data() + y * m_width;
+                for (int x = minTileX; x <= maxTileX; ++x)
+                {
+                    if (nearestDepth <= row[x])
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+const char* OcclusionBuffer::GetSimdName()
+{
+#ifdef ITUGL_OCCLUSION_BUFFER_SIMD
+    return ITUGL_OCCLUSION_BUFFER_SIMD;
+#else
+    return "none";
+#endif
+}
@@ -1,28 +1,202 @@
 #include <ituGL/scene/RendererSceneVisitor.h>
 
-#include <ituGL/renderer/Renderer.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/geometry/Model.h>
+#include <ituGL/scene/OcclusionBuffer.h>
 #include <ituGL/scene/SceneCamera.h>
 #include <ituGL/scene/SceneLight.h>
 #include <ituGL/scene/SceneModel.h>
 #include <ituGL/scene/Transform.h>
+#include <ituGL/scene/Scene.h>
+#include <glm/geometric.hpp>
+#include <algorithm>
+
+// Nodes per range in VisitParallel, fewer are not worth the cost of another buffer
+static constexpr unsigned int s_minNodesPerRange = 256;
+// Ranges per thread, more than one to balance the work when some ranges are culled
+static constexpr unsigned int s_rangesPerThread = 4;
 
 RendererSceneVisitor::RendererSceneVisitor(Renderer& renderer) : m_renderer(renderer)
+    , m_drawcallBuffer(nullptr), m_bufferedCamera(nullptr)
+    , m_modelsEnabled(true)
+    , m_frustumCulling(false), m_frustum(glm::mat4(1.0f))
+    , m_occlusionBuffer(nullptr)
+    , m_lodSelection(false), m_lodCameraPosition(0.0f), m_lodProjectionScale(1.0f), m_lodOrthographic(false), m_lodHysteresis(0.0f)
+    , m_visibleModelCount(0), m_culledModelCount(0), m_occludedModelCount(0)
+{
+}
+
+RendererSceneVisitor::RendererSceneVisitor(const RendererSceneVisitor& parent, Renderer::DrawcallBuffer& drawcallBuffer)
+    : m_renderer(parent.m_renderer)
+    , m_drawcallBuffer(&drawcallBuffer), m_bufferedCamera(nullptr)
+    , m_modelsEnabled(parent.m_modelsEnabled)
+    , m_frustumCulling(parent.m_frustumCulling), m_frustum(parent.m_frustum)
+    , m_occlusionBuffer(parent.m_occlusionBuffer)
+    , m_lodSelection(parent.m_lodSelection), m_lodCameraPosition(parent.m_lodCameraPosition), m_lodProjectionScale(parent.m_lodProjectionScale)
+    , m_lodOrthographic(parent.m_lodOrthographic), m_lodHysteresis(parent.m_lodHysteresis)
+    , m_visibleModelCount(0), m_culledModelCount(0), m_occludedModelCount(0)
 {
 }
 
 void RendererSceneVisitor::VisitCamera(SceneCamera& sceneCamera)
 {
+    if (m_drawcallBuffer)
+    {
+        assert(!m_bufferedCamera);
+        m_bufferedCamera = sceneCamera.GetCamera().get();
+        return;
+    }
+
     assert(!m_renderer.HasCamera()); // Currently, only one camera per scene supported
     m_renderer.SetCurrentCamera(*sceneCamera.GetCamera());
 }
 
 void RendererSceneVisitor::VisitLight(SceneLight& sceneLight)
 {
+    if (m_drawcallBuffer)
+    {
+        m_bufferedLights.push_back(sceneLight.GetLight().get());
+        return;
+    }
+
     m_renderer.AddLight(*sceneLight.GetLight());
 }
 
 void RendererSceneVisitor::VisitModel(SceneModel& sceneModel)
 {
+    if (!m_modelsEnabled)
+    {
+        return;
+    }
+
     assert(sceneModel.GetTransform());
-    m_renderer.AddModel(*sceneModel.GetModel(), sceneModel.GetTransform()->GetTransformMatrix());
+    assert(sceneModel.GetModel());
+    const Model& model = *sceneModel.GetModel();
+    glm::mat4 worldMatrix = sceneModel.GetTransform()->GetTransformMatrix();
+
+    if (m_frustumCulling && model.HasLocalBounds())
+    {
+        if (!Bounds::Intersects(m_frustum, BoxBounds(model.GetLocalBounds(), worldMatrix)))
+        {
+            ++m_culledModelCount;
+            return;
+        }
+    }
+
+    if (m_occlusionBuffer && model.HasLocalBounds())
+    {
+        if (!m_occlusionBuffer->IsVisible(model.GetLocalBounds(), worldMatrix))
+        {
+            ++m_culledModelCount;
+            ++m_occludedModelCount;
+            return;
+        }
+    }
+
+    unsigned int lod = 0;
+    if (m_lodSelection && model.GetLodCount() > 1 && model.HasLocalBounds())
+    {
+        // Projected size of the bounding sphere, as a fraction of the screen height
+        SphereBounds sphere(BoxBounds(model.GetLocalBounds(), worldMatrix));
+        float screenSize = sphere.GetRadius() * m_lodProjectionScale;
+        if (!m_lodOrthographic)
+        {
+            screenSize /= std::max(glm::distance(sphere.GetCenter(), m_lodCameraPosition), 1e-4f);
+        }
+        lod = model.SelectLod(screenSize, sceneModel.GetLod(), m_lodHysteresis);
+        sceneModel.SetLod(lod);
+    }
+
+    ++m_visibleModelCount;
+    if (m_drawcallBuffer)
+    {
+        m_renderer.AddModel(*m_drawcallBuffer, model, worldMatrix, lod);
+    }
+    else
+    {
+        m_renderer.AddModel(model, worldMatrix, lod);
+    }
+}
+
+void RendererSceneVisitor::VisitParallel(Scene& scene)
+{
+    assert(!m_drawcallBuffer);
+
+    ThreadPool& threadPool = m_renderer.GetThreadPool();
+    unsigned int nodeCount = scene.GetNodeCount();
+    unsigned int maxRangeCount = (threadPool.GetThreadCount() + 1) * s_rangesPerThread;
+    unsigned int rangeCount = std::clamp(nodeCount / s_minNodesPerRange, 1u, maxRangeCount);
+
+    std::span<Renderer::DrawcallBuffer> drawcallBuffers = m_renderer.GetDrawcallBuffers(rangeCount);
+    std::vector<RendererSceneVisitor> rangeVisitors;
+    rangeVisitors.reserve(rangeCount);
+    for (Renderer::DrawcallBuffer& drawcallBuffer : drawcallBuffers)
+    {
+        rangeVisitors.push_back(RendererSceneVisitor(*this, drawcallBuffer));
+    }
+
+    // The transforms cache their matrices when read, and siblings share their parents, so update them before the threads read them
+    scene.UpdateTransforms();
+
+    threadPool.ParallelFor(rangeCount, [&](unsigned int rangeIndex)
+        {
+            // Contiguous ranges, so merging them in order keeps the order of the nodes
+            unsigned int first = static_cast<unsigned int>(static_cast<std::uint64_t>(nodeCount) * rangeIndex / rangeCount);
+            unsigned int last = static_cast<unsigned int>(static_cast<std::uint64_t>(nodeCount) * (rangeIndex + 1) / rangeCount);
+            scene.AcceptVisitor(rangeVisitors[rangeIndex], first, last - first);
+        });
+
+    m_renderer.MergeDrawcallBuffers(drawcallBuffers);
+
+    for (const RendererSceneVisitor& rangeVisitor : rangeVisitors)
+    {
+        if (rangeVisitor.m_bufferedCamera)
+        {
+            assert(!m_renderer.HasCamera()); // Currently, only one camera per scene supported
+            m_renderer.SetCurrentCamera(*rangeVisitor.m_bufferedCamera);
+        }
+        for (const Light* light : rangeVisitor.m_bufferedLights)
+        {
+            m_renderer.AddLight(*light);
+        }
+        m_visibleModelCount += rangeVisitor.m_visibleModelCount;
+        m_culledModelCount += rangeVisitor.m_culledModelCount;
+        m_occludedModelCount += rangeVisitor.m_occludedModelCount;
+    }
+}
+
+void RendererSceneVisitor::EnableFrustumCulling(const Camera& camera)
+{
+    m_frustum.SetViewProjectionMatrix(camera.GetViewProjectionMatrix());
+    m_frustumCulling = true;
+}
+
+void RendererSceneVisitor::DisableFrustumCulling()
+{
+    m_frustumCulling = false;
+}
+
+void RendererSceneVisitor::EnableOcclusionCulling(const OcclusionBuffer& occlusionBuffer)
+{
+    m_occlusionBuffer = &occlusionBuffer;
+}
+
+void RendererSceneVisitor::DisableOcclusionCulling()
+{
+    m_occlusionBuffer = nullptr;
+}
+
+void RendererSceneVisitor::EnableLodSelection(const Camera& camera, float hysteresis)
+{
+    const glm::mat4& projMatrix = camera.GetProjectionMatrix();
+    m_lodCameraPosition = camera.ExtractTranslation();
+    m_lodProjectionScale = projMatrix[1][1];
+    m_lodOrthographic = projMatrix[3][3] != 0.0f;
+    m_lodHysteresis = hysteresis;
+    m_lodSelection = true;
+}
+
+void RendererSceneVisitor::DisableLodSelection()
+{
+    m_lodSelection = false;
 }
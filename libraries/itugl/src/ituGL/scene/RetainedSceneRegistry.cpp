@@ -0,0 +1,105 @@
+#include <ituGL/scene/RetainedSceneRegistry.h>
+
+#include <ituGL/geometry/Model.h>
+#include <ituGL/scene/SceneModel.h>
+#include <ituGL/scene/Transform.h>
+#include <cassert>
+
+RetainedSceneRegistry::RetainedSceneRegistry(Renderer& renderer) : m_renderer(renderer), m_updatedModelCount(0)
+{
+}
+
+RetainedSceneRegistry::~RetainedSceneRegistry()
+{
+    Clear();
+}
+
+void RetainedSceneRegistry::VisitModel(SceneModel& sceneModel)
+{
+    AddModel(sceneModel);
+}
+
+void RetainedSceneRegistry::AddModel(SceneModel& sceneModel)
+{
+    assert(sceneModel.GetTransform());
+    assert(sceneModel.GetModel());
+
+    auto result = m_entryIndices.try_emplace(&sceneModel, static_cast<unsigned int>(m_entries.size()));
+    if (!result.second)
+    {
+        return;
+    }
+
+    const Model* model = sceneModel.GetModel().get();
+    const Transform& transform = *sceneModel.GetTransform();
+    std::uint64_t transformVersion = transform.GetVersion();
+    Renderer::RetainedModelId id = m_renderer.AddRetainedModel(*model, transform.GetTransformMatrix());
+    m_entries.push_back(Entry{ &sceneModel, model, transformVersion, id });
+}
+
+void RetainedSceneRegistry::RemoveModel(const SceneModel& sceneModel)
+{
+    auto itEntry = m_entryIndices.find(&sceneModel);
+    if (itEntry == m_entryIndices.end())
+    {
+        return;
+    }
+
+    unsigned int index = itEntry->second;
+    m_renderer.RemoveRetainedModel(m_entries[index].id);
+    m_entryIndices.erase(itEntry);
+
+    // Move the last entry to the free position
+    if (index + 1 < m_entries.size())
+    {
+        m_entries[index] = m_entries.back();
+        m_entryIndices[m_entries[index].sceneModel] = index;
+    }
+    m_entries.pop_back();
+}
+
+void RetainedSceneRegistry::Clear()
+{
+    for (const Entry& entry : m_entries)
+    {
+        m_renderer.RemoveRetainedModel(entry.id);
+    }
+    m_entries.clear();
+    m_entryIndices.clear();
+}
+
+void RetainedSceneRegistry::InvalidateMaterials(const SceneModel& sceneModel)
+{
+    auto itEntry = m_entryIndices.find(&sceneModel);
+    if (itEntry != m_entryIndices.end())
+    {
+        m_renderer.UpdateRetainedModelMaterials(m_entries[itEntry->second].id);
+    }
+}
+
+void RetainedSceneRegistry::Update()
+{
+    m_updatedModelCount = 0;
+
+    for (Entry& entry : m_entries)
+    {
+        SceneModel& sceneModel = *entry.sceneModel;
+        const Model* model = sceneModel.GetModel().get();
+        const Transform& transform = *sceneModel.GetTransform();
+        std::uint64_t transformVersion = transform.GetVersion();
+        if (model != entry.model)
+        {
+            // A different model has other drawcalls, add it again
+            m_renderer.RemoveRetainedModel(entry.id);
+            entry.id = m_renderer.AddRetainedModel(*model, transform.GetTransformMatrix());
+            entry.model = model;
+            ++m_updatedModelCount;
+        }
+        else if (transformVersion != entry.transformVersion)
+        {
+            m_renderer.SetRetainedModelWorldMatrix(entry.id, transform.GetTransformMatrix());
+            ++m_updatedModelCount;
+        }
+        entry.transformVersion = transformVersion;
+    }
+}
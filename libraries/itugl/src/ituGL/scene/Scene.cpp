@@ -2,6 +2,8 @@
 
 #include <ituGL/scene/SceneNode.h>
 #include <ituGL/scene/SceneVisitor.h>
+#include <ituGL/scene/Transform.h>
+#include <algorithm>
 #include <cassert>
 
 Scene::Scene()
@@ -31,6 +33,7 @@ bool Scene::AddSceneNode(std::shared_ptr<SceneNode> node)
     assert(node);
     assert(m_nodes.find(node->GetName()) == m_nodes.end());
     m_nodes[node->GetName()] = node;
+    m_nodeList.push_back(node);
     node->SetOwnerScene(this);
     return true;
 }
@@ -49,24 +52,49 @@ bool Scene::RemoveSceneNode(const std::string& name)
         assert(it->second);
         assert(it->second->GetOwnerScene() == this);
         it->second->SetOwnerScene(nullptr);
+        m_nodeList.erase(std::find(m_nodeList.begin(), m_nodeList.end(), it->second));
         m_nodes.erase(it);
         return true;
     }
     return false;
 }
 
-void Scene::AcceptVisitor(SceneVisitor& visitor)
+void Scene::UpdateTransforms() const
 {
-    for (auto& pair : m_nodes)
+    for (const std::shared_ptr<SceneNode>& node : m_nodeList)
     {
-        pair.second->AcceptVisitor(visitor);
+        // Dirty parents are updated by their children
+        if (const std::shared_ptr<Transform>& transform = node->GetTransform())
+        {
+            transform->GetTransformMatrix();
+        }
     }
 }
 
+void Scene::AcceptVisitor(SceneVisitor& visitor)
+{
+    AcceptVisitor(visitor, 0, GetNodeCount());
+}
+
 void Scene::AcceptVisitor(SceneVisitor& visitor) const
 {
-    for (auto& pair : m_nodes)
+    AcceptVisitor(visitor, 0, GetNodeCount());
+}
+
+void Scene::AcceptVisitor(SceneVisitor& visitor, unsigned int first, unsigned int count)
+{
+    assert(first + count <= GetNodeCount());
+    for (unsigned int i = first; i < first + count; ++i)
+    {
+        m_nodeList[i]->AcceptVisitor(visitor);
+    }
+}
+
+void Scene::AcceptVisitor(SceneVisitor& visitor, unsigned int first, unsigned int count) const
+{
+    assert(first + count <= GetNodeCount());
+    for (unsigned int i = first; i < first + count; ++i)
     {
-        pair.second->AcceptVisitor(visitor);
+        m_nodeList[i]->AcceptVisitor(visitor);
     }
 }
@@ -6,15 +6,15 @@
 #include <ituGL/scene/SceneVisitor.h>
 #include <cassert>
 
-SceneModel::SceneModel(const std::string& name, std::shared_ptr<Model> model) : SceneNode(name), m_model(model)
+SceneModel::SceneModel(const std::string& name, std::shared_ptr<Model> model) : SceneNode(name), m_model(model), m_lod(0)
 {
 }
 
-SceneModel::SceneModel(const std::string& name, std::shared_ptr<Model> model, std::shared_ptr<Transform> transform) : SceneNode(name, transform), m_model(model)
+SceneModel::SceneModel(const std::string& name, std::shared_ptr<Model> model, std::shared_ptr<Transform> transform) : SceneNode(name, transform), m_model(model), m_lod(0)
 {
 }
 
-std::shared_ptr<Model> SceneModel::GetModel() const
+const std::shared_ptr<Model>& SceneModel::GetModel() const
 {
     return m_model;
 }
@@ -22,6 +22,7 @@ std::shared_ptr<Model> SceneModel::GetModel() const
 void SceneModel::SetModel(std::shared_ptr<Model> model)
 {
     m_model = model;
+    m_lod = 0;
 }
 
 /*glm::mat4 SceneModel::GetWorldMatrix() const
@@ -57,7 +58,11 @@ BoxBounds SceneModel::GetBoxBounds() const
 {
     assert(m_transform);
     assert(m_model);
-    return BoxBounds(m_transform->GetTranslation(), m_transform->GetRotationMatrix(), m_transform->GetScale() /* * m_model->GetSize()*/);
+    if (m_model->HasLocalBounds())
+    {
+        return BoxBounds(m_model->GetLocalBounds(), m_transform->GetTransformMatrix());
+    }
+    return BoxBounds(m_transform->GetTranslation(), m_transform->GetRotationMatrix(), m_transform->GetScale());
 }
 
 void SceneModel::AcceptVisitor(SceneVisitor& visitor)
@@ -36,7 +36,7 @@ void SceneNode::Rename(const std::string& name)
     }
 }
 
-std::shared_ptr<Transform> SceneNode::GetTransform()
+const std::shared_ptr<Transform>& SceneNode::GetTransform()
 {
     return m_transform;
 }
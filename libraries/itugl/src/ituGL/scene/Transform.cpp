@@ -1,8 +1,11 @@
 #include <ituGL/scene/Transform.h>
 
 #include <glm/ext/matrix_transform.hpp>
+#include <algorithm>
 
-Transform::Transform() : m_translation(0, 0, 0), m_rotation(0, 0, 0), m_scale(1, 1, 1), m_matrix(1.0f), m_dirty(false)
+std::atomic<std::uint64_t> Transform::s_lastVersion = 0;
+
+Transform::Transform() : m_translation(0, 0, 0), m_rotation(0, 0, 0), m_scale(1, 1, 1), m_version(0), m_matrix(1.0f), m_matrixVersion(0)
 {
 }
 
@@ -27,19 +30,26 @@ glm::mat4 Transform::GetScaleMatrix() const
 
 glm::mat4 Transform::GetTransformMatrix() const
 {
-    if (IsDirty())
+    // Only this matrix is updated, so the siblings still see that a shared parent changed
+    std::uint64_t version = GetVersion();
+    if (version != m_matrixVersion)
     {
         m_matrix = GetTranslationMatrix() * GetRotationMatrix() * GetScaleMatrix();
         if (m_parent)
         {
             m_matrix = m_parent->GetTransformMatrix() * m_matrix;
         }
-        m_dirty = false;
+        m_matrixVersion = version;
     }
     return m_matrix;
 }
 
 bool Transform::IsDirty() const
 {
-    return m_dirty || (m_parent && m_parent->IsDirty());
+    return GetVersion() != m_matrixVersion;
+}
+
+std::uint64_t Transform::GetVersion() const
+{
+    return m_parent ? std::max(m_version, m_parent->GetVersion()) : m_version;
 }
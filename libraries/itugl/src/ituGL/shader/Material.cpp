@@ -2,6 +2,8 @@
 #include <ituGL/core/DeviceGL.h>
 #include <cassert>
 
+std::atomic<unsigned int> Material::s_nextSortId = 0;
+
 Material::Material() : Material(nullptr)
 {
 }
@@ -18,6 +20,7 @@ Material::Material(std::shared_ptr<ShaderProgram> shaderProgram, const NameSet&
     , m_stencilDepthPass{ StencilOperation::Keep, StencilOperation::Keep }
     , m_blendEquations{ BlendEquation::None }
     , m_blendParams{ BlendParam::One, BlendParam::Zero, BlendParam::One, BlendParam::Zero }
+    , m_sortId(s_nextSortId++)
 {
 }
 
@@ -199,16 +202,22 @@ void Material::Use(OverrideFlags overrideFlags) const
 {
     assert(m_shaderProgram);
 
-    // Set the shader program as the one currently in use
-    m_shaderProgram->Use();
-
-    // Set the value of all the uniforms stored as properties
-    SetUniforms();
+    // If not skipped, set the shader program as the one currently in use
+    if ((overrideFlags & OverrideFlags::OverrideShaderProgram) == 0)
+    {
+        m_shaderProgram->Use();
+    }
 
-    if (m_shaderSetupFunction)
+    // If not skipped, set the value of all the uniforms stored as properties
+    if ((overrideFlags & OverrideFlags::OverrideUniforms) == 0)
     {
-        // if needed, do extra set up for the shader
-        m_shaderSetupFunction(*m_shaderProgram);
+        SetUniforms();
+
+        if (m_shaderSetupFunction)
+        {
+            // if needed, do extra set up for the shader
+            m_shaderSetupFunction(*m_shaderProgram);
+        }
     }
 
     // If not skipped, set the depth settings
@@ -146,6 +146,22 @@ ShaderProgram::Location ShaderProgram::GetUniformLocation(const char* name) cons
     return glGetUniformLocation(GetHandle(), name);
 }
 
+// Find a uniform block index by name
+GLuint ShaderProgram::GetUniformBlockIndex(const char* name) const
+{
+    assert(IsValid());
+    assert(IsLinked());
+    return glGetUniformBlockIndex(GetHandle(), name);
+}
+
+// Assign the binding point to the uniform block. The program doesn't need to be in use
+void ShaderProgram::SetUniformBlockBinding(GLuint blockIndex, GLuint bindingIndex) const
+{
+    assert(IsValid());
+    assert(blockIndex != GL_INVALID_INDEX);
+    glUniformBlockBinding(GetHandle(), blockIndex, bindingIndex);
+}
+
 // Get how many uniforms exist in this shader program
 unsigned int ShaderProgram::GetUniformCount() const
 {
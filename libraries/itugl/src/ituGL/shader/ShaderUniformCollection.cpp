@@ -87,7 +87,10 @@ void ShaderUniformCollection::ExtractUniforms(const NameSet& filteredUniforms)
 
         // Get the uniform location
         ShaderProgram::Location location = GetUniformLocation(uniformName);
-        assert(location >= 0);
+
+        // Members of uniform blocks don't have a location, their values come from a UniformBufferObject
+        if (location < 0)
+            continue;
 
         Data::Type type;
         UniformDimension dimension;
@@ -253,6 +256,11 @@ bool ShaderUniformCollection::IsTextureUniform(GLenum glType, TextureObject::Tar
     case GL_SAMPLER_CUBE_MAP_ARRAY:
         target = TextureObject::Target::TextureCubemapArray;
         break;
+    case GL_SAMPLER_BUFFER:
+    case GL_INT_SAMPLER_BUFFER:
+    case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+        target = TextureObject::Target::TextureBuffer;
+        break;
     default:
         return false;
     }
@@ -0,0 +1,75 @@
+#include <ituGL/shader/UniformBlockLayout.h>
+
+#include <algorithm>
+
+UniformBlockLayout::UniformBlockLayout() : m_size(0)
+{
+}
+
+int UniformBlockLayout::GetMemberOffset(const char* name) const
+{
+    auto itFind = m_memberIndices.find(name);
+    return itFind != m_memberIndices.end() ? static_cast<int>(m_members[itFind->second].offset) : -1;
+}
+
+unsigned int UniformBlockLayout::AddMember(const char* name, unsigned int columns, unsigned int rows, unsigned int arraySize)
+{
+    assert(!m_memberIndices.contains(name));
+    assert(rows >= 1 && rows <= 4);
+
+    // Size of one column vector: N components of 4 bytes
+    unsigned int columnSize = rows * 4;
+
+    Member member;
+    member.columns = columns;
+    member.rows = rows;
+    member.arraySize = arraySize;
+
+    unsigned int alignment;
+    unsigned int size;
+    if (columns > 1 || arraySize > 0)
+    {
+        // Matrices and arrays: each column or element is aligned to the size of a vec4
+        alignment = 16;
+        member.stride = 16;
+        size = member.stride * columns * std::max(arraySize, 1u);
+    }
+    else
+    {
+        // Scalars are aligned to 4 bytes, vec2 to 8 bytes, and vec3 and vec4 to 16 bytes
+        alignment = rows == 3 ? 16 : columnSize;
+        member.stride = columnSize;
+        size = columnSize;
+    }
+
+    // Place the member at the next aligned offset
+    member.offset = (m_size + alignment - 1) / alignment * alignment;
+    m_size = member.offset + size;
+
+    // The size of the block is padded to vec4, so blocks can be stored one after the other
+    m_size = std::max(m_size, (member.offset + size + 15) / 16 * 16);
+
+    m_memberIndices[name] = static_cast<unsigned int>(m_members.size());
+    m_members.push_back(member);
+
+    return member.offset;
+}
+
+const UniformBlockLayout::Member& UniformBlockLayout::GetMember(const char* name) const
+{
+    auto itFind = m_memberIndices.find(name);
+    assert(itFind != m_memberIndices.end());
+    return m_members[itFind->second];
+}
+
+void UniformBlockLayout::WriteElement(std::span<std::byte> data, const Member& member, unsigned int element, const float* values) const
+{
+    unsigned int columnSize = member.rows * 4;
+    unsigned int offset = member.offset + element * member.columns * member.stride;
+    assert(offset + (member.columns - 1) * member.stride + columnSize <= data.size());
+
+    for (unsigned int column = 0; column < member.columns; ++column)
+    {
+        std::memcpy(data.data() + offset + column * member.stride, values + column * member.rows, columnSize);
+    }
+}
@@ -0,0 +1,37 @@
+#include <ituGL/shader/UniformBufferObject.h>
+
+UniformBufferObject::UniformBufferObject()
+{
+    // Nothing to do here, it is done by the base class
+}
+
+// Call the base implementation with Usage::DynamicDraw
+void UniformBufferObject::AllocateData(size_t size)
+{
+    AllocateData(size, Usage::DynamicDraw);
+}
+
+// Call the base implementation with Usage::DynamicDraw
+void UniformBufferObject::AllocateData(std::span<const std::byte> data)
+{
+    AllocateData(data, Usage::DynamicDraw);
+}
+
+// Bind the buffer handle to the indexed binding point. It also binds it to the generic target
+void UniformBufferObject::BindBase(GLuint bindingIndex) const
+{
+    glBindBufferBase(GetTarget(), bindingIndex, GetHandle());
+}
+
+// Bind the range of the buffer to the indexed binding point. It also binds it to the generic target
+void UniformBufferObject::BindRange(GLuint bindingIndex, size_t offset, size_t size) const
+{
+    glBindBufferRange(GetTarget(), bindingIndex, GetHandle(), offset, size);
+}
+
+size_t UniformBufferObject::GetOffsetAlignment()
+{
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    return static_cast<size_t>(alignment);
+}
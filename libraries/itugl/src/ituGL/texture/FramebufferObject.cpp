@@ -4,6 +4,7 @@
 #include <cassert>
 
 std::shared_ptr<const FramebufferObject> FramebufferObject::s_defaultFramebuffer(std::make_shared<FramebufferObject>(FramebufferObject(Object::NullHandle)));
+std::shared_ptr<const FramebufferObject> FramebufferObject::s_defaultRedirect;
 
 FramebufferObject::FramebufferObject() : Object(NullHandle)
 {
@@ -34,6 +35,10 @@ void FramebufferObject::Bind() const
 void FramebufferObject::Bind(Target target) const
 {
     Handle handle = GetHandle();
+    if (handle == NullHandle && s_defaultRedirect)
+    {
+        handle = s_defaultRedirect->GetHandle();
+    }
     glBindFramebuffer(static_cast<GLenum>(target), handle);
 }
 
@@ -44,7 +49,7 @@ void FramebufferObject::Unbind()
 
 void FramebufferObject::Unbind(Target target)
 {
-    Handle handle = NullHandle;
+    Handle handle = s_defaultRedirect ? s_defaultRedirect->GetHandle() : NullHandle;
     glBindFramebuffer(static_cast<GLenum>(target), handle);
 }
 
@@ -53,6 +58,12 @@ std::shared_ptr<const FramebufferObject> FramebufferObject::GetDefault()
     return FramebufferObject::s_defaultFramebuffer;
 }
 
+void FramebufferObject::SetDefaultRedirect(std::shared_ptr<const FramebufferObject> framebuffer)
+{
+    s_defaultRedirect = framebuffer;
+    Unbind();
+}
+
 void FramebufferObject::SetTexture(Target target, Attachment attachment, const Texture2DObject& texture, int level)
 {
     glFramebufferTexture2D(static_cast<GLenum>(target), static_cast<GLenum>(attachment), texture.GetTarget(), texture.GetHandle(), level);
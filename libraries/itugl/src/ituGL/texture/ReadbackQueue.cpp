@@ -0,0 +1,256 @@
+#include <ituGL/texture/ReadbackQueue.h>
+
+#include <ituGL/texture/Texture2DObject.h>
+#include <cassert>
+
+ReadbackQueue::ReadbackQueue(unsigned int bufferCount)
+    : m_writeIndex(0)
+    , m_copyIndex(0)
+    , m_copyingCount(0)
+    , m_nextId(InvalidId + 1)
+    , m_pendingCount(0)
+    , m_droppedCount(0)
+    , m_stopping(false)
+{
+    assert(bufferCount > 0);
+    for (unsigned int i = 0; i < bufferCount; ++i)
+    {
+        m_slots.push_back(std::make_unique<Slot>());
+    }
+
+    m_thread = std::thread(&ReadbackQueue::WorkerLoop, this);
+}
+
+ReadbackQueue::~ReadbackQueue()
+{
+    Finish();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workCondition.notify_one();
+    m_thread.join();
+}
+
+unsigned int ReadbackQueue::Read(const FramebufferObject& framebuffer, int x, int y, int width, int height,
+    TextureObject::Format format, Data::Type type, Callback callback, FramebufferObject::Attachment attachment)
+{
+    Slot* slot = BeginRead(width, height, format, type, std::move(callback));
+    if (!slot)
+    {
+        return InvalidId;
+    }
+
+    framebuffer.Bind(FramebufferObject::Target::Read);
+
+    // The default framebuffer has no attachments, only the back buffer. It could also be redirected to an offscreen one
+    // The read buffer is state of the framebuffer, so it is restored after the read for the next users of the framebuffer
+    GLint readHandle = 0, previousReadBuffer = GL_NONE;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readHandle);
+    glGetIntegerv(GL_READ_BUFFER, &previousReadBuffer);
+    glReadBuffer(readHandle == 0 ? GL_BACK : static_cast<GLenum>(attachment));
+
+    // With a pixel pack buffer bound, the last argument is an offset in the buffer, and the call returns immediately
+    glReadPixels(x, y, width, height, format, static_cast<GLenum>(type), nullptr);
+
+    glReadBuffer(static_cast<GLenum>(previousReadBuffer));
+    FramebufferObject::Unbind(FramebufferObject::Target::Read);
+
+    EndRead(*slot);
+    return slot->image.id;
+}
+
+unsigned int ReadbackQueue::Read(const Texture2DObject& texture, int level,
+    TextureObject::Format format, Data::Type type, Callback callback)
+{
+    texture.Bind();
+    GLint width = 0, height = 0;
+    glGetTexLevelParameteriv(texture.GetTarget(), level, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(texture.GetTarget(), level, GL_TEXTURE_HEIGHT, &height);
+
+    Slot* slot = BeginRead(width, height, format, type, std::move(callback));
+    if (slot)
+    {
+        glGetTexImage(texture.GetTarget(), level, format, static_cast<GLenum>(type), nullptr);
+        EndRead(*slot);
+    }
+
+    Texture2DObject::Unbind();
+    return slot ? slot->image.id : InvalidId;
+}
+
+unsigned int ReadbackQueue::Poll()
+{
+    RecycleProcessedSlots();
+    return ProcessFinishedCopies(false);
+}
+
+void ReadbackQueue::Finish()
+{
+    ProcessFinishedCopies(true);
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_processedCondition.wait(lock, [&]()
+            {
+                for (const std::unique_ptr<Slot>& slot : m_slots)
+                {
+                    if (slot->state == State::Processing)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            });
+    }
+
+    RecycleProcessedSlots();
+    assert(m_pendingCount == 0);
+}
+
+ReadbackQueue::Slot* ReadbackQueue::BeginRead(int width, int height, TextureObject::Format format, Data::Type type, Callback&& callback)
+{
+    assert(width > 0 && height > 0);
+    assert(callback);
+
+    Slot& slot = *m_slots[m_writeIndex];
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (slot.state != State::Free)
+        {
+            ++m_droppedCount;
+            return nullptr;
+        }
+    }
+
+    size_t size = static_cast<size_t>(width) * height * TextureObject::GetComponentCount(format) * Data::GetTypeSize(type);
+
+    slot.buffer.Bind();
+    if (slot.capacity < size)
+    {
+        // Allocated on first use, and when the image grows. The driver can keep it in memory that the CPU reads fast
+        slot.buffer.AllocateData(size, BufferObject::StreamRead);
+        slot.capacity = size;
+    }
+
+    slot.image.id = m_nextId++;
+    if (m_nextId == InvalidId)
+    {
+        m_nextId = InvalidId + 1;
+    }
+    slot.image.width = width;
+    slot.image.height = height;
+    slot.image.format = format;
+    slot.image.type = type;
+    slot.size = size;
+    slot.callback = std::move(callback);
+
+    // Rows without padding, whatever the width
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    return &slot;
+}
+
+void ReadbackQueue::EndRead(Slot& slot)
+{
+    // The buffer must not stay bound, or the next pixel reads of the application would go to it
+    BufferObjectBase<BufferObject::PixelPackBuffer>::Unbind();
+
+    assert(!slot.fence);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.state = State::Copying;
+
+    m_writeIndex = (m_writeIndex + 1) % m_slots.size();
+    ++m_copyingCount;
+    ++m_pendingCount;
+}
+
+unsigned int ReadbackQueue::ProcessFinishedCopies(bool wait)
+{
+    unsigned int count = 0;
+
+    // Slots are copied in order, so the ones waiting for their fence start at the copy index
+    while (m_copyingCount > 0)
+    {
+        Slot& slot = *m_slots[m_copyIndex];
+
+        // Flush the commands, otherwise the fence could never be signaled
+        GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (wait && result == GL_TIMEOUT_EXPIRED)
+        {
+            result = glClientWaitSync(slot.fence, 0, 1000000); // 1 ms
+        }
+        assert(result != GL_WAIT_FAILED);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            // Copies finish in order, so the next ones are not ready either
+            break;
+        }
+
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        // The copy is finished, so mapping doesn't wait. The worker reads the mapped memory directly, without copying it
+        slot.buffer.Bind();
+        std::span<std::byte> data = slot.buffer.MapRange(0, slot.size, GL_MAP_READ_BIT);
+        BufferObjectBase<BufferObject::PixelPackBuffer>::Unbind();
+        assert(!data.empty());
+        slot.image.data = data;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            slot.state = State::Processing;
+            m_queue.push_back(&slot);
+        }
+        m_workCondition.notify_one();
+
+        m_copyIndex = (m_copyIndex + 1) % m_slots.size();
+        --m_copyingCount;
+        ++count;
+    }
+
+    return count;
+}
+
+void ReadbackQueue::RecycleProcessedSlots()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (std::unique_ptr<Slot>& slot : m_slots)
+    {
+        if (slot->state == State::Processed)
+        {
+            slot->buffer.Bind();
+            slot->buffer.Unmap();
+            BufferObjectBase<BufferObject::PixelPackBuffer>::Unbind();
+
+            slot->image.data = std::span<const std::byte>();
+            slot->state = State::Free;
+            --m_pendingCount;
+        }
+    }
+}
+
+void ReadbackQueue::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_workCondition.wait(lock, [&]() { return m_stopping || !m_queue.empty(); });
+        if (m_queue.empty())
+        {
+            break;
+        }
+
+        Slot* slot = m_queue.front();
+        m_queue.pop_front();
+
+        lock.unlock();
+        slot->callback(slot->image);
+        slot->callback = nullptr;
+        lock.lock();
+
+        slot->state = State::Processed;
+        m_processedCondition.notify_all();
+    }
+}
@@ -0,0 +1,20 @@
+#include <ituGL/texture/TextureBufferObject.h>
+
+#include <cassert>
+
+TextureBufferObject::TextureBufferObject()
+{
+}
+
+void TextureBufferObject::SetBuffer(InternalFormat internalFormat, const BufferObject& buffer)
+{
+    assert(IsBound());
+    glTexBuffer(GetTarget(), internalFormat, buffer.GetHandle());
+}
+
+GLint TextureBufferObject::GetMaxSize()
+{
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxSize);
+    return maxSize;
+}
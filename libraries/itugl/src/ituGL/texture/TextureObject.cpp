@@ -203,6 +203,7 @@ int TextureObject::GetDataComponentCount(InternalFormat internalFormat)
     case InternalFormatR16SNorm:
     case InternalFormatR16F:
     case InternalFormatR32F:
+    case InternalFormatR32UI:
     case InternalFormatRCompressed:
     case InternalFormatR11G11B10:
     case InternalFormatRGB10A2:
@@ -221,6 +222,7 @@ int TextureObject::GetDataComponentCount(InternalFormat internalFormat)
     case InternalFormatRG16SNorm:
     case InternalFormatRG16F:
     case InternalFormatRG32F:
+    case InternalFormatRG32UI:
     case InternalFormatRGCompressed:
         return 2;
     case InternalFormatRGB:
@@ -241,6 +243,7 @@ int TextureObject::GetDataComponentCount(InternalFormat internalFormat)
     case InternalFormatRGBA16SNorm:
     case InternalFormatRGBA16F:
     case InternalFormatRGBA32F:
+    case InternalFormatRGBA32UI:
     case InternalFormatSRGBA8:
     case InternalFormatRGBACompressed:
     case InternalFormatSRGBACompressed:
@@ -0,0 +1,45 @@
+#include <ituGL/utils/ImageWriter.h>
+
+#include <cassert>
+#include <fstream>
+#include <vector>
+
+bool ImageWriter::Save(const char* path, int width, int height, int components, std::span<const std::byte> data, bool bottomToTop)
+{
+    assert(components == 1 || components == 3 || components == 4);
+    assert(data.size() >= static_cast<size_t>(width) * height * components);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    // PGM for grayscale, PPM for color
+    int fileComponents = components == 1 ? 1 : 3;
+    file << (fileComponents == 1 ? "P5\n" : "P6\n") << width << " " << height << "\n255\n";
+
+    size_t rowSize = static_cast<size_t>(width) * components;
+    std::vector<char> row(static_cast<size_t>(width) * fileComponents);
+    for (int y = 0; y < height; ++y)
+    {
+        // Files store the rows from top to bottom
+        int sourceY = bottomToTop ? height - 1 - y : y;
+        const char* source = reinterpret_cast<const char*>(data.data() + sourceY * rowSize);
+        if (components == fileComponents)
+        {
+            file.write(source, rowSize);
+        }
+        else
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                row[x * 3 + 0] = source[x * 4 + 0];
+                row[x * 3 + 1] = source[x * 4 + 1];
+                row[x * 3 + 2] = source[x * 4 + 2];
+            }
+            file.write(row.data(), row.size());
+        }
+    }
+    return file.good();
+}
@@ -0,0 +1,340 @@
+#include <ituGL/utils/Profiler.h>
+
+#include <cassert>
+#include <fstream>
+
+Profiler* Profiler::s_current = nullptr;
+
+// Each thread keeps track of its own open CPU markers
+static thread_local unsigned int s_cpuDepth = 0;
+
+Profiler::Scope::Scope(const char* name, bool gpu, const char* detail)
+    : m_profiler(Profiler::GetCurrent()), m_cpuMarker(-1), m_gpuMarker(-1)
+{
+    if (m_profiler)
+    {
+        m_cpuMarker = m_profiler->BeginCpuMarker(name, detail);
+        if (gpu)
+        {
+            m_gpuMarker = m_profiler->BeginGpuMarker(name);
+        }
+    }
+}
+
+Profiler::Scope::~Scope()
+{
+    if (m_profiler)
+    {
+        m_profiler->EndGpuMarker(m_gpuMarker);
+        m_profiler->EndCpuMarker(m_cpuMarker);
+    }
+}
+
+Profiler::Profiler()
+    : m_enabled(true)
+    , m_startTime(std::chrono::steady_clock::now())
+    , m_inFrame(false)
+    , m_frameMarker(-1)
+    , m_gpuDepth(0)
+    , m_droppedGpuFrames(0)
+{
+    for (GpuFrame& gpuFrame : m_gpuFrames)
+    {
+        gpuFrame.frameIndex = 0;
+        gpuFrame.usedQueries = 0;
+        gpuFrame.cpuStart = 0.0;
+        gpuFrame.gpuStart = 0;
+        gpuFrame.pending = false;
+    }
+
+    // Frame 0 collects the markers before the first frame, like the initialization
+    m_frames.push_back(Frame{ 0, {}, {}, true });
+
+    s_current = this;
+}
+
+Profiler::~Profiler()
+{
+    for (GpuFrame& gpuFrame : m_gpuFrames)
+    {
+        if (!gpuFrame.queryPool.empty())
+        {
+            glDeleteQueries(static_cast<GLsizei>(gpuFrame.queryPool.size()), gpuFrame.queryPool.data());
+        }
+    }
+
+    if (s_current == this)
+    {
+        s_current = nullptr;
+    }
+}
+
+void Profiler::BeginFrame()
+{
+    assert(!m_inFrame);
+    if (!m_enabled)
+    {
+        return;
+    }
+
+    unsigned int frameIndex;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        frameIndex = m_frames.back().index + 1;
+        m_frames.push_back(Frame{ frameIndex, {}, {}, false });
+        if (m_frames.size() > s_historySize)
+        {
+            m_frames.pop_front();
+        }
+    }
+    m_inFrame = true;
+
+    // Reuse the queries of the oldest frame in flight. If they are still not available, drop them instead of waiting
+    GpuFrame& gpuFrame = m_gpuFrames[frameIndex % s_gpuLatency];
+    if (gpuFrame.pending && !ResolveGpuFrame(gpuFrame))
+    {
+        ++m_droppedGpuFrames;
+    }
+    gpuFrame.frameIndex = frameIndex;
+    gpuFrame.markers.clear();
+    gpuFrame.usedQueries = 0;
+    gpuFrame.cpuStart = GetTime();
+    // Current GPU time, without waiting for the previous commands to finish
+    glGetInteger64v(GL_TIMESTAMP, &gpuFrame.gpuStart);
+    gpuFrame.pending = true;
+    m_gpuDepth = 0;
+
+    m_frameMarker = BeginCpuMarker("Frame");
+}
+
+void Profiler::EndFrame()
+{
+    if (!m_inFrame)
+    {
+        return;
+    }
+
+    EndCpuMarker(m_frameMarker);
+    m_frameMarker = -1;
+    m_inFrame = false;
+
+    // Read the results of the older frames that are already available
+    for (GpuFrame& gpuFrame : m_gpuFrames)
+    {
+        if (gpuFrame.pending && gpuFrame.frameIndex != m_frames.back().index && ResolveGpuFrame(gpuFrame))
+        {
+            gpuFrame.pending = false;
+        }
+    }
+}
+
+int Profiler::BeginCpuMarker(const char* name, const char* detail)
+{
+    if (!m_enabled)
+    {
+        return -1;
+    }
+
+    double start = GetTime();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<Event>& events = GetCurrentFrame().cpuEvents;
+    events.push_back(Event{ name, detail ? detail : "", start, 0.0, GetThreadIndex(), s_cpuDepth++ });
+    return static_cast<int>(events.size() - 1);
+}
+
+void Profiler::EndCpuMarker(int marker)
+{
+    if (marker < 0)
+    {
+        return;
+    }
+
+    double end = GetTime();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<Event>& events = GetCurrentFrame().cpuEvents;
+    assert(static_cast<size_t>(marker) < events.size());
+    events[marker].duration = end - events[marker].start;
+    --s_cpuDepth;
+}
+
+int Profiler::BeginGpuMarker(const char* name)
+{
+    if (!m_enabled || !m_inFrame)
+    {
+        return -1;
+    }
+
+    // Timestamps instead of elapsed time queries, because elapsed time queries can't be nested
+    GpuFrame& gpuFrame = m_gpuFrames[GetCurrentFrame().index % s_gpuLatency];
+    GpuMarker& gpuMarker = gpuFrame.markers.emplace_back(GpuMarker{ name, m_gpuDepth++, { AcquireQuery(gpuFrame), 0 } });
+    glQueryCounter(gpuMarker.queries[0], GL_TIMESTAMP);
+    return static_cast<int>(gpuFrame.markers.size() - 1);
+}
+
+void Profiler::EndGpuMarker(int marker)
+{
+    if (marker < 0 || !m_inFrame)
+    {
+        return;
+    }
+
+    GpuFrame& gpuFrame = m_gpuFrames[GetCurrentFrame().index % s_gpuLatency];
+    assert(static_cast<size_t>(marker) < gpuFrame.markers.size());
+    GLuint query = AcquireQuery(gpuFrame);
+    gpuFrame.markers[marker].queries[1] = query;
+    glQueryCounter(query, GL_TIMESTAMP);
+    --m_gpuDepth;
+}
+
+double Profiler::GetTime() const
+{
+    std::chrono::duration<double, std::micro> time = std::chrono::steady_clock::now() - m_startTime;
+    return time.count();
+}
+
+// Must be called with the mutex locked
+unsigned int Profiler::GetThreadIndex()
+{
+    std::thread::id threadId = std::this_thread::get_id();
+    for (unsigned int i = 0; i < m_threadIds.size(); ++i)
+    {
+        if (m_threadIds[i] == threadId)
+        {
+            return i + 1;
+        }
+    }
+    m_threadIds.push_back(threadId);
+    return static_cast<unsigned int>(m_threadIds.size());
+}
+
+GLuint Profiler::AcquireQuery(GpuFrame& gpuFrame)
+{
+    if (gpuFrame.usedQueries == gpuFrame.queryPool.size())
+    {
+        GLuint query;
+        glGenQueries(1, &query);
+        gpuFrame.queryPool.push_back(query);
+    }
+    return gpuFrame.queryPool[gpuFrame.usedQueries++];
+}
+
+bool Profiler::ResolveGpuFrame(GpuFrame& gpuFrame)
+{
+    std::vector<Event> events;
+    if (!gpuFrame.markers.empty())
+    {
+        // Queries finish in order, so if the last one is available, all of them are
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(gpuFrame.queryPool[gpuFrame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            return false;
+        }
+
+        for (const GpuMarker& gpuMarker : gpuFrame.markers)
+        {
+            // Markers that were never closed are ignored
+            if (gpuMarker.queries[1] == 0)
+            {
+                continue;
+            }
+
+            GLuint64 begin, end;
+            glGetQueryObjectui64v(gpuMarker.queries[0], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(gpuMarker.queries[1], GL_QUERY_RESULT, &end);
+
+            // Timestamps are in nanoseconds
+            double start = gpuFrame.cpuStart + (static_cast<GLint64>(begin) - gpuFrame.gpuStart) * 0.001;
+            events.push_back(Event{ gpuMarker.name, "", start, (end - begin) * 0.001, 0, gpuMarker.depth });
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto itFrame = m_frames.rbegin(); itFrame != m_frames.rend(); ++itFrame)
+    {
+        if (itFrame->index == gpuFrame.frameIndex)
+        {
+            itFrame->gpuEvents = std::move(events);
+            itFrame->gpuResolved = true;
+            break;
+        }
+    }
+    return true;
+}
+
+// Write a string as a JSON string literal
+static void WriteJsonString(std::ostream& stream, const char* string)
+{
+    stream << '"';
+    for (const char* c = string; *c; ++c)
+    {
+        switch (*c)
+        {
+        case '"': stream << "\\\""; break;
+        case '\\': stream << "\\\\"; break;
+        case '\n': stream << "\\n"; break;
+        case '\t': stream << "\\t"; break;
+        default:
+            // Other control characters are not expected in marker names or paths
+            if (static_cast<unsigned char>(*c) >= 0x20)
+            {
+                stream << *c;
+            }
+            break;
+        }
+    }
+    stream << '"';
+}
+
+bool Profiler::SaveChromeTrace(const char* path) const
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    // Name the tracks
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+    for (unsigned int i = 0; i < m_threadIds.size(); ++i)
+    {
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i + 1 << ",\"args\":{\"name\":\"" << (i == 0 ? "Main" : "Worker") << " " << i + 1 << "\"}}";
+    }
+
+    file.setf(std::ios::fixed);
+    file.precision(3);
+    auto writeEvent = [&](const Event& event, unsigned int frameIndex)
+    {
+        file << ",\n{\"name\":";
+        WriteJsonString(file, event.name);
+        file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":" << event.start << ",\"dur\":" << event.duration;
+        file << ",\"args\":{\"frame\":" << frameIndex;
+        if (!event.detail.empty())
+        {
+            file << ",\"detail\":";
+            WriteJsonString(file, event.detail.c_str());
+        }
+        file << "}}";
+    };
+
+    for (const Frame& frame : m_frames)
+    {
+        for (const Event& event : frame.cpuEvents)
+        {
+            writeEvent(event, frame.index);
+        }
+        for (const Event& event : frame.gpuEvents)
+        {
+            writeEvent(event, frame.index);
+        }
+    }
+
+    file << "\n]}\n";
+    return file.good();
+}
@@ -0,0 +1,115 @@
+#include <ituGL/utils/Profiler.h>
+
+#include <ituGL/utils/DearImGui.h>
+#include <imgui.h>
+#include <cstring>
+
+// Kept apart from Profiler.cpp, so only the applications that draw the GUI need to link ImGui
+
+void Profiler::DrawGUI(DearImGui& imGui)
+{
+    if (auto window = imGui.UseWindow("Profiler"))
+    {
+        ImGui::Checkbox("Enabled", &m_enabled);
+
+        // Total time of each marker name, over the complete frames in the history
+        struct Row
+        {
+            const char* name;
+            unsigned int depth;
+            double cpuTime;
+            double gpuTime;
+        };
+        std::vector<Row> rows;
+        auto findRow = [&](const Event& event) -> Row&
+        {
+            for (Row& row : rows)
+            {
+                if (std::strcmp(row.name, event.name) == 0)
+                {
+                    return row;
+                }
+            }
+            return rows.emplace_back(Row{ event.name, event.depth, 0.0, 0.0 });
+        };
+
+        std::vector<float> frameTimes;
+        unsigned int gpuFrameCount = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const Frame& frame : m_frames)
+            {
+                // Skip the initialization and the frame in progress
+                if (frame.index == 0 || (m_inFrame && &frame == &m_frames.back()))
+                {
+                    continue;
+                }
+
+                for (const Event& event : frame.cpuEvents)
+                {
+                    if (event.depth == 0 && std::strcmp(event.name, "Frame") == 0)
+                    {
+                        frameTimes.push_back(static_cast<float>(event.duration * 0.001));
+                    }
+                    findRow(event).cpuTime += event.duration;
+                }
+                if (frame.gpuResolved)
+                {
+                    for (const Event& event : frame.gpuEvents)
+                    {
+                        findRow(event).gpuTime += event.duration;
+                    }
+                    ++gpuFrameCount;
+                }
+            }
+        }
+
+        if (!frameTimes.empty())
+        {
+            float averageFrameTime = 0.0f;
+            for (float frameTime : frameTimes)
+            {
+                averageFrameTime += frameTime;
+            }
+            averageFrameTime /= frameTimes.size();
+            ImGui::Text("Frame: %.2f ms (%.1f FPS)", averageFrameTime, 1000.0f / averageFrameTime);
+            ImGui::PlotLines("##FrameTimes", frameTimes.data(), static_cast<int>(frameTimes.size()), 0, nullptr, 0.0f, 2.0f * averageFrameTime, ImVec2(0, 60));
+        }
+
+        // Average per frame, in milliseconds
+        if (ImGui::BeginTable("Markers", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+        {
+            ImGui::TableSetupColumn("Marker");
+            ImGui::TableSetupColumn("CPU (ms)");
+            ImGui::TableSetupColumn("GPU (ms)");
+            ImGui::TableHeadersRow();
+            for (const Row& row : rows)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%*s%s", row.depth * 2, "", row.name);
+                ImGui::TableNextColumn();
+                if (!frameTimes.empty())
+                {
+                    ImGui::Text("%.3f", row.cpuTime * 0.001 / frameTimes.size());
+                }
+                ImGui::TableNextColumn();
+                if (gpuFrameCount > 0 && row.gpuTime > 0.0)
+                {
+                    ImGui::Text("%.3f", row.gpuTime * 0.001 / gpuFrameCount);
+                }
+            }
+            ImGui::EndTable();
+        }
+
+        if (m_droppedGpuFrames > 0)
+        {
+            ImGui::Text("Dropped GPU frames: %u", m_droppedGpuFrames);
+        }
+
+        if (ImGui::Button("Save Chrome trace"))
+        {
+            SaveChromeTrace("profile.json");
+        }
+    }
+}
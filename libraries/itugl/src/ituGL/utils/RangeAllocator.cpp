@@ -0,0 +1,400 @@
+#include <ituGL/utils/RangeAllocator.h>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+RangeAllocator::RangeAllocator(unsigned int size)
+{
+    Reset(size);
+}
+
+void RangeAllocator::Reset(unsigned int size)
+{
+    m_size = size;
+    m_nodes.clear();
+    m_unusedNodes.clear();
+    m_firstNode = InvalidNode;
+
+    std::fill(std::begin(m_freeLists), std::end(m_freeLists), InvalidNode);
+    m_firstLevelMask = 0;
+    std::fill(std::begin(m_secondLevelMasks), std::end(m_secondLevelMasks), 0u);
+
+    m_usedSize = 0;
+    m_allocationCount = 0;
+    m_freeRangeCount = 0;
+
+    if (size > 0)
+    {
+        m_firstNode = CreateNode(0, size, InvalidNode, InvalidNode);
+        AddFreeNode(m_firstNode);
+    }
+}
+
+RangeAllocator::Allocation RangeAllocator::Allocate(unsigned int size)
+{
+    assert(size > 0);
+
+    unsigned int nodeIndex = FindFreeNode(size);
+    if (nodeIndex == InvalidNode)
+    {
+        return Allocation{ InvalidId, 0, 0 };
+    }
+
+    RemoveFreeNode(nodeIndex);
+
+    // The rest of the range stays free, as a new node after this one
+    if (m_nodes[nodeIndex].size > size)
+    {
+        const Node& node = m_nodes[nodeIndex];
+        unsigned int restIndex = CreateNode(node.offset + size, node.size - size, nodeIndex, node.next);
+        if (m_nodes[restIndex].next != InvalidNode)
+        {
+            m_nodes[m_nodes[restIndex].next].previous = restIndex;
+        }
+        m_nodes[nodeIndex].next = restIndex;
+        m_nodes[nodeIndex].size = size;
+        AddFreeNode(restIndex);
+    }
+
+    Node& node = m_nodes[nodeIndex];
+    node.used = true;
+    m_usedSize += size;
+    ++m_allocationCount;
+
+    return Allocation{ nodeIndex, node.offset, node.size };
+}
+
+void RangeAllocator::Free(AllocationId id)
+{
+    assert(id < m_nodes.size() && m_nodes[id].used);
+
+    unsigned int nodeIndex = id;
+    m_nodes[nodeIndex].used = false;
+    m_usedSize -= m_nodes[nodeIndex].size;
+    --m_allocationCount;
+
+    // Merge with the free neighbours. The node with the lower offset is kept
+    unsigned int nextIndex = m_nodes[nodeIndex].next;
+    if (nextIndex != InvalidNode && !m_nodes[nextIndex].used)
+    {
+        RemoveFreeNode(nextIndex);
+        m_nodes[nodeIndex].size += m_nodes[nextIndex].size;
+        m_nodes[nodeIndex].next = m_nodes[nextIndex].next;
+        if (m_nodes[nodeIndex].next != InvalidNode)
+        {
+            m_nodes[m_nodes[nodeIndex].next].previous = nodeIndex;
+        }
+        ReleaseNode(nextIndex);
+    }
+
+    unsigned int previousIndex = m_nodes[nodeIndex].previous;
+    if (previousIndex != InvalidNode && !m_nodes[previousIndex].used)
+    {
+        RemoveFreeNode(previousIndex);
+        m_nodes[previousIndex].size += m_nodes[nodeIndex].size;
+        m_nodes[previousIndex].next = m_nodes[nodeIndex].next;
+        if (m_nodes[previousIndex].next != InvalidNode)
+        {
+            m_nodes[m_nodes[previousIndex].next].previous = previousIndex;
+        }
+        ReleaseNode(nodeIndex);
+        nodeIndex = previousIndex;
+    }
+
+    AddFreeNode(nodeIndex);
+}
+
+RangeAllocator::Allocation RangeAllocator::GetAllocation(AllocationId id) const
+{
+    assert(id < m_nodes.size() && m_nodes[id].used);
+    const Node& node = m_nodes[id];
+    return Allocation{ id, node.offset, node.size };
+}
+
+std::vector<RangeAllocator::Move> RangeAllocator::Defragment()
+{
+    std::vector<Move> moves;
+
+    // Keep the used nodes, in order, and release the free ones
+    std::vector<unsigned int> usedNodes;
+    usedNodes.reserve(m_allocationCount);
+    for (unsigned int nodeIndex = m_firstNode; nodeIndex != InvalidNode; nodeIndex = m_nodes[nodeIndex].next)
+    {
+        if (m_nodes[nodeIndex].used)
+        {
+            usedNodes.push_back(nodeIndex);
+        }
+        else
+        {
+            ReleaseNode(nodeIndex);
+        }
+    }
+
+    std::fill(std::begin(m_freeLists), std::end(m_freeLists), InvalidNode);
+    m_firstLevelMask = 0;
+    std::fill(std::begin(m_secondLevelMasks), std::end(m_secondLevelMasks), 0u);
+    m_freeRangeCount = 0;
+
+    // Pack them from offset 0
+    unsigned int offset = 0;
+    unsigned int previousIndex = InvalidNode;
+    for (unsigned int nodeIndex : usedNodes)
+    {
+        Node& node = m_nodes[nodeIndex];
+        if (node.offset != offset)
+        {
+            moves.push_back(Move{ nodeIndex, node.offset, offset, node.size });
+            node.offset = offset;
+        }
+        node.previous = previousIndex;
+        node.next = InvalidNode;
+        if (previousIndex != InvalidNode)
+        {
+            m_nodes[previousIndex].next = nodeIndex;
+        }
+        previousIndex = nodeIndex;
+        offset += node.size;
+    }
+    m_firstNode = usedNodes.empty() ? InvalidNode : usedNodes.front();
+
+    // All the free space after them
+    if (offset < m_size)
+    {
+        unsigned int freeIndex = CreateNode(offset, m_size - offset, previousIndex, InvalidNode);
+        if (previousIndex != InvalidNode)
+        {
+            m_nodes[previousIndex].next = freeIndex;
+        }
+        else
+        {
+            m_firstNode = freeIndex;
+        }
+        AddFreeNode(freeIndex);
+    }
+
+    return moves;
+}
+
+RangeAllocator::Stats RangeAllocator::GetStats() const
+{
+    Stats stats;
+    stats.size = m_size;
+    stats.usedSize = m_usedSize;
+    stats.allocationCount = m_allocationCount;
+    stats.freeSize = m_size - m_usedSize;
+    stats.freeRangeCount = m_freeRangeCount;
+    stats.largestFreeRange = 0;
+
+    // The lists don't overlap in size, so the largest range is in the last list that is not empty
+    if (m_firstLevelMask != 0)
+    {
+        unsigned int firstLevel = 31 - std::countl_zero(m_firstLevelMask);
+        unsigned int secondLevel = 31 - std::countl_zero(m_secondLevelMasks[firstLevel]);
+        for (unsigned int nodeIndex = m_freeLists[firstLevel * SecondLevelCount + secondLevel]; nodeIndex != InvalidNode; nodeIndex = m_nodes[nodeIndex].nextFree)
+        {
+            stats.largestFreeRange = std::max(stats.largestFreeRange, m_nodes[nodeIndex].size);
+        }
+    }
+
+    return stats;
+}
+
+bool RangeAllocator::IsValid() const
+{
+    // Neighbours cover the whole size, without gaps, and never two free ones together
+    unsigned int offset = 0, usedSize = 0, allocationCount = 0, freeRangeCount = 0;
+    unsigned int previousIndex = InvalidNode;
+    bool previousFree = false;
+    for (unsigned int nodeIndex = m_firstNode; nodeIndex != InvalidNode; nodeIndex = m_nodes[nodeIndex].next)
+    {
+        const Node& node = m_nodes[nodeIndex];
+        if (node.offset != offset || node.size == 0 || node.previous != previousIndex || (previousFree && !node.used))
+        {
+            return false;
+        }
+        if (node.used)
+        {
+            usedSize += node.size;
+            ++allocationCount;
+        }
+        else
+        {
+            ++freeRangeCount;
+        }
+        offset += node.size;
+        previousIndex = nodeIndex;
+        previousFree = !node.used;
+    }
+    if (offset != m_size || usedSize != m_usedSize || allocationCount != m_allocationCount || freeRangeCount != m_freeRangeCount)
+    {
+        return false;
+    }
+
+    // Every free node is in the list of its size, and the masks match the lists
+    unsigned int listedCount = 0;
+    for (unsigned int listIndex = 0; listIndex < ListCount; ++listIndex)
+    {
+        unsigned int firstLevel = listIndex / SecondLevelCount, secondLevel = listIndex % SecondLevelCount;
+        bool listBit = (m_secondLevelMasks[firstLevel] >> secondLevel) & 1u;
+        if (listBit != (m_freeLists[listIndex] != InvalidNode) || (listBit && !((m_firstLevelMask >> firstLevel) & 1u)))
+        {
+            return false;
+        }
+        unsigned int previousFreeIndex = InvalidNode;
+        for (unsigned int nodeIndex = m_freeLists[listIndex]; nodeIndex != InvalidNode; nodeIndex = m_nodes[nodeIndex].nextFree)
+        {
+            const Node& node = m_nodes[nodeIndex];
+            if (node.used || node.previousFree != previousFreeIndex || GetListIndex(node.size) != listIndex || ++listedCount > m_freeRangeCount)
+            {
+                return false;
+            }
+            previousFreeIndex = nodeIndex;
+        }
+    }
+    for (unsigned int firstLevel = 0; firstLevel < FirstLevelCount; ++firstLevel)
+    {
+        if (((m_firstLevelMask >> firstLevel) & 1u) != (m_secondLevelMasks[firstLevel] != 0))
+        {
+            return false;
+        }
+    }
+    return listedCount == m_freeRangeCount;
+}
+
+unsigned int RangeAllocator::GetListIndex(unsigned int size)
+{
+    assert(size > 0);
+
+    // Small sizes have a list each
+    if (size < SecondLevelCount)
+    {
+        return size;
+    }
+
+    // The top bit selects the first level, and the next bits the second level
+    unsigned int topBit = std::bit_width(size) - 1;
+    unsigned int firstLevel = topBit - SecondLevelBits + 1;
+    unsigned int secondLevel = (size >> (topBit - SecondLevelBits)) & (SecondLevelCount - 1);
+    return firstLevel * SecondLevelCount + secondLevel;
+}
+
+unsigned int RangeAllocator::CreateNode(unsigned int offset, unsigned int size, unsigned int previous, unsigned int next)
+{
+    unsigned int nodeIndex;
+    if (!m_unusedNodes.empty())
+    {
+        nodeIndex = m_unusedNodes.back();
+        m_unusedNodes.pop_back();
+    }
+    else
+    {
+        nodeIndex = static_cast<unsigned int>(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+
+    m_nodes[nodeIndex] = Node{ offset, size, previous, next, InvalidNode, InvalidNode, false };
+    return nodeIndex;
+}
+
+void RangeAllocator::ReleaseNode(unsigned int nodeIndex)
+{
+    m_nodes[nodeIndex].used = false;
+    m_nodes[nodeIndex].size = 0;
+    m_unusedNodes.push_back(nodeIndex);
+}
+
+void RangeAllocator::AddFreeNode(unsigned int nodeIndex)
+{
+    Node& node = m_nodes[nodeIndex];
+    unsigned int listIndex = GetListIndex(node.size);
+
+    node.previousFree = InvalidNode;
+    node.nextFree = m_freeLists[listIndex];
+    if (node.nextFree != InvalidNode)
+    {
+        m_nodes[node.nextFree].previousFree = nodeIndex;
+    }
+    m_freeLists[listIndex] = nodeIndex;
+
+    unsigned int firstLevel = listIndex / SecondLevelCount;
+    m_firstLevelMask |= 1u << firstLevel;
+    m_secondLevelMasks[firstLevel] |= 1u << (listIndex % SecondLevelCount);
+    ++m_freeRangeCount;
+}
+
+void RangeAllocator::RemoveFreeNode(unsigned int nodeIndex)
+{
+    Node& node = m_nodes[nodeIndex];
+    unsigned int listIndex = GetListIndex(node.size);
+
+    if (node.previousFree != InvalidNode)
+    {
+        m_nodes[node.previousFree].nextFree = node.nextFree;
+    }
+    else
+    {
+        assert(m_freeLists[listIndex] == nodeIndex);
+        m_freeLists[listIndex] = node.nextFree;
+    }
+    if (node.nextFree != InvalidNode)
+    {
+        m_nodes[node.nextFree].previousFree = node.previousFree;
+    }
+    node.previousFree = InvalidNode;
+    node.nextFree = InvalidNode;
+
+    if (m_freeLists[listIndex] == InvalidNode)
+    {
+        unsigned int firstLevel = listIndex / SecondLevelCount;
+        m_secondLevelMasks[firstLevel] &= ~(1u << (listIndex % SecondLevelCount));
+        if (m_secondLevelMasks[firstLevel] == 0)
+        {
+            m_firstLevelMask &= ~(1u << firstLevel);
+        }
+    }
+    --m_freeRangeCount;
+}
+
+unsigned int RangeAllocator::FindFreeNode(unsigned int size) const
+{
+    // Round the size up to the next list, so any range in that list or the ones after it is big enough
+    std::uint64_t roundedSize = size;
+    if (size >= SecondLevelCount)
+    {
+        roundedSize += (1u << (std::bit_width(size) - 1 - SecondLevelBits)) - 1;
+    }
+
+    if (roundedSize <= ~0u)
+    {
+        unsigned int listIndex = GetListIndex(static_cast<unsigned int>(roundedSize));
+        unsigned int firstLevel = listIndex / SecondLevelCount;
+        std::uint32_t secondLevelMask = m_secondLevelMasks[firstLevel] & (~0u << (listIndex % SecondLevelCount));
+        if (secondLevelMask == 0)
+        {
+            std::uint32_t firstLevelMask = m_firstLevelMask & (~0u << (firstLevel + 1));
+            if (firstLevelMask != 0)
+            {
+                firstLevel = std::countr_zero(firstLevelMask);
+                secondLevelMask = m_secondLevelMasks[firstLevel];
+            }
+        }
+        if (secondLevelMask != 0)
+        {
+            return m_freeLists[firstLevel * SecondLevelCount + std::countr_zero(secondLevelMask)];
+        }
+    }
+
+    // The list of the size can still have a range big enough, only the first ranges are checked
+    const unsigned int maxChecks = 8;
+    unsigned int nodeIndex = m_freeLists[GetListIndex(size)];
+    for (unsigned int i = 0; i < maxChecks && nodeIndex != InvalidNode; ++i, nodeIndex = m_nodes[nodeIndex].nextFree)
+    {
+        if (m_nodes[nodeIndex].size >= size)
+        {
+            return nodeIndex;
+        }
+    }
+
+    return InvalidNode;
+}
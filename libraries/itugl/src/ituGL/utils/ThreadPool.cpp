@@ -0,0 +1,100 @@
+#include <ituGL/utils/ThreadPool.h>
+
+#include <algorithm>
+#include <cassert>
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+    : m_function(nullptr), m_count(0), m_nextIndex(0), m_generation(0), m_pendingWorkers(0), m_stopping(false)
+{
+    if (threadCount == 0)
+    {
+        // hardware_concurrency can return 0 if it is not known
+        threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        m_threads.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_startCondition.notify_all();
+
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::ParallelFor(unsigned int count, const Function& function)
+{
+    // Not worth waking up the workers
+    if (count <= 1 || m_threads.empty())
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            function(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        assert(m_pendingWorkers == 0);
+        m_function = &function;
+        m_count = count;
+        m_nextIndex = 0;
+        m_pendingWorkers = GetThreadCount();
+        m_generation++;
+    }
+    m_startCondition.notify_all();
+
+    RunIterations();
+
+    // Wait for all the workers, even the ones that didn't get any iteration, so none of them sees this loop later
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finishCondition.wait(lock, [this] { return m_pendingWorkers == 0; });
+    m_function = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    unsigned int generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_startCondition.wait(lock, [&] { return m_stopping || m_generation != generation; });
+            if (m_stopping)
+                break;
+            generation = m_generation;
+        }
+
+        RunIterations();
+
+        bool finished;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            finished = --m_pendingWorkers == 0;
+        }
+        if (finished)
+        {
+            m_finishCondition.notify_one();
+        }
+    }
+}
+
+void ThreadPool::RunIterations()
+{
+    unsigned int index;
+    while ((index = m_nextIndex.fetch_add(1)) < m_count)
+    {
+        (*m_function)(index);
+    }
+}
@@ -0,0 +1,71 @@
+#include "Test.h"
+
+#include <ituGL/renderer/DynamicResolutionController.h>
+
+void TestDynamicResolutionController()
+{
+    // Frames under the budget keep the full resolution, and frames without time are ignored
+    {
+        DynamicResolutionController controller(14.0, 0.5f, 1.0f);
+        ITUGL_CHECK(controller.GetScale() == 1.0f);
+        ITUGL_CHECK(controller.Update(5.0) == 1.0f);
+        ITUGL_CHECK(controller.Update(0.0) == 1.0f);
+        ITUGL_CHECK(controller.GetGpuFrameTime() == 0.0);
+    }
+
+    // The scale goes down right away over the budget, never under the minimum, and comes back slowly
+    {
+        DynamicResolutionController controller(14.0, 0.5f, 1.0f);
+        float scale = controller.Update(28.0);
+        ITUGL_CHECK(scale < 0.8f && scale >= 0.5f);
+
+        for (int frame = 0; frame < 20; ++frame)
+        {
+            scale = controller.Update(100.0);
+        }
+        ITUGL_CHECK(scale == 0.5f);
+
+        // A single cheap frame only brings back a part of the resolution
+        scale = controller.Update(1.0);
+        ITUGL_CHECK(scale > 0.5f && scale < 0.6f);
+
+        // Many cheap frames reach the maximum exactly
+        for (int frame = 0; frame < 200; ++frame)
+        {
+            scale = controller.Update(1.0);
+        }
+        ITUGL_CHECK(scale == 1.0f);
+    }
+
+    // Under a steady load, where the GPU time grows with the pixels, the scale settles under the budget and stays there
+    {
+        DynamicResolutionController controller(14.0, 0.5f, 1.0f);
+        const double fullResolutionTime = 20.0;
+        float scale = controller.GetScale();
+        for (int frame = 0; frame < 200; ++frame)
+        {
+            scale = controller.Update(fullResolutionTime * scale * scale);
+        }
+        double frameTime = fullResolutionTime * scale * scale;
+        ITUGL_CHECK(frameTime <= controller.GetTargetFrameTime() && frameTime > controller.GetTargetFrameTime() * 0.75);
+
+        bool stable = true;
+        for (int frame = 0; frame < 50; ++frame)
+        {
+            stable &= controller.Update(fullResolutionTime * scale * scale) == scale;
+        }
+        ITUGL_CHECK(stable);
+    }
+
+    // New bounds clamp the current scale
+    {
+        DynamicResolutionController controller(14.0, 0.5f, 1.0f);
+        controller.SetScaleBounds(0.25f, 0.75f);
+        ITUGL_CHECK(controller.GetScale() == 0.75f);
+        for (int frame = 0; frame < 20; ++frame)
+        {
+            controller.Update(1000.0);
+        }
+        ITUGL_CHECK(controller.GetScale() == 0.25f);
+    }
+}
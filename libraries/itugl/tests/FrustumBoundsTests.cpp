@@ -0,0 +1,73 @@
+#include "Test.h"
+
+#include <ituGL/scene/Bounds.h>
+#include <ituGL/camera/Camera.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+
+// Brute force reference: the box is culled only if its 8 corners are outside the same clip plane
+static bool IsVisibleReference(const glm::mat4& viewProjMatrix, const AabbBounds& localBounds, const glm::mat4& worldMatrix)
+{
+    unsigned int outsideMask = 0x3F;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        glm::vec3 offset((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+        glm::vec4 clip = viewProjMatrix * worldMatrix * glm::vec4(localBounds.GetCenter() + offset * localBounds.GetSize(), 1.0f);
+        unsigned int cornerMask = 0;
+        cornerMask |= clip.x < -clip.w ? 0x01 : 0;
+        cornerMask |= clip.x > clip.w ? 0x02 : 0;
+        cornerMask |= clip.y < -clip.w ? 0x04 : 0;
+        cornerMask |= clip.y > clip.w ? 0x08 : 0;
+        cornerMask |= clip.z < -clip.w ? 0x10 : 0;
+        cornerMask |= clip.z > clip.w ? 0x20 : 0;
+        outsideMask &= cornerMask;
+    }
+    return outsideMask == 0;
+}
+
+void TestFrustumBounds()
+{
+    Camera camera;
+    camera.SetViewMatrix(glm::vec3(10.0f, 5.0f, 30.0f), glm::vec3(0.0f));
+    camera.SetPerspectiveProjectionMatrix(1.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+    glm::mat4 viewProjMatrix = camera.GetViewProjectionMatrix();
+    FrustumBounds frustum(camera);
+
+    AabbBounds localBounds(glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(1.0f, 0.5f, 1.0f));
+
+    // Simple cases
+    {
+        ITUGL_CHECK(Bounds::Intersects(frustum, BoxBounds(localBounds, glm::mat4(1.0f))));
+        // Behind the camera, and beyond the far plane
+        ITUGL_CHECK(!Bounds::Intersects(frustum, BoxBounds(localBounds, glm::translate(glm::mat4(1.0f), glm::vec3(20.0f, 10.0f, 60.0f)))));
+        ITUGL_CHECK(!Bounds::Intersects(frustum, BoxBounds(localBounds, glm::translate(glm::mat4(1.0f), glm::vec3(-40.0f, -20.0f, -120.0f)))));
+        // Around the camera, crossing all the planes
+        glm::mat4 aroundCamera = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(10.0f, 0.0f, 30.0f)), glm::vec3(500.0f));
+        ITUGL_CHECK(Bounds::Intersects(frustum, BoxBounds(localBounds, aroundCamera)));
+    }
+
+    // Random rotated and scaled boxes, the same culled boxes as the reference
+    {
+        std::mt19937 random(4321);
+        std::uniform_real_distribution<float> positionDistribution(-100.0f, 100.0f);
+        std::uniform_real_distribution<float> sizeDistribution(0.1f, 5.0f);
+        std::uniform_real_distribution<float> angleDistribution(0.0f, 6.28f);
+
+        unsigned int mismatchCount = 0, visibleCount = 0;
+        for (unsigned int i = 0; i < 50000; ++i)
+        {
+            glm::vec3 position(positionDistribution(random), positionDistribution(random), positionDistribution(random));
+            glm::vec3 axis = glm::normalize(glm::vec3(positionDistribution(random), positionDistribution(random), 1.0f));
+            glm::mat4 worldMatrix = glm::translate(glm::mat4(1.0f), position);
+            worldMatrix = glm::rotate(worldMatrix, angleDistribution(random), axis);
+            worldMatrix = glm::scale(worldMatrix, glm::vec3(sizeDistribution(random), sizeDistribution(random), sizeDistribution(random)));
+
+            bool visible = Bounds::Intersects(frustum, BoxBounds(localBounds, worldMatrix));
+            visibleCount += visible ? 1 : 0;
+            mismatchCount += visible != IsVisibleReference(viewProjMatrix, localBounds, worldMatrix) ? 1 : 0;
+        }
+        ITUGL_CHECK(mismatchCount == 0);
+        // Some boxes on each side, or the test doesn't check much
+        ITUGL_CHECK(visibleCount > 0 && visibleCount < 50000);
+    }
+}
@@ -0,0 +1,116 @@
+#include "Test.h"
+
+#include <ituGL/lighting/LightClusterGrid.h>
+#include <ituGL/lighting/PointLight.h>
+#include <ituGL/lighting/DirectionalLight.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/utils/ThreadPool.h>
+#include <algorithm>
+#include <random>
+#include <span>
+#include <vector>
+
+// Build the grid with the fast paths, single thread and with the pool, and check both against the brute force reference
+static bool BuildAndValidate(LightClusterGrid& grid, std::span<const Light* const> lights, const Camera& camera, ThreadPool& threadPool)
+{
+    LightClusterGrid referenceGrid(grid.GetDimensions());
+    referenceGrid.BuildReference(lights, camera);
+
+    grid.Build(lights, camera);
+    bool valid = ITUGL_CHECK(grid.HasSameAssignment(referenceGrid));
+    grid.Build(lights, camera, &threadPool);
+    valid &= ITUGL_CHECK(grid.HasSameAssignment(referenceGrid));
+    return valid;
+}
+
+static bool HasLight(std::span<const unsigned int> lightIndices, unsigned int lightIndex)
+{
+    return std::find(lightIndices.begin(), lightIndices.end(), lightIndex) != lightIndices.end();
+}
+
+static bool IsInAnyCluster(const LightClusterGrid& grid, unsigned int lightIndex)
+{
+    return HasLight(grid.GetLightIndices(), lightIndex);
+}
+
+void TestLightClusterGrid()
+{
+    ThreadPool threadPool;
+
+    // Looking down -Z from the origin, so view depth is -z
+    Camera camera;
+    camera.SetViewMatrix(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+    camera.SetPerspectiveProjectionMatrix(1.0f, 16.0f / 9.0f, 0.1f, 30.0f);
+
+    LightClusterGrid grid;
+    const glm::uvec3& dimensions = grid.GetDimensions();
+    // Clusters in the middle of the screen, in the first and the last slice
+    unsigned int nearCenterCluster = grid.GetClusterIndex(glm::uvec3(dimensions.x / 2, dimensions.y / 2, 0));
+    unsigned int farCenterCluster = grid.GetClusterIndex(glm::uvec3(dimensions.x / 2, dimensions.y / 2, dimensions.z - 1));
+
+    auto createPointLight = [](const glm::vec3& position, float range)
+        {
+            PointLight pointLight;
+            pointLight.SetPosition(position);
+            pointLight.SetDistanceAttenuation(glm::vec2(range * 0.5f, range));
+            return pointLight;
+        };
+
+    // Edge cases, one light each
+    {
+        PointLight behindCamera = createPointLight(glm::vec3(0.0f, 0.0f, 1.0f), 0.5f);
+        PointLight beforeNear = createPointLight(glm::vec3(0.0f, 0.0f, -0.05f), 0.02f);
+        PointLight crossingNear = createPointLight(glm::vec3(0.0f, 0.0f, 0.05f), 0.5f);
+        PointLight crossingFar = createPointLight(glm::vec3(0.0f, 0.0f, -30.5f), 1.0f);
+        PointLight crossingNearAndFar = createPointLight(glm::vec3(0.0f, 0.0f, -15.0f), 20.0f);
+        PointLight beyondFar = createPointLight(glm::vec3(0.0f, 0.0f, -35.0f), 1.0f);
+        PointLight zeroRange = createPointLight(glm::vec3(0.0f, 0.0f, -5.0f), 0.0f);
+        DirectionalLight directionalLight;
+        const Light* lights[] = { &behindCamera, &beforeNear, &crossingNear, &crossingFar, &crossingNearAndFar, &beyondFar, &zeroRange, &directionalLight };
+
+        BuildAndValidate(grid, lights, camera, threadPool);
+
+        // Spheres completely behind the near plane, or beyond the far plane, don't reach any cluster
+        ITUGL_CHECK(!IsInAnyCluster(grid, 0));
+        ITUGL_CHECK(!IsInAnyCluster(grid, 1));
+        ITUGL_CHECK(!IsInAnyCluster(grid, 5));
+
+        // Spheres crossing the near or far planes reach the first or last slice
+        ITUGL_CHECK(HasLight(grid.GetClusterLightIndices(nearCenterCluster), 2));
+        ITUGL_CHECK(!HasLight(grid.GetClusterLightIndices(farCenterCluster), 2));
+        ITUGL_CHECK(HasLight(grid.GetClusterLightIndices(farCenterCluster), 3));
+        ITUGL_CHECK(!HasLight(grid.GetClusterLightIndices(nearCenterCluster), 3));
+        ITUGL_CHECK(HasLight(grid.GetClusterLightIndices(nearCenterCluster), 4));
+        ITUGL_CHECK(HasLight(grid.GetClusterLightIndices(farCenterCluster), 4));
+
+        // Lights without range reach everything, so they only go to the global list
+        ITUGL_CHECK(!IsInAnyCluster(grid, 6) && HasLight(grid.GetGlobalLightIndices(), 6));
+        ITUGL_CHECK(!IsInAnyCluster(grid, 7) && HasLight(grid.GetGlobalLightIndices(), 7));
+        ITUGL_CHECK(grid.GetGlobalLightIndices().size() == 2);
+    }
+
+    // Many random lights, some of them behind the camera or out of the depth range
+    {
+        std::mt19937 random(5678);
+        std::uniform_real_distribution<float> positionDistribution(-20.0f, 20.0f);
+        std::uniform_real_distribution<float> rangeDistribution(0.5f, 4.0f);
+
+        std::vector<PointLight> pointLights;
+        for (unsigned int i = 0; i < 500; ++i)
+        {
+            glm::vec3 position(positionDistribution(random), positionDistribution(random) * 0.25f, positionDistribution(random) - 10.0f);
+            pointLights.push_back(createPointLight(position, rangeDistribution(random)));
+        }
+        std::vector<const Light*> lights;
+        for (const PointLight& pointLight : pointLights)
+        {
+            lights.push_back(&pointLight);
+        }
+
+        BuildAndValidate(grid, lights, camera, threadPool);
+        ITUGL_CHECK(!grid.GetLightIndices().empty());
+
+        // Building again reuses the lists, and must give the same result
+        BuildAndValidate(grid, lights, camera, threadPool);
+    }
+}
@@ -0,0 +1,109 @@
+#include "Test.h"
+
+#include <ituGL/geometry/MeshSimplifier.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+// Square grid of quads on the XZ plane, with the height of each vertex given by the function
+static void CreateGrid(unsigned int gridSize, const std::function<float(float, float)>& height,
+    std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices)
+{
+    for (unsigned int i = 0; i <= gridSize; ++i)
+    {
+        for (unsigned int j = 0; j <= gridSize; ++j)
+        {
+            float x = static_cast<float>(i) / gridSize, z = static_cast<float>(j) / gridSize;
+            positions.emplace_back(x, height(x, z), z);
+        }
+    }
+    for (unsigned int i = 0; i < gridSize; ++i)
+    {
+        for (unsigned int j = 0; j < gridSize; ++j)
+        {
+            unsigned int v00 = i * (gridSize + 1) + j, v10 = v00 + gridSize + 1;
+            indices.insert(indices.end(), { v00, v00 + 1, v10 + 1, v00, v10 + 1, v10 });
+        }
+    }
+}
+
+// Indices of existing vertices, and triangles with 3 different vertices
+static bool IsValidResult(std::span<const unsigned int> indices, unsigned int vertexCount)
+{
+    bool valid = indices.size() % 3 == 0;
+    for (size_t i = 0; valid && i < indices.size(); i += 3)
+    {
+        valid = indices[i] < vertexCount && indices[i + 1] < vertexCount && indices[i + 2] < vertexCount;
+        valid &= indices[i] != indices[i + 1] && indices[i + 1] != indices[i + 2] && indices[i + 2] != indices[i];
+    }
+    return valid;
+}
+
+void TestMeshSimplifier()
+{
+    const unsigned int gridSize = 32;
+    MeshSimplifier simplifier;
+
+    // A flat grid simplifies without error, and keeps the vertices of its open border
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<unsigned int> indices;
+        CreateGrid(gridSize, [](float, float) { return 0.0f; }, positions, indices);
+        unsigned int vertexCount = static_cast<unsigned int>(positions.size());
+
+        unsigned int targetIndexCount = static_cast<unsigned int>(indices.size() / 10 / 3 * 3);
+        std::vector<unsigned int> simplified = simplifier.Simplify(positions, indices, targetIndexCount);
+        ITUGL_CHECK(!simplified.empty() && simplified.size() <= targetIndexCount);
+        ITUGL_CHECK(IsValidResult(simplified, vertexCount));
+        ITUGL_CHECK(simplifier.GetError() < 1e-4f);
+
+        bool hasBorder = true;
+        for (unsigned int vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            glm::vec3 position = positions[vertex];
+            if (position.x == 0.0f || position.x == 1.0f || position.z == 0.0f || position.z == 1.0f)
+            {
+                hasBorder &= std::find(simplified.begin(), simplified.end(), vertex) != simplified.end();
+            }
+        }
+        ITUGL_CHECK(hasBorder);
+    }
+
+    // A curved grid, simplified to several ratios, always gives the same result for the same mesh
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<unsigned int> indices;
+        CreateGrid(gridSize, [](float x, float z) { return 0.1f * std::sin(x * 6.28f) * std::cos(z * 6.28f); }, positions, indices);
+        unsigned int vertexCount = static_cast<unsigned int>(positions.size());
+
+        float previousError = 0.0f;
+        for (float ratio : { 0.5f, 0.25f, 0.1f })
+        {
+            unsigned int targetIndexCount = static_cast<unsigned int>(indices.size() * ratio / 3) * 3;
+            std::vector<unsigned int> simplified = simplifier.Simplify(positions, indices, targetIndexCount);
+            float error = simplifier.GetError();
+            ITUGL_CHECK(simplified.size() <= targetIndexCount);
+            ITUGL_CHECK(IsValidResult(simplified, vertexCount));
+            ITUGL_CHECK(simplifier.Simplify(positions, indices, targetIndexCount) == simplified);
+            ITUGL_CHECK(simplifier.GetError() == error);
+            // Fewer triangles can't be closer to the surface
+            ITUGL_CHECK(error >= previousError);
+            previousError = error;
+        }
+
+        // The error limit stops the simplification before the target
+        float maxError = previousError * 0.5f;
+        std::vector<unsigned int> simplified = simplifier.Simplify(positions, indices, 3, maxError);
+        ITUGL_CHECK(simplified.size() > indices.size() / 10);
+        ITUGL_CHECK(simplifier.GetError() <= maxError);
+        ITUGL_CHECK(IsValidResult(simplified, vertexCount));
+    }
+
+    // Nothing to simplify
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<unsigned int> indices;
+        ITUGL_CHECK(simplifier.Simplify(positions, indices, 0).empty());
+    }
+}
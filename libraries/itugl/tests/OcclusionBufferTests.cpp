@@ -0,0 +1,89 @@
+#include "Test.h"
+
+#include <ituGL/scene/OcclusionBuffer.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/utils/ThreadPool.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <vector>
+
+static glm::mat4 CreateBoxMatrix(const glm::vec3& position, const glm::vec3& scale)
+{
+    return glm::scale(glm::translate(glm::mat4(1.0f), position), scale);
+}
+
+void TestOcclusionBuffer()
+{
+    ThreadPool threadPool;
+    AabbBounds unitBounds(glm::vec3(0.0f), glm::vec3(0.5f));
+
+    // The SIMD kernel and the thread pool must write exactly the same depths as the serial reference
+    {
+        // Rows of walls across the view, with gaps between them, and a floor
+        std::vector<glm::mat4> occluderMatrices;
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int column = -3; column <= 3; ++column)
+            {
+                glm::vec3 position(column * 24.0f + (row % 2) * 12.0f, 8.0f, -20.0f - row * 25.0f);
+                occluderMatrices.push_back(CreateBoxMatrix(position, glm::vec3(20.0f, 16.0f, 1.0f)));
+            }
+        }
+        occluderMatrices.push_back(CreateBoxMatrix(glm::vec3(0.0f, -0.5f, -50.0f), glm::vec3(200.0f, 1.0f, 200.0f)));
+
+        Camera camera;
+        camera.SetViewMatrix(glm::vec3(0.0f, 4.0f, 10.0f), glm::vec3(0.0f, 4.0f, -50.0f));
+        camera.SetPerspectiveProjectionMatrix(1.0f, 16.0f / 9.0f, 0.1f, 200.0f);
+
+        // Not a multiple of the tile size, so the last tiles are partial
+        OcclusionBuffer referenceBuffer(200, 100), occlusionBuffer(200, 100);
+        for (OcclusionBuffer* buffer : { &referenceBuffer, &occlusionBuffer })
+        {
+            buffer->Clear(camera.GetViewProjectionMatrix());
+            for (const glm::mat4& occluderMatrix : occluderMatrices)
+            {
+                buffer->AddOccluder(unitBounds, occluderMatrix);
+            }
+        }
+
+        referenceBuffer.Rasterize(nullptr, OcclusionBuffer::Kernel::Reference);
+        ITUGL_CHECK(std::ranges::any_of(referenceBuffer.GetDepths(), [](float depth) { return depth < 1.0f; }));
+
+        occlusionBuffer.Rasterize(nullptr, OcclusionBuffer::Kernel::Simd);
+        ITUGL_CHECK(std::ranges::equal(occlusionBuffer.GetDepths(), referenceBuffer.GetDepths()));
+        occlusionBuffer.Rasterize(&threadPool, OcclusionBuffer::Kernel::Simd);
+        ITUGL_CHECK(std::ranges::equal(occlusionBuffer.GetDepths(), referenceBuffer.GetDepths()));
+        occlusionBuffer.Rasterize(&threadPool, OcclusionBuffer::Kernel::Reference);
+        ITUGL_CHECK(std::ranges::equal(occlusionBuffer.GetDepths(), referenceBuffer.GetDepths()));
+    }
+
+    // Visibility of single boxes, around a wall in front of the camera
+    {
+        Camera camera;
+        camera.SetViewMatrix(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f));
+        camera.SetPerspectiveProjectionMatrix(1.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+
+        OcclusionBuffer occlusionBuffer;
+        occlusionBuffer.Clear(camera.GetViewProjectionMatrix());
+        occlusionBuffer.Rasterize(&threadPool);
+
+        // Without occluders, everything is visible
+        glm::mat4 behindWall = CreateBoxMatrix(glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(1.0f));
+        ITUGL_CHECK(occlusionBuffer.IsVisible(unitBounds, behindWall));
+
+        occlusionBuffer.Clear(camera.GetViewProjectionMatrix());
+        occlusionBuffer.AddOccluder(unitBounds, CreateBoxMatrix(glm::vec3(0.0f), glm::vec3(4.0f, 4.0f, 1.0f)));
+        occlusionBuffer.Rasterize(&threadPool);
+
+        ITUGL_CHECK(!occlusionBuffer.IsVisible(unitBounds, behindWall));
+        // In front of the wall
+        ITUGL_CHECK(occlusionBuffer.IsVisible(unitBounds, CreateBoxMatrix(glm::vec3(0.0f, 0.0f, 2.0f), glm::vec3(1.0f))));
+        // Behind the wall, but only partially covered by it
+        ITUGL_CHECK(occlusionBuffer.IsVisible(unitBounds, CreateBoxMatrix(glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(30.0f, 1.0f, 1.0f))));
+        // Behind the wall depth, but to the side of it
+        ITUGL_CHECK(occlusionBuffer.IsVisible(unitBounds, CreateBoxMatrix(glm::vec3(12.0f, 0.0f, -10.0f), glm::vec3(1.0f))));
+        // Crossing the near plane, and behind the camera, are always visible
+        ITUGL_CHECK(occlusionBuffer.IsVisible(unitBounds, CreateBoxMatrix(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(1.0f))));
+        ITUGL_CHECK(occlusionBuffer.IsVisible(unitBounds, CreateBoxMatrix(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(1.0f))));
+    }
+}
@@ -0,0 +1,120 @@
+#include "Test.h"
+
+#include <ituGL/utils/RangeAllocator.h>
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+void TestRangeAllocator()
+{
+    // Simple cases
+    {
+        RangeAllocator allocator(100);
+        RangeAllocator::Allocation first = allocator.Allocate(40);
+        RangeAllocator::Allocation second = allocator.Allocate(60);
+        ITUGL_CHECK(first.id != RangeAllocator::InvalidId && second.id != RangeAllocator::InvalidId);
+        ITUGL_CHECK(first.offset + first.size <= second.offset || second.offset + second.size <= first.offset);
+        ITUGL_CHECK(allocator.Allocate(1).id == RangeAllocator::InvalidId);
+
+        // Freed ranges are merged with their free neighbours
+        allocator.Free(first.id);
+        allocator.Free(second.id);
+        RangeAllocator::Stats stats = allocator.GetStats();
+        ITUGL_CHECK(stats.usedSize == 0 && stats.allocationCount == 0 && stats.freeRangeCount == 1 && stats.largestFreeRange == 100);
+        ITUGL_CHECK(allocator.Allocate(100).id != RangeAllocator::InvalidId);
+        ITUGL_CHECK(allocator.IsValid());
+
+        // Defragment keeps the ids and the order, and leaves the free space at the end
+        allocator.Reset(100);
+        RangeAllocator::Allocation a = allocator.Allocate(10);
+        RangeAllocator::Allocation b = allocator.Allocate(20);
+        RangeAllocator::Allocation c = allocator.Allocate(30);
+        allocator.Free(a.id);
+        std::vector<RangeAllocator::Move> moves = allocator.Defragment();
+        ITUGL_CHECK(moves.size() == 2);
+        ITUGL_CHECK(allocator.GetAllocation(b.id).offset == 0 && allocator.GetAllocation(c.id).offset == 20);
+        ITUGL_CHECK(allocator.GetStats().freeRangeCount == 1 && allocator.GetStats().largestFreeRange == 50);
+        ITUGL_CHECK(allocator.IsValid());
+    }
+
+    // Random allocations and frees, with defragmentations
+    {
+        const unsigned int size = 1u << 20;
+        const unsigned int operationCount = 200000;
+
+        // Fixed seed, so every run does the same operations. Mostly small meshes, and a few big ones
+        std::mt19937 random(4321);
+        auto randomSize = [&]() { return random() % 4 == 0 ? 1 + random() % 20000 : 1 + random() % 300; };
+
+        // Each unit stores the tag of its allocation, so overlapping allocations and wrong moves change the tags
+        RangeAllocator allocator(size);
+        std::vector<unsigned int> memory(size, 0);
+        std::vector<std::pair<RangeAllocator::AllocationId, unsigned int>> allocations;
+        auto checkTags = [&](RangeAllocator::AllocationId id, unsigned int tag, unsigned int newTag)
+            {
+                RangeAllocator::Allocation allocation = allocator.GetAllocation(id);
+                bool valid = allocation.offset + allocation.size <= size;
+                for (unsigned int offset = allocation.offset; valid && offset < allocation.offset + allocation.size; ++offset)
+                {
+                    valid &= memory[offset] == tag;
+                    memory[offset] = newTag;
+                }
+                return valid;
+            };
+
+        unsigned int nextTag = 1, failedCount = 0, defragmentCount = 0;
+        bool valid = true;
+        for (unsigned int i = 0; i < operationCount && valid; ++i)
+        {
+            if (allocations.empty() || random() % 100 < 55)
+            {
+                RangeAllocator::Allocation allocation = allocator.Allocate(randomSize());
+                if (allocation.id == RangeAllocator::InvalidId)
+                {
+                    ++failedCount;
+                }
+                else
+                {
+                    valid &= ITUGL_CHECK(checkTags(allocation.id, 0, nextTag));
+                    allocations.emplace_back(allocation.id, nextTag++);
+                }
+            }
+            else
+            {
+                unsigned int index = random() % allocations.size();
+                valid &= ITUGL_CHECK(checkTags(allocations[index].first, allocations[index].second, 0));
+                allocator.Free(allocations[index].first);
+                allocations[index] = allocations.back();
+                allocations.pop_back();
+            }
+
+            if (i % 1000 == 0)
+            {
+                valid &= ITUGL_CHECK(allocator.IsValid());
+            }
+
+            // Defragment from time to time, moving the tags as the buffer copies would
+            if (i % 50000 == 49999)
+            {
+                for (const RangeAllocator::Move& move : allocator.Defragment())
+                {
+                    std::memmove(&memory[move.newOffset], &memory[move.oldOffset], move.size * sizeof(unsigned int));
+                }
+                std::fill(memory.begin() + allocator.GetStats().usedSize, memory.end(), 0u);
+                for (auto [id, tag] : allocations)
+                {
+                    valid &= ITUGL_CHECK(checkTags(id, tag, tag));
+                }
+                valid &= ITUGL_CHECK(allocator.IsValid());
+                valid &= ITUGL_CHECK(allocator.GetStats().freeRangeCount <= 1);
+                ++defragmentCount;
+            }
+        }
+
+        // The sizes must fill the space sometimes, or the test doesn't reach the full buffer cases
+        ITUGL_CHECK(failedCount > 0);
+        ITUGL_CHECK(defragmentCount == operationCount / 50000);
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+// Minimal checks for the CPU-only tests of itugl. A failed check is printed and counted, and the test keeps running
+// The test executable returns non-zero if any check failed, so ctest reports it
+#define ITUGL_CHECK(condition) CheckTest((condition), #condition, __FILE__, __LINE__)
+
+bool CheckTest(bool condition, const char* expression, const char* file, int line);
+
+// Test groups, selected by name in the command line
+void TestDynamicResolutionController();
+void TestFrustumBounds();
+void TestLightClusterGrid();
+void TestMeshSimplifier();
+void TestOcclusionBuffer();
+void TestRangeAllocator();
+void TestTransform();
+void TestTransformBatch();
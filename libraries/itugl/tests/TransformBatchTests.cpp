@@ -0,0 +1,86 @@
+#include "Test.h"
+
+#include <ituGL/renderer/TransformBatch.h>
+#include <ituGL/camera/Camera.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Largest difference between the components, relative to their size
+template<int C, int R>
+static float GetMaxError(const glm::mat<C, R, float>& a, const glm::mat<C, R, float>& b)
+{
+    float maxError = 0.0f;
+    for (int column = 0; column < C; ++column)
+    {
+        for (int row = 0; row < R; ++row)
+        {
+            float error = std::abs(a[column][row] - b[column][row]) / std::max(1.0f, std::abs(a[column][row]));
+            maxError = std::max(maxError, error);
+        }
+    }
+    return maxError;
+}
+
+// The SIMD kernel must give the same matrices as glm, for the first count matrices
+static bool HasSameMatrices(const TransformBatch& glmBatch, const TransformBatch& simdBatch, unsigned int count)
+{
+    bool valid = ITUGL_CHECK(glmBatch.GetCount() == count && simdBatch.GetCount() == count);
+    float maxError = 0.0f;
+    for (unsigned int i = 0; valid && i < count; ++i)
+    {
+        maxError = std::max(maxError, GetMaxError(glmBatch.GetWorldViewMatrix(i), simdBatch.GetWorldViewMatrix(i)));
+        maxError = std::max(maxError, GetMaxError(glmBatch.GetWorldViewProjMatrix(i), simdBatch.GetWorldViewProjMatrix(i)));
+        maxError = std::max(maxError, GetMaxError(glmBatch.GetNormalMatrix(i), simdBatch.GetNormalMatrix(i)));
+    }
+    return valid & ITUGL_CHECK(maxError < 1e-4f);
+}
+
+void TestTransformBatch()
+{
+    std::mt19937 random(8765);
+    std::uniform_real_distribution<float> positionDistribution(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> sizeDistribution(0.1f, 5.0f);
+    std::uniform_real_distribution<float> angleDistribution(0.0f, 6.28f);
+
+    // Not a multiple of the SIMD width, so the last lanes are padding
+    std::vector<glm::mat4> worldMatrices;
+    for (unsigned int i = 0; i < 10003; ++i)
+    {
+        glm::vec3 position(positionDistribution(random), positionDistribution(random), positionDistribution(random));
+        glm::vec3 axis = glm::normalize(glm::vec3(positionDistribution(random), positionDistribution(random), 1.0f));
+        glm::mat4 worldMatrix = glm::translate(glm::mat4(1.0f), position);
+        worldMatrix = glm::rotate(worldMatrix, angleDistribution(random), axis);
+        worldMatrix = glm::scale(worldMatrix, glm::vec3(sizeDistribution(random), sizeDistribution(random), sizeDistribution(random)));
+        worldMatrices.push_back(worldMatrix);
+    }
+
+    Camera camera;
+    camera.SetViewMatrix(glm::vec3(10.0f, 5.0f, 30.0f), glm::vec3(0.0f));
+    camera.SetPerspectiveProjectionMatrix(1.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+
+    TransformBatch glmBatch, simdBatch;
+    glmBatch.Compute(worldMatrices, camera.GetViewMatrix(), camera.GetProjectionMatrix(), TransformBatch::Kernel::Glm);
+    simdBatch.Compute(worldMatrices, camera.GetViewMatrix(), camera.GetProjectionMatrix(), TransformBatch::Kernel::Simd);
+    HasSameMatrices(glmBatch, simdBatch, static_cast<unsigned int>(worldMatrices.size()));
+
+    // The glm kernel is the reference, so check it against the matrices computed here too
+    glm::mat4 worldViewMatrix = camera.GetViewMatrix() * worldMatrices[0];
+    ITUGL_CHECK(GetMaxError(glmBatch.GetWorldViewMatrix(0), worldViewMatrix) < 1e-5f);
+    ITUGL_CHECK(GetMaxError(glmBatch.GetWorldViewProjMatrix(0), camera.GetProjectionMatrix() * worldViewMatrix) < 1e-5f);
+    ITUGL_CHECK(GetMaxError(glmBatch.GetNormalMatrix(0), glm::transpose(glm::inverse(glm::mat3(worldViewMatrix)))) < 1e-4f);
+
+    // Smaller batches after the large one keep the stride of the large one, and must only compute their own matrices
+    for (unsigned int count : { 5u, 1u, 0u, 17u })
+    {
+        std::span<const glm::mat4> firstMatrices(worldMatrices.data() + 100, count);
+        glmBatch.Compute(firstMatrices, camera.GetViewMatrix(), camera.GetProjectionMatrix(), TransformBatch::Kernel::Glm);
+        simdBatch.Compute(firstMatrices, camera.GetViewMatrix(), camera.GetProjectionMatrix(), TransformBatch::Kernel::Simd);
+        HasSameMatrices(glmBatch, simdBatch, count);
+    }
+
+    simdBatch.Clear();
+    ITUGL_CHECK(simdBatch.GetCount() == 0);
+}
@@ -0,0 +1,52 @@
+#include "Test.h"
+
+#include <ituGL/scene/Transform.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <memory>
+
+void TestTransform()
+{
+    // A parent with two children, like two scene models attached to the same node
+    std::shared_ptr<Transform> parent = std::make_shared<Transform>();
+    std::shared_ptr<Transform> firstChild = std::make_shared<Transform>();
+    std::shared_ptr<Transform> secondChild = std::make_shared<Transform>();
+    firstChild->SetParent(parent);
+    firstChild->SetTranslation(glm::vec3(1.0f, 0.0f, 0.0f));
+    secondChild->SetParent(parent);
+    secondChild->SetTranslation(glm::vec3(0.0f, 2.0f, 0.0f));
+
+    firstChild->GetTransformMatrix();
+    secondChild->GetTransformMatrix();
+    ITUGL_CHECK(!parent->IsDirty() && !firstChild->IsDirty() && !secondChild->IsDirty());
+
+    // Reading the matrices doesn't change the versions
+    std::uint64_t firstVersion = firstChild->GetVersion();
+    std::uint64_t secondVersion = secondChild->GetVersion();
+    firstChild->GetTransformMatrix();
+    ITUGL_CHECK(firstChild->GetVersion() == firstVersion && secondChild->GetVersion() == secondVersion);
+
+    // Moving the parent changes both children, even after the first one read its matrix, which also updates the parent
+    parent->SetTranslation(glm::vec3(0.0f, 0.0f, 5.0f));
+    glm::mat4 firstMatrix = firstChild->GetTransformMatrix();
+    ITUGL_CHECK(firstChild->GetVersion() != firstVersion);
+    ITUGL_CHECK(secondChild->GetVersion() != secondVersion);
+    ITUGL_CHECK(secondChild->IsDirty());
+    ITUGL_CHECK(firstMatrix == glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 0.0f, 5.0f)));
+    ITUGL_CHECK(secondChild->GetTransformMatrix() == glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 2.0f, 5.0f)));
+
+    // Moving a child doesn't change its sibling or its parent
+    firstVersion = firstChild->GetVersion();
+    secondVersion = secondChild->GetVersion();
+    std::uint64_t parentVersion = parent->GetVersion();
+    firstChild->SetScale(glm::vec3(2.0f));
+    ITUGL_CHECK(firstChild->GetVersion() != firstVersion);
+    ITUGL_CHECK(secondChild->GetVersion() == secondVersion && parent->GetVersion() == parentVersion);
+
+    // Attaching to another parent changes the version, even if the new parent didn't change since the last read
+    std::shared_ptr<Transform> otherParent = std::make_shared<Transform>();
+    otherParent->GetTransformMatrix();
+    secondVersion = secondChild->GetVersion();
+    secondChild->SetParent(otherParent);
+    ITUGL_CHECK(secondChild->GetVersion() != secondVersion);
+    ITUGL_CHECK(secondChild->GetTransformMatrix() == glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 2.0f, 0.0f)));
+}
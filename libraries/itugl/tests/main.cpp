@@ -0,0 +1,56 @@
+#include "Test.h"
+
+#include <cstdio>
+#include <cstring>
+
+static unsigned int s_failureCount = 0;
+
+bool CheckTest(bool condition, const char* expression, const char* file, int line)
+{
+    if (!condition)
+    {
+        std::printf("%s(%d): check failed: %s\n", file, line, expression);
+        ++s_failureCount;
+    }
+    return condition;
+}
+
+int main(int argc, char* argv[])
+{
+    struct TestGroup
+    {
+        const char* name;
+        void (*function)();
+    };
+    const TestGroup testGroups[] =
+    {
+        { "dynamic_resolution", TestDynamicResolutionController },
+        { "frustum_bounds", TestFrustumBounds },
+        { "light_clusters", TestLightClusterGrid },
+        { "mesh_simplifier", TestMeshSimplifier },
+        { "occlusion_buffer", TestOcclusionBuffer },
+        { "range_allocator", TestRangeAllocator },
+        { "transforms", TestTransform },
+        { "transform_batch", TestTransformBatch },
+    };
+
+    // Run the group in the first argument, or all of them
+    bool found = false;
+    for (const TestGroup& testGroup : testGroups)
+    {
+        if (argc < 2 || std::strcmp(argv[1], testGroup.name) == 0)
+        {
+            std::printf("Running %s\n", testGroup.name);
+            testGroup.function();
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        std::printf("Unknown test group: %s\n", argv[1]);
+        return 1;
+    }
+
+    std::printf("%u checks failed\n", s_failureCount);
+    return s_failureCount == 0 ? 0 : 1;
+}